@@ -7,6 +7,7 @@ import android.view.ViewGroup;
 import android.widget.FrameLayout;
 import android.os.Handler;
 import android.os.Looper;
+import android.os.SystemClock;
 import android.net.Uri;
 import android.util.Log;
 
@@ -15,6 +16,8 @@ import org.videolan.libvlc.Media;
 import org.videolan.libvlc.MediaPlayer;
 
 import java.util.ArrayList;
+import java.util.HashSet;
+import java.util.Random;
 
 public class VlcSurfaceHelper {
 
@@ -24,6 +27,350 @@ public class VlcSurfaceHelper {
     private static LibVLC libVLC;
     private static MediaPlayer mediaPlayer;
 
+    // Latency options applied to every new Media, set from VLCBridge.setLatencyProfile()
+    private static int cachingMs = 150;
+    private static boolean dropLateFrames = false;
+
+    public static void setLatencyOptions(int caching, boolean dropLate) {
+        new Handler(Looper.getMainLooper()).post(() -> {
+            cachingMs = caching;
+            dropLateFrames = dropLate;
+        });
+    }
+
+    // Decoder policy codes shared with VlcPlayer::DecodePolicy on the C++ side
+    private static final int DECODE_AUTO = 0;
+    private static final int DECODE_HARDWARE = 1;
+    private static final int DECODE_SOFTWARE = 2;
+    private static final int DECODE_SOFTWARE_CAPPED = 3;
+
+    // Decoder options applied to every new Media, set from VLCBridge.setDecodePolicy()
+    private static int decodePolicy = DECODE_AUTO;
+    private static int decodeThreads = 2;
+
+    // URLs whose hardware decoder failed under DECODE_AUTO; they stay on software
+    private static final HashSet<String> hardwareFailedUrls = new HashSet<>();
+
+    public static void setDecodeOptions(int policy, int threads) {
+        new Handler(Looper.getMainLooper()).post(() -> {
+            decodePolicy = policy;
+            decodeThreads = threads;
+            hardwareFailedUrls.clear();
+        });
+    }
+
+    private static boolean usesHardware(String url) {
+        return decodePolicy == DECODE_HARDWARE
+                || (decodePolicy == DECODE_AUTO && !hardwareFailedUrls.contains(url));
+    }
+
+    // Transport codes shared with VlcPlayer::Transport on the C++ side
+    private static final int TRANSPORT_AUTO = 0;
+    private static final int TRANSPORT_TCP = 1;
+    private static final int TRANSPORT_UDP = 2;
+    private static final int TRANSPORT_MULTICAST = 3;
+
+    // RTP transport applied to every new Media, set from VLCBridge.playInSurface(); the engine
+    // option --rtsp-tcp is only the default a media option overrides
+    private static int transport = TRANSPORT_TCP;
+
+    // URLs that received nothing over UDP; they stay on TCP until the transport changes
+    private static final HashSet<String> udpFailedUrls = new HashSet<>();
+
+    public static void setTransport(int mode) {
+        new Handler(Looper.getMainLooper()).post(() -> {
+            if (mode != transport) {
+                transport = mode;
+                udpFailedUrls.clear();
+            }
+        });
+    }
+
+    private static boolean usesUdp(String url) {
+        return transport != TRANSPORT_TCP && !udpFailedUrls.contains(url);
+    }
+
+    // Visibility codes shared with VlcPlayer::Visibility on the C++ side
+    private static final int VISIBLE = 0;
+    private static final int HIDDEN_NO_RENDER = 1;
+    private static final int HIDDEN_KEYFRAMES = 2;
+    private static final int HIDDEN_AUDIO_ONLY = 3;
+
+    // Mode set from VLCBridge.updateVisibility() and the video track HIDDEN_AUDIO_ONLY turned off
+    // (-1 while video is on)
+    private static int visibility = VISIBLE;
+    private static int disabledVideoTrack = -1;
+
+    // Every hidden mode stops composing the TextureView; HIDDEN_KEYFRAMES reopens the media with
+    // frame skipping and HIDDEN_AUDIO_ONLY turns the video track off, keeping the RTSP session
+    public static void setVisibility(int mode) {
+        mainHandler.post(() -> {
+            if (mode == visibility) {
+                return;
+            }
+            boolean keyframes = visibility == HIDDEN_KEYFRAMES;
+            visibility = mode;
+            Log.d(TAG, "Visibility " + mode);
+
+            if (textureView != null && currentUrl != null) {
+                textureView.setVisibility(mode == VISIBLE ? View.VISIBLE : View.INVISIBLE);
+            }
+            if (keyframes != (mode == HIDDEN_KEYFRAMES) && currentUrl != null && mediaPlayer != null) {
+                Media media = createMedia(currentUrl);
+                mediaPlayer.setMedia(media);
+                media.release();
+                mediaPlayer.play();
+                startWatchdog();
+            }
+            applyVideoTrack();
+        });
+    }
+
+    // The track can only be turned off once the media has created it; repeated on every Vout event
+    private static void applyVideoTrack() {
+        if (mediaPlayer == null) {
+            return;
+        }
+        if (visibility == HIDDEN_AUDIO_ONLY) {
+            if (disabledVideoTrack < 0) {
+                int track = mediaPlayer.getVideoTrack();
+                if (track >= 0 && mediaPlayer.setVideoTrack(-1)) {
+                    disabledVideoTrack = track;
+                }
+            }
+        } else if (disabledVideoTrack >= 0) {
+            mediaPlayer.setVideoTrack(disabledVideoTrack);
+            disabledVideoTrack = -1;
+        }
+    }
+
+    // State codes shared with VlcPlayer::State on the C++ side
+    private static final int STATE_IDLE = 0;
+    private static final int STATE_OPENING = 1;
+    private static final int STATE_BUFFERING = 2;
+    private static final int STATE_PLAYING = 3;
+    private static final int STATE_PAUSED = 4;
+    private static final int STATE_ENDED = 5;
+    private static final int STATE_ERROR = 6;
+
+    // Implemented in vlcbridge.cpp; forwards to VLCBridge::onSurfaceState() on the Qt thread
+    private static native void nativeStateChanged(int state, String message);
+
+    private static void reportState(int state, String message) {
+        try {
+            nativeStateChanged(state, message);
+        } catch (UnsatisfiedLinkError e) {
+            Log.w(TAG, "State callback not available", e);
+        }
+    }
+
+    // Reconnect supervision: the current URL is reopened on the warm player after an outage,
+    // with jittered exponential backoff (0.5, 1, 2, ... 30 s)
+    private static final Handler mainHandler = new Handler(Looper.getMainLooper());
+    private static final Random random = new Random();
+    private static final int STALL_TIMEOUT_MS = 4000;
+    private static final int CONNECT_TIMEOUT_MS = 10000;
+    private static final int WATCHDOG_INTERVAL_MS = 1000;
+    private static final int BASE_BACKOFF_MS = 500;
+    private static final int MAX_BACKOFF_MS = 30000;
+    private static String currentUrl;
+    private static int reconnectAttempt;
+    private static boolean reconnectPending;
+    private static long lastMediaTime = -1;
+    private static long lastProgressAt;
+    // Playing not reached yet since the last (re)open, and paused by the user
+    private static boolean connecting;
+    private static boolean paused;
+    private static long connectStartedAt;
+
+    private static final Runnable reconnectTask = () -> {
+        reconnectPending = false;
+        if (currentUrl == null || libVLC == null || mediaPlayer == null) {
+            return;
+        }
+        Log.d(TAG, "Reconnecting to " + currentUrl + ", attempt " + reconnectAttempt);
+        Media media = createMedia(currentUrl);
+        mediaPlayer.setMedia(media);
+        media.release();
+        mediaPlayer.play();
+        startWatchdog();
+    };
+
+    // A connection that never reaches Playing, or media time that stops advancing while the
+    // player plays, means the source is gone; only a pause stops the clock
+    private static final Runnable watchdogTask = new Runnable() {
+        @Override
+        public void run() {
+            if (currentUrl == null || mediaPlayer == null || reconnectPending) {
+                return;
+            }
+            long now = SystemClock.elapsedRealtime();
+            long time = mediaPlayer.getTime();
+            if (paused) {
+                lastMediaTime = time;
+                lastProgressAt = now;
+            } else if (connecting) {
+                if (now - connectStartedAt > CONNECT_TIMEOUT_MS) {
+                    fallBackToTcpIfSilent();
+                    scheduleReconnect("not playing within " + CONNECT_TIMEOUT_MS + " ms");
+                    return;
+                }
+            } else if (time != lastMediaTime) {
+                if (lastMediaTime >= 0) {
+                    reconnectAttempt = 0;
+                }
+                lastMediaTime = time;
+                lastProgressAt = now;
+            } else if (now - lastProgressAt > STALL_TIMEOUT_MS) {
+                fallBackToTcpIfSilent();
+                scheduleReconnect("media time stuck");
+                return;
+            }
+            mainHandler.postDelayed(this, WATCHDOG_INTERVAL_MS);
+        }
+    };
+
+    private static void startWatchdog() {
+        mainHandler.removeCallbacks(watchdogTask);
+        lastMediaTime = -1;
+        lastProgressAt = SystemClock.elapsedRealtime();
+        connectStartedAt = lastProgressAt;
+        connecting = true;
+        paused = false;
+        mainHandler.postDelayed(watchdogTask, WATCHDOG_INTERVAL_MS);
+    }
+
+    private static void superviseUrl(String url) {
+        currentUrl = url;
+        reconnectAttempt = 0;
+        reconnectPending = false;
+        mainHandler.removeCallbacks(reconnectTask);
+        if (url != null) {
+            startWatchdog();
+        } else {
+            mainHandler.removeCallbacks(watchdogTask);
+        }
+    }
+
+    private static void scheduleReconnect(String reason) {
+        if (currentUrl == null || reconnectPending) {
+            return;
+        }
+        // Equal jitter keeps cameras that dropped together from reconnecting in lockstep
+        int step = Math.min(MAX_BACKOFF_MS, BASE_BACKOFF_MS << Math.min(reconnectAttempt, 16));
+        int delay = step / 2 + random.nextInt(step / 2 + 1);
+        reconnectAttempt++;
+        reconnectPending = true;
+        mainHandler.removeCallbacks(watchdogTask);
+        mainHandler.postDelayed(reconnectTask, delay);
+        Log.w(TAG, "Outage (" + reason + "), reconnecting in " + delay + " ms");
+    }
+
+    // Translate MediaPlayer events into bridge states; runs on the main looper
+    private static final MediaPlayer.EventListener eventListener = event -> {
+        switch (event.type) {
+            case MediaPlayer.Event.Opening:
+                reportState(STATE_OPENING, null);
+                break;
+            case MediaPlayer.Event.Buffering:
+                if (event.getBuffering() < 100f) {
+                    reportState(STATE_BUFFERING, null);
+                } else if (mediaPlayer != null && mediaPlayer.isPlaying()) {
+                    reportState(STATE_PLAYING, null);
+                }
+                break;
+            case MediaPlayer.Event.Playing:
+                // The stall clock starts once the connection is up or the pause is over
+                if (connecting || paused) {
+                    lastProgressAt = SystemClock.elapsedRealtime();
+                }
+                connecting = false;
+                paused = false;
+                reportState(STATE_PLAYING, null);
+                break;
+            case MediaPlayer.Event.Vout:
+                applyVideoTrack();
+                break;
+            case MediaPlayer.Event.Paused:
+                paused = true;
+                reportState(STATE_PAUSED, null);
+                break;
+            case MediaPlayer.Event.Stopped:
+                reportState(STATE_IDLE, null);
+                break;
+            case MediaPlayer.Event.EndReached:
+                reportState(STATE_ENDED, null);
+                scheduleReconnect("stream ended");
+                break;
+            case MediaPlayer.Event.EncounteredError:
+                if (currentUrl != null && usesHardware(currentUrl) && decodePolicy == DECODE_AUTO
+                        && receivedButNotDecoded()) {
+                    hardwareFailedUrls.add(currentUrl);
+                    Log.w(TAG, "Falling back to software decoding for " + currentUrl);
+                }
+                fallBackToTcpIfSilent();
+                reportState(STATE_ERROR, "Playback failed");
+                scheduleReconnect("playback error");
+                break;
+            default:
+                break;
+        }
+    };
+
+    // Data arrived but no picture came out: blame the decoder rather than the network
+    private static boolean receivedButNotDecoded() {
+        Media media = mediaPlayer != null ? mediaPlayer.getMedia() : null;
+        if (media == null) {
+            return false;
+        }
+        Media.Stats stats = media.getStats();
+        media.release();
+        return stats != null && stats.demuxReadBytes > 0 && stats.decodedVideo == 0;
+    }
+
+    // Not a byte arrived over UDP: the packets are blocked between the camera and us, so the
+    // reconnect goes over TCP
+    private static void fallBackToTcpIfSilent() {
+        if (currentUrl == null || !usesUdp(currentUrl)) {
+            return;
+        }
+        Media media = mediaPlayer != null ? mediaPlayer.getMedia() : null;
+        if (media == null) {
+            return;
+        }
+        Media.Stats stats = media.getStats();
+        media.release();
+        if (stats != null && stats.demuxReadBytes == 0) {
+            udpFailedUrls.add(currentUrl);
+            Log.w(TAG, "No UDP packets from " + currentUrl + ", falling back to RTSP over TCP");
+        }
+    }
+
+    private static Media createMedia(String url) {
+        Media media = new Media(libVLC, Uri.parse(url));
+        media.addOption(":network-caching=" + cachingMs);
+        media.addOption(":live-caching=" + cachingMs);
+        media.addOption(dropLateFrames ? ":drop-late-frames" : ":no-drop-late-frames");
+        if (!usesUdp(url)) {
+            media.addOption(":rtsp-tcp");
+        } else {
+            media.addOption(":no-rtsp-tcp");
+            if (transport == TRANSPORT_MULTICAST) {
+                media.addOption(":rtsp-mcast");
+            }
+        }
+        media.setHWDecoderEnabled(usesHardware(url), decodePolicy == DECODE_HARDWARE);
+        if (decodePolicy == DECODE_SOFTWARE_CAPPED) {
+            media.addOption(":avcodec-threads=" + decodeThreads);
+        }
+        if (visibility == HIDDEN_KEYFRAMES) {
+            media.addOption(":avcodec-skip-frame=3");
+        }
+        // A new media starts with its video track on
+        disabledVideoTrack = -1;
+        return media;
+    }
+
     public static void startPlaybackInSurface(Activity activity, String url, float x, float y, float width, float height) {
         new Handler(Looper.getMainLooper()).post(() -> {
             try {
@@ -39,7 +386,7 @@ public class VlcSurfaceHelper {
                 params.leftMargin = (int) x;
                 params.topMargin = (int) y;
                 textureView.setLayoutParams(params);
-                textureView.setVisibility(View.VISIBLE);
+                textureView.setVisibility(visibility == VISIBLE ? View.VISIBLE : View.INVISIBLE);
 
                 if (libVLC == null) {
                     ArrayList<String> options = new ArrayList<>();
@@ -52,9 +399,12 @@ public class VlcSurfaceHelper {
 
                 if (mediaPlayer == null) {
                     mediaPlayer = new MediaPlayer(libVLC);
+                    mediaPlayer.setEventListener(eventListener);
                 } else {
                     mediaPlayer.stop();
-                    mediaPlayer.getVLCVout().detachViews();
+                    if (mediaPlayer.getVLCVout().areViewsAttached()) {
+                        mediaPlayer.getVLCVout().detachViews();
+                    }
                 }
 
                 mediaPlayer.getVLCVout().setVideoView(textureView);
@@ -63,34 +413,67 @@ public class VlcSurfaceHelper {
                 
                 mediaPlayer.getVLCVout().attachViews();
 
-                Media media = new Media(libVLC, Uri.parse(url));
+                Media media = createMedia(url);
                 mediaPlayer.setMedia(media);
                 media.release();
                 mediaPlayer.play();
+                superviseUrl(url);
 
                 Log.d(TAG, "Playback started at " + x + "," + y + " size " + width + "x" + height);
 
             } catch (Exception e) {
                 Log.e(TAG, "Error starting playback", e);
+                reportState(STATE_ERROR, "Error starting playback: " + e.getMessage());
             }
         });
     }
 
+    // Latest requested geometry; several calls between two main-looper turns apply only the last one
+    private static final Object geometryLock = new Object();
+    private static int pendingX, pendingY, pendingWidth, pendingHeight;
+    private static boolean geometryPending;
+
+    private static final Runnable applyGeometry = () -> {
+        int x, y, width, height;
+        synchronized (geometryLock) {
+            geometryPending = false;
+            x = pendingX;
+            y = pendingY;
+            width = pendingWidth;
+            height = pendingHeight;
+        }
+        if (textureView == null) {
+            return;
+        }
+        FrameLayout.LayoutParams params = (FrameLayout.LayoutParams) textureView.getLayoutParams();
+        if (params.width == width && params.height == height
+                && params.leftMargin == x && params.topMargin == y) {
+            return;
+        }
+        boolean resized = params.width != width || params.height != height;
+        params.width = width;
+        params.height = height;
+        params.leftMargin = x;
+        params.topMargin = y;
+        textureView.setLayoutParams(params);
+
+        if (resized && mediaPlayer != null) {
+            mediaPlayer.getVLCVout().setWindowSize(width, height);
+        }
+    };
+
     public static void updateSurfacePosition(float x, float y, float width, float height) {
-        new Handler(Looper.getMainLooper()).post(() -> {
-            if (textureView != null) {
-                FrameLayout.LayoutParams params = (FrameLayout.LayoutParams) textureView.getLayoutParams();
-                params.width = (int) width;
-                params.height = (int) height;
-                params.leftMargin = (int) x;
-                params.topMargin = (int) y;
-                textureView.setLayoutParams(params);
-                
-                if (mediaPlayer != null) {
-                    mediaPlayer.getVLCVout().setWindowSize((int) width, (int) height);
-                }
+        synchronized (geometryLock) {
+            pendingX = (int) x;
+            pendingY = (int) y;
+            pendingWidth = (int) width;
+            pendingHeight = (int) height;
+            if (geometryPending) {
+                return;
             }
-        });
+            geometryPending = true;
+        }
+        mainHandler.post(applyGeometry);
     }
 
     public static void pause() {
@@ -101,33 +484,86 @@ public class VlcSurfaceHelper {
         });
     }
 
+    public static void resume() {
+        new Handler(Looper.getMainLooper()).post(() -> {
+            if (mediaPlayer != null && currentUrl != null && !mediaPlayer.isPlaying()) {
+                mediaPlayer.play();
+            }
+        });
+    }
+
+    public static void switchTo(String url) {
+        new Handler(Looper.getMainLooper()).post(() -> {
+            try {
+                if (libVLC == null || mediaPlayer == null) {
+                    Log.w(TAG, "switchTo called without a warm player");
+                    reportState(STATE_ERROR, "switchTo called without a warm player");
+                    return;
+                }
+
+                // Reuse the engine, the player and the attached TextureView; only the media changes
+                Media media = createMedia(url);
+                mediaPlayer.setMedia(media);
+                media.release();
+                mediaPlayer.play();
+                superviseUrl(url);
+
+                if (textureView != null) {
+                    textureView.setVisibility(visibility == VISIBLE ? View.VISIBLE : View.INVISIBLE);
+                }
+
+                Log.d(TAG, "Switched to " + url);
+            } catch (Exception e) {
+                Log.e(TAG, "Error switching stream", e);
+                reportState(STATE_ERROR, "Error switching stream: " + e.getMessage());
+            }
+        });
+    }
+
     public static void stop() {
         new Handler(Looper.getMainLooper()).post(() -> {
             try {
+                // Keep LibVLC, the MediaPlayer and the TextureView warm so the next
+                // startPlaybackInSurface() does not rebuild them from scratch
+                superviseUrl(null);
                 if (mediaPlayer != null) {
                     mediaPlayer.stop();
-                    mediaPlayer.getVLCVout().detachViews();
-
-                    new Handler(Looper.getMainLooper()).postDelayed(() -> {
-                        if (mediaPlayer != null) {
-                            mediaPlayer.release();
-                            mediaPlayer = null;
-                        }
-                        if (libVLC != null) {
-                            libVLC.release();
-                            libVLC = null;
-                        }
-                        if (textureView != null) {
-                            ViewGroup parent = (ViewGroup) textureView.getParent();
-                            if (parent != null) {
-                                parent.removeView(textureView);
-                            }
-                            textureView = null;
-                        }
-                    }, 150);
+                }
+                if (textureView != null) {
+                    textureView.setVisibility(View.INVISIBLE);
                 }
             } catch (Exception e) {
                 Log.e(TAG, "Error during stop", e);
+                reportState(STATE_ERROR, "Error during stop: " + e.getMessage());
+            }
+        });
+    }
+
+    // Free the warm engine, player and view; called when the bridge goes away or the native player takes over
+    public static void release() {
+        new Handler(Looper.getMainLooper()).post(() -> {
+            try {
+                superviseUrl(null);
+                if (mediaPlayer != null) {
+                    mediaPlayer.setEventListener(null);
+                    mediaPlayer.stop();
+                    mediaPlayer.getVLCVout().detachViews();
+                    mediaPlayer.release();
+                    mediaPlayer = null;
+                }
+                if (libVLC != null) {
+                    libVLC.release();
+                    libVLC = null;
+                }
+                if (textureView != null) {
+                    ViewGroup parent = (ViewGroup) textureView.getParent();
+                    if (parent != null) {
+                        parent.removeView(textureView);
+                    }
+                    textureView = null;
+                }
+            } catch (Exception e) {
+                Log.e(TAG, "Error during release", e);
             }
         });
     }
@@ -0,0 +1,126 @@
+#include "lossyproxy.h"
+#include <QHostAddress>
+#include <QRandomGenerator>
+
+LossyProxy::LossyProxy(quint16 upstreamPort, double lossRate, QObject *parent)
+    : QObject(parent)
+    , m_upstreamPort(upstreamPort)
+    , m_lossRate(qBound(0.0, lossRate, 1.0))
+{
+    connect(&m_server, &QTcpServer::newConnection, this, &LossyProxy::onNewConnection);
+}
+
+LossyProxy::~LossyProxy()
+{
+    qDeleteAll(m_sessions);
+}
+
+bool LossyProxy::listen(quint16 port)
+{
+    return m_server.listen(QHostAddress::LocalHost, port);
+}
+
+QString LossyProxy::errorString() const
+{
+    return m_server.errorString();
+}
+
+LossyProxy::Stats LossyProxy::stats() const
+{
+    return m_stats;
+}
+
+void LossyProxy::onNewConnection()
+{
+    while (QTcpSocket *client = m_server.nextPendingConnection()) {
+        auto *session = new Session;
+        session->client = client;
+        session->upstream = new QTcpSocket(this);
+        m_sessions.append(session);
+
+        // Writes issued while the upstream is still connecting are buffered by QTcpSocket
+        // Записи, сделанные пока соединение с сервером устанавливается, буферизуются QTcpSocket
+        connect(client, &QTcpSocket::readyRead, this, [session]() {
+            if (session->upstream)
+                session->upstream->write(session->client->readAll());
+        });
+        connect(session->upstream, &QTcpSocket::readyRead, this, [this, session]() {
+            session->pending += session->upstream->readAll();
+            relayDownstream(session);
+        });
+        connect(client, &QTcpSocket::disconnected, this, [this, session]() { closeSession(session); });
+        connect(session->upstream, &QTcpSocket::disconnected, this, [this, session]() { closeSession(session); });
+        connect(session->upstream, &QTcpSocket::errorOccurred, this, [this, session]() { closeSession(session); });
+
+        session->upstream->connectToHost(QHostAddress::LocalHost, m_upstreamPort);
+    }
+}
+
+void LossyProxy::relayDownstream(Session *session)
+{
+    QByteArray &buffer = session->pending;
+    QByteArray out;
+    qsizetype pos = 0;
+
+    while (pos < buffer.size()) {
+        if (buffer.at(pos) == '$') {
+            // Interleaved packet: '$', channel, 16-bit big-endian length, payload
+            // Чередуемый пакет: '$', канал, 16-битная длина big-endian, данные
+            if (buffer.size() - pos < 4)
+                break;
+            const uchar channel = uchar(buffer.at(pos + 1));
+            const int length = (uchar(buffer.at(pos + 2)) << 8) | uchar(buffer.at(pos + 3));
+            if (buffer.size() - pos < 4 + length)
+                break;
+
+            const bool rtp = (channel % 2) == 0;
+            if (rtp && m_lossRate > 0.0 && QRandomGenerator::global()->generateDouble() < m_lossRate) {
+                ++m_stats.droppedPackets;
+            } else {
+                out.append(buffer.constData() + pos, 4 + length);
+                if (rtp)
+                    ++m_stats.forwardedPackets;
+            }
+            pos += 4 + length;
+            continue;
+        }
+
+        // RTSP response: headers up to an empty line, then Content-Length bytes of body (SDP)
+        // Ответ RTSP: заголовки до пустой строки, затем Content-Length байт тела (SDP)
+        const qsizetype headerEnd = buffer.indexOf("\r\n\r\n", pos);
+        if (headerEnd < 0)
+            break;
+        qsizetype bodyLength = 0;
+        const QList<QByteArray> lines = buffer.mid(pos, headerEnd - pos).split('\n');
+        for (const QByteArray &line : lines) {
+            const QByteArray trimmed = line.trimmed();
+            if (trimmed.toLower().startsWith("content-length:"))
+                bodyLength = trimmed.mid(15).trimmed().toLongLong();
+        }
+        const qsizetype messageEnd = headerEnd + 4 + bodyLength;
+        if (messageEnd > buffer.size())
+            break;
+        out.append(buffer.constData() + pos, messageEnd - pos);
+        pos = messageEnd;
+    }
+
+    buffer.remove(0, pos);
+    if (!out.isEmpty() && session->client)
+        session->client->write(out);
+}
+
+void LossyProxy::closeSession(Session *session)
+{
+    if (!m_sessions.removeOne(session))
+        return;
+
+    if (session->client) {
+        session->client->disconnect(this);
+        session->client->deleteLater();
+    }
+    if (session->upstream) {
+        session->upstream->disconnect(this);
+        session->upstream->deleteLater();
+    }
+    delete session;
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <QByteArray>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QTcpServer>
+#include <QTcpSocket>
+
+// LossyProxy: TCP relay in front of the test RTSP server that drops RTP packets
+// The client runs RTSP over TCP (RFC 2326 interleaving), so the relay sees RTSP text messages
+// and '$'-framed binary packets; text is always forwarded, packets on even (RTP) channels are
+// dropped with the given probability. RTCP on odd channels is kept so the session stays alive
+// LossyProxy: TCP ретранслятор перед тестовым RTSP сервером, отбрасывающий пакеты RTP
+// Клиент работает с RTSP поверх TCP (чередование RFC 2326), поэтому ретранслятор видит текстовые
+// сообщения RTSP и двоичные пакеты с префиксом '$'; текст всегда пересылается, пакеты на четных (RTP)
+// каналах отбрасываются с заданной вероятностью. RTCP на нечетных каналах сохраняется, чтобы сессия жила
+class LossyProxy : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Stats
+    {
+        qint64 forwardedPackets = 0;
+        qint64 droppedPackets = 0;
+    };
+
+    // lossRate is a probability in [0, 1]
+    // lossRate - вероятность в диапазоне [0, 1]
+    LossyProxy(quint16 upstreamPort, double lossRate, QObject *parent = nullptr);
+    ~LossyProxy() override;
+
+    bool listen(quint16 port);
+    QString errorString() const;
+
+    Stats stats() const;
+
+private:
+    // One client connection and its upstream counterpart
+    // Одно соединение клиента и его пара к серверу
+    struct Session
+    {
+        QPointer<QTcpSocket> client;
+        QPointer<QTcpSocket> upstream;
+        QByteArray pending;     // Server bytes not yet forming a complete message
+    };
+
+    void onNewConnection();
+
+    // Forward complete messages from session.pending to the client, dropping some RTP packets
+    // Переслать клиенту полные сообщения из session.pending, отбрасывая часть пакетов RTP
+    void relayDownstream(Session *session);
+
+    void closeSession(Session *session);
+
+    QTcpServer m_server;
+    quint16 m_upstreamPort;
+    double m_lossRate;
+    QList<Session *> m_sessions;
+    Stats m_stats;
+};
@@ -0,0 +1,564 @@
+// rtspbench: Headless benchmark of the playback pipeline against a loopback RTSP test source
+// The binary runs twice: the parent process drives VLCBridge / StreamSessionModel and measures,
+// a child started with --serve encodes the synthetic streams, so encoder load never pollutes
+// the client CPU figures. Results are written as JSON for regression tracking
+// rtspbench: Бенчмарк конвейера воспроизведения без интерфейса на тестовом RTSP источнике loopback
+// Бинарный файл запускается дважды: родительский процесс управляет VLCBridge / StreamSessionModel
+// и измеряет, дочерний с --serve кодирует синтетические потоки, поэтому нагрузка кодировщика
+// не искажает показатели CPU клиента. Результаты записываются в JSON для отслеживания регрессий
+
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QGuiApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QProcess>
+#include <QSysInfo>
+#include <QTextStream>
+#include <QTimer>
+#include <algorithm>
+#include <functional>
+
+#ifdef Q_OS_LINUX
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include "framebufferpool.h"
+#include "lossyproxy.h"
+#include "pixelkernels.h"
+#include "streamsessionmodel.h"
+#include "testsource.h"
+#include "vlcbridge.h"
+#include "vlcplayer.h"
+
+namespace {
+
+// A first frame later than this counts as a failed start
+// Первый кадр позже этого считается неудачным стартом
+constexpr int kFirstFrameTimeoutMs = 15000;
+
+// Pause between runs so the previous session is fully torn down
+// Пауза между прогонами, чтобы предыдущая сессия была полностью разобрана
+constexpr int kSettleMs = 500;
+
+// Steady-state sampling starts after this warm-up, once caches and decoders have settled
+// Выборка установившегося режима начинается после этого прогрева, когда кэши и декодеры устоялись
+constexpr int kWarmupMs = 3000;
+
+struct Options
+{
+    TestSource::Config source;
+    double lossPercent = 0.0;
+    int streams = 4;
+    int runs = 5;
+    int switches = 10;
+    int durationSec = 20;
+    QString output;
+};
+
+// ========== MEASUREMENT HELPERS ==========
+
+// Spin the event loop until done() holds or the timeout expires
+// Крутить цикл событий, пока done() не станет истинным или не истечет таймаут
+bool waitFor(const std::function<bool()> &done, int timeoutMs)
+{
+    if (done())
+        return true;
+
+    QElapsedTimer clock;
+    clock.start();
+    QEventLoop loop;
+    QTimer poll;
+    poll.setInterval(20);
+    QObject::connect(&poll, &QTimer::timeout, &loop, [&]() {
+        if (done() || clock.elapsed() > timeoutMs)
+            loop.quit();
+    });
+    poll.start();
+    loop.exec();
+    return done();
+}
+
+// Let the event loop run for ms without polling, so idle time costs no client CPU
+// Дать циклу событий поработать ms без опроса, чтобы простой не тратил CPU клиента
+void sleepFor(int ms)
+{
+    QEventLoop loop;
+    QTimer::singleShot(ms, &loop, &QEventLoop::quit);
+    loop.exec();
+}
+
+// User + system CPU time of this process, ms (-1 where unsupported)
+// Пользовательское + системное время CPU процесса, мс (-1, где не поддерживается)
+qint64 cpuTimeMs()
+{
+#ifdef Q_OS_LINUX
+    rusage usage {};
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+        return -1;
+    return (qint64(usage.ru_utime.tv_sec) + usage.ru_stime.tv_sec) * 1000
+        + (qint64(usage.ru_utime.tv_usec) + usage.ru_stime.tv_usec) / 1000;
+#else
+    return -1;
+#endif
+}
+
+// Resident set size of this process, KiB (-1 where unsupported)
+// Резидентный размер процесса, КиБ (-1, где не поддерживается)
+qint64 rssKb()
+{
+#ifdef Q_OS_LINUX
+    QFile statm(QStringLiteral("/proc/self/statm"));
+    if (!statm.open(QIODevice::ReadOnly))
+        return -1;
+    const QList<QByteArray> fields = statm.readAll().split(' ');
+    if (fields.size() < 2)
+        return -1;
+    return fields.at(1).toLongLong() * sysconf(_SC_PAGESIZE) / 1024;
+#else
+    return -1;
+#endif
+}
+
+// min / median / p95 / max of a sample set plus the number of failed runs
+// min / медиана / p95 / max набора замеров плюс количество неудачных прогонов
+QJsonObject summarize(QList<qint64> samples, int failures)
+{
+    QJsonObject result;
+    result[QStringLiteral("count")] = samples.size();
+    result[QStringLiteral("failures")] = failures;
+    if (samples.isEmpty())
+        return result;
+
+    std::sort(samples.begin(), samples.end());
+    const auto at = [&](double q) { return samples.at(qMin(samples.size() - 1, qsizetype(q * samples.size()))); };
+    QJsonArray raw;
+    for (qint64 sample : std::as_const(samples))
+        raw.append(sample);
+    result[QStringLiteral("minMs")] = samples.first();
+    result[QStringLiteral("medianMs")] = at(0.5);
+    result[QStringLiteral("p95Ms")] = at(0.95);
+    result[QStringLiteral("maxMs")] = samples.last();
+    result[QStringLiteral("samplesMs")] = raw;
+    return result;
+}
+
+// ========== TEST SOURCE PROCESS ==========
+
+// Two sources at least so switching has somewhere to go; more only multiplies encoder load
+// Минимум два источника, чтобы было куда переключаться; больше лишь умножает нагрузку кодировщика
+int sourceCount(const Options &options)
+{
+    return qBound(2, options.streams, 4);
+}
+
+// --serve: run the encoders (and the lossy relay) until killed
+// --serve: запустить кодировщики (и ретранслятор с потерями) до завершения процесса
+int runServer(const Options &options)
+{
+    QTextStream out(stdout);
+
+    TestSource::Config config = options.source;
+    config.streams = sourceCount(options);
+    const bool lossy = options.lossPercent > 0.0;
+    if (lossy)
+        config.port = options.source.port + 1;
+
+    TestSource source;
+    if (!source.start(config)) {
+        out << "ERROR " << source.errorString() << Qt::endl;
+        return 1;
+    }
+
+    LossyProxy proxy(config.port, options.lossPercent / 100.0);
+    if (lossy && !proxy.listen(options.source.port)) {
+        out << "ERROR " << proxy.errorString() << Qt::endl;
+        return 1;
+    }
+
+    // Relay counters are reported periodically; the client keeps the last line
+    // Счетчики ретранслятора сообщаются периодически; клиент сохраняет последнюю строку
+    QTimer statsTimer;
+    QObject::connect(&statsTimer, &QTimer::timeout, [&]() {
+        const LossyProxy::Stats stats = proxy.stats();
+        out << "STATS " << stats.forwardedPackets << ' ' << stats.droppedPackets << Qt::endl;
+    });
+    statsTimer.start(1000);
+
+    out << "READY" << Qt::endl;
+    return QCoreApplication::exec();
+}
+
+// Client side handle of the --serve child
+// Клиентская обертка над дочерним процессом --serve
+class ServerProcess
+{
+public:
+    bool start(const QStringList &arguments)
+    {
+        m_process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+        QObject::connect(&m_process, &QProcess::readyReadStandardOutput, [this]() {
+            while (m_process.canReadLine()) {
+                const QByteArray line = m_process.readLine().trimmed();
+                if (line == "READY")
+                    m_ready = true;
+                else if (line.startsWith("STATS "))
+                    m_lastStats = line.mid(6);
+                else if (line.startsWith("ERROR "))
+                    m_error = QString::fromUtf8(line.mid(6));
+            }
+        });
+        m_process.start(QCoreApplication::applicationFilePath(), QStringList{ QStringLiteral("--serve") } + arguments);
+
+        // Encoders need a moment before the RTSP server accepts DESCRIBE
+        // Кодировщикам нужно время, прежде чем RTSP сервер начнет принимать DESCRIBE
+        return waitFor([this]() { return m_ready || !m_error.isEmpty() || m_process.state() == QProcess::NotRunning; },
+                       kFirstFrameTimeoutMs)
+            && m_ready;
+    }
+
+    void stop()
+    {
+        m_process.terminate();
+        if (!m_process.waitForFinished(3000))
+            m_process.kill();
+    }
+
+    QString errorString() const
+    {
+        return m_error.isEmpty() ? QStringLiteral("test source did not start") : m_error;
+    }
+
+    QJsonObject packetStats() const
+    {
+        const QList<QByteArray> fields = m_lastStats.split(' ');
+        QJsonObject result;
+        if (fields.size() == 2) {
+            result[QStringLiteral("forwarded")] = fields.at(0).toLongLong();
+            result[QStringLiteral("dropped")] = fields.at(1).toLongLong();
+        }
+        return result;
+    }
+
+private:
+    QProcess m_process;
+    bool m_ready = false;
+    QByteArray m_lastStats;
+    QString m_error;
+};
+
+// ========== SCENARIOS ==========
+
+// Cold start (first open: engine creation, first connection) and warm restarts of one stream
+// Холодный старт (первое открытие: создание движка, первое соединение) и теплые перезапуски одного потока
+QJsonObject measureStartup(const QStringList &urls, int runs)
+{
+    VLCBridge bridge;
+    QList<qint64> warm;
+    qint64 cold = -1;
+    int failures = 0;
+
+    for (int run = 0; run < runs; ++run) {
+        qint64 startupMs = -1;
+        const QMetaObject::Connection connection =
+            QObject::connect(&bridge, &VLCBridge::startupMsChanged, [&](qint64 value) { startupMs = value; });
+
+        bridge.play(urls.first(), nullptr, 0, 0, 0, 0);
+        if (waitFor([&]() { return startupMs >= 0; }, kFirstFrameTimeoutMs)) {
+            if (run == 0)
+                cold = startupMs;
+            else
+                warm << startupMs;
+        } else {
+            ++failures;
+        }
+
+        QObject::disconnect(connection);
+        bridge.stop();
+        sleepFor(kSettleMs);
+    }
+
+    // The bridge's own split: a start counts as warm only with the engine up and the stream cached
+    // Собственное разделение моста: старт теплый, только если движок запущен, а поток есть в кэше
+    QJsonObject result = summarize(warm, failures);
+    result[QStringLiteral("coldMs")] = cold;
+    result[QStringLiteral("startup")] = QJsonObject::fromVariantMap(bridge.startupStats());
+    return result;
+}
+
+// Camera switches through the preloading standby decoder, alternating between two sources
+// Переключения камер через предзагружающий резервный декодер с чередованием двух источников
+QJsonObject measureSwitching(const QStringList &urls, int switches)
+{
+    VLCBridge bridge;
+    qint64 startupMs = -1;
+    QObject::connect(&bridge, &VLCBridge::startupMsChanged, [&](qint64 value) { startupMs = value; });
+    bridge.play(urls.at(0), nullptr, 0, 0, 0, 0);
+    if (!waitFor([&]() { return startupMs >= 0; }, kFirstFrameTimeoutMs))
+        return summarize({}, switches);
+
+    QList<qint64> samples;
+    int failures = 0;
+    for (int i = 0; i < switches; ++i) {
+        const QString target = urls.at((i + 1) % 2);
+        qint64 switchMs = -1;
+        const QMetaObject::Connection connection =
+            QObject::connect(&bridge, &VLCBridge::switchCompleted, [&](const QString &url, qint64 elapsedMs) {
+                if (url == target)
+                    switchMs = elapsedMs;
+            });
+
+        bridge.switchTo(target);
+        if (waitFor([&]() { return switchMs >= 0; }, kFirstFrameTimeoutMs))
+            samples << switchMs;
+        else
+            ++failures;
+
+        QObject::disconnect(connection);
+        sleepFor(kSettleMs);
+    }
+
+    // Switching is where control calls pile up: how long they waited for the player worker
+    // При переключении управляющие вызовы накапливаются: сколько они ждали поток обработки плееров
+    bridge.stop();
+    QJsonObject result = summarize(samples, failures);
+    result[QStringLiteral("playerQueue")] = QJsonObject::fromVariantMap(bridge.playerQueueStats());
+    return result;
+}
+
+// N concurrent tiles: CPU per stream, RSS growth and frame loss over a fixed window
+// N одновременных плиток: CPU на поток, рост RSS и потери кадров за фиксированное окно
+QJsonObject measureSteadyState(const QStringList &urls, int streams, int durationSec)
+{
+    QJsonObject result;
+    const qint64 rssBefore = rssKb();
+
+    StreamSessionModel model;
+    model.setMaxActiveDecodes(streams);
+    for (int i = 0; i < streams; ++i)
+        model.addStream(urls.at(i % urls.size()), StreamSessionModel::Full);
+
+    const auto playerAt = [&](int row) {
+        return model.data(model.index(row), StreamSessionModel::PlayerRole).value<VlcPlayer *>();
+    };
+    const auto allStarted = [&]() {
+        for (int row = 0; row < model.rowCount(); ++row) {
+            VlcPlayer *player = playerAt(row);
+            if (!player || !player->hasFrame())
+                return false;
+        }
+        return true;
+    };
+
+    if (!waitFor(allStarted, kFirstFrameTimeoutMs)) {
+        result[QStringLiteral("error")] = QStringLiteral("not every stream produced a frame");
+        model.clear();
+        return result;
+    }
+    sleepFor(kWarmupMs);
+
+    // Counters are cumulative since open(), so the window is measured as a difference
+    // Счетчики накапливаются с open(), поэтому окно измеряется как разность
+    QList<PlaybackMetrics> before;
+    for (int row = 0; row < model.rowCount(); ++row)
+        before << playerAt(row)->metrics();
+    const qint64 rssStart = rssKb();
+    const qint64 poolAllocationsStart = FrameBufferPool::shared().stats().allocations;
+    const qint64 cpuStart = cpuTimeMs();
+    QElapsedTimer wall;
+    wall.start();
+
+    sleepFor(durationSec * 1000);
+
+    const qint64 cpuMs = cpuTimeMs() - cpuStart;
+    const qint64 wallMs = wall.elapsed();
+    const qint64 rssEnd = rssKb();
+    const FrameBufferPool::Stats pool = FrameBufferPool::shared().stats();
+
+    qint64 decoded = 0;
+    qint64 dropped = 0;
+    qint64 late = 0;
+    int stalls = 0;
+    int reconnects = 0;
+    QJsonArray perStream;
+    for (int row = 0; row < model.rowCount(); ++row) {
+        const PlaybackMetrics now = playerAt(row)->metrics();
+        const PlaybackMetrics &then = before.at(row);
+        QJsonObject stream;
+        stream[QStringLiteral("decodedFrames")] = now.decodedFrames - then.decodedFrames;
+        stream[QStringLiteral("droppedFrames")] = now.droppedFrames - then.droppedFrames;
+        stream[QStringLiteral("lateFrames")] = now.lateFrames - then.lateFrames;
+        stream[QStringLiteral("stalls")] = now.stallCount - then.stallCount;
+        stream[QStringLiteral("jitterMs")] = now.jitterMs;
+        stream[QStringLiteral("decoderPath")] = now.decoderPath;
+        perStream.append(stream);
+
+        decoded += now.decodedFrames - then.decodedFrames;
+        dropped += now.droppedFrames - then.droppedFrames;
+        late += now.lateFrames - then.lateFrames;
+        stalls += now.stallCount - then.stallCount;
+        reconnects += now.reconnectCount - then.reconnectCount;
+    }
+
+    model.clear();
+
+    // CPU is reported as percent of one core, so 100 means one core fully busy
+    // CPU выражается в процентах одного ядра, 100 означает полностью занятое ядро
+    const double cpuPercent = wallMs > 0 && cpuMs >= 0 ? 100.0 * cpuMs / wallMs : -1.0;
+    result[QStringLiteral("streams")] = streams;
+    result[QStringLiteral("windowMs")] = wallMs;
+    result[QStringLiteral("cpuPercent")] = cpuPercent;
+    result[QStringLiteral("cpuPercentPerStream")] = cpuPercent >= 0 ? cpuPercent / streams : -1.0;
+    result[QStringLiteral("rssBeforeKb")] = rssBefore;
+    result[QStringLiteral("rssStartKb")] = rssStart;
+    result[QStringLiteral("rssEndKb")] = rssEnd;
+    result[QStringLiteral("rssGrowthKb")] = rssEnd - rssStart;
+    result[QStringLiteral("frameBufferAllocations")] = pool.allocations - poolAllocationsStart;
+    result[QStringLiteral("frameBufferHighWaterBytes")] = pool.highWaterBytes;
+    result[QStringLiteral("decodedFrames")] = decoded;
+    result[QStringLiteral("droppedFrames")] = dropped;
+    result[QStringLiteral("lateFrames")] = late;
+    result[QStringLiteral("stalls")] = stalls;
+    result[QStringLiteral("reconnects")] = reconnects;
+    result[QStringLiteral("perStream")] = perStream;
+    return result;
+}
+
+// ========== COMMAND LINE ==========
+
+bool parseOptions(const QCoreApplication &app, Options *options, bool *serve, QString *error)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Headless RTSP playback benchmark"));
+    parser.addHelpOption();
+
+    const QCommandLineOption serveOption(QStringLiteral("serve"), QStringLiteral("Run the test source only (internal)."));
+    const QCommandLineOption codecOption(QStringLiteral("codec"), QStringLiteral("h264 or h265."), QStringLiteral("codec"), QStringLiteral("h264"));
+    const QCommandLineOption resolutionOption(QStringLiteral("resolution"), QStringLiteral("Frame size WxH."), QStringLiteral("WxH"), QStringLiteral("1280x720"));
+    const QCommandLineOption fpsOption(QStringLiteral("fps"), QStringLiteral("Frame rate."), QStringLiteral("fps"), QStringLiteral("25"));
+    const QCommandLineOption lossOption(QStringLiteral("loss"), QStringLiteral("RTP packet loss, percent."), QStringLiteral("percent"), QStringLiteral("0"));
+    const QCommandLineOption streamsOption(QStringLiteral("streams"), QStringLiteral("Concurrent streams in the steady-state run."), QStringLiteral("count"), QStringLiteral("4"));
+    const QCommandLineOption runsOption(QStringLiteral("runs"), QStringLiteral("Time-to-first-frame runs (the first one is cold)."), QStringLiteral("count"), QStringLiteral("5"));
+    const QCommandLineOption switchesOption(QStringLiteral("switches"), QStringLiteral("Camera switches to time."), QStringLiteral("count"), QStringLiteral("10"));
+    const QCommandLineOption durationOption(QStringLiteral("duration"), QStringLiteral("Steady-state window, seconds."), QStringLiteral("seconds"), QStringLiteral("20"));
+    const QCommandLineOption portOption(QStringLiteral("port"), QStringLiteral("Loopback RTSP port."), QStringLiteral("port"), QStringLiteral("8554"));
+    const QCommandLineOption outputOption({ QStringLiteral("o"), QStringLiteral("output") }, QStringLiteral("JSON result file (default: stdout)."), QStringLiteral("file"));
+    parser.addOptions({ serveOption, codecOption, resolutionOption, fpsOption, lossOption, streamsOption,
+                        runsOption, switchesOption, durationOption, portOption, outputOption });
+    parser.process(app);
+
+    *serve = parser.isSet(serveOption);
+    options->source.codec = parser.value(codecOption).toLower();
+    if (options->source.codec == QLatin1String("hevc"))
+        options->source.codec = QStringLiteral("h265");
+    if (options->source.codec != QLatin1String("h264") && options->source.codec != QLatin1String("h265")) {
+        *error = QStringLiteral("Unsupported codec: %1").arg(options->source.codec);
+        return false;
+    }
+
+    const QStringList size = parser.value(resolutionOption).split(QLatin1Char('x'));
+    options->source.width = size.size() == 2 ? size.at(0).toInt() : 0;
+    options->source.height = size.size() == 2 ? size.at(1).toInt() : 0;
+    if (options->source.width < 16 || options->source.height < 16) {
+        *error = QStringLiteral("Bad resolution: %1").arg(parser.value(resolutionOption));
+        return false;
+    }
+
+    options->source.fps = qBound(1, parser.value(fpsOption).toInt(), 120);
+    options->source.port = quint16(parser.value(portOption).toUInt());
+    options->lossPercent = qBound(0.0, parser.value(lossOption).toDouble(), 100.0);
+    options->streams = qMax(1, parser.value(streamsOption).toInt());
+    options->runs = qMax(1, parser.value(runsOption).toInt());
+    options->switches = qMax(0, parser.value(switchesOption).toInt());
+    options->durationSec = qMax(1, parser.value(durationOption).toInt());
+    options->output = parser.value(outputOption);
+    return true;
+}
+
+// Arguments that make the --serve child generate the same streams
+// Аргументы, с которыми дочерний --serve генерирует те же потоки
+QStringList serverArguments(const Options &options)
+{
+    return {
+        QStringLiteral("--codec"), options.source.codec,
+        QStringLiteral("--resolution"), QStringLiteral("%1x%2").arg(options.source.width).arg(options.source.height),
+        QStringLiteral("--fps"), QString::number(options.source.fps),
+        QStringLiteral("--loss"), QString::number(options.lossPercent),
+        QStringLiteral("--streams"), QString::number(options.streams),
+        QStringLiteral("--port"), QString::number(options.source.port),
+    };
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    // No display on the benchmark box; frames are decoded without being shown
+    // На машине бенчмарка нет дисплея; кадры декодируются без показа
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
+    QGuiApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("rtspbench"));
+
+    Options options;
+    bool serve = false;
+    QString error;
+    if (!parseOptions(app, &options, &serve, &error)) {
+        QTextStream(stderr) << error << Qt::endl;
+        return 2;
+    }
+    if (serve)
+        return runServer(options);
+
+    ServerProcess server;
+    if (!server.start(serverArguments(options))) {
+        QTextStream(stderr) << "rtspbench: " << server.errorString() << Qt::endl;
+        server.stop();
+        return 1;
+    }
+
+    QStringList urls;
+    for (int i = 0; i < sourceCount(options); ++i)
+        urls << QStringLiteral("rtsp://127.0.0.1:%1%2").arg(options.source.port).arg(TestSource::streamPath(i));
+
+    QJsonObject config;
+    config[QStringLiteral("codec")] = options.source.codec;
+    config[QStringLiteral("width")] = options.source.width;
+    config[QStringLiteral("height")] = options.source.height;
+    config[QStringLiteral("fps")] = options.source.fps;
+    config[QStringLiteral("lossPercent")] = options.lossPercent;
+    config[QStringLiteral("streams")] = options.streams;
+    config[QStringLiteral("durationSec")] = options.durationSec;
+
+    QJsonObject report;
+    report[QStringLiteral("config")] = config;
+    report[QStringLiteral("host")] = QJsonObject{
+        { QStringLiteral("cpu"), QSysInfo::currentCpuArchitecture() },
+        { QStringLiteral("pixelKernels"), QString::fromLatin1(PixelKernels::isaName(PixelKernels::kernels().isa)) },
+        { QStringLiteral("kernel"), QSysInfo::kernelVersion() },
+        { QStringLiteral("os"), QSysInfo::prettyProductName() },
+    };
+    report[QStringLiteral("timeToFirstFrame")] = measureStartup(urls, options.runs);
+    report[QStringLiteral("switchLatency")] = measureSwitching(urls, options.switches);
+    report[QStringLiteral("steadyState")] = measureSteadyState(urls, options.streams, options.durationSec);
+    report[QStringLiteral("packets")] = server.packetStats();
+    server.stop();
+
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+    if (options.output.isEmpty()) {
+        QTextStream(stdout) << json;
+        return 0;
+    }
+    QFile file(options.output);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        QTextStream(stderr) << "rtspbench: " << file.errorString() << Qt::endl;
+        return 1;
+    }
+    file.write(json);
+    return 0;
+}
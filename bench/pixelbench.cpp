@@ -0,0 +1,305 @@
+// pixelbench: Micro-benchmark of the PixelKernels used by the CPU video path
+// Every instruction set available on this machine is timed against the scalar reference on the
+// same synthetic picture, and its output is compared with the reference byte for byte. Results are
+// written as JSON, like rtspbench, for regression tracking
+// pixelbench: Микробенчмарк ядер PixelKernels, используемых видеопутем на процессоре
+// Каждый доступный на этой машине набор инструкций замеряется против скалярного эталона на одной
+// и той же синтетической картинке, а его результат сравнивается с эталоном побайтно. Результаты
+// записываются в JSON, как у rtspbench, для отслеживания регрессий
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSize>
+#include <QStringList>
+#include <QSysInfo>
+#include <QTextStream>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "pixelkernels.h"
+
+namespace {
+
+using PixelKernels::Isa;
+using PixelKernels::Kernels;
+
+struct Options
+{
+    QSize source { 1920, 1080 };
+    QSize tile { 480, 270 };
+    int iterations = 200;
+    QString output;
+};
+
+// One decoded picture in both 4:2:0 layouts, with strides padded the way the sink pads them
+// Один декодированный кадр в обеих раскладках 4:2:0 с шагами строк, дополненными как в приемнике
+struct Picture
+{
+    explicit Picture(const QSize &size)
+        : width(size.width())
+        , height(size.height())
+        , stride((size.width() + 63) / 64 * 64)
+        , y(size_t(stride) * height)
+        , u(size_t(stride / 2) * (height / 2))
+        , v(size_t(stride / 2) * (height / 2))
+        , uv(size_t(stride) * (height / 2))
+    {
+        // Smooth gradients with noise on top, so neither the converter nor the filters see flat input
+        // Плавные градиенты с шумом поверх, чтобы ни преобразователь, ни фильтры не получали плоский вход
+        std::mt19937 random(20240611);
+        std::uniform_int_distribution<int> noise(-24, 24);
+        for (int row = 0; row < height; ++row) {
+            for (int x = 0; x < width; ++x)
+                y[size_t(row) * stride + x] = uchar(qBound(0, 16 + 219 * x / width + noise(random), 255));
+        }
+        for (int row = 0; row < height / 2; ++row) {
+            for (int x = 0; x < width / 2; ++x) {
+                const uchar cb = uchar(qBound(0, 16 + 224 * row / (height / 2) + noise(random), 255));
+                const uchar cr = uchar(qBound(0, 240 - 224 * x / (width / 2) + noise(random), 255));
+                u[size_t(row) * (stride / 2) + x] = cb;
+                v[size_t(row) * (stride / 2) + x] = cr;
+                uv[size_t(row) * stride + 2 * x] = cb;
+                uv[size_t(row) * stride + 2 * x + 1] = cr;
+            }
+        }
+    }
+
+    int width;
+    int height;
+    int stride;
+    std::vector<uchar> y;
+    std::vector<uchar> u;
+    std::vector<uchar> v;
+    std::vector<uchar> uv;
+};
+
+// One kernel call on a set of kernels, writing into out (sized by the case)
+// Один вызов ядра на наборе ядер с записью в out (размер задает случай)
+struct Case
+{
+    QString name;
+    qint64 pixels = 0;      // Destination pixels per call
+    qsizetype outBytes = 0;
+    std::function<void(const Kernels &, std::vector<uchar> &)> run;
+};
+
+// The path a frame takes in the sink for a small tile: 2x2 passes, conversion, bilinear remainder
+// Путь кадра в приемнике для маленькой плитки: проходы 2x2, преобразование, билинейный остаток
+void tilePipeline(const Kernels &k, const Picture &picture, const QSize &tile, std::vector<uchar> &out)
+{
+    static thread_local std::vector<uchar> planes[2];
+    static thread_local std::vector<uchar> rgb;
+    static thread_local std::vector<uchar> scratch;
+
+    int width = picture.width;
+    int height = picture.height;
+    const uchar *y = picture.y.data();
+    const uchar *u = picture.u.data();
+    const uchar *v = picture.v.data();
+    int yStride = picture.stride;
+    int passes = 0;
+    while ((width >> 1) >= tile.width() && (height >> 1) >= tile.height() && (width & 3) == 0 && (height & 3) == 0) {
+        const int halfWidth = width / 2;
+        const int halfHeight = height / 2;
+        const int halfStride = (halfWidth + 31) / 32 * 32;
+        std::vector<uchar> &next = planes[passes++ % 2];
+        next.resize(size_t(halfStride) * halfHeight * 3 / 2);
+        uchar *nextU = next.data() + qsizetype(halfStride) * halfHeight;
+        uchar *nextV = nextU + qsizetype(halfStride / 2) * (halfHeight / 2);
+        k.halvePlane(y, yStride, next.data(), halfStride, halfWidth, halfHeight, 1);
+        k.halvePlane(u, yStride / 2, nextU, halfStride / 2, halfWidth / 2, halfHeight / 2, 1);
+        k.halvePlane(v, yStride / 2, nextV, halfStride / 2, halfWidth / 2, halfHeight / 2, 1);
+        y = next.data();
+        u = nextU;
+        v = nextV;
+        yStride = halfStride;
+        width = halfWidth;
+        height = halfHeight;
+    }
+
+    rgb.resize(size_t(width) * 4 * height);
+    scratch.resize(size_t(PixelKernels::scaleScratchBytes(width, tile.width())));
+    k.i420ToRgb32(y, yStride, u, yStride / 2, v, yStride / 2, rgb.data(), width * 4, width, height);
+    k.scaleRgb32(rgb.data(), width * 4, width, height, out.data(), tile.width() * 4, tile.width(), tile.height(), scratch.data());
+}
+
+std::vector<Case> makeCases(const Picture &picture, const Options &options)
+{
+    const int width = picture.width;
+    const int height = picture.height;
+    const int stride = picture.stride;
+    const QSize tile = options.tile;
+
+    // Scale input: the reference conversion of the whole picture
+    // Вход масштабирования: эталонное преобразование всей картинки
+    auto rgb = std::make_shared<std::vector<uchar>>(size_t(width) * 4 * height);
+    PixelKernels::kernelsFor(Isa::Scalar)->i420ToRgb32(picture.y.data(), stride, picture.u.data(), stride / 2,
+                                                       picture.v.data(), stride / 2, rgb->data(), width * 4, width, height);
+    auto scratch = std::make_shared<std::vector<uchar>>(size_t(PixelKernels::scaleScratchBytes(width, tile.width())));
+
+    return {
+        { QStringLiteral("i420ToRgb32"), qint64(width) * height, qsizetype(width) * 4 * height,
+          [&picture, width, height, stride](const Kernels &k, std::vector<uchar> &out) {
+              k.i420ToRgb32(picture.y.data(), stride, picture.u.data(), stride / 2, picture.v.data(), stride / 2,
+                            out.data(), width * 4, width, height);
+          } },
+        { QStringLiteral("nv12ToRgb32"), qint64(width) * height, qsizetype(width) * 4 * height,
+          [&picture, width, height, stride](const Kernels &k, std::vector<uchar> &out) {
+              k.nv12ToRgb32(picture.y.data(), stride, picture.uv.data(), stride, out.data(), width * 4, width, height);
+          } },
+        { QStringLiteral("halvePlaneY"), qint64(width / 2) * (height / 2), qsizetype(width / 2) * (height / 2),
+          [&picture, width, height, stride](const Kernels &k, std::vector<uchar> &out) {
+              k.halvePlane(picture.y.data(), stride, out.data(), width / 2, width / 2, height / 2, 1);
+          } },
+        { QStringLiteral("halvePlaneUV"), qint64(width / 4) * (height / 4), qsizetype(width / 2) * (height / 4),
+          [&picture, width, height, stride](const Kernels &k, std::vector<uchar> &out) {
+              k.halvePlane(picture.uv.data(), stride, out.data(), width / 2, width / 4, height / 4, 2);
+          } },
+        { QStringLiteral("scaleRgb32"), qint64(tile.width()) * tile.height(), qsizetype(tile.width()) * 4 * tile.height(),
+          [rgb, scratch, width, height, tile](const Kernels &k, std::vector<uchar> &out) {
+              k.scaleRgb32(rgb->data(), width * 4, width, height, out.data(), tile.width() * 4,
+                           tile.width(), tile.height(), scratch->data());
+          } },
+        { QStringLiteral("tilePipeline"), qint64(tile.width()) * tile.height(), qsizetype(tile.width()) * 4 * tile.height(),
+          [&picture, tile](const Kernels &k, std::vector<uchar> &out) {
+              tilePipeline(k, picture, tile, out);
+          } },
+    };
+}
+
+// Median time per call in microseconds; a few untimed calls first warm the caches
+// Медианное время вызова в микросекундах; несколько вызовов без замера сначала прогревают кэши
+double timeCase(const Case &c, const Kernels &kernels, int iterations, std::vector<uchar> &out)
+{
+    for (int i = 0; i < 3; ++i)
+        c.run(kernels, out);
+
+    std::vector<qint64> samples;
+    samples.reserve(size_t(iterations));
+    QElapsedTimer clock;
+    for (int i = 0; i < iterations; ++i) {
+        clock.start();
+        c.run(kernels, out);
+        samples.push_back(clock.nsecsElapsed());
+    }
+    std::sort(samples.begin(), samples.end());
+    return double(samples[samples.size() / 2]) / 1000.0;
+}
+
+bool parseSize(const QString &text, QSize *size)
+{
+    const QStringList parts = text.split(QLatin1Char('x'));
+    if (parts.size() != 2)
+        return false;
+    *size = QSize(parts.at(0).toInt(), parts.at(1).toInt());
+    return size->width() >= 16 && size->height() >= 16;
+}
+
+bool parseOptions(const QCoreApplication &app, Options *options, QString *error)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Pixel conversion and scaling kernel micro-benchmark"));
+    parser.addHelpOption();
+
+    const QCommandLineOption resolutionOption(QStringLiteral("resolution"), QStringLiteral("Decoded picture size WxH."), QStringLiteral("WxH"), QStringLiteral("1920x1080"));
+    const QCommandLineOption tileOption(QStringLiteral("tile"), QStringLiteral("Tile size WxH for the scaling cases."), QStringLiteral("WxH"), QStringLiteral("480x270"));
+    const QCommandLineOption iterationsOption(QStringLiteral("iterations"), QStringLiteral("Timed calls per kernel."), QStringLiteral("count"), QStringLiteral("200"));
+    const QCommandLineOption outputOption({ QStringLiteral("o"), QStringLiteral("output") }, QStringLiteral("JSON result file (default: stdout)."), QStringLiteral("file"));
+    parser.addOptions({ resolutionOption, tileOption, iterationsOption, outputOption });
+    parser.process(app);
+
+    if (!parseSize(parser.value(resolutionOption), &options->source)) {
+        *error = QStringLiteral("Bad resolution: %1").arg(parser.value(resolutionOption));
+        return false;
+    }
+    // The conversions take even sizes, as the sink hands them
+    // Преобразования принимают четные размеры, как их передает приемник
+    options->source = QSize(options->source.width() & ~1, options->source.height() & ~1);
+    if (!parseSize(parser.value(tileOption), &options->tile) || options->tile.width() > options->source.width()
+        || options->tile.height() > options->source.height()) {
+        *error = QStringLiteral("Bad tile size: %1").arg(parser.value(tileOption));
+        return false;
+    }
+    options->iterations = qMax(1, parser.value(iterationsOption).toInt());
+    options->output = parser.value(outputOption);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("pixelbench"));
+
+    Options options;
+    QString error;
+    if (!parseOptions(app, &options, &error)) {
+        QTextStream(stderr) << error << Qt::endl;
+        return 2;
+    }
+
+    const Picture picture(options.source);
+    const std::vector<Case> cases = makeCases(picture, options);
+    const std::vector<Isa> isas = PixelKernels::supportedIsas();
+    const Kernels &reference = *PixelKernels::kernelsFor(Isa::Scalar);
+
+    QJsonArray results;
+    bool allMatch = true;
+    for (const Case &c : cases) {
+        std::vector<uchar> expected(size_t(c.outBytes));
+        const double scalarUs = timeCase(c, reference, options.iterations, expected);
+
+        QJsonObject perIsa;
+        for (Isa isa : isas) {
+            std::vector<uchar> out(size_t(c.outBytes));
+            const double us = isa == Isa::Scalar ? scalarUs : timeCase(c, *PixelKernels::kernelsFor(isa), options.iterations, out);
+            const bool matches = isa == Isa::Scalar || out == expected;
+            allMatch = allMatch && matches;
+            perIsa[QString::fromLatin1(PixelKernels::isaName(isa))] = QJsonObject{
+                { QStringLiteral("medianUs"), us },
+                { QStringLiteral("megapixelsPerSec"), us > 0.0 ? double(c.pixels) / us : 0.0 },
+                { QStringLiteral("speedup"), us > 0.0 ? scalarUs / us : 0.0 },
+                { QStringLiteral("matchesScalar"), matches },
+            };
+        }
+        results.append(QJsonObject{ { QStringLiteral("kernel"), c.name }, { QStringLiteral("isa"), perIsa } });
+    }
+
+    QJsonObject report;
+    report[QStringLiteral("config")] = QJsonObject{
+        { QStringLiteral("resolution"), QStringLiteral("%1x%2").arg(options.source.width()).arg(options.source.height()) },
+        { QStringLiteral("tile"), QStringLiteral("%1x%2").arg(options.tile.width()).arg(options.tile.height()) },
+        { QStringLiteral("iterations"), options.iterations },
+    };
+    report[QStringLiteral("host")] = QJsonObject{
+        { QStringLiteral("cpu"), QSysInfo::currentCpuArchitecture() },
+        { QStringLiteral("selected"), QString::fromLatin1(PixelKernels::isaName(PixelKernels::kernels().isa)) },
+    };
+    report[QStringLiteral("kernels")] = results;
+    report[QStringLiteral("allMatchScalar")] = allMatch;
+
+    const QByteArray json = QJsonDocument(report).toJson(QJsonDocument::Indented);
+    if (options.output.isEmpty()) {
+        QTextStream(stdout) << json;
+    } else {
+        QFile file(options.output);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            QTextStream(stderr) << "pixelbench: " << file.errorString() << Qt::endl;
+            return 1;
+        }
+        file.write(json);
+    }
+
+    // A kernel that drifts from the reference fails the run, so CI scripts notice
+    // Ядро, расходящееся с эталоном, проваливает прогон, чтобы это заметили скрипты CI
+    return allMatch ? 0 : 3;
+}
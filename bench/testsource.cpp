@@ -0,0 +1,147 @@
+#include "testsource.h"
+#include <QByteArray>
+#include <QDebug>
+#include <QFile>
+
+namespace {
+
+// The clip loops, so a handful of frames is enough; this keeps 4K clips small on disk
+// Клип зацикливается, поэтому хватает нескольких кадров; так 4K клипы занимают мало места
+constexpr int kMaxClipFrames = 12;
+
+} // namespace
+
+TestSource::TestSource() = default;
+
+TestSource::~TestSource()
+{
+    for (libvlc_media_player_t *player : m_players) {
+        libvlc_media_player_stop(player);
+        libvlc_media_player_release(player);
+    }
+    if (m_vlc)
+        libvlc_release(m_vlc);
+}
+
+QString TestSource::errorString() const
+{
+    return m_error;
+}
+
+QString TestSource::streamPath(int index)
+{
+    return QStringLiteral("/stream%1").arg(index);
+}
+
+bool TestSource::writeClip(const QString &path, const Config &config)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        m_error = file.errorString();
+        return false;
+    }
+
+    // 4:2:0 planar: full-size luma plane followed by two quarter-size chroma planes
+    // 4:2:0 планарный: яркостная плоскость полного размера и две хроматические в четверть размера
+    const int w = config.width;
+    const int h = config.height;
+    const int cw = (w + 1) / 2;
+    const int ch = (h + 1) / 2;
+    file.write(QStringLiteral("YUV4MPEG2 W%1 H%2 F%3:1 Ip A1:1 C420jpeg\n")
+                   .arg(w).arg(h).arg(config.fps).toLatin1());
+
+    const int frames = qMin(config.fps, kMaxClipFrames);
+    QByteArray frame(w * h + 2 * cw * ch, Qt::Uninitialized);
+    for (int n = 0; n < frames; ++n) {
+        uchar *y = reinterpret_cast<uchar *>(frame.data());
+        uchar *u = y + w * h;
+        uchar *v = u + cw * ch;
+
+        // Diagonal gradient scrolling by a few pixels per frame, plus a box crossing the picture
+        // Диагональный градиент, сдвигающийся на несколько пикселей за кадр, и пересекающий кадр прямоугольник
+        const int shift = n * 8;
+        const int boxSize = qMax(16, h / 6);
+        const int boxX = (w - boxSize) * n / qMax(1, frames - 1);
+        const int boxY = (h - boxSize) / 2;
+        for (int row = 0; row < h; ++row) {
+            for (int col = 0; col < w; ++col) {
+                const bool inBox = col >= boxX && col < boxX + boxSize && row >= boxY && row < boxY + boxSize;
+                y[row * w + col] = inBox ? 235 : uchar(16 + ((row + col + shift) & 0xff) * 219 / 255);
+            }
+        }
+        for (int row = 0; row < ch; ++row) {
+            for (int col = 0; col < cw; ++col) {
+                u[row * cw + col] = uchar(128 + ((col + shift) & 0x3f) - 32);
+                v[row * cw + col] = uchar(128 + ((row + shift) & 0x3f) - 32);
+            }
+        }
+
+        file.write("FRAME\n");
+        file.write(frame);
+    }
+    return true;
+}
+
+QString TestSource::soutChain(const Config &config, int index)
+{
+    // One key frame per second, no B-frames: what an IP camera usually sends
+    // Один ключевой кадр в секунду, без B-кадров: то, что обычно отправляет IP камера
+    const QString encoder = config.codec == QLatin1String("h265")
+        ? QStringLiteral("vcodec=hevc,venc=x265")
+        : QStringLiteral("vcodec=h264,venc=x264{preset=ultrafast,tune=zerolatency,keyint=%1,bframes=0}")
+              .arg(config.fps);
+
+    return QStringLiteral(":sout=#transcode{%1,fps=%2,acodec=none}:rtp{sdp=rtsp://127.0.0.1:%3%4}")
+        .arg(encoder)
+        .arg(config.fps)
+        .arg(config.port)
+        .arg(streamPath(index));
+}
+
+bool TestSource::start(const Config &config)
+{
+    if (!m_dir.isValid()) {
+        m_error = QStringLiteral("Cannot create a temporary directory");
+        return false;
+    }
+
+    const QString clip = m_dir.filePath(QStringLiteral("clip.y4m"));
+    if (!writeClip(clip, config))
+        return false;
+
+    const char *const args[] = { "--no-audio", "--quiet" };
+    m_vlc = libvlc_new(int(std::size(args)), args);
+    if (!m_vlc) {
+        m_error = QStringLiteral("libvlc_new failed");
+        return false;
+    }
+
+    for (int i = 0; i < config.streams; ++i) {
+        libvlc_media_t *media = libvlc_media_new_path(m_vlc, clip.toUtf8().constData());
+        if (!media) {
+            m_error = QStringLiteral("Cannot open %1").arg(clip);
+            return false;
+        }
+
+        // Loop the clip forever and keep the stream output alive across loops
+        // Зациклить клип навсегда и сохранять потоковый вывод между повторами
+        libvlc_media_add_option(media, soutChain(config, i).toUtf8().constData());
+        libvlc_media_add_option(media, ":sout-keep");
+        libvlc_media_add_option(media, ":input-repeat=65535");
+
+        libvlc_media_player_t *player = libvlc_media_player_new_from_media(media);
+        libvlc_media_release(media);
+        if (!player || libvlc_media_player_play(player) != 0) {
+            const char *msg = libvlc_errmsg();
+            m_error = msg ? QString::fromUtf8(msg) : QStringLiteral("Cannot start stream %1").arg(i);
+            if (player)
+                libvlc_media_player_release(player);
+            return false;
+        }
+        m_players.push_back(player);
+    }
+
+    qDebug() << "TestSource:" << config.streams << config.codec << "streams"
+             << config.width << "x" << config.height << "@" << config.fps << "fps on port" << config.port;
+    return true;
+}
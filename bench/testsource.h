@@ -0,0 +1,53 @@
+#pragma once
+
+#include <QString>
+#include <QTemporaryDir>
+#include <vlc/vlc.h>
+#include <vector>
+
+// TestSource: Loopback RTSP server used by the benchmark, built on libvlc stream output
+// A short synthetic Y4M clip (moving gradient and box) is looped, encoded to H.264 or H.265
+// and served as rtsp://127.0.0.1:<port>/stream<N>; no camera, network or GPU is needed
+// TestSource: RTSP сервер на loopback для бенчмарка, построенный на потоковом выводе libvlc
+// Короткий синтетический Y4M клип (движущийся градиент и прямоугольник) зацикливается, кодируется
+// в H.264 или H.265 и раздается как rtsp://127.0.0.1:<port>/stream<N>; камера, сеть и GPU не нужны
+class TestSource
+{
+public:
+    struct Config
+    {
+        QString codec = QStringLiteral("h264");     // "h264" or "h265"
+        int width = 1280;
+        int height = 720;
+        int fps = 25;
+        int streams = 2;                            // Number of independent encoded streams
+        quint16 port = 8554;
+    };
+
+    TestSource();
+    ~TestSource();
+
+    // Generate the clip and start one encoder per stream; returns false with errorString() set
+    // Сгенерировать клип и запустить по кодировщику на поток; возвращает false с заполненным errorString()
+    bool start(const Config &config);
+
+    QString errorString() const;
+
+    // URL path of stream index, e.g. "/stream0"
+    // Путь URL потока с номером index, например "/stream0"
+    static QString streamPath(int index);
+
+private:
+    // Write a looping YUV4MPEG2 clip of a few frames with motion in every frame
+    // Записать зацикливаемый клип YUV4MPEG2 из нескольких кадров с движением в каждом кадре
+    bool writeClip(const QString &path, const Config &config);
+
+    // Stream output chain for one stream
+    // Цепочка потокового вывода для одного потока
+    static QString soutChain(const Config &config, int index);
+
+    libvlc_instance_t *m_vlc = nullptr;
+    std::vector<libvlc_media_player_t *> m_players;
+    QTemporaryDir m_dir;
+    QString m_error;
+};
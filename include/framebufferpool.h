@@ -0,0 +1,108 @@
+#pragma once
+
+#include <QMutex>
+#include <QSize>
+#include <QtGlobal>
+#include <vector>
+
+// FrameBufferPool: Reusable aligned picture buffers for the video output path
+// Buffers are keyed by pixel format, resolution and row stride. Released buffers stay idle in
+// their bucket and are handed out again to the next player negotiating the same format, so
+// reconnects, camera switches and steady playback do not touch the heap. Idle memory is bounded:
+// when a resolution change leaves buffers of the old size behind, the least recently used
+// buckets are freed first
+// FrameBufferPool: Повторно используемые выровненные буферы кадров для пути видеовывода
+// Буферы группируются по формату пикселей, разрешению и шагу строки. Освобожденные буферы
+// остаются в своей корзине и снова выдаются следующему плееру с тем же форматом, поэтому
+// переподключения, переключения камер и установившееся воспроизведение не обращаются к куче.
+// Простаивающая память ограничена: когда смена разрешения оставляет буферы старого размера,
+// первыми освобождаются давно не использованные корзины
+class FrameBufferPool
+{
+public:
+    // Buffer layout; a buffer holds stride * size.height() bytes
+    // Раскладка буфера; буфер вмещает stride * size.height() байт
+    struct Key
+    {
+        quint32 fourcc = 0;
+        QSize size;
+        int stride = 0;
+
+        qsizetype bytes() const { return qsizetype(stride) * size.height(); }
+        bool operator==(const Key &other) const
+        {
+            return fourcc == other.fourcc && size == other.size && stride == other.stride;
+        }
+    };
+
+    struct Stats
+    {
+        qint64 allocations = 0;         // Heap allocations since start; flat during steady playback
+        qint64 reuses = 0;              // acquire() calls served from an idle buffer
+        qint64 evictions = 0;           // Idle buffers freed to stay within the idle budget
+        int buffersInUse = 0;
+        int buffersIdle = 0;
+        qint64 bytesInUse = 0;
+        qint64 bytesIdle = 0;
+        int highWaterBuffers = 0;       // Peak of buffersInUse + buffersIdle
+        qint64 highWaterBytes = 0;      // Peak of bytesInUse + bytesIdle
+    };
+
+    // Buffers start on this boundary, so rows padded to it stay cache-line aligned
+    // Буферы начинаются на этой границе, поэтому дополненные до нее строки выровнены по кэш-линиям
+    static constexpr int kAlignment = 64;
+
+    explicit FrameBufferPool(qint64 idleBudgetBytes = 64 * 1024 * 1024);
+    ~FrameBufferPool();
+
+    FrameBufferPool(const FrameBufferPool &) = delete;
+    FrameBufferPool &operator=(const FrameBufferPool &) = delete;
+
+    // Process-wide pool shared by every VideoFrameSink
+    // Общий на процесс пул, разделяемый всеми VideoFrameSink
+    static FrameBufferPool &shared();
+
+    // Return a buffer for key, reusing an idle one when possible; thread-safe
+    // Вернуть буфер для key, по возможности повторно используя простаивающий; потокобезопасно
+    uchar *acquire(const Key &key);
+
+    // Give a buffer obtained with the same key back to the pool
+    // Вернуть в пул буфер, полученный с тем же ключом
+    void release(const Key &key, uchar *buffer);
+
+    // Upper bound of idle memory kept for reuse
+    // Верхняя граница простаивающей памяти, сохраняемой для повторного использования
+    void setIdleBudgetBytes(qint64 bytes);
+    qint64 idleBudgetBytes() const;
+
+    // Free every idle buffer, e.g. when the application goes to the background
+    // Освободить все простаивающие буферы, например при уходе приложения в фон
+    void trim();
+
+    Stats stats() const;
+
+private:
+    struct Bucket
+    {
+        Key key;
+        std::vector<uchar *> idle;
+        int inUse = 0;
+        quint64 lastUsed = 0;
+    };
+
+    Bucket *bucketFor(const Key &key);
+
+    // Free idle buffers, least recently used buckets first, until idle memory fits budget
+    // Освобождать простаивающие буферы, начиная с давно не использованных корзин, пока память не уложится в бюджет
+    void evictTo(qint64 budget);
+
+    // Forget buckets that have neither idle nor in-use buffers
+    // Забыть корзины, в которых нет ни простаивающих, ни используемых буферов
+    void dropEmptyBuckets();
+
+    mutable QMutex m_mutex;
+    std::vector<Bucket> m_buckets;
+    qint64 m_idleBudgetBytes;
+    quint64 m_tick = 0;
+    Stats m_stats;
+};
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QImage>
+#include <QMutex>
+#include <QSize>
+#include <QWaitCondition>
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class QThread;
+
+// FrameConsumer: Receiver of decoded frames registered with a FrameTap (motion detection, analytics)
+// consumeFrame() runs on a worker thread owned by the tap, one thread per consumer
+// FrameConsumer: Получатель декодированных кадров, зарегистрированный в FrameTap (детекция движения, аналитика)
+// consumeFrame() выполняется в рабочем потоке, принадлежащем отводу, по одному потоку на потребителя
+class FrameConsumer
+{
+public:
+    // A frame prepared for one consumer
+    // Кадр, подготовленный для одного потребителя
+    struct Frame
+    {
+        // Pixels in the requested size and format, backed by a buffer of the tap's ring. Keeping a copy
+        // past consumeFrame() is allowed but makes the tap allocate a new buffer when the slot is reused
+        // Пиксели в запрошенном размере и формате в буфере кольца отвода. Сохранять копию после
+        // consumeFrame() можно, но тогда отвод выделит новый буфер при повторном использовании слота
+        QImage image;
+        qint64 sequence = 0;        // Frames shown by the player since the tap started
+        qint64 timestampMs = 0;     // Monotonic time the frame was displayed
+    };
+
+    virtual ~FrameConsumer() = default;
+    virtual void consumeFrame(const Frame &frame) = 0;
+};
+
+// FrameTap: Hands frames already decoded for display to registered consumers
+// The player's display callback converts each frame into a free buffer of the consumer's ring
+// (downscale, pixel format, rate limit) and wakes the consumer's thread. Ring buffers are allocated
+// once per size and format; when every buffer is still queued or in use the frame is dropped for
+// that consumer, so a slow consumer never stalls playback and never causes an allocation
+// FrameTap: Передает кадры, уже декодированные для показа, зарегистрированным потребителям
+// Колбэк показа плеера преобразует каждый кадр в свободный буфер кольца потребителя
+// (уменьшение, формат пикселей, ограничение частоты) и будит поток потребителя. Буферы кольца
+// выделяются один раз на размер и формат; если все буферы еще в очереди или в работе, кадр для этого
+// потребителя отбрасывается, поэтому медленный потребитель не тормозит воспроизведение и не вызывает выделений
+class FrameTap
+{
+public:
+    // What a consumer wants to receive
+    // Что потребитель хочет получать
+    struct Request
+    {
+        // Bounding box; the frame is downscaled keeping its aspect ratio, never upscaled.
+        // An empty size delivers frames at decoded resolution
+        // Ограничивающий прямоугольник; кадр уменьшается с сохранением пропорций и никогда не
+        // увеличивается. Пустой размер доставляет кадры в декодированном разрешении
+        QSize maxSize;
+
+        // Format_RGB32, Format_RGB888 or Format_Grayscale8; anything else is delivered as Format_RGB32
+        // Format_RGB32, Format_RGB888 или Format_Grayscale8; все прочее доставляется как Format_RGB32
+        QImage::Format format = QImage::Format_RGB32;
+
+        // Upper bound of the delivery rate, 0 for every displayed frame
+        // Верхняя граница частоты доставки, 0 - каждый показанный кадр
+        double maxFps = 0.0;
+
+        // Buffers in the consumer's ring (2..8)
+        // Буферов в кольце потребителя (2..8)
+        int ringSize = 3;
+    };
+
+    // Per-consumer counters
+    // Счетчики потребителя
+    struct Stats
+    {
+        qint64 delivered = 0;       // Frames passed to consumeFrame()
+        qint64 dropped = 0;         // Frames lost because the ring was full (consumer too slow)
+        qint64 rateSkipped = 0;     // Frames skipped by the maxFps limit
+        qint64 allocations = 0;     // Ring buffer (re)allocations: once per size or format change
+    };
+
+    FrameTap();
+    ~FrameTap();
+
+    FrameTap(const FrameTap &) = delete;
+    FrameTap &operator=(const FrameTap &) = delete;
+
+    // Register consumer and start its thread; returns an id for unsubscribe(). The consumer must
+    // stay alive until unsubscribe() returns
+    // Зарегистрировать потребителя и запустить его поток; возвращает id для unsubscribe().
+    // Потребитель должен жить, пока unsubscribe() не вернет управление
+    int subscribe(FrameConsumer *consumer, const Request &request);
+
+    // Stop delivering to the consumer; waits for a consumeFrame() call in progress,
+    // so it must not be called from consumeFrame() itself
+    // Прекратить доставку потребителю; ждет завершения выполняемого вызова consumeFrame(),
+    // поэтому не должен вызываться из самого consumeFrame()
+    void unsubscribe(int id);
+
+    Stats stats(int id) const;
+
+    // Whether anyone is subscribed; lets the display path skip the tap cheaply
+    // Есть ли подписчики; позволяет пути показа дешево пропускать отвод
+    bool isActive() const;
+
+    // Smallest bounding box that covers every consumer's maxSize; empty when a consumer wants the
+    // decoded resolution or nobody is subscribed
+    // Наименьший ограничивающий прямоугольник, покрывающий maxSize всех потребителей; пустой, если
+    // потребителю нужно декодированное разрешение или подписчиков нет
+    QSize requiredSize() const;
+
+    // Called from the video output thread with a displayed RV32 frame
+    // Вызывается из потока видеовывода с показанным кадром RV32
+    void deliver(const uchar *data, const QSize &size, int stride);
+
+private:
+    struct Subscription;
+
+    // Consumer thread: hand queued frames to the consumer in display order
+    // Поток потребителя: передавать кадры из очереди потребителю в порядке показа
+    static void run(Subscription *subscription);
+
+    // Scale and convert one RV32 frame into target (nearest-neighbour, no allocation)
+    // Масштабировать и преобразовать один кадр RV32 в target (ближайший сосед, без выделений)
+    static void convert(const uchar *data, const QSize &size, int stride,
+                        const std::vector<int> &columns, QImage *target);
+
+    mutable QMutex m_mutex;
+    std::vector<std::unique_ptr<Subscription>> m_subscriptions;
+    std::atomic<int> m_subscriberCount {0};
+    int m_nextId = 1;
+    qint64 m_sequence = 0;
+    QElapsedTimer m_clock;
+};
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include "playbackmetrics.h"
+
+// LatencyController: Picks the caching (jitter buffer) size and late-frame policy of a stream
+// from its measured jitter and underruns. Grows quickly after a stall, shrinks slowly while the
+// link stays clean, and only recommends a change when it is large enough to be worth a retune
+// LatencyController: Выбирает размер кэширования (джиттер-буфера) и политику опоздавших кадров
+// потока по измеренному джиттеру и опустошениям буфера. Быстро растет после остановки, медленно
+// уменьшается, пока канал чист, и рекомендует изменение, только если оно стоит перенастройки
+class LatencyController
+{
+public:
+    // Bounds of the caching the controller may choose, ms
+    // Границы кэширования, которое может выбрать контроллер, мс
+    static constexpr int kMinCachingMs = 40;
+    static constexpr int kMaxCachingMs = 1000;
+
+    // Caching used right after a reset, ms
+    // Кэширование сразу после сброса, мс
+    static constexpr int kInitialCachingMs = 150;
+
+    explicit LatencyController(int cachingMs = kInitialCachingMs);
+
+    // Feed one metrics sample of the stream; returns true when cachingMs()/dropLateFrames()
+    // changed and the stream should be retuned
+    // Передать одну выборку метрик потока; возвращает true, если cachingMs()/dropLateFrames()
+    // изменились и поток нужно перенастроить
+    bool update(const PlaybackMetrics &metrics);
+
+    // Recommended caching for network and live inputs, ms
+    // Рекомендуемое кэширование для сетевых и живых источников, мс
+    int cachingMs() const;
+
+    // Drop frames that arrive too late to be shown on time (used for small buffers)
+    // Отбрасывать кадры, пришедшие слишком поздно для своевременного показа (для малых буферов)
+    bool dropLateFrames() const;
+
+    // Forget the stall history of the previous media, e.g. after a retune reopened the stream
+    // Забыть историю остановок предыдущего медиа, например после переоткрытия потока при перенастройке
+    void restartMeasurement();
+
+private:
+    int m_cachingMs;
+    int m_lastStallCount = 0;
+
+    // Time since the last stall or change; shrinking waits for a quiet period
+    // Время с последней остановки или изменения; уменьшение ждет спокойного периода
+    QElapsedTimer m_quietTimer;
+};
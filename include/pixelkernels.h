@@ -0,0 +1,161 @@
+#pragma once
+
+#include <QtGlobal>
+#include <vector>
+
+// PixelKernels: Pixel format conversion and downscaling for the CPU video path
+// libvlc hands the sink planar I420 or semi-planar NV12 pictures; they are shrunk toward the tile
+// size with 2x2 box passes on the planes, converted to Format_RGB32 (BT.601, limited range) and
+// resampled bilinearly to the exact output size. Every instruction set produces the same bytes
+// as the scalar reference, the fastest one the CPU supports is picked on first use
+// PixelKernels: Преобразование формата пикселей и уменьшение для видеопути на процессоре
+// libvlc передает приемнику планарные I420 или полупланарные NV12 кадры; они уменьшаются к размеру
+// плитки проходами 2x2 по плоскостям, преобразуются в Format_RGB32 (BT.601, ограниченный диапазон)
+// и билинейно масштабируются до точного выходного размера. Все наборы инструкций дают те же байты,
+// что и скалярный эталон; самый быстрый из поддерживаемых процессором выбирается при первом вызове
+namespace PixelKernels {
+
+enum class Isa { Scalar, Sse41, Avx2, Neon };
+
+// One implementation of every kernel; widths and heights are in pixels of the destination unless
+// stated otherwise, strides in bytes. Any width is accepted, vector loops finish with scalar tails
+// Одна реализация каждого ядра; ширина и высота в пикселях приемника, если не указано иное,
+// шаги строк в байтах. Принимается любая ширина, векторные циклы завершаются скалярными хвостами
+struct Kernels
+{
+    Isa isa = Isa::Scalar;
+
+    // 4:2:0 with separate U and V planes into 0xffRRGGBB words; width and height are even
+    // 4:2:0 с отдельными плоскостями U и V в слова 0xffRRGGBB; ширина и высота четные
+    void (*i420ToRgb32)(const uchar *y, int yStride, const uchar *u, int uStride, const uchar *v, int vStride,
+                        uchar *dst, int dstStride, int width, int height) = nullptr;
+
+    // 4:2:0 with an interleaved UV plane into 0xffRRGGBB words; width and height are even
+    // 4:2:0 с чередующейся плоскостью UV в слова 0xffRRGGBB; ширина и высота четные
+    void (*nv12ToRgb32)(const uchar *y, int yStride, const uchar *uv, int uvStride,
+                        uchar *dst, int dstStride, int width, int height) = nullptr;
+
+    // Average 2x2 blocks of an 8-bit plane with pixelBytes 1 (Y, U, V) or 2 (interleaved UV); the
+    // source is 2*width x 2*height. Rows first, then columns, both rounding up like pavgb
+    // Усреднить блоки 2x2 8-битной плоскости с pixelBytes 1 (Y, U, V) или 2 (чередующиеся UV);
+    // источник размером 2*width x 2*height. Сначала строки, затем столбцы, оба с округлением вверх как pavgb
+    void (*halvePlane)(const uchar *src, int srcStride, uchar *dst, int dstStride,
+                       int width, int height, int pixelBytes) = nullptr;
+
+    // Bilinear resample of RGB32 with pixel centres aligned and 8-bit weights; source and
+    // destination are at least 2x2. scratch holds scaleScratchBytes() bytes
+    // Билинейное масштабирование RGB32 с выровненными центрами пикселей и 8-битными весами; источник
+    // и приемник не меньше 2x2. scratch вмещает scaleScratchBytes() байт
+    void (*scaleRgb32)(const uchar *src, int srcStride, int srcWidth, int srcHeight,
+                       uchar *dst, int dstStride, int dstWidth, int dstHeight, uchar *scratch) = nullptr;
+};
+
+// Scratch for scaleRgb32(): the column table followed by one vertically blended source line
+// Рабочий буфер для scaleRgb32(): таблица столбцов, за ней одна смешанная по вертикали строка источника
+inline qsizetype scaleScratchBytes(int srcWidth, int dstWidth)
+{
+    return qsizetype(dstWidth) * 2 * qsizetype(sizeof(int)) + qsizetype(srcWidth) * 4;
+}
+
+// Kernels for this CPU, chosen once; RTSPSTREAM_PIXEL_ISA=scalar|sse4.1|avx2|neon narrows the choice
+// Ядра для этого процессора, выбираются один раз; RTSPSTREAM_PIXEL_ISA=scalar|sse4.1|avx2|neon сужает выбор
+const Kernels &kernels();
+
+// Kernels of one instruction set, nullptr when it is not built in or the CPU lacks it
+// Ядра одного набора инструкций; nullptr, если он не собран или процессор его не поддерживает
+const Kernels *kernelsFor(Isa isa);
+
+// Instruction sets usable here, scalar first
+// Наборы инструкций, доступные здесь, скалярный первым
+std::vector<Isa> supportedIsas();
+
+const char *isaName(Isa isa);
+
+// Pixel arithmetic shared by every implementation, so their output stays bit-exact
+// Арифметика пикселей, общая для всех реализаций, чтобы их результат совпадал побитно
+namespace detail {
+
+// BT.601 limited range in 6-bit fixed point: 1.164, 1.596, 0.391, 0.813, 2.018. Luma gets half a
+// step more (74.5) so that 235 still reaches 255
+// BT.601 ограниченный диапазон в фиксированной точке с 6 битами: 1.164, 1.596, 0.391, 0.813, 2.018.
+// Яркость получает еще полшага (74.5), чтобы 235 по-прежнему давало 255
+constexpr int kYScale = 74;
+constexpr int kVToR = 102;
+constexpr int kUToG = 25;
+constexpr int kVToG = 52;
+constexpr int kUToB = 129;
+
+inline uchar clampByte(int value)
+{
+    return uchar(value < 0 ? 0 : value > 255 ? 255 : value);
+}
+
+inline quint32 yuvToRgb32(int y, int u, int v)
+{
+    const int luma = (y - 16) * kYScale + ((y - 16) >> 1) + 32;
+    u -= 128;
+    v -= 128;
+    const int r = (luma + kVToR * v) >> 6;
+    const int g = (luma - kUToG * u - kVToG * v) >> 6;
+    const int b = (luma + kUToB * u) >> 6;
+    return 0xff000000u | (quint32(clampByte(r)) << 16) | (quint32(clampByte(g)) << 8) | clampByte(b);
+}
+
+inline int average(int a, int b)
+{
+    return (a + b + 1) >> 1;
+}
+
+// Source position of destination index i in 1/256 pixel; first index and its right/lower weight.
+// The last source index is never first, so both neighbours can always be read
+// Позиция в источнике для индекса приемника i в 1/256 пикселя; первый индекс и вес правого/нижнего.
+// Последний индекс источника никогда не бывает первым, поэтому оба соседа всегда читаются
+inline void samplePosition(int i, int srcLength, int dstLength, int *first, int *weight)
+{
+    const qint64 position = ((2 * qint64(i) + 1) * srcLength * 256) / (2 * qint64(dstLength)) - 128;
+    const int clamped = int(qMax<qint64>(0, position));
+    *first = clamped >> 8;
+    *weight = clamped & 0xff;
+    if (*first >= srcLength - 1) {
+        *first = srcLength - 2;
+        *weight = 256;
+    }
+}
+
+inline int blend(int a, int b, int weight)
+{
+    return (a * (256 - weight) + b * weight + 128) >> 8;
+}
+
+// Fill scratch with { first, weight } per destination column; returns the line buffer after it
+// Заполнить scratch парами { first, weight } для каждого столбца приемника; возвращает буфер строки за ними
+inline uchar *columnTable(int srcWidth, int dstWidth, uchar *scratch)
+{
+    auto *table = reinterpret_cast<int *>(scratch);
+    for (int x = 0; x < dstWidth; ++x)
+        samplePosition(x, srcWidth, dstWidth, &table[2 * x], &table[2 * x + 1]);
+    return scratch + qsizetype(dstWidth) * 2 * qsizetype(sizeof(int));
+}
+
+// Scalar remainders used by the vector loops for the last columns of a row
+// Скалярные остатки, которыми векторные циклы обрабатывают последние столбцы строки
+void i420RowTail(const uchar *y, const uchar *u, const uchar *v, quint32 *dst, int from, int width);
+void nv12RowTail(const uchar *y, const uchar *uv, quint32 *dst, int from, int width);
+void halveRowTail(const uchar *row0, const uchar *row1, uchar *dst, int from, int width, int pixelBytes);
+void blendRowsTail(const uchar *row0, const uchar *row1, uchar *dst, int from, int bytes, int weight);
+void blendColumnsTail(const uchar *row, const int *table, quint32 *dst, int from, int width);
+
+// Per-instruction-set tables; the vector ones live in pixelkernels_<isa>.cpp, built only for their target
+// Таблицы наборов инструкций; векторные находятся в pixelkernels_<isa>.cpp и собираются только для своей цели
+const Kernels &scalarKernels();
+#ifdef RTSPSTREAM_PIXEL_X86
+const Kernels &sse41Kernels();
+const Kernels &avx2Kernels();
+#endif
+#ifdef RTSPSTREAM_PIXEL_NEON
+const Kernels &neonKernels();
+#endif
+
+} // namespace detail
+
+} // namespace PixelKernels
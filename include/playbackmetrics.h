@@ -0,0 +1,127 @@
+#pragma once
+
+#include <QObject>
+#include <QVariantMap>
+#include <QtQml/qqmlregistration.h>
+
+// PlaybackMetrics: Snapshot of latency and throughput figures of one stream
+// Filled by VlcPlayer from libvlc media statistics, player events and frame timing;
+// available in QML as vlcBridge.metrics.<name>
+// PlaybackMetrics: Снимок показателей задержки и пропускной способности одного потока
+// Заполняется VlcPlayer из статистики медиа libvlc, событий плеера и тайминга кадров;
+// доступен в QML как vlcBridge.metrics.<имя>
+struct PlaybackMetrics
+{
+    Q_GADGET
+    QML_VALUE_TYPE(playbackMetrics)
+
+    // Time from open() to the first decoded frame, ms (-1 until measured)
+    // Время от open() до первого декодированного кадра, мс (-1 до измерения)
+    Q_PROPERTY(qint64 timeToFirstFrameMs MEMBER timeToFirstFrameMs)
+
+    // The connection started warm: engine already up and the stream known from an earlier
+    // session (see SessionCache); cold and warm first frame times are aggregated there
+    // Соединение стартовало тепло: движок уже запущен, а поток известен по прошлой сессии
+    // (см. SessionCache); времена первого кадра холодных и теплых стартов собираются там
+    Q_PROPERTY(bool warmStart MEMBER warmStart)
+
+    // Estimated delay between receiving and showing a frame: configured caching plus
+    // the backlog the player has accumulated since the first frame, ms
+    // Оценка задержки между приемом и показом кадра: заданное кэширование плюс
+    // отставание, накопленное плеером с первого кадра, мс
+    Q_PROPERTY(qint64 bufferingDelayMs MEMBER bufferingDelayMs)
+
+    // Fill level reported by the last libvlc buffering event, percent
+    // Уровень заполнения из последнего события буферизации libvlc, проценты
+    Q_PROPERTY(float bufferingPercent MEMBER bufferingPercent)
+
+    // Times playback fell back into buffering after it had started (underruns)
+    // Сколько раз воспроизведение возвращалось в буферизацию после старта (опустошения буфера)
+    Q_PROPERTY(int stallCount MEMBER stallCount)
+
+    // Frame counters since open()
+    // Счетчики кадров с момента open()
+    Q_PROPERTY(qint64 decodedFrames MEMBER decodedFrames)
+    Q_PROPERTY(qint64 displayedFrames MEMBER displayedFrames)
+    Q_PROPERTY(qint64 droppedFrames MEMBER droppedFrames)
+    Q_PROPERTY(qint64 lateFrames MEMBER lateFrames)
+
+    // Bitrates over the last sampling interval, kbit/s
+    // Битрейты за последний интервал выборки, кбит/с
+    Q_PROPERTY(double inputBitrateKbps MEMBER inputBitrateKbps)
+    Q_PROPERTY(double demuxBitrateKbps MEMBER demuxBitrateKbps)
+
+    // Smoothed deviation of frame inter-arrival time from its running mean, ms (RFC 3550 style)
+    // Сглаженное отклонение интервала прихода кадров от его скользящего среднего, мс (как в RFC 3550)
+    Q_PROPERTY(double jitterMs MEMBER jitterMs)
+
+    // Demuxer error counters (corrupted blocks and stream discontinuities)
+    // Счетчики ошибок демультиплексора (поврежденные блоки и разрывы потока)
+    Q_PROPERTY(qint64 corruptedBlocks MEMBER corruptedBlocks)
+    Q_PROPERTY(qint64 discontinuities MEMBER discontinuities)
+
+    // Automatic reconnects since open(): recovered outages and reopen attempts that failed
+    // Автоматические переподключения с open(): восстановленные обрывы и неудачные попытки переоткрытия
+    Q_PROPERTY(int reconnectCount MEMBER reconnectCount)
+    Q_PROPERTY(int failedReconnects MEMBER failedReconnects)
+
+    // Outage durations: the ongoing one (0 while healthy), the last recovered one and their total, ms
+    // Длительности обрывов: текущего (0, пока все в порядке), последнего восстановленного и их сумма, мс
+    Q_PROPERTY(qint64 outageMs MEMBER outageMs)
+    Q_PROPERTY(qint64 lastOutageMs MEMBER lastOutageMs)
+    Q_PROPERTY(qint64 totalOutageMs MEMBER totalOutageMs)
+
+    // Decoder path the stream ended up on (see VlcPlayer::decoderPath())
+    // Путь декодирования, на котором оказался поток (см. VlcPlayer::decoderPath())
+    Q_PROPERTY(QString decoderPath MEMBER decoderPath)
+
+    // RTP transport the stream runs on (see VlcPlayer::transportPath()) and how often it fell back
+    // from UDP to TCP since open()
+    // Транспорт RTP, на котором идет поток (см. VlcPlayer::transportPath()), и сколько раз он
+    // откатывался с UDP на TCP с open()
+    Q_PROPERTY(QString transport MEMBER transport)
+    Q_PROPERTY(int transportFallbacks MEMBER transportFallbacks)
+
+    // Work shed while the picture was hidden (see VlcPlayer::Visibility): the mode in effect, time
+    // spent hidden, frames decoded but never rendered, and an estimate of the frames not decoded at
+    // all compared to the visible decode rate. Counted since open(), across visibility reopens
+    // Работа, сброшенная, пока картинка была скрыта (см. VlcPlayer::Visibility): действующий режим,
+    // время в скрытом состоянии, кадры, декодированные, но не отрисованные, и оценка кадров, не
+    // декодированных вовсе, по сравнению с видимым темпом. Считаются с open(), через переоткрытия видимости
+    Q_PROPERTY(QString visibility MEMBER visibility)
+    Q_PROPERTY(qint64 hiddenMs MEMBER hiddenMs)
+    Q_PROPERTY(qint64 rendersSkipped MEMBER rendersSkipped)
+    Q_PROPERTY(qint64 decodesSkipped MEMBER decodesSkipped)
+
+public:
+    // Flat key/value form for logging and dashboard exporters
+    // Плоская форма ключ/значение для логирования и экспорта в дашборды
+    QVariantMap toVariantMap() const;
+
+    qint64 timeToFirstFrameMs = -1;
+    bool warmStart = false;
+    qint64 bufferingDelayMs = 0;
+    float bufferingPercent = 0.0f;
+    int stallCount = 0;
+    qint64 decodedFrames = 0;
+    qint64 displayedFrames = 0;
+    qint64 droppedFrames = 0;
+    qint64 lateFrames = 0;
+    double inputBitrateKbps = 0.0;
+    double demuxBitrateKbps = 0.0;
+    double jitterMs = 0.0;
+    qint64 corruptedBlocks = 0;
+    qint64 discontinuities = 0;
+    int reconnectCount = 0;
+    int failedReconnects = 0;
+    qint64 outageMs = 0;
+    qint64 lastOutageMs = 0;
+    qint64 totalOutageMs = 0;
+    QString decoderPath;
+    QString transport;
+    int transportFallbacks = 0;
+    QString visibility;
+    qint64 hiddenMs = 0;
+    qint64 rendersSkipped = 0;
+    qint64 decodesSkipped = 0;
+};
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QPointer>
+#include <QSemaphore>
+#include <QString>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <vlc/vlc.h>
+
+class QObject;
+class QThread;
+class VlcPlayer;
+
+// PlayerWorker: Thread that performs the libvlc player calls which may block on the decoder
+// libvlc stops the previous input synchronously when a media is set or stopped, which can take
+// hundreds of milliseconds. VlcPlayer keeps its state and bookkeeping on the GUI thread and only
+// posts commands here through a lock-free multi-producer queue, so a caller never waits for libvlc.
+// Commands that pile up while the worker is busy are collapsed per player into the final intent:
+// only the last play or stop is applied, and a play of the media that is already running is not
+// applied at all, so play -> stop -> play of the same stream keeps the session
+// PlayerWorker: Поток, выполняющий вызовы плеера libvlc, которые могут блокироваться на декодере
+// libvlc синхронно останавливает предыдущий вход при установке медиа или остановке, что может занять
+// сотни миллисекунд. VlcPlayer хранит свое состояние и учет в потоке GUI и лишь отправляет сюда
+// команды через неблокирующую очередь с несколькими производителями, поэтому вызывающий никогда не
+// ждет libvlc. Команды, накопившиеся, пока поток занят, сворачиваются для каждого плеера в итоговое
+// намерение: применяется только последний запуск или остановка, а запуск уже идущего медиа не
+// применяется вовсе, поэтому запуск -> остановка -> запуск того же потока сохраняет сессию
+class PlayerWorker
+{
+public:
+    // The libvlc player a command is for, the VlcPlayer told about the outcome of play() (may be
+    // gone by then), the number of its commands not yet applied and the generation of the media
+    // the worker last set, which tags the player events
+    // Плеер libvlc, которому адресована команда, VlcPlayer, которому сообщается результат play()
+    // (к тому времени его может уже не быть), число его еще не примененных команд и поколение
+    // медиа, последним установленного потоком обработки, которым помечаются события плеера
+    struct Target
+    {
+        libvlc_media_player_t *player = nullptr;
+        QPointer<VlcPlayer> owner;
+        std::shared_ptr<std::atomic<int>> pending = std::make_shared<std::atomic<int>>(0);
+        std::shared_ptr<std::atomic<int>> generation = std::make_shared<std::atomic<int>>(0);
+    };
+
+    struct Stats
+    {
+        int depth = 0;              // Commands posted and not yet taken by the worker
+        int highWaterDepth = 0;
+        qint64 posted = 0;
+        qint64 applied = 0;         // Commands that reached libvlc
+        qint64 coalesced = 0;       // Dropped because a later command of the same player superseded them
+        qint64 restartsSkipped = 0; // Plays whose media was already running
+        double lastLatencyMs = 0.0; // From post to the start of execution
+        double meanLatencyMs = 0.0;
+        double maxLatencyMs = 0.0;
+        double meanApplyMs = 0.0;   // Time spent inside libvlc per applied command
+        double maxApplyMs = 0.0;
+    };
+
+    PlayerWorker();
+    ~PlayerWorker();
+
+    PlayerWorker(const PlayerWorker &) = delete;
+    PlayerWorker &operator=(const PlayerWorker &) = delete;
+
+    // Process-wide worker shared by every VlcPlayer; started on first use
+    // Общий на процесс поток, разделяемый всеми VlcPlayer; запускается при первом использовании
+    static PlayerWorker &shared();
+
+    // Set media (the reference is handed over) and start it. key identifies the media and its
+    // options; unless restart is set, a play whose key is already running is skipped. The owner
+    // learns the outcome through VlcPlayer::onStartApplied() with generation
+    // Установить медиа (ссылка передается) и запустить его. key определяет медиа и его параметры;
+    // если restart не задан, запуск с уже идущим key пропускается. Владелец узнает результат через
+    // VlcPlayer::onStartApplied() с generation
+    void play(const Target &target, libvlc_media_t *media, const QString &key, bool restart, int generation);
+    void stop(const Target &target);
+    void setPaused(const Target &target, bool paused);
+    void setMuted(const Target &target, bool muted);
+
+    // Turn the video track off (remembering it) or back on; the track of a new media starts on
+    // Выключить видеодорожку (запомнив ее) или включить обратно; дорожка нового медиа включена
+    void setVideoEnabled(const Target &target, bool enabled);
+
+    // Stop and release the player after everything posted before, then delete sink, the object
+    // its video callbacks decode into, on the thread it belongs to
+    // Остановить и освободить плеер после всего, что отправлено раньше, затем удалить sink, объект,
+    // в который декодируют его видео-колбэки, в потоке, которому он принадлежит
+    void release(const Target &target, QObject *sink);
+
+    Stats stats() const;
+
+private:
+    struct Command;
+
+    // What the worker last applied to one libvlc player; only touched on the worker thread
+    // Что поток обработки последним применил к одному плееру libvlc; используется только в его потоке
+    struct PlayerState
+    {
+        QString key;                // Media started by the last applied play, empty after a stop
+        int disabledTrack = -1;     // Video track turned off by setVideoEnabled(false)
+    };
+
+    // Multi-producer single-consumer queue (intrusive, after D. Vyukov): producers only swap the
+    // head, the worker walks from the tail
+    // Очередь с несколькими производителями и одним потребителем (интрузивная, по Д. Вьюкову):
+    // производители только меняют голову, поток обработки идет от хвоста
+    void push(Command *command);
+    Command *pop();
+
+    void post(Command *command);
+    void run();
+
+    // Collapse one drained batch and apply what is left, player by player
+    // Свернуть одну извлеченную пачку и применить оставшееся, плеер за плеером
+    void applyBatch(std::vector<Command *> &batch);
+    void apply(Command *command);
+    void discard(Command *command);
+
+    // Fold the latency and the libvlc time of one applied command into the statistics
+    // Учесть задержку и время в libvlc одной примененной команды в статистике
+    void account(double latencyMs, double applyMs, bool restartSkipped);
+
+    std::atomic<Command *> m_head;
+    Command *m_tail = nullptr;
+    std::unique_ptr<Command> m_stub;
+    QSemaphore m_wake;
+    std::atomic<int> m_depth { 0 };
+    std::atomic<int> m_highWaterDepth { 0 };
+    std::atomic<qint64> m_posted { 0 };
+    QThread *m_thread = nullptr;
+    QHash<libvlc_media_player_t *, PlayerState> m_players;
+
+    mutable QMutex m_statsMutex;
+    Stats m_stats;
+};
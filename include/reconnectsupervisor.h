@@ -0,0 +1,111 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+
+class VlcPlayer;
+
+// ReconnectSupervisor: Watches one VlcPlayer and brings its stream back after an outage
+// An outage is a stall (no new frame or frozen media time while playing), a connection that
+// produces no frame in time, or an Ended/Error state. Retries reopen the stream on the same
+// libvlc player, video sink and engine and are spaced by jittered exponential backoff
+// ReconnectSupervisor: Следит за одним VlcPlayer и восстанавливает его поток после обрыва
+// Обрыв - это зависание (нет новых кадров или замерло время медиа во время воспроизведения),
+// соединение, не выдавшее кадр вовремя, или состояние Ended/Error. Повторы переоткрывают поток
+// на том же плеере libvlc, приемнике видео и движке с экспоненциальной задержкой со случайным разбросом
+class ReconnectSupervisor : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Outage bookkeeping since the last arm()
+    // Учет обрывов с последнего arm()
+    struct Stats
+    {
+        int reconnectCount = 0;         // Outages that ended with a frame on screen again
+        int failedAttempts = 0;         // Reopen attempts that did not produce a frame
+        qint64 currentOutageMs = 0;     // Duration of the ongoing outage (0 while healthy)
+        qint64 lastOutageMs = 0;        // Duration of the last recovered outage
+        qint64 totalOutageMs = 0;       // Sum of all recovered outages
+    };
+
+    // The supervisor is owned by the player it watches
+    // Супервизор принадлежит плееру, за которым следит
+    explicit ReconnectSupervisor(VlcPlayer *player);
+
+    // Start watching a freshly opened stream and clear the statistics
+    // Начать следить за только что открытым потоком и сбросить статистику
+    void arm();
+
+    // Stop watching and cancel a pending retry (the stream was stopped on purpose)
+    // Прекратить наблюдение и отменить ожидающий повтор (поток остановлен намеренно)
+    void disarm();
+
+    // Time without a new frame or media time progress that counts as a stall, ms
+    // Время без нового кадра или продвижения времени медиа, считающееся зависанием, мс
+    void setStallTimeoutMs(int ms);
+    int stallTimeoutMs() const;
+
+    Stats stats() const;
+
+signals:
+    // A reopen is scheduled in delayMs; attempt counts from 1 within the current outage
+    // Переоткрытие запланировано через delayMs; attempt считается с 1 в пределах текущего обрыва
+    void reconnectScheduled(int attempt, int delayMs);
+
+    // The stream is back; outageMs - time from detecting the outage to the first new frame
+    // Поток восстановлен; outageMs - время от обнаружения обрыва до первого нового кадра
+    void reconnected(qint64 outageMs);
+
+private slots:
+    // Periodic health check of the watched player
+    // Периодическая проверка состояния наблюдаемого плеера
+    void check();
+
+    // Backoff expired: reopen the stream
+    // Задержка истекла: переоткрыть поток
+    void retry();
+
+private:
+    void onStateChanged();
+    void onFirstFrame();
+
+    // Enter the outage state (once) and schedule the first retry
+    // Войти в состояние обрыва (однократно) и запланировать первый повтор
+    void beginOutage(const char *reason);
+
+    // Schedule the next retry after a jittered exponential delay
+    // Запланировать следующий повтор после экспоненциальной задержки с разбросом
+    void scheduleRetry();
+    int backoffDelayMs(int attempt) const;
+
+    // Forget the progress reference points (after open, resume or a retry)
+    // Сбросить опорные точки прогресса (после открытия, возобновления или повтора)
+    void resetProgress();
+
+    VlcPlayer *m_player;
+    bool m_armed = false;
+    int m_stallTimeoutMs;
+
+    QTimer m_checkTimer;
+    QTimer m_retryTimer;
+
+    // Progress tracking: last seen frame counter and media time, and how long each stood still
+    // Отслеживание прогресса: последние счетчик кадров и время медиа и как долго каждый стоял
+    qint64 m_lastFrames = -1;
+    qint64 m_lastMediaTimeMs = -1;
+    QElapsedTimer m_frameClock;
+    QElapsedTimer m_mediaTimeClock;
+
+    // Time since the current connection attempt (arm() or the last retry) started
+    // Время с начала текущей попытки соединения (arm() или последний повтор)
+    QElapsedTimer m_attemptClock;
+
+    // Valid while an outage is in progress
+    // Действителен, пока идет обрыв
+    QElapsedTimer m_outageClock;
+    int m_attempt = 0;
+
+    Stats m_stats;
+};
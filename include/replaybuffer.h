@@ -0,0 +1,161 @@
+#pragma once
+
+#include "tspipe.h"
+#include "vlcplayer.h"
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QWaitCondition>
+#include <atomic>
+#include <deque>
+#include <vector>
+
+class QThread;
+
+// ReplayBuffer: Memory-bounded ring of the compressed stream over the last N seconds, for instant replay
+// The live player duplicates its elementary streams, without transcoding, into an MPEG-TS mux whose
+// output is a named pipe (see streamOutput()). A reader thread keeps whole transport stream packets in a
+// fixed ring and indexes the key frames by arrival time. A replay player opens the ring through libvlc
+// media callbacks (see mediaCallbacks()) starting at the key frame chosen by prepareReader(), so a seek
+// is a lookup in the index plus a local reopen: the RTSP session of the live player is never touched
+// ReplayBuffer: Ограниченное по памяти кольцо сжатого потока за последние N секунд для мгновенного повтора
+// Живой плеер дублирует свои элементарные потоки без перекодирования в мультиплексор MPEG-TS, выход
+// которого - именованный канал (см. streamOutput()). Поток чтения хранит целые пакеты транспортного потока
+// в кольце фиксированного размера и индексирует ключевые кадры по времени прихода. Плеер повтора открывает
+// кольцо через колбэки медиа libvlc (см. mediaCallbacks()), начиная с ключевого кадра, выбранного
+// prepareReader(), поэтому перемотка - это поиск по индексу и локальное переоткрытие: RTSP сессия живого
+// плеера не затрагивается
+class ReplayBuffer : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Config
+    {
+        int windowSeconds = 30;                 // Key frames older than this are forgotten
+        qint64 maxBytes = 32LL * 1024 * 1024;   // Ring capacity; bounds memory whatever the bitrate
+    };
+
+    struct Stats
+    {
+        qint64 bytesReceived = 0;   // Transport stream bytes taken from the pipe
+        qint64 bytesBuffered = 0;   // Bytes currently held by the ring
+        qint64 bytesSkipped = 0;    // Bytes thrown away while resynchronising on packet boundaries
+        int keyFrames = 0;          // Key frames in the index
+        qint64 availableMs = 0;     // How far back a replay can start right now
+        int readers = 0;            // Replay players reading the ring
+        int readerResyncs = 0;      // Readers overtaken by the live edge and moved to the oldest key frame
+    };
+
+    explicit ReplayBuffer(QObject *parent = nullptr);
+    ~ReplayBuffer() override;
+
+    // Create the pipe, allocate the ring and start the reader thread; on failure emits error()
+    // Создать канал, выделить кольцо и запустить поток чтения; при неудаче выпускает error()
+    bool start(const Config &config);
+
+    // Stop the reader thread and free the ring. The live player must have stopped writing into
+    // streamOutput() and the replay player must have been stopped first
+    // Остановить поток чтения и освободить кольцо. Живой плеер должен сначала прекратить запись
+    // в streamOutput(), а плеер повтора - быть остановлен
+    void stop();
+
+    bool isActive() const;
+
+    // Change the window of a running buffer; the ring keeps its size
+    // Изменить окно работающего буфера; кольцо сохраняет свой размер
+    void setWindowSeconds(int seconds);
+
+    // Stream output chain for VlcPlayer::setStreamOutputs(): MPEG-TS mux into the pipe
+    // Цепочка потокового вывода для VlcPlayer::setStreamOutputs(): мультиплексор MPEG-TS в канал
+    QString streamOutput() const;
+
+    // Forget everything buffered so far, e.g. when the live player opens another stream
+    // Забыть все накопленное, например, когда живой плеер открывает другой поток
+    void clear();
+
+    // Milliseconds on the clock key frames are stamped with
+    // Миллисекунды по часам, которыми помечаются ключевые кадры
+    qint64 nowMs() const;
+
+    // Pick the key frame at or before msBehindLive (the oldest one if the window is shorter) for the
+    // next reader opened through mediaCallbacks(); returns its arrival time on nowMs()'s clock, -1 if
+    // no key frame has been buffered yet
+    // Выбрать ключевой кадр на msBehindLive назад или раньше (самый старый, если окно короче) для
+    // следующего читателя, открытого через mediaCallbacks(); возвращает время его прихода по часам
+    // nowMs(), -1, если ни один ключевой кадр еще не накоплен
+    qint64 prepareReader(qint64 msBehindLive);
+
+    // Callbacks for VlcPlayer::openCallbacks(); every open reads on its own cursor
+    // Колбэки для VlcPlayer::openCallbacks(); каждое открытие читает своим курсором
+    VlcPlayer::MediaCallbacks mediaCallbacks();
+
+    // Make the readers waiting at the live edge return end-of-stream, so the replay player can be
+    // stopped without blocking; readers opened afterwards are not affected
+    // Заставить читателей, ждущих у живого края, вернуть конец потока, чтобы плеер повтора можно было
+    // остановить без блокировки; открытые после этого читатели не затрагиваются
+    void interruptReaders();
+
+    Stats stats() const;
+
+signals:
+    void error(const QString &message);
+
+private:
+    struct KeyFrame
+    {
+        qint64 offset;      // Absolute byte offset of its first packet
+        qint64 arrivalMs;   // nowMs() when it arrived
+    };
+
+    // One replay player's cursor into the ring, created by the open callback
+    // Курсор одного плеера повтора в кольце, создается колбэком открытия
+    struct Reader
+    {
+        ReplayBuffer *buffer = nullptr;
+        qint64 position = 0;
+        std::vector<uchar> tables;   // PAT/PMT served ahead of the ring data
+        size_t tablesRead = 0;
+        bool interrupted = false;
+    };
+
+    static int openReader(void *opaque, void **datap, uint64_t *sizep);
+    static ssize_t readReader(void *opaque, unsigned char *buffer, size_t length);
+    static void closeReader(void *opaque);
+
+    // Reader thread: pipe -> ring, indexing key frames
+    // Поток чтения: канал -> кольцо с индексацией ключевых кадров
+    void readLoop();
+
+    // Store one 188-byte packet; called with m_mutex held
+    // Сохранить один 188-байтный пакет; вызывается с захваченным m_mutex
+    void appendPacket(const uchar *packet, qint64 now);
+
+    // Drop key frames overwritten by the ring or older than the window; called with m_mutex held
+    // Удалить ключевые кадры, перезаписанные кольцом или старше окна; вызывается с захваченным m_mutex
+    void trimIndex(qint64 now);
+
+    qint64 oldestOffset() const;
+
+    Config m_config;
+    TsPipe m_pipe;
+    QThread *m_thread = nullptr;
+    std::atomic<bool> m_stopping {false};
+    QElapsedTimer m_clock;
+
+    // Ring addressed by absolute byte offsets: offset o lives at o % capacity while
+    // o >= m_written - capacity. Guarded by m_mutex
+    // Кольцо с адресацией по абсолютным смещениям: смещение o лежит в o % capacity, пока
+    // o >= m_written - capacity. Защищено m_mutex
+    mutable QMutex m_mutex;
+    QWaitCondition m_dataAvailable;
+    std::vector<char> m_ring;
+    qint64 m_written = 0;
+    std::deque<KeyFrame> m_keyFrames;
+    std::vector<uchar> m_pat;
+    std::vector<uchar> m_pmt;
+    int m_pmtPid = -1;
+    qint64 m_nextReaderOffset = -1;
+    std::vector<Reader *> m_readers;
+    Stats m_stats;
+};
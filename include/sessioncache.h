@@ -0,0 +1,130 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QSize>
+#include <QString>
+#include <QtGlobal>
+
+// SessionCache: What earlier sessions learned about each stream URL, shared by every VlcPlayer
+// A repeat open of a URL hands libvlc the resolved address instead of the host name, starts on
+// the decoder path and RTP transport that worked last time and sizes the RTSP frame buffer for
+// the known resolution, so the first key frame is not truncated. An entry that leads to a failed
+// open is dropped and the next attempt starts cold. First frame times are kept apart for cold and
+// warm starts
+// SessionCache: Что предыдущие сессии узнали о каждом URL потока; общий для всех VlcPlayer
+// Повторное открытие URL передает libvlc разрешенный адрес вместо имени хоста, начинает с пути
+// декодирования и транспорта RTP, сработавших в прошлый раз, и задает размер буфера кадра RTSP под
+// известное разрешение, чтобы первый ключевой кадр не обрезался. Запись, приведшая к неудачному
+// открытию, удаляется, и следующая попытка стартует холодной. Времена первого кадра хранятся
+// отдельно для холодных и теплых стартов
+class SessionCache
+{
+public:
+    // Parameters of one stream as seen by its last session
+    // Параметры одного потока, какими их видела последняя сессия
+    struct Entry
+    {
+        QString address;            // Resolved host address; empty for IP literals or until resolved
+        QString transport;          // RTP transport the session ran on: "tcp", "udp" or "multicast"
+        QString videoCodec;         // libvlc fourcc of the video track, e.g. "h264", "hevc"
+        QString audioCodec;         // libvlc fourcc of the audio track, empty without audio
+        QSize videoSize;
+        double frameRate = 0.0;
+        bool hardwareFailed = false;    // DecodeAuto gave up on the hardware decoder for this stream
+        bool udpFailed = false;         // No UDP packets arrived; TransportAuto starts on TCP
+        qint64 coldFirstFrameMs = -1;   // Last first frame time of a cold / warm start
+        qint64 warmFirstFrameMs = -1;
+        qint64 hits = 0;
+
+        // True once a session got as far as a decoded frame and filled in the stream parameters
+        // True, когда сессия дошла до декодированного кадра и заполнила параметры потока
+        bool isLearned() const { return !videoSize.isEmpty(); }
+    };
+
+    struct Stats
+    {
+        int entries = 0;
+        qint64 hits = 0;            // Starts that found a learned entry
+        qint64 misses = 0;
+        qint64 invalidations = 0;   // Entries dropped after a failed open
+        qint64 lookups = 0;         // Host name lookups finished
+        qint64 coldStarts = 0;      // First frames of cold / warm starts and their times, ms
+        qint64 warmStarts = 0;
+        qint64 lastColdMs = -1;
+        qint64 lastWarmMs = -1;
+        double meanColdMs = 0.0;
+        double meanWarmMs = 0.0;
+    };
+
+    // Resolved addresses are trusted for this long; the stream parameters until an open fails
+    // Разрешенным адресам доверяют столько времени; параметрам потока - пока открытие не сорвется
+    static constexpr qint64 kAddressTtlMs = 5 * 60 * 1000;
+
+    // Least recently used entries beyond this are forgotten
+    // Давно не использованные записи сверх этого числа забываются
+    static constexpr int kMaxEntries = 64;
+
+    SessionCache() = default;
+
+    SessionCache(const SessionCache &) = delete;
+    SessionCache &operator=(const SessionCache &) = delete;
+
+    // Process-wide cache shared by every VlcPlayer
+    // Общий на процесс кэш, разделяемый всеми VlcPlayer
+    static SessionCache &shared();
+
+    // Copy the entry of url into entry; returns false and counts a miss when nothing was learned yet
+    // Скопировать запись url в entry; возвращает false и учитывает промах, если еще ничего не известно
+    bool lookup(const QString &url, Entry *entry);
+
+    // MRL to hand to libvlc: url with its host replaced by a fresh resolved address, otherwise url
+    // MRL для передачи libvlc: url с хостом, замененным свежим разрешенным адресом, иначе url
+    QString mrlFor(const QString &url) const;
+
+    // Look up the host of url in the background unless it is an IP literal or already fresh;
+    // must be called from a thread with an event loop
+    // Разрешить хост url в фоне, если это не IP-литерал и адрес еще не свежий;
+    // вызывать из потока с циклом событий
+    void resolve(const QString &url);
+
+    // Store what a session found out after its first frame; the address and the first frame
+    // times of the entry are kept
+    // Сохранить то, что сессия выяснила после первого кадра; адрес и времена первого кадра записи сохраняются
+    void learn(const QString &url, const Entry &learned);
+
+    // Forget url after an open that used its entry failed
+    // Забыть url после того, как открытие с его записью не удалось
+    void invalidate(const QString &url);
+
+    // Count the first frame of a start of url
+    // Учесть первый кадр старта url
+    void recordFirstFrame(const QString &url, bool warm, qint64 elapsedMs);
+
+    void clear();
+    Stats stats() const;
+
+private:
+    struct Slot
+    {
+        Entry entry;
+        QElapsedTimer resolvedAt;
+        quint64 lastUsed = 0;
+    };
+
+    // Entry of url, created on demand; evicts the least recently used one when full
+    // Запись url, создаваемая по требованию; вытесняет давно не использованную при заполнении
+    Slot &slotFor(const QString &url);
+
+    // Store the outcome of a host lookup started by resolve()
+    // Сохранить результат разрешения хоста, запущенного resolve()
+    void resolved(const QString &host, const QString &address);
+
+    mutable QMutex m_mutex;
+    QHash<QString, Slot> m_slots;
+    QSet<QString> m_pendingHosts;
+    quint64 m_tick = 0;
+    Stats m_stats;
+};
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QImage>
+#include <QObject>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <vector>
+
+class QTimer;
+class VideoFrameSink;
+class VlcPlayer;
+
+// SnapshotService: Still images of streams for camera pickers, without disturbing what is on screen
+// A stream that is already playing gives its last displayed frame (copied, not taken from the
+// renderer). Any other stream is probed: a muted, keyframe-only player connects, decodes the first
+// key frame and disconnects. Encoding to JPEG or PNG runs on a small thread pool, results are cached
+// for a TTL, and requests for a URL that is already being captured wait for that capture
+// SnapshotService: Неподвижные кадры потоков для выбора камер, не мешая тому, что на экране
+// Уже играющий поток отдает свой последний показанный кадр (копию, не забирая его у рендерера).
+// Любой другой поток зондируется: заглушенный плеер, декодирующий только ключевые кадры, подключается,
+// декодирует первый ключевой кадр и отключается. Кодирование в JPEG или PNG выполняется в небольшом
+// пуле потоков, результаты кэшируются на время TTL, а запросы URL, который уже снимается, ждут этого снимка
+class SnapshotService : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Format {
+        Jpeg,
+        Png
+    };
+
+    struct Config
+    {
+        QSize maxSize = QSize(320, 180);    // Bounding box, aspect ratio kept, never upscaled
+        Format format = Jpeg;
+        int quality = 80;                   // JPEG quality, 0..100
+        int ttlMs = 30000;                  // How long a snapshot is served from the cache
+        int probeTimeoutMs = 8000;          // Give up on a stream that shows no key frame by then
+        int maxProbes = 2;                  // Streams connected at the same time; the rest queue
+    };
+
+    struct Stats
+    {
+        int requests = 0;       // Calls to request()
+        int cacheHits = 0;      // Answered from the cache
+        int merged = 0;         // Joined a capture already in progress for the URL
+        int liveGrabs = 0;      // Taken from a playing stream
+        int probes = 0;         // Short keyframe-only connections
+        int failures = 0;       // Probes that timed out or failed, and empty encodings
+        int encoded = 0;        // Images encoded
+    };
+
+    explicit SnapshotService(QObject *parent = nullptr);
+    ~SnapshotService() override;
+
+    void setConfig(const Config &config);
+    Config config() const;
+
+    // Ask for a snapshot of url; the answer comes through ready() or failed(), from the cache
+    // (queued, never synchronous) or once captured. liveSink is the sink of a player already showing
+    // url, or nullptr to probe the stream; a live sink without a frame yet fails instead of probing
+    // Запросить снимок url; ответ приходит через ready() или failed() из кэша (в очереди, никогда
+    // синхронно) или после съемки. liveSink - приемник плеера, уже показывающего url, или nullptr,
+    // чтобы зондировать поток; живой приемник без кадра завершается ошибкой, а не зондированием
+    void request(const QString &url, VideoFrameSink *liveSink = nullptr);
+
+    // Encoded snapshot of url if it is still fresh, otherwise empty
+    // Закодированный снимок url, если он еще свежий, иначе пусто
+    QByteArray cached(const QString &url) const;
+
+    // MIME type of the encoded images ("image/jpeg" or "image/png")
+    // MIME тип закодированных изображений ("image/jpeg" или "image/png")
+    QString mimeType() const;
+
+    // Drop every cached snapshot
+    // Удалить все кэшированные снимки
+    void clear();
+
+    Stats stats() const;
+
+signals:
+    void ready(const QString &url, const QByteArray &data);
+    void failed(const QString &url, const QString &message);
+
+private:
+    struct Entry
+    {
+        QByteArray data;
+        QElapsedTimer age;
+    };
+
+    // A warm player used for keyframe-only connections; url is empty while it is free
+    // Прогретый плеер для подключений только по ключевым кадрам; url пуст, пока он свободен
+    struct Probe
+    {
+        VlcPlayer *player = nullptr;
+        QTimer *timeout = nullptr;
+        QString url;
+    };
+
+    // Hand queued URLs to free probes
+    // Передать URL из очереди свободным зондам
+    void startProbes();
+    void finishProbe(int index, const QImage &frame, const QString &message);
+
+    // Scale and encode image on the pool; the result comes back through onEncoded()
+    // Масштабировать и закодировать image в пуле; результат возвращается через onEncoded()
+    void encode(const QString &url, const QImage &image);
+    void onEncoded(const QString &url, const QByteArray &data);
+    void fail(const QString &url, const QString &message);
+
+    Config m_config;
+    Stats m_stats;
+    QHash<QString, Entry> m_cache;
+    QStringList m_inFlight;         // URLs being captured or encoded
+    QStringList m_probeQueue;       // URLs waiting for a free probe
+    std::vector<Probe> m_probes;    // Created on demand up to maxProbes, then reused
+    QThreadPool m_pool;
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include "tspipe.h"
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QWaitCondition>
+#include <atomic>
+#include <vector>
+
+class QFile;
+class QThread;
+
+// StreamRecorder: Writes the compressed streams of a playing session to rotating MPEG-TS segments
+// The player duplicates its elementary streams, without transcoding, into an MPEG-TS mux whose output
+// is a named pipe (see streamOutput()). A reader thread drains the pipe into a bounded ring so libvlc
+// never waits on the disk; a writer thread cuts the transport stream into segments at key frames,
+// repeats PAT/PMT at the start of each file so every segment plays on its own, and deletes the
+// oldest segments beyond maxSegments. When the disk falls behind and the ring fills up, data is
+// dropped and backpressure is reported instead of stalling playback
+// StreamRecorder: Записывает сжатые потоки воспроизводимой сессии в сменяющиеся сегменты MPEG-TS
+// Плеер дублирует свои элементарные потоки без перекодирования в мультиплексор MPEG-TS, выход
+// которого - именованный канал (см. streamOutput()). Поток чтения вычерпывает канал в ограниченное
+// кольцо, поэтому libvlc никогда не ждет диск; поток записи режет транспортный поток на сегменты по
+// ключевым кадрам, повторяет PAT/PMT в начале каждого файла, чтобы каждый сегмент воспроизводился
+// сам по себе, и удаляет самые старые сегменты сверх maxSegments. Когда диск отстает и кольцо
+// заполняется, данные отбрасываются и сообщается о противодавлении вместо остановки воспроизведения
+class StreamRecorder : public QObject
+{
+    Q_OBJECT
+
+public:
+    struct Config
+    {
+        QString directory;                              // Created if missing
+        QString prefix = QStringLiteral("record");      // Segment file name prefix
+        int segmentSeconds = 60;                        // Target segment length
+        qint64 segmentMaxBytes = 512LL * 1024 * 1024;   // Hard cap of one segment
+        int maxSegments = 0;                            // Oldest segments are deleted beyond this; 0 keeps all
+        int bufferBytes = 8 * 1024 * 1024;              // Ring between the pipe and the disk
+    };
+
+    struct Stats
+    {
+        qint64 bytesWritten = 0;        // Bytes stored in segment files
+        qint64 bytesDropped = 0;        // Bytes lost because the ring was full
+        int segments = 0;               // Segments started since start()
+        int deletedSegments = 0;        // Segments removed by rotation
+        int backlogBytes = 0;           // Bytes waiting for the disk right now
+        int backlogHighWater = 0;       // Largest backlog seen
+        bool backpressure = false;      // True while the disk cannot keep up
+        QString currentSegment;
+    };
+
+    explicit StreamRecorder(QObject *parent = nullptr);
+    ~StreamRecorder() override;
+
+    // Create the pipe and start the threads; on failure returns false and emits error()
+    // Создать канал и запустить потоки; при неудаче возвращает false и выпускает error()
+    bool start(const Config &config);
+
+    // Stop the threads and close the last segment. The player must have stopped writing
+    // into streamOutput() first, otherwise libvlc would write into a closed pipe
+    // Остановить потоки и закрыть последний сегмент. Плеер должен сначала прекратить запись
+    // в streamOutput(), иначе libvlc будет писать в закрытый канал
+    void stop();
+
+    bool isRecording() const;
+
+    // Stream output chain for VlcPlayer::setStreamOutputs(): MPEG-TS mux into the pipe
+    // Цепочка потокового вывода для VlcPlayer::setStreamOutputs(): мультиплексор MPEG-TS в канал
+    QString streamOutput() const;
+
+    Stats stats() const;
+
+signals:
+    // Emitted from the writer thread; connect with a queued (or auto) connection
+    // Выпускаются из потока записи; подключать через queued (или auto) соединение
+    void segmentStarted(const QString &path);
+    void segmentFinished(const QString &path, qint64 bytes);
+    void backpressureChanged(bool active);
+    void error(const QString &message);
+
+private:
+    // Reader thread: pipe -> ring, never blocking on the disk
+    // Поток чтения: канал -> кольцо, никогда не блокируется на диске
+    void readLoop();
+
+    // Writer thread: ring -> segment files, at whole transport stream packets
+    // Поток записи: кольцо -> файлы сегментов, целыми пакетами транспортного потока
+    void writeLoop();
+
+    // Handle one 188-byte packet: track PAT/PMT, roll over at key frames, write
+    // Обработать один 188-байтный пакет: отслеживать PAT/PMT, сменять сегмент на ключевых кадрах, записать
+    void writePacket(const uchar *packet);
+
+    bool openSegment();
+    void closeSegment();
+    void rotateSegments();
+    void fail(const QString &message);
+
+    Config m_config;
+    TsPipe m_pipe;
+    QThread *m_reader = nullptr;
+    QThread *m_writer = nullptr;
+    std::atomic<bool> m_stopping {false};
+
+    // Byte ring shared by the two threads, guarded by m_mutex
+    // Байтовое кольцо, общее для двух потоков, защищено m_mutex
+    mutable QMutex m_mutex;
+    QWaitCondition m_dataAvailable;
+    std::vector<char> m_ring;
+    qsizetype m_ringHead = 0;
+    qsizetype m_ringSize = 0;
+    Stats m_stats;
+
+    // Writer-thread state
+    // Состояние потока записи
+    QFile *m_segment = nullptr;
+    qint64 m_segmentBytes = 0;
+    qint64 m_bytesWritten = 0;
+    QElapsedTimer m_segmentClock;
+    QStringList m_finishedSegments;
+    std::vector<uchar> m_pat;
+    std::vector<uchar> m_pmt;
+    int m_pmtPid = -1;
+    bool m_failed = false;
+};
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <QAbstractListModel>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QtQml/qqmlregistration.h>
+
+#include "vlcplayer.h"
+
+// StreamSessionModel: List of concurrent RTSP sessions for multi-camera grid layouts
+// Every row owns its own VlcPlayer; all players share the single libvlc instance of VlcEngine.
+// At most maxActiveDecodes sessions decode at once, the rest wait in the "Queued" state
+// StreamSessionModel: Список одновременных RTSP сессий для многокамерных сеток
+// Каждая строка владеет собственным VlcPlayer; все плееры разделяют единственный экземпляр libvlc из VlcEngine.
+// Одновременно декодируют не более maxActiveDecodes сессий, остальные ждут в состоянии "Queued"
+class StreamSessionModel : public QAbstractListModel
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("Use the streamSessions context property")
+
+    // Number of sessions (tiles) in the model
+    // Количество сессий (плиток) в модели
+    Q_PROPERTY(int count READ rowCount NOTIFY countChanged)
+
+    // Upper bound of sessions decoding in parallel
+    // Верхняя граница одновременно декодирующих сессий
+    Q_PROPERTY(int maxActiveDecodes READ maxActiveDecodes WRITE setMaxActiveDecodes NOTIFY maxActiveDecodesChanged)
+
+    // Number of sessions currently decoding
+    // Количество сессий, декодирующих в данный момент
+    Q_PROPERTY(int activeDecodes READ activeDecodes NOTIFY activeDecodesChanged)
+
+    // Decoder policy of every tile and the per-tile thread cap of VlcPlayer.DecodeSoftwareCapped;
+    // with N tiles the software decoders use at most N * decodeThreads threads
+    // Политика декодера всех плиток и ограничение потоков на плитку для VlcPlayer.DecodeSoftwareCapped;
+    // при N плитках программные декодеры используют не более N * decodeThreads потоков
+    Q_PROPERTY(VlcPlayer::DecodePolicy decodePolicy READ decodePolicy WRITE setDecodePolicy NOTIFY decodePolicyChanged)
+    Q_PROPERTY(int decodeThreads READ decodeThreads WRITE setDecodeThreads NOTIFY decodeThreadsChanged)
+
+    // RTP transport of every tile; VlcPlayer.TransportMulticast lets a wall share one copy of each
+    // camera with every other viewer on the segment
+    // Транспорт RTP всех плиток; VlcPlayer.TransportMulticast позволяет стене делить одну копию
+    // каждой камеры со всеми остальными зрителями сегмента
+    Q_PROPERTY(VlcPlayer::Transport transport READ transport WRITE setTransport NOTIFY transportChanged)
+
+    // What a tile sheds while it is hidden (setTileVisible(row, false)) and every tile while the
+    // application is in the background; tiles are muted, so HiddenAudioOnly stops decoding entirely
+    // while the RTSP sessions stay up
+    // Что сбрасывает плитка, пока она скрыта (setTileVisible(row, false)), и все плитки, пока
+    // приложение в фоне; плитки без звука, поэтому HiddenAudioOnly полностью прекращает
+    // декодирование, а RTSP сессии остаются открытыми
+    Q_PROPERTY(VlcPlayer::Visibility hiddenMode READ hiddenMode WRITE setHiddenMode NOTIFY hiddenModeChanged)
+
+public:
+    // Per-tile quality policy; Auto picks a level from the number of tiles
+    // Политика качества для плитки; Auto выбирает уровень по количеству плиток
+    enum Quality {
+        Auto,           // Full up to 4 tiles, Reduced up to 9, Low beyond
+        Full,           // Decoder defaults
+        Reduced,        // No deblocking, 2 decoder threads
+        Low,            // No deblocking, skip non-reference frames, 1 decoder thread
+        KeyframesOnly   // Decode key frames only, 1 decoder thread
+    };
+    Q_ENUM(Quality)
+
+    // Model roles available to QML delegates as model.url, model.player, ...
+    // Роли модели, доступные делегатам QML как model.url, model.player, ...
+    enum Role {
+        UrlRole = Qt::UserRole + 1,
+        PlayerRole,
+        StateRole,
+        QualityRole,
+        EffectiveQualityRole,
+        DecoderPathRole,
+        VisibilityRole
+    };
+
+    explicit StreamSessionModel(QObject *parent = nullptr);
+    ~StreamSessionModel() override;
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    // Append a session for url; it starts decoding as soon as a decode slot is free
+    // Returns the row of the new session
+    // Добавить сессию для url; она начнет декодирование, как только освободится слот
+    // Возвращает строку новой сессии
+    Q_INVOKABLE int addStream(const QString &url, int quality = Auto);
+
+    // Stop and remove the session at row
+    // Остановить и удалить сессию в строке row
+    Q_INVOKABLE void removeStream(int row);
+
+    // Stop and remove all sessions
+    // Остановить и удалить все сессии
+    Q_INVOKABLE void clear();
+
+    // Change the quality policy of one tile; the stream is reopened with the new options
+    // Изменить политику качества одной плитки; поток переоткрывается с новыми параметрами
+    Q_INVOKABLE void setQuality(int row, int quality);
+
+    // Tell whether the tile at row can be seen (false when scrolled off or covered)
+    // Сообщить, видна ли плитка в строке row (false, если она прокручена или перекрыта)
+    Q_INVOKABLE void setTileVisible(int row, bool visible);
+
+    int maxActiveDecodes() const;
+    void setMaxActiveDecodes(int value);
+
+    int activeDecodes() const;
+
+    VlcPlayer::DecodePolicy decodePolicy() const;
+    void setDecodePolicy(VlcPlayer::DecodePolicy policy);
+
+    int decodeThreads() const;
+    void setDecodeThreads(int threads);
+
+    VlcPlayer::Transport transport() const;
+    void setTransport(VlcPlayer::Transport transport);
+
+    VlcPlayer::Visibility hiddenMode() const;
+    void setHiddenMode(VlcPlayer::Visibility mode);
+
+signals:
+    void countChanged();
+    void maxActiveDecodesChanged();
+    void activeDecodesChanged();
+    void decodePolicyChanged();
+    void decodeThreadsChanged();
+    void transportChanged();
+    void hiddenModeChanged();
+
+    // Forwarded from the player of a session
+    // Перенаправлено от плеера сессии
+    void error(int row, const QString &message);
+
+private:
+    enum class State { Queued, Playing, Error };
+
+    struct Session
+    {
+        QString url;
+        Quality quality = Auto;
+        Quality appliedQuality = Full;
+        State state = State::Queued;
+        bool visible = true;
+        VlcPlayer *player = nullptr;
+    };
+
+    // Quality actually used for a session once Auto is resolved
+    // Качество, фактически используемое сессией после разрешения Auto
+    Quality effectiveQuality(const Session &session) const;
+
+    // libvlc media options implementing a quality level
+    // Параметры медиа libvlc, реализующие уровень качества
+    static QStringList qualityOptions(Quality quality);
+
+    static QString stateName(State state);
+
+    // Row of the session owning player, -1 if it is gone
+    // Строка сессии, владеющей player, -1, если ее уже нет
+    int rowOf(const VlcPlayer *player) const;
+
+    // Reopen every decoding session, e.g. after the decoder settings changed
+    // Переоткрыть все декодирующие сессии, например после изменения настроек декодера
+    void restartPlaying();
+
+    // Start queued sessions while decode slots are available and retune Auto tiles
+    // Запустить ожидающие сессии, пока есть свободные слоты, и перенастроить плитки Auto
+    void schedule();
+
+    // Open the session's stream with options matching its effective quality
+    // Открыть поток сессии с параметрами, соответствующими ее эффективному качеству
+    void startSession(int row);
+
+    // Stop a session whose stream keeps failing and free its decode slot
+    // Остановить сессию, чей поток продолжает отказывать, и освободить ее слот декодирования
+    void giveUp(int row);
+
+    // Give every player the visibility its tile and the application state call for
+    // Задать каждому плееру видимость, которой требуют его плитка и состояние приложения
+    void updateVisibility();
+
+    QList<Session> m_sessions;
+    int m_maxActiveDecodes;
+    VlcPlayer::DecodePolicy m_decodePolicy = VlcPlayer::DecodeAuto;
+    int m_decodeThreads;
+    VlcPlayer::Transport m_transport = VlcPlayer::TransportTcp;
+    VlcPlayer::Visibility m_hiddenMode = VlcPlayer::HiddenAudioOnly;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <QSize>
+#include <QString>
+#include <QStringList>
+#include <QVariantList>
+#include <vector>
+
+// StreamVariants: The encodings one logical camera offers (main, sub, third stream) and which one to show
+// The smallest variant that covers the tile's physical pixel size is chosen, so a small tile does not
+// pull and decode a main stream only to downscale it. Going down needs a clear margin, so a tile
+// resized around a boundary does not flip between two streams
+// StreamVariants: Кодировки одной логической камеры (основной, дополнительный, третий поток) и какую показывать
+// Выбирается наименьший вариант, покрывающий физический размер плитки в пикселях, чтобы маленькая плитка
+// не тянула и не декодировала основной поток только ради уменьшения. Переход вниз требует явного запаса,
+// поэтому плитка, меняющая размер около границы, не переключается туда-обратно между двумя потоками
+class StreamVariants
+{
+public:
+    struct Variant
+    {
+        QString url;
+        QSize size;     // Encoded resolution
+    };
+
+    StreamVariants() = default;
+    explicit StreamVariants(std::vector<Variant> variants);
+
+    // Build from QML: a list of { url, width, height } maps; entries without a url are skipped
+    // Построить из QML: список карт { url, width, height }; элементы без url пропускаются
+    static StreamVariants fromVariantList(const QVariantList &list);
+
+    bool isEmpty() const;
+    bool contains(const QString &url) const;
+    QStringList urls() const;
+
+    // The largest variant, used while the tile size is not known yet
+    // Наибольший вариант; используется, пока размер плитки еще неизвестен
+    QString largest() const;
+
+    // Variant to show in a tile of targetPx physical pixels; current is the variant playing now
+    // (may be empty) and is kept unless the choice clearly changed
+    // Вариант для плитки размером targetPx физических пикселей; current - играющий сейчас вариант
+    // (может быть пустым), он сохраняется, если выбор явно не изменился
+    QString select(const QSize &targetPx, const QString &current = QString()) const;
+
+private:
+    // Index of the smallest variant covering target scaled by factor, or the largest one
+    // Индекс наименьшего варианта, покрывающего target, умноженный на factor, или наибольшего
+    int smallestCovering(const QSize &target, double factor) const;
+
+    // Sorted by pixel count, smallest first
+    // Отсортированы по числу пикселей, от меньшего к большему
+    std::vector<Variant> m_variants;
+};
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <QMetaObject>
+#include <QObject>
+#include <QPointer>
+#include <QRectF>
+
+class QQuickItem;
+class QQuickWindow;
+
+// SurfaceGeometrySync: Follows the on-screen geometry of a QML item for a native overlay
+// Geometry and window changes only mark the sync dirty; the rectangle is read once per rendered
+// frame (QQuickWindow::afterAnimating) and geometryChanged() is emitted only if it really moved,
+// so resizes and animations cost at most one native relayout per frame
+// SurfaceGeometrySync: Следит за геометрией элемента QML на экране для нативного оверлея
+// Изменения геометрии и окна только помечают синхронизацию как грязную; прямоугольник читается
+// один раз за отрисованный кадр (QQuickWindow::afterAnimating), и geometryChanged() выпускается,
+// только если он действительно сдвинулся, поэтому изменение размера и анимации стоят не более
+// одной нативной перекомпоновки за кадр
+class SurfaceGeometrySync : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Counters since the item was set
+    // Счетчики с момента назначения элемента
+    struct Stats
+    {
+        qint64 requested = 0;   // Geometry notifications and explicit requestUpdate() calls
+        qint64 coalesced = 0;   // Requests merged into an update already pending for the frame
+        qint64 skipped = 0;     // Frames whose rectangle matched the last one sent (no-ops)
+        qint64 sent = 0;        // geometryChanged() emissions, i.e. native relayouts
+    };
+
+    explicit SurfaceGeometrySync(QObject *parent = nullptr);
+
+    // Item to follow; nullptr stops following. The current rectangle is treated as already applied
+    // Элемент для отслеживания; nullptr прекращает отслеживание. Текущий прямоугольник считается уже примененным
+    void setItem(QQuickItem *item);
+    QQuickItem *item() const;
+
+    // Ask for a geometry check on the next frame (e.g. a layout the item cannot observe changed)
+    // Запросить проверку геометрии на следующем кадре (например, изменился макет, который элемент не видит)
+    void requestUpdate();
+
+    // Current item rectangle in physical window pixels
+    // Текущий прямоугольник элемента в физических пикселях окна
+    QRectF currentRect() const;
+
+    Stats stats() const;
+
+signals:
+    // New rectangle of the item in physical window pixels, at most once per frame
+    // Новый прямоугольник элемента в физических пикселях окна, не чаще раза за кадр
+    void geometryChanged(const QRectF &rectPx);
+
+private:
+    // Track the window the item lives in; its frames drive flush()
+    // Отслеживать окно, в котором живет элемент; его кадры управляют flush()
+    void attachWindow(QQuickWindow *window);
+
+    // Once per frame: emit the rectangle if it changed since the last emission
+    // Раз за кадр: выпустить прямоугольник, если он изменился с последнего выпуска
+    void flush();
+
+    QPointer<QQuickItem> m_item;
+    QPointer<QQuickWindow> m_window;
+    QList<QMetaObject::Connection> m_itemConnections;
+    QList<QMetaObject::Connection> m_windowConnections;
+
+    bool m_pending = false;
+    QRectF m_lastRect;
+    Stats m_stats;
+};
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QtGlobal>
+
+// TsPacket: Minimal MPEG-TS packet inspection shared by the recorder and the replay ring
+// Only what is needed to cut a stream at key frames and to make a cut start decodable:
+// the PID, the payload start flag, the random access flag and the PMT PID from a PAT
+// TsPacket: Минимальный разбор пакетов MPEG-TS, общий для рекордера и кольца повтора
+// Только то, что нужно, чтобы резать поток на ключевых кадрах и сделать начало отреза декодируемым:
+// PID, флаг начала полезной нагрузки, флаг произвольного доступа и PID PMT из PAT
+namespace TsPacket {
+
+constexpr int kSize = 188;
+constexpr uchar kSyncByte = 0x47;
+
+inline int pid(const uchar *packet)
+{
+    return ((packet[1] & 0x1f) << 8) | packet[2];
+}
+
+inline bool startsPayload(const uchar *packet)
+{
+    return (packet[1] & 0x40) != 0;
+}
+
+// random_access_indicator of the adaptation field, set by libvlc's TS mux on video key frames
+// random_access_indicator поля адаптации, выставляется мультиплексором TS libvlc на ключевых кадрах видео
+inline bool isRandomAccess(const uchar *packet)
+{
+    return (packet[3] & 0x20) && packet[4] > 0 && (packet[5] & 0x40);
+}
+
+// A packet boundary: this byte and the one a packet later (if present) are sync bytes
+// Граница пакета: этот байт и байт на пакет дальше (если есть) - байты синхронизации
+inline bool isSynced(const uchar *data, qsizetype available)
+{
+    return data[0] == kSyncByte && (available < 2 * kSize || data[kSize] == kSyncByte);
+}
+
+// PMT PID of the first program in a single-packet PAT, -1 if the packet holds none
+// PID PMT первой программы в PAT из одного пакета, -1, если в пакете ее нет
+inline int pmtPidFromPat(const uchar *packet)
+{
+    int offset = 4;
+    if (packet[3] & 0x20)
+        offset += 1 + packet[4];
+    if (offset >= kSize)
+        return -1;
+    offset += 1 + packet[offset];   // pointer_field
+    if (offset + 8 > kSize || packet[offset] != 0x00)
+        return -1;
+
+    const int sectionLength = ((packet[offset + 1] & 0x0f) << 8) | packet[offset + 2];
+    const int end = qMin(offset + 3 + sectionLength - 4, kSize);   // CRC excluded
+    for (int i = offset + 8; i + 4 <= end; i += 4) {
+        const int program = (packet[i] << 8) | packet[i + 1];
+        if (program != 0)
+            return ((packet[i + 2] & 0x1f) << 8) | packet[i + 3];
+    }
+    return -1;
+}
+
+} // namespace TsPacket
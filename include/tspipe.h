@@ -0,0 +1,39 @@
+#pragma once
+
+#include <QString>
+#include <QtGlobal>
+
+// TsPipe: Named pipe that receives a libvlc stream output inside the process
+// libvlc's file access writes an MPEG-TS mux into the pipe (see streamOutput()); the owner reads
+// it on a thread of its own. Used by StreamRecorder and ReplayBuffer; POSIX only
+// TsPipe: Именованный канал, принимающий потоковый вывод libvlc внутри процесса
+// Файловый доступ libvlc пишет мультиплексированный MPEG-TS в канал (см. streamOutput()); владелец
+// читает его в собственном потоке. Используется StreamRecorder и ReplayBuffer; только POSIX
+class TsPipe
+{
+public:
+    TsPipe() = default;
+    ~TsPipe();
+
+    TsPipe(const TsPipe &) = delete;
+    TsPipe &operator=(const TsPipe &) = delete;
+
+    // Create the pipe under the temporary directory; name tells the owners' pipes apart
+    // Создать канал во временном каталоге; name различает каналы владельцев
+    bool open(const QString &name, QString *errorMessage);
+    void close();
+    bool isOpen() const;
+
+    // Stream output chain writing an MPEG-TS mux into the pipe
+    // Цепочка потокового вывода, пишущая мультиплексированный MPEG-TS в канал
+    QString streamOutput() const;
+
+    // Read what is available, waiting at most timeoutMs; 0 on timeout, -1 on error
+    // Прочитать доступное, ожидая не более timeoutMs; 0 по таймауту, -1 при ошибке
+    qsizetype read(char *buffer, qsizetype size, int timeoutMs);
+
+private:
+    QString m_path;
+    int m_readFd = -1;
+    int m_keepAliveFd = -1;
+};
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QSize>
+#include <memory>
+#include <vector>
+#include <vlc/vlc.h>
+
+class FrameTap;
+
+// VideoFrameSink: Receives decoded pictures from libvlc's video callbacks
+// libvlc decodes into I420 or NV12 buffers owned by the sink; at display time the picture is
+// shrunk to the target size and converted to RGB32 in one pass with the PixelKernels of this CPU.
+// The newest finished picture is handed to the renderer as a QImage that wraps the same memory
+// VideoFrameSink: Принимает декодированные кадры из видео-колбэков libvlc
+// libvlc декодирует в буферы I420 или NV12, принадлежащие приемнику; в момент показа кадр
+// уменьшается до целевого размера и преобразуется в RGB32 за один проход ядрами PixelKernels этого
+// процессора. Последний готовый кадр передается рендереру как QImage, ссылающийся на ту же память
+class VideoFrameSink : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Presentation timing measured in the display callback
+    // Тайминг показа, измеряемый в колбэке display
+    struct Timing
+    {
+        qint64 displayedFrames = 0;
+        qint64 lateFrames = 0;    // inter-frame gap above 1.5x the running mean
+        double jitterMs = 0.0;    // smoothed |gap - mean|, RFC 3550 style
+        qint64 unrenderedFrames = 0;  // decoded while rendering was off, never uploaded
+    };
+
+    explicit VideoFrameSink(QObject *parent = nullptr);
+    ~VideoFrameSink() override;
+
+    // Register the format and lock/unlock/display callbacks on a libvlc player
+    // Must be called before libvlc_media_player_play()
+    // Зарегистрировать колбэки формата и lock/unlock/display в плеере libvlc
+    // Должно вызываться до libvlc_media_player_play()
+    void attach(libvlc_media_player_t *player);
+
+    // Return the newest decoded frame that has not been taken yet, or a null QImage
+    // The image references sink memory; the slot is recycled once the last copy is destroyed and,
+    // so grabFrame() keeps working, a newer frame has been displayed
+    // Вернуть самый новый декодированный кадр, который еще не забран, или пустой QImage
+    // Изображение ссылается на память приемника; слот освобождается после уничтожения последней копии
+    // и, чтобы grabFrame() продолжал работать, показа более нового кадра
+    QImage takeFrame();
+
+    // Copy of the frame displayed last, without taking it from the renderer; null before the first
+    // frame. Decimated by whole factors while larger than twice maxSize, so the copy made under the
+    // slot lock stays small; the caller scales the rest. An empty maxSize copies at full size
+    // Копия последнего показанного кадра, не забирая его у рендерера; пустая до первого кадра.
+    // Прореживается в целое число раз, пока больше удвоенного maxSize, чтобы копия под блокировкой
+    // слота оставалась небольшой; остальное масштабирует вызывающий. Пустой maxSize - полный размер
+    QImage grabFrame(const QSize &maxSize = QSize()) const;
+
+    // Size of the pictures libvlc currently decodes into
+    // Размер кадров, в которые libvlc декодирует в данный момент
+    QSize frameSize() const;
+
+    // Size of the RGB32 frames handed out, at most frameSize(); empty before the first frame
+    // Размер выдаваемых кадров RGB32, не больше frameSize(); пустой до первого кадра
+    QSize outputSize() const;
+
+    // Chroma negotiated with libvlc: "I420" or "NV12", empty before the format is known
+    // Цветность, согласованная с libvlc: "I420" или "NV12"; пустая, пока формат неизвестен
+    QString chroma() const;
+
+    // Physical pixel size the picture is shown at; frames are scaled down to fit it (aspect kept,
+    // never up). Empty keeps the decoded size. An active frame tap widens it to the largest size its
+    // consumers ask for. May be changed while playing
+    // Размер в физических пикселях, в котором показывается картинка; кадры уменьшаются, чтобы вписаться
+    // в него (с сохранением пропорций, без увеличения). Пустой сохраняет размер декодирования. Активный
+    // отвод кадров расширяет его до наибольшего размера, запрошенного его потребителями. Можно менять во
+    // время воспроизведения
+    void setTargetSize(const QSize &size);
+    QSize targetSize() const;
+
+    // Timing figures since the last resetTiming()
+    // Показатели тайминга с последнего resetTiming()
+    Timing timing() const;
+
+    // Frame tap fed with every displayed frame, or nullptr; may be changed while playing
+    // Отвод кадров, получающий каждый показанный кадр, или nullptr; можно менять во время воспроизведения
+    void setFrameTap(std::shared_ptr<FrameTap> tap);
+
+    // Hand frames to the renderer (default) or only keep the newest one, e.g. while the picture
+    // cannot be seen. Without an active frame tap the kept picture is not even converted to RGB
+    // until it is needed. Decoding, the frame tap and grabFrame() are not affected; turning
+    // rendering back on shows the newest frame right away
+    // Передавать кадры рендереру (по умолчанию) или только хранить самый новый, например пока
+    // картинку не видно. Без активного отвода кадров сохраненный кадр даже не преобразуется в RGB,
+    // пока он не понадобится. Декодирование, отвод кадров и grabFrame() не затрагиваются; после
+    // включения отрисовки самый новый кадр показывается сразу
+    void setRendering(bool rendering);
+    bool isRendering() const;
+
+    // Start a new measurement, called when a new media is opened
+    // Начать новое измерение; вызывается при открытии нового медиа
+    void resetTiming();
+
+signals:
+    // Emitted from the libvlc video output thread whenever a new frame is ready
+    // Connect with Qt::QueuedConnection (or AutoConnection across threads)
+    // Выпущено из потока видеовывода libvlc при каждом новом готовом кадре
+    // Подключать через Qt::QueuedConnection (или AutoConnection между потоками)
+    void frameReady();
+
+private:
+    struct Input;
+    struct Storage;
+    struct FrameRef;
+
+    // libvlc callback trampolines; opaque is the VideoFrameSink instance
+    // Колбэки-трамплины libvlc; opaque - экземпляр VideoFrameSink
+    static unsigned setupCallback(void **opaque, char *chroma, unsigned *width, unsigned *height,
+                                  unsigned *pitches, unsigned *lines);
+    static void cleanupCallback(void *opaque);
+    static void *lockCallback(void *opaque, void **planes);
+    static void unlockCallback(void *opaque, void *picture, void *const *planes);
+    static void displayCallback(void *opaque, void *picture);
+
+    // Convert one decoded buffer at the size the tile and the frame tap need, feed the tap and
+    // publish the frame; runs on the video output thread, or on the caller's for a kept picture
+    // Преобразовать один буфер декодирования в размер, нужный плитке и отводу кадров, передать его
+    // отводу и опубликовать кадр; выполняется в потоке видеовывода или, для сохраненного кадра, в потоке вызывающего
+    void present(const std::shared_ptr<Input> &input, int buffer, std::shared_ptr<Storage> storage,
+                 const std::shared_ptr<FrameTap> &tap, QSize target);
+
+    // Release a slot held by a QImage handed out by takeFrame()
+    // Освободить слот, удерживаемый QImage, выданным takeFrame()
+    static void releaseFrame(void *info);
+
+    // RGB32 frame size for a decoded size and a target size
+    // Размер кадра RGB32 для размера декодирования и целевого размера
+    static QSize outputSizeFor(const QSize &decoded, const QSize &target);
+
+    // Guards m_input, m_storage, m_tap and m_targetSize; buffer and slot states are guarded by
+    // Input::mutex and Storage::mutex
+    // Защищает m_input, m_storage, m_tap и m_targetSize; состояния буферов и слотов защищены
+    // Input::mutex и Storage::mutex
+    mutable QMutex m_mutex;
+    std::shared_ptr<Input> m_input;
+    std::shared_ptr<Storage> m_storage;
+    std::shared_ptr<FrameTap> m_tap;
+    QSize m_targetSize;
+
+    // Display timing state, guarded by m_mutex
+    // Состояние тайминга показа, защищено m_mutex
+    QElapsedTimer m_clock;
+    qint64 m_lastDisplayNs = -1;
+    double m_meanIntervalMs = 0.0;
+    Timing m_timing;
+    bool m_rendering = true;
+};
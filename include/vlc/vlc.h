@@ -13,6 +13,7 @@ extern "C"
 
 #include <stdint.h>
 #include <stddef.h>
+#include <sys/types.h>
 
 /* Opaque structures */
 typedef struct libvlc_instance_t libvlc_instance_t;
@@ -20,6 +21,7 @@ typedef struct libvlc_media_t libvlc_media_t;
 typedef struct libvlc_media_player_t libvlc_media_player_t;
 typedef struct libvlc_event_manager_t libvlc_event_manager_t;
 typedef struct libvlc_event_t libvlc_event_t;
+typedef int libvlc_event_type_t;
 
 /* State enum */
 typedef enum libvlc_state_t {
@@ -33,6 +35,68 @@ typedef enum libvlc_state_t {
     libvlc_Error
 } libvlc_state_t;
 
+/* Media player events */
+enum libvlc_event_e {
+    libvlc_MediaPlayerMediaChanged = 0x100,
+    libvlc_MediaPlayerNothingSpecial,
+    libvlc_MediaPlayerOpening,
+    libvlc_MediaPlayerBuffering,
+    libvlc_MediaPlayerPlaying,
+    libvlc_MediaPlayerPaused,
+    libvlc_MediaPlayerStopped,
+    libvlc_MediaPlayerForward,
+    libvlc_MediaPlayerBackward,
+    libvlc_MediaPlayerEndReached,
+    libvlc_MediaPlayerEncounteredError,
+    libvlc_MediaPlayerTimeChanged,
+    libvlc_MediaPlayerPositionChanged,
+    libvlc_MediaPlayerSeekableChanged,
+    libvlc_MediaPlayerPausableChanged,
+    libvlc_MediaPlayerTitleChanged,
+    libvlc_MediaPlayerSnapshotTaken,
+    libvlc_MediaPlayerLengthChanged,
+    libvlc_MediaPlayerVout
+};
+
+/* Event payload (subset of the union used by this application) */
+struct libvlc_event_t {
+    int type;
+    void *p_obj;
+    union {
+        struct { float new_cache; } media_player_buffering;
+        struct { int64_t new_time; } media_player_time_changed;
+        struct { float new_position; } media_player_position_changed;
+        struct { int new_count; } media_player_vout;
+    } u;
+};
+
+typedef void (*libvlc_callback_t)(const struct libvlc_event_t *p_event, void *p_data);
+
+/* Media statistics */
+typedef struct libvlc_media_stats_t {
+    /* Input */
+    int i_read_bytes;
+    float f_input_bitrate;
+    /* Demux */
+    int i_demux_read_bytes;
+    float f_demux_bitrate;
+    int i_demux_corrupted;
+    int i_demux_discontinuity;
+    /* Decoders */
+    int i_decoded_video;
+    int i_decoded_audio;
+    /* Video Output */
+    int i_displayed_pictures;
+    int i_lost_pictures;
+    /* Audio output */
+    int i_played_abuffers;
+    int i_lost_abuffers;
+    /* Stream output */
+    int i_sent_packets;
+    int i_sent_bytes;
+    float f_send_bitrate;
+} libvlc_media_stats_t;
+
 /* Core functions */
 libvlc_instance_t *libvlc_new(int argc, const char *const *argv);
 void libvlc_release(libvlc_instance_t *p_instance);
@@ -40,27 +104,132 @@ void libvlc_release(libvlc_instance_t *p_instance);
 /* Media functions */
 libvlc_media_t *libvlc_media_new_path(libvlc_instance_t *p_instance,
                                       const char *path);
+libvlc_media_t *libvlc_media_new_location(libvlc_instance_t *p_instance,
+                                          const char *psz_mrl);
+void libvlc_media_add_option(libvlc_media_t *p_md, const char *psz_options);
 void libvlc_media_release(libvlc_media_t *p_md);
+int libvlc_media_get_stats(libvlc_media_t *p_md, libvlc_media_stats_t *p_stats);
+
+/* Elementary stream description (libvlc 3 layout; trailing fields of the video track omitted,
+ * the structures are only read through the pointers libvlc returns) */
+typedef enum libvlc_track_type_t {
+    libvlc_track_unknown = -1,
+    libvlc_track_audio = 0,
+    libvlc_track_video = 1,
+    libvlc_track_text = 2
+} libvlc_track_type_t;
+
+typedef struct libvlc_audio_track_t {
+    unsigned i_channels;
+    unsigned i_rate;
+} libvlc_audio_track_t;
+
+typedef struct libvlc_video_track_t {
+    unsigned i_height;
+    unsigned i_width;
+    unsigned i_sar_num;
+    unsigned i_sar_den;
+    unsigned i_frame_rate_num;
+    unsigned i_frame_rate_den;
+} libvlc_video_track_t;
+
+typedef struct libvlc_media_track_t {
+    uint32_t i_codec;
+    uint32_t i_original_fourcc;
+    int i_id;
+    libvlc_track_type_t i_type;
+    int i_profile;
+    int i_level;
+    union {
+        libvlc_audio_track_t *audio;
+        libvlc_video_track_t *video;
+        void *subtitle;
+    };
+    unsigned int i_bitrate;
+    char *psz_language;
+    char *psz_description;
+} libvlc_media_track_t;
+
+unsigned libvlc_media_tracks_get(libvlc_media_t *p_md, libvlc_media_track_t ***tracks);
+void libvlc_media_tracks_release(libvlc_media_track_t **p_tracks, unsigned i_count);
+
+/* Media from application callbacks */
+typedef int (*libvlc_media_open_cb)(void *opaque, void **datap, uint64_t *sizep);
+typedef ssize_t (*libvlc_media_read_cb)(void *opaque, unsigned char *buf, size_t len);
+typedef int (*libvlc_media_seek_cb)(void *opaque, uint64_t offset);
+typedef void (*libvlc_media_close_cb)(void *opaque);
+libvlc_media_t *libvlc_media_new_callbacks(libvlc_instance_t *instance,
+                                           libvlc_media_open_cb open_cb,
+                                           libvlc_media_read_cb read_cb,
+                                           libvlc_media_seek_cb seek_cb,
+                                           libvlc_media_close_cb close_cb,
+                                           void *opaque);
 
 /* Media player functions */
 libvlc_media_player_t *libvlc_media_list_player_new(libvlc_instance_t *p_libvlc);
 void libvlc_media_list_player_release(libvlc_media_player_t *p_mlp);
+libvlc_media_player_t *libvlc_media_player_new(libvlc_instance_t *p_libvlc_instance);
+void libvlc_media_player_release(libvlc_media_player_t *p_mi);
 void libvlc_media_player_set_media(libvlc_media_player_t *p_mi,
                                    libvlc_media_t *p_md);
+libvlc_media_t *libvlc_media_player_get_media(libvlc_media_player_t *p_mi);
+
+/* Native window embedding */
+void libvlc_media_player_set_xwindow(libvlc_media_player_t *p_mi, uint32_t drawable);
+void libvlc_media_player_set_hwnd(libvlc_media_player_t *p_mi, void *drawable);
+void libvlc_media_player_set_nsobject(libvlc_media_player_t *p_mi, void *drawable);
+
+/* Video callbacks: decode into application-owned buffers */
+typedef unsigned (*libvlc_video_format_cb)(void **opaque, char *chroma,
+                                           unsigned *width, unsigned *height,
+                                           unsigned *pitches, unsigned *lines);
+typedef void (*libvlc_video_cleanup_cb)(void *opaque);
+typedef void *(*libvlc_video_lock_cb)(void *opaque, void **planes);
+typedef void (*libvlc_video_unlock_cb)(void *opaque, void *picture,
+                                       void *const *planes);
+typedef void (*libvlc_video_display_cb)(void *opaque, void *picture);
+
+void libvlc_video_set_callbacks(libvlc_media_player_t *mp,
+                                libvlc_video_lock_cb lock,
+                                libvlc_video_unlock_cb unlock,
+                                libvlc_video_display_cb display,
+                                void *opaque);
+void libvlc_video_set_format_callbacks(libvlc_media_player_t *mp,
+                                       libvlc_video_format_cb setup,
+                                       libvlc_video_cleanup_cb cleanup);
+
+/* Video track selection (-1 disables video) */
+int libvlc_video_get_track(libvlc_media_player_t *p_mi);
+int libvlc_video_set_track(libvlc_media_player_t *p_mi, int i_track);
 
 /* Playback control */
 int libvlc_media_player_play(libvlc_media_player_t *p_mi);
 void libvlc_media_player_set_pause(libvlc_media_player_t *p_mi, int do_pause);
 void libvlc_media_player_stop(libvlc_media_player_t *p_mi);
 
+/* Audio control */
+void libvlc_audio_set_mute(libvlc_media_player_t *p_mi, int status);
+
 /* State query */
 libvlc_state_t libvlc_media_player_get_state(libvlc_media_player_t *p_mi);
+int libvlc_media_player_is_playing(libvlc_media_player_t *p_mi);
 
 /* Time and position */
 int64_t libvlc_media_player_get_length(libvlc_media_player_t *p_mi);
 int64_t libvlc_media_player_get_time(libvlc_media_player_t *p_mi);
 void libvlc_media_player_set_time(libvlc_media_player_t *p_mi, int64_t i_time);
 
+/* Events */
+libvlc_event_manager_t *libvlc_media_player_event_manager(libvlc_media_player_t *p_mi);
+int libvlc_event_attach(libvlc_event_manager_t *p_event_manager,
+                        libvlc_event_type_t i_event_type,
+                        libvlc_callback_t f_callback,
+                        void *user_data);
+void libvlc_event_detach(libvlc_event_manager_t *p_event_manager,
+                         libvlc_event_type_t i_event_type,
+                         libvlc_callback_t f_callback,
+                         void *p_user_data);
+
 /* Error handling */
 const char *libvlc_errmsg(void);
 
@@ -8,16 +8,45 @@
 #include <QQuickItem>
 #include <QJniObject>
 #include <QJniEnvironment>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QTimer>
+#include <QHash>
+#include <QStringList>
+#include <QVariantMap>
+#include <QtQml/qqmlregistration.h>
+#include "frametap.h"
+#include "latencycontroller.h"
+#include "playbackmetrics.h"
+#include "replaybuffer.h"
+#include "snapshotservice.h"
+#include "streamvariants.h"
+#include "streamrecorder.h"
+#include "surfacegeometrysync.h"
+#include "vlcplayer.h"
+
+class VlcVideoItem;
 
 // ========== CLASS DECLARATION ==========
-// VLCBridge: Bridge class connecting QML (C++ side) with Android VLC playback via JNI
-// VLCBridge: Класс-мост, соединяющий QML (сторона C++) с воспроизведением VLC Android через JNI
+// VLCBridge: Bridge class connecting QML (C++ side) with VLC playback
+// Streams are decoded by libvlc into a VlcVideoItem; on Android other containers still use
+// the JNI VlcSurfaceHelper TextureView
+// VLCBridge: Класс-мост, соединяющий QML (сторона C++) с воспроизведением VLC
+// Потоки декодируются libvlc в VlcVideoItem; на Android прочие контейнеры по-прежнему используют
+// TextureView из VlcSurfaceHelper через JNI
 class VLCBridge : public QObject
 {
     // Enable Qt's meta-object system for signals, slots, and properties
     // Включить систему мета-объектов Qt для сигналов, слотов и свойств
     Q_OBJECT
 
+    // Register the type so QML can use its enums (VLCBridge.LatencyAuto, ...)
+    // The instance itself is provided through the vlcBridge context property
+    // Зарегистрировать тип, чтобы QML мог использовать его перечисления (VLCBridge.LatencyAuto, ...)
+    // Сам экземпляр предоставляется через контекстное свойство vlcBridge
+    QML_ELEMENT
+    QML_UNCREATABLE("Use the vlcBridge context property")
+
     // ========== Q_PROPERTY DECLARATIONS ==========
     // Expose C++ properties to QML with automatic change notifications
     // Expose свойства C++ для QML с автоматическим уведомлением об изменениях
@@ -38,31 +67,127 @@ class VLCBridge : public QObject
     // NOTIFY: выпущенный сигнал isPausedChanged(bool)
     Q_PROPERTY(bool isPaused READ isPaused NOTIFY isPausedChanged)
 
+    // What the active decoder is actually doing (Opening, Buffering, Playing, Paused, ...)
+    // isPlaying and isPaused are derived from it: Buffering and Playing count as playing
+    // Что на самом деле делает активный декодер (Opening, Buffering, Playing, Paused, ...)
+    // isPlaying и isPaused выводятся из него: Buffering и Playing считаются воспроизведением
+    Q_PROPERTY(VlcPlayer::State state READ state NOTIFY stateChanged)
+
+    // Time from play() to the first decoded frame in milliseconds (-1 until measured)
+    // Время от play() до первого декодированного кадра в миллисекундах (-1 до измерения)
+    Q_PROPERTY(qint64 startupMs READ startupMs NOTIFY startupMsChanged)
+
+    // Duration of the last camera switch done by switchTo() in milliseconds (-1 until measured)
+    // Длительность последнего переключения камеры через switchTo() в миллисекундах (-1 до измерения)
+    Q_PROPERTY(qint64 lastSwitchMs READ lastSwitchMs NOTIFY lastSwitchMsChanged)
+
+    // Latency and throughput metrics of the active stream, refreshed every second
+    // Usage in QML: vlcBridge.metrics.timeToFirstFrameMs, vlcBridge.metrics.jitterMs, ...
+    // Метрики задержки и пропускной способности активного потока, обновляются каждую секунду
+    // Использование в QML: vlcBridge.metrics.timeToFirstFrameMs, vlcBridge.metrics.jitterMs, ...
+    Q_PROPERTY(PlaybackMetrics metrics READ metrics NOTIFY metricsChanged)
+
+    // Latency profile applied to every stream opened by the bridge
+    // Профиль задержки, применяемый ко всем потокам, открытым мостом
+    Q_PROPERTY(LatencyProfile latencyProfile READ latencyProfile WRITE setLatencyProfile NOTIFY latencyProfileChanged)
+
+    // Caching (jitter buffer) currently in effect for the active stream, ms
+    // Кэширование (джиттер-буфер), действующее для активного потока, мс
+    Q_PROPERTY(int cachingMs READ cachingMs NOTIFY cachingMsChanged)
+
+    // Decoder policy for streams without a per-stream override, and the thread cap of
+    // VlcPlayer.DecodeSoftwareCapped
+    // Политика декодера для потоков без индивидуальной настройки и ограничение потоков
+    // для VlcPlayer.DecodeSoftwareCapped
+    Q_PROPERTY(VlcPlayer::DecodePolicy decodePolicy READ decodePolicy WRITE setDecodePolicy NOTIFY decodePolicyChanged)
+    Q_PROPERTY(int decodeThreads READ decodeThreads WRITE setDecodeThreads NOTIFY decodeThreadsChanged)
+
+    // Decoder path the active stream ended up on ("hardware", "software (fallback)", ...)
+    // Путь декодирования, на котором оказался активный поток ("hardware", "software (fallback)", ...)
+    Q_PROPERTY(QString decoderPath READ decoderPath NOTIFY decoderPathChanged)
+
+    // RTP transport for streams without a per-stream override, and the transport the active stream
+    // runs on ("tcp", "udp", "multicast", "tcp (fallback)")
+    // Транспорт RTP для потоков без индивидуальной настройки и транспорт, на котором идет активный
+    // поток ("tcp", "udp", "multicast", "tcp (fallback)")
+    Q_PROPERTY(VlcPlayer::Transport transport READ transport WRITE setTransport NOTIFY transportChanged)
+    Q_PROPERTY(QString transportPath READ transportPath NOTIFY transportPathChanged)
+
+    // True while the active stream is being recorded to disk
+    // True, пока активный поток записывается на диск
+    Q_PROPERTY(bool isRecording READ isRecording NOTIFY recordingChanged)
+
+    // Seconds of the active stream kept in memory for instant replay; 0 (the default) turns it off
+    // Секунды активного потока, хранимые в памяти для мгновенного повтора; 0 (по умолчанию) отключает его
+    Q_PROPERTY(int replayWindowSeconds READ replayWindowSeconds WRITE setReplayWindowSeconds NOTIFY replayWindowSecondsChanged)
+
+    // True while the video item shows the replay instead of the live picture
+    // True, пока элемент видео показывает повтор вместо живой картинки
+    Q_PROPERTY(bool isReplaying READ isReplaying NOTIFY replayingChanged)
+
+    // How far behind live the picture on screen is, and how far back a replay can start, ms
+    // Refreshed twice a second while replay is enabled
+    // Насколько картинка на экране отстает от живой и насколько далеко назад может начаться повтор, мс
+    // Обновляются дважды в секунду, пока повтор включен
+    Q_PROPERTY(qint64 replayOffsetMs READ replayOffsetMs NOTIFY replayPositionChanged)
+    Q_PROPERTY(qint64 replayAvailableMs READ replayAvailableMs NOTIFY replayPositionChanged)
+
+    // What the active stream sheds while it cannot be seen: backgroundMode while the application is
+    // hidden or suspended, hiddenMode while videoVisible is false (tile scrolled off or covered, set
+    // from QML) or the video item is invisible. The savings show up in metrics
+    // Что сбрасывает активный поток, пока его не видно: backgroundMode, пока приложение скрыто или
+    // приостановлено, hiddenMode, пока videoVisible равно false (плитка прокручена или перекрыта,
+    // задается из QML) или элемент видео невидим. Экономия видна в metrics
+    Q_PROPERTY(VlcPlayer::Visibility backgroundMode READ backgroundMode WRITE setBackgroundMode NOTIFY backgroundModeChanged)
+    Q_PROPERTY(VlcPlayer::Visibility hiddenMode READ hiddenMode WRITE setHiddenMode NOTIFY hiddenModeChanged)
+    Q_PROPERTY(bool videoVisible READ videoVisible WRITE setVideoVisible NOTIFY videoVisibleChanged)
+
 public:
+    // ========== ENUMS ==========
+    // Trade-off between delay and smoothness of the jitter buffer
+    // Компромисс между задержкой и плавностью джиттер-буфера
+    enum LatencyProfile {
+        LatencyUltraLow,    // 50 ms caching, late frames dropped - clean LAN
+        LatencyBalanced,    // 150 ms caching, late frames shown - previous fixed behaviour
+        LatencySmooth,      // 600 ms caching, late frames shown - lossy Wi-Fi / WAN
+        LatencyAuto         // Caching and drop policy retuned per stream from jitter and stalls
+    };
+    Q_ENUM(LatencyProfile)
+
     // ========== CONSTRUCTOR ==========
     // Initialize VLCBridge with optional parent QObject for memory management
     // Инициализировать VLCBridge с опциональным родительским QObject для управления памятью
     explicit VLCBridge(QObject *parent = nullptr);
 
+    // Stop every player while the buffers they read from and write into still exist
+    // Остановить все плееры, пока буферы, из которых они читают и в которые пишут, еще существуют
+    ~VLCBridge() override;
+
     // ========== Q_INVOKABLE METHODS ==========
     // These methods are callable from QML with automatic type conversion
     // Эти методы вызываются из QML с автоматическим преобразованием типа
 
     // Start RTSP stream playback at specified position and size
-    // Parameters: url - stream URL, videoContainer - QML item for positioning,
+    // url may also name a camera registered with setCameraVariants(); the variant that fits the
+    // container's physical pixel size is played and followed as the container is resized
+    // Parameters: url - stream URL or camera, videoContainer - QML item for positioning,
     //             x, y - position in device-independent pixels,
     //             width, height - size in device-independent pixels
     // Начать воспроизведение RTSP потока в указанной позиции и размере
-    // Параметры: url - URL потока, videoContainer - элемент QML для позиционирования,
+    // url может также называть камеру, зарегистрированную через setCameraVariants(); воспроизводится
+    // вариант, подходящий под физический размер контейнера в пикселях, и он отслеживается при изменении размера
+    // Параметры: url - URL потока или камера, videoContainer - элемент QML для позиционирования,
     //            x, y - позиция в аппаратно-независимых пиксельях,
     //            width, height - размер в аппаратно-независимых пиксельях
-    Q_INVOKABLE void play(const QString &url, QObject *videoContainer, qreal x, qreal y, qreal width, qreal height);
+    Q_INVOKABLE void play(const QString &urlOrCamera, QObject *videoContainer, qreal x, qreal y, qreal width, qreal height);
 
     // Update the position and size of the active video playback surface
-    // This method is called when the video container is resized or moved
+    // The surface already follows its container once per frame; for that container this call only
+    // requests a check on the next frame, so calling it from every geometry handler is cheap
     // Parameters: same as play() except url (uses currently playing stream)
     // Обновить позицию и размер активной поверхности воспроизведения видео
-    // Этот метод вызывается, когда контейнер видео изменяет размер или перемещается
+    // Поверхность и так следует за своим контейнером раз за кадр; для этого контейнера вызов только
+    // запрашивает проверку на следующем кадре, поэтому вызывать его из каждого обработчика геометрии дешево
     // Параметры: как play() кроме url (использует текущий воспроизводящийся поток)
     Q_INVOKABLE void updatePosition(QObject *videoContainer, qreal x, qreal y, qreal width, qreal height);
 
@@ -70,10 +195,155 @@ public:
     // Приостановить текущий воспроизводящийся видео поток
     Q_INVOKABLE void pause();
 
-    // Stop the currently playing or paused video stream and release resources
-    // Остановить текущий воспроизводящийся или приостановленный видео поток и освободить ресурсы
+    // Continue a paused stream (or paused replay) where it stopped
+    // Продолжить приостановленный поток (или приостановленный повтор) с места остановки
+    Q_INVOKABLE void resume();
+
+    // Stop the currently playing or paused video stream
+    // The libvlc engine, players and frame buffers stay warm for the next play()
+    // Остановить текущий воспроизводящийся или приостановленный видео поток
+    // Движок libvlc, плееры и буферы кадров остаются прогретыми для следующего play()
     Q_INVOKABLE void stop();
 
+    // Open url in the muted standby player so a later switchTo(url) is instant
+    // A camera is preloaded in the variant that fits the current tile
+    // Открыть url в заглушенном резервном плеере, чтобы последующий switchTo(url) был мгновенным
+    // Камера предзагружается в варианте, подходящем текущей плитке
+    Q_INVOKABLE void preload(const QString &urlOrCamera);
+
+    // Switch the current video container to url or camera without a black gap
+    // The old stream keeps playing until the new one delivers its first decoded frame
+    // Переключить текущий контейнер видео на url или камеру без черного промежутка
+    // Старый поток продолжает играть, пока новый не выдаст первый декодированный кадр
+    Q_INVOKABLE void switchTo(const QString &urlOrCamera);
+
+    // Bring the playback engine up in the background and look up the hosts of the given URLs or
+    // cameras, so the first play() neither waits for libvlc nor for DNS. Called by main() while QML
+    // loads; more URLs may be warmed later, e.g. the cameras of a saved layout
+    // Запустить движок воспроизведения в фоне и разрешить хосты указанных URL или камер, чтобы
+    // первый play() не ждал ни libvlc, ни DNS. Вызывается из main() во время загрузки QML; позже
+    // можно прогреть другие URL, например камеры сохраненной раскладки
+    Q_INVOKABLE void prewarm(const QStringList &urlsOrCameras = {});
+
+    // Start-up figures: engineReady, engineInitMs, prewarmed, cold and warm first frame times
+    // (coldStarts, lastColdMs, meanColdMs, warmStarts, lastWarmMs, meanWarmMs) and the session cache
+    // counters (cacheEntries, cacheHits, cacheMisses, cacheInvalidations, hostLookups)
+    // Показатели запуска: engineReady, engineInitMs, prewarmed, времена первого кадра холодных и теплых
+    // стартов (coldStarts, lastColdMs, meanColdMs, warmStarts, lastWarmMs, meanWarmMs) и счетчики кэша
+    // сессий (cacheEntries, cacheHits, cacheMisses, cacheInvalidations, hostLookups)
+    Q_INVOKABLE QVariantMap startupStats() const;
+
+    // Player command queue: depth, highWaterDepth, posted, applied, coalesced (superseded by a
+    // later command of the same player), restartsSkipped, lastLatencyMs / meanLatencyMs /
+    // maxLatencyMs from posting to execution and meanApplyMs / maxApplyMs spent inside libvlc
+    // Очередь команд плееров: depth, highWaterDepth, posted, applied, coalesced (вытеснены более
+    // поздней командой того же плеера), restartsSkipped, lastLatencyMs / meanLatencyMs /
+    // maxLatencyMs от отправки до выполнения и meanApplyMs / maxApplyMs, проведенные внутри libvlc
+    Q_INVOKABLE QVariantMap playerQueueStats() const;
+
+    // Pin the decoder policy of one stream (a VlcPlayer.DecodePolicy value); -1 removes the override
+    // Закрепить политику декодера одного потока (значение VlcPlayer.DecodePolicy); -1 снимает настройку
+    Q_INVOKABLE void setStreamDecodePolicy(const QString &url, int policy);
+
+    // Pin the RTP transport of one stream (a VlcPlayer.Transport value); -1 removes the override
+    // Закрепить транспорт RTP одного потока (значение VlcPlayer.Transport); -1 снимает настройку
+    Q_INVOKABLE void setStreamTransport(const QString &url, int transport);
+
+    // Transport of the active stream: requested (the VlcPlayer.Transport key), transport (what it
+    // runs on), fallbacks from UDP to TCP since open, lossEvents and discontinuities (frames the
+    // demuxer got damaged or with a gap; libvlc 3 does not expose the RTP packet counters)
+    // Транспорт активного потока: requested (ключ VlcPlayer.Transport), transport (на чем он идет),
+    // fallbacks - откаты с UDP на TCP с открытия, lossEvents и discontinuities (кадры, пришедшие в
+    // демультиплексор поврежденными или с разрывом; libvlc 3 не предоставляет счетчики пакетов RTP)
+    Q_INVOKABLE QVariantMap transportStats() const;
+
+    // Declare the streams of one logical camera: a list of { url, width, height } maps (main, sub,
+    // third stream); an empty list forgets the camera. play() and switchTo() accept the camera name
+    // or any of its URLs, and a resized or fullscreen tile moves to the smallest variant that covers
+    // it through the gapless standby swap. The variant is held while recording or replaying
+    // Объявить потоки одной логической камеры: список карт { url, width, height } (основной,
+    // дополнительный, третий поток); пустой список забывает камеру. play() и switchTo() принимают имя
+    // камеры или любой из ее URL, а плитка, изменившая размер или развернутая на весь экран, переходит
+    // на наименьший покрывающий ее вариант через бесшовную замену резервным плеером. Во время записи
+    // или повтора вариант не меняется
+    Q_INVOKABLE void setCameraVariants(const QString &camera, const QVariantList &variants);
+
+    // Counters of the surface geometry sync: requested, coalesced, skipped and sent updates
+    // Счетчики синхронизации геометрии поверхности: запрошенные, объединенные, пропущенные и отправленные обновления
+    Q_INVOKABLE QVariantMap geometryStats() const;
+
+    // Counters of the shared video frame buffer pool: allocations, reuses, in-use/idle buffers and high-water marks
+    // Счетчики общего пула буферов кадров: выделения, повторные использования, занятые/простаивающие буферы и пики
+    Q_INVOKABLE QVariantMap frameBufferStats() const;
+
+    // CPU video path of the active player: pixel kernels in use and available, negotiated chroma,
+    // decoded size and the size frames are converted to for the tile
+    // Видеопуть на процессоре активного плеера: используемые и доступные ядра пикселей, согласованная
+    // цветность, размер декодирования и размер, в который кадры преобразуются для плитки
+    Q_INVOKABLE QVariantMap videoPathStats() const;
+
+    // Record the active stream as it arrives (no second connection, no transcoding) into rotating
+    // MPEG-TS segments of about segmentSeconds in directory; maxSegments > 0 deletes the oldest
+    // files beyond it. Starting or stopping restarts the stream once, as libvlc only applies
+    // stream output when a media starts. Switching camera, play() or stop() end the recording
+    // Записывать активный поток по мере поступления (без второго соединения и перекодирования)
+    // в сменяющиеся сегменты MPEG-TS длиной около segmentSeconds в directory; maxSegments > 0
+    // удаляет самые старые файлы сверх этого. Запуск и остановка один раз перезапускают поток,
+    // так как libvlc применяет потоковый вывод только при запуске медиа. Переключение камеры,
+    // play() или stop() завершают запись
+    Q_INVOKABLE bool startRecording(const QString &directory, int segmentSeconds = 60, int maxSegments = 0);
+    Q_INVOKABLE void stopRecording();
+
+    // Recorder counters: bytesWritten, bytesDropped, segments, deletedSegments, backlogBytes,
+    // backlogHighWater, backpressure, currentSegment
+    // Счетчики записи: bytesWritten, bytesDropped, segments, deletedSegments, backlogBytes,
+    // backlogHighWater, backpressure, currentSegment
+    Q_INVOKABLE QVariantMap recordingStats() const;
+
+    // Show the active stream from secondsBack ago (snapped to the key frame at or before it) while the
+    // live session keeps running; calling it again while replaying scrubs. Positioning is a lookup in
+    // the in-memory key frame index, the RTSP session is never rebuilt. Needs replayWindowSeconds > 0
+    // Показать активный поток с момента secondsBack назад (с привязкой к ключевому кадру на нем или
+    // раньше), пока живая сессия продолжает работать; повторный вызов во время повтора перематывает.
+    // Позиционирование - поиск в индексе ключевых кадров в памяти, RTSP сессия не пересоздается.
+    // Требует replayWindowSeconds > 0
+    Q_INVOKABLE bool replay(qreal secondsBack);
+
+    // Leave the replay and show the live picture again
+    // Выйти из повтора и снова показать живую картинку
+    Q_INVOKABLE void returnToLive();
+
+    // Replay buffer counters: bytesReceived, bytesBuffered, bytesSkipped, keyFrames, availableMs,
+    // readers, readerResyncs
+    // Счетчики буфера повтора: bytesReceived, bytesBuffered, bytesSkipped, keyFrames, availableMs,
+    // readers, readerResyncs
+    Q_INVOKABLE QVariantMap replayStats() const;
+
+    // Ask for a thumbnail of url for camera pickers; answered by snapshotReady() or snapshotFailed().
+    // A stream this bridge is playing gives its current frame, any other one is connected briefly
+    // and only its first key frame is decoded. Results are cached for a while, and requests for a
+    // URL already being captured are merged
+    // Запросить миниатюру url для выбора камер; ответ приходит через snapshotReady() или snapshotFailed().
+    // Поток, который играет этот мост, отдает текущий кадр, любой другой ненадолго подключается,
+    // и декодируется только его первый ключевой кадр. Результаты кэшируются на время, а запросы
+    // URL, который уже снимается, объединяются
+    Q_INVOKABLE void requestSnapshot(const QString &url);
+
+    // Snapshot counters: requests, cacheHits, merged, liveGrabs, probes, failures, encoded
+    // Счетчики снимков: requests, cacheHits, merged, liveGrabs, probes, failures, encoded
+    Q_INVOKABLE QVariantMap snapshotStats() const;
+
+    // ========== FRAME TAP (C++ ONLY) ==========
+    // Hand the frames decoded for the active stream to an analytics consumer, without a second
+    // RTSP session or decode; follows the stream across switchTo(). Frames only flow while the
+    // native player renders (not in the Android TextureView fallback)
+    // Передавать кадры, декодированные для активного потока, потребителю аналитики без второй
+    // RTSP сессии и декодирования; следует за потоком при switchTo(). Кадры идут, только пока
+    // отрисовывает нативный плеер (не в запасном режиме Android TextureView)
+    int addFrameConsumer(FrameConsumer *consumer, const FrameTap::Request &request = FrameTap::Request());
+    void removeFrameConsumer(int id);
+    FrameTap::Stats frameConsumerStats(int id) const;
+
     // ========== PROPERTY GETTER METHODS ==========
     // Inline getters for Q_PROPERTY read access
     // Встроенные геттеры для доступа для чтения Q_PROPERTY
@@ -86,6 +356,58 @@ public:
     // Вернуть текущее состояние паузы
     bool isPaused() const;
 
+    // Return the state of the active stream
+    // Вернуть состояние активного потока
+    VlcPlayer::State state() const;
+
+    // Return the measured start-up and switch times
+    // Вернуть измеренные времена запуска и переключения
+    qint64 startupMs() const;
+    qint64 lastSwitchMs() const;
+
+    // Return the latest metrics snapshot of the active stream
+    // Вернуть последний снимок метрик активного потока
+    PlaybackMetrics metrics() const;
+
+    // Latency profile accessors and the caching in effect
+    // Методы доступа к профилю задержки и действующее кэширование
+    LatencyProfile latencyProfile() const;
+    void setLatencyProfile(LatencyProfile profile);
+    int cachingMs() const;
+
+    // Decoder policy accessors and the path of the active stream
+    // Методы доступа к политике декодера и путь активного потока
+    VlcPlayer::DecodePolicy decodePolicy() const;
+    void setDecodePolicy(VlcPlayer::DecodePolicy policy);
+    int decodeThreads() const;
+    void setDecodeThreads(int threads);
+    QString decoderPath() const;
+
+    // Transport accessors and the transport of the active stream
+    // Методы доступа к транспорту и транспорт активного потока
+    VlcPlayer::Transport transport() const;
+    void setTransport(VlcPlayer::Transport transport);
+    QString transportPath() const;
+
+    bool isRecording() const;
+
+    // Instant replay accessors
+    // Методы доступа к мгновенному повтору
+    int replayWindowSeconds() const;
+    void setReplayWindowSeconds(int seconds);
+    bool isReplaying() const;
+    qint64 replayOffsetMs() const;
+    qint64 replayAvailableMs() const;
+
+    // Visibility shedding accessors
+    // Методы доступа к сбросу нагрузки по видимости
+    VlcPlayer::Visibility backgroundMode() const;
+    void setBackgroundMode(VlcPlayer::Visibility mode);
+    VlcPlayer::Visibility hiddenMode() const;
+    void setHiddenMode(VlcPlayer::Visibility mode);
+    bool videoVisible() const;
+    void setVideoVisible(bool visible);
+
     // ========== SIGNALS SECTION ==========
     // Signals are emitted to notify connected slots of state changes
     // Сигналы выпускаются для уведомления подключенных слотов об изменениях состояния
@@ -98,6 +420,10 @@ signals:
     // Выпущено при изменении состояния паузы (пауза или возобновление)
     void isPausedChanged(bool value);
 
+    // Emitted on every state transition reported by the decoder
+    // Выпущено при каждом переходе состояния, о котором сообщил декодер
+    void stateChanged(VlcPlayer::State state);
+
     // Emitted with status updates (e.g., "Playing", "Paused", "Stopped")
     // Allows QML to display current playback status to user
     // Выпущено с обновлениями состояния (например, "Playing", "Paused", "Stopped")
@@ -110,6 +436,63 @@ signals:
     // Содержит удобочитаемое сообщение об ошибке для логирования или уведомления пользователя
     void error(const QString &message);
 
+    // Emitted when the start-up / switch time measurements change
+    // Выпущено при изменении измерений времени запуска / переключения
+    void startupMsChanged(qint64 value);
+    void lastSwitchMsChanged(qint64 value);
+
+    // Emitted when switchTo() has swapped to the new stream
+    // Выпущено, когда switchTo() переключился на новый поток
+    void switchCompleted(const QString &url, qint64 elapsedMs);
+
+    // Emitted when the metrics property changes
+    // Выпущено при изменении свойства metrics
+    void metricsChanged();
+
+    // Periodic metrics report (once a second while playing) as a flat map for dashboards
+    // Периодический отчет о метриках (раз в секунду во время воспроизведения) в виде плоской карты для дашбордов
+    void metricsUpdated(const QVariantMap &metrics);
+
+    // Emitted when the latency profile or the effective caching changes
+    // Выпущено при изменении профиля задержки или действующего кэширования
+    void latencyProfileChanged(LatencyProfile value);
+    void cachingMsChanged(int value);
+
+    // Emitted when the decoder settings or the active stream's decoder path change
+    // Выпущено при изменении настроек декодера или пути декодирования активного потока
+    void decodePolicyChanged(VlcPlayer::DecodePolicy value);
+    void decodeThreadsChanged(int value);
+    void decoderPathChanged(const QString &path);
+
+    // Emitted when the transport setting or the active stream's transport changes
+    // Выпущено при изменении настройки транспорта или транспорта активного потока
+    void transportChanged(VlcPlayer::Transport value);
+    void transportPathChanged(const QString &path);
+
+    // Recording state, segment rollover and disk backpressure
+    // Состояние записи, смена сегментов и противодавление диска
+    void recordingChanged(bool value);
+    void recordingSegmentStarted(const QString &path);
+    void recordingSegmentFinished(const QString &path, qint64 bytes);
+    void recordingBackpressureChanged(bool active);
+
+    // Instant replay settings, mode and position
+    // Настройки, режим и позиция мгновенного повтора
+    void replayWindowSecondsChanged(int value);
+    void replayingChanged(bool value);
+    void replayPositionChanged();
+
+    // Visibility shedding settings
+    // Настройки сброса нагрузки по видимости
+    void backgroundModeChanged(VlcPlayer::Visibility value);
+    void hiddenModeChanged(VlcPlayer::Visibility value);
+    void videoVisibleChanged(bool value);
+
+    // Thumbnail of url as a data URL usable as an Image source, or the reason there is none
+    // Миниатюра url в виде data URL, пригодного как источник Image, или причина ее отсутствия
+    void snapshotReady(const QString &url, const QString &dataUrl);
+    void snapshotFailed(const QString &url, const QString &message);
+
 private:
     // ========== PRIVATE HELPER METHOD ==========
     // Static method to convert device-independent pixels (DP) to physical pixels (PX)
@@ -122,6 +505,128 @@ private:
     // Returns: QRectF with coordinates scaled by DPI ratio
     static QRectF toPx(QObject *videoContainer, const QRectF &rectDp);
 
+    // Adopt a state reported by the active decoder, derive the flags and emit the change signals
+    // Принять состояние, сообщенное активным декодером, вывести флаги и выпустить сигналы изменения
+    void applyState(VlcPlayer::State state);
+
+    // State change of either player: drives the bridge state or aborts a failing switch
+    // Изменение состояния любого плеера: управляет состоянием моста или прерывает неудачное переключение
+    void onPlayerState(VlcPlayer *player, VlcPlayer::State state);
+
+    // True while a stream is opening, playing or paused (not stopped, ended or failed)
+    // True, пока поток открывается, воспроизводится или приостановлен (не остановлен, не завершен и не упал)
+    bool hasActiveStream() const;
+
+    // Create a native player whose errors and first frames are routed to the bridge
+    // Создать нативный плеер, чьи ошибки и первые кадры направляются в мост
+    VlcPlayer *createPlayer();
+
+    // First decoded frame of either player: records start-up time or completes a switch
+    // Первый декодированный кадр любого плеера: фиксирует время запуска или завершает переключение
+    void onFirstFrame(VlcPlayer *player, qint64 elapsedMs);
+
+    // Start a switch to url (possibly the URL already playing, to retune it)
+    // Начать переключение на url (возможно, уже играющий URL - для перенастройки)
+    void beginSwitch(const QString &url);
+
+    // Open url muted in the standby player
+    // Открыть url без звука в резервном плеере
+    void openStandby(const QString &url);
+
+    // Latency settings of a stream and the libvlc media options that implement them
+    // Настройки задержки потока и параметры медиа libvlc, которые их реализуют
+    int cachingFor(const QString &url) const;
+    bool dropLateFramesFor(const QString &url) const;
+    QStringList streamOptions(const QString &url) const;
+
+    // Decoder policy of a stream (override or the global one) and applying it to a player
+    // Политика декодера потока (индивидуальная или общая) и ее применение к плееру
+    VlcPlayer::DecodePolicy decodePolicyFor(const QString &url) const;
+    void applyDecodePolicy(VlcPlayer *player, const QString &url) const;
+
+    // Transport of a stream (override or the global one)
+    // Транспорт потока (индивидуальный или общий)
+    VlcPlayer::Transport transportFor(const QString &url) const;
+
+    // Camera a URL or camera name belongs to, empty for a plain URL
+    // Камера, которой принадлежит URL или имя камеры; пусто для обычного URL
+    QString cameraFor(const QString &urlOrCamera) const;
+
+    // Stream to open for urlOrCamera in a tile of sizePx physical pixels
+    // Поток, который нужно открыть для urlOrCamera в плитке размером sizePx физических пикселей
+    QString variantFor(const QString &urlOrCamera, const QSize &sizePx) const;
+
+    // Physical pixel size of the video item on screen (empty without one)
+    // Физический размер элемента видео на экране в пикселях (пусто без него)
+    QSize tilePixelSize() const;
+
+    // Move the active camera to the variant that fits its tile now, if that changed
+    // Перевести активную камеру на вариант, подходящий ее плитке сейчас, если он изменился
+    void reselectVariant();
+
+    // Mode the active stream should be in now, from the application state and the video visibility
+    // Режим, в котором активный поток должен быть сейчас, по состоянию приложения и видимости видео
+    VlcPlayer::Visibility currentVisibility() const;
+
+    // Apply currentVisibility() to the player on screen (or the Android surface)
+    // Применить currentVisibility() к плееру на экране (или к поверхности Android)
+    void updateVisibility();
+
+    // Reopen the active stream with the current settings through a gapless standby swap
+    // Переоткрыть активный поток с текущими настройками через бесшовную замену резервным
+    void retune();
+
+    // Retune once the pause, switch, recording or replay that held a retune back has ended
+    // Перенастроить, когда закончились пауза, переключение, запись или повтор, задержавшие перенастройку
+    void applyPendingRetune();
+
+    // Feed the active stream's metrics to its latency controller and retune when advised
+    // Передать метрики активного потока его контроллеру задержки и перенастроить по совету
+    void adaptLatency();
+
+    // Swap the standby player in, keep the previous one stopped as the new standby
+    // Подменить плеер резервным, сохранив предыдущий остановленным в качестве нового резервного
+    void finishSwitch();
+
+    // Forget a pending switch and stop the standby player
+    // Отменить ожидающее переключение и остановить резервный плеер
+    void cancelSwitch();
+
+    // Stream outputs a player should feed: the recorder (active player only) and its replay buffer
+    // Потоковые выводы, которые должен питать плеер: рекордер (только активный плеер) и его буфер повтора
+    QStringList streamOutputsFor(VlcPlayer *player) const;
+
+    // Remove chain from the outputs of both players before its reader goes away
+    // Убрать chain из выводов обоих плееров до того, как исчезнет его читатель
+    void detachStreamOutput(const QString &chain);
+
+    // Start buffer if replay is enabled and it is not running yet
+    // Запустить buffer, если повтор включен, а он еще не работает
+    bool ensureReplayBuffer(ReplayBuffer *buffer);
+
+    // Detach and stop both replay buffers, giving their memory back
+    // Отключить и остановить оба буфера повтора, вернув их память
+    void stopReplayBuffers();
+
+#ifdef Q_OS_ANDROID
+    // Legacy playback through VlcSurfaceHelper's overlaid TextureView
+    // Устаревшее воспроизведение через накладываемый TextureView из VlcSurfaceHelper
+    void playInSurface(const QString &url, QObject *videoContainer, const QRectF &rectDp);
+
+    // Move the TextureView to rectPx (physical pixels)
+    // Переместить TextureView в rectPx (физические пиксели)
+    void sendSurfaceGeometry(const QRectF &rectPx);
+
+public:
+    // State reported by the MediaPlayer of VlcSurfaceHelper through JNI, already on the GUI thread
+    // state uses the VlcPlayer::State values; message is non-empty for failures
+    // Состояние, сообщенное MediaPlayer из VlcSurfaceHelper через JNI, уже в потоке GUI
+    // state использует значения VlcPlayer::State; message не пуст при сбоях
+    void onSurfaceState(int state, const QString &message);
+
+private:
+#endif
+
     // ========== MEMBER VARIABLES ==========
     // Track the current playback state to validate operations and emit signals
     // Отслеживать текущее состояние воспроизведения для проверки операций и выпуска сигналов
@@ -133,4 +638,108 @@ private:
     // Flag indicating whether video playback is currently paused
     // Флаг, указывающий, приостановлено ли воспроизведение видео в данный момент
     bool m_isPaused = false;
+
+    // Last state reported by the active decoder; the flags above are derived from it
+    // Последнее состояние, сообщенное активным декодером; флаги выше выводятся из него
+    VlcPlayer::State m_state = VlcPlayer::Idle;
+
+    // Native libvlc player whose frames are rendered by VlcVideoItem
+    // Нативный плеер libvlc, чьи кадры отрисовывает VlcVideoItem
+    VlcPlayer *m_player = nullptr;
+
+    // Second native player used to pre-open the next camera for switchTo()
+    // Второй нативный плеер для предварительного открытия следующей камеры для switchTo()
+    VlcPlayer *m_standby = nullptr;
+
+    // URL currently opened in the standby player (empty while it is idle)
+    // URL, открытый в резервном плеере (пустой, пока он простаивает)
+    QString m_standbyUrl;
+
+    // Video item the active player renders into
+    // Элемент видео, в который отрисовывает активный плеер
+    QPointer<VlcVideoItem> m_videoItem;
+
+    // Switch bookkeeping: target URL, elapsed time and a guard against streams that never start
+    // Учет переключения: целевой URL, прошедшее время и защита от потоков, которые не запускаются
+    QString m_pendingSwitchUrl;
+    QElapsedTimer m_switchTimer;
+
+    // Stream or camera preload() was asked for while the standby was busy with a switch
+    // Поток или камера, запрошенные у preload(), пока резервный плеер был занят переключением
+    QString m_queuedPreload;
+
+    // A retune of the active stream is due but was held back
+    // Перенастройка активного потока нужна, но была отложена
+    bool m_retunePending = false;
+    QTimer m_switchTimeout;
+
+    // Last measured start-up and switch times in milliseconds
+    // Последние измеренные времена запуска и переключения в миллисекундах
+    qint64 m_startupMs = -1;
+    qint64 m_lastSwitchMs = -1;
+
+    // Metrics of the active player
+    // Метрики активного плеера
+    PlaybackMetrics m_metrics;
+
+    // Selected latency profile and, for LatencyAuto, one controller per stream URL
+    // Выбранный профиль задержки и, для LatencyAuto, по одному контроллеру на URL потока
+    LatencyProfile m_latencyProfile = LatencyBalanced;
+    QHash<QString, LatencyController> m_latencyControllers;
+
+    // Decoder policy, thread cap and per-stream overrides
+    // Политика декодера, ограничение потоков и индивидуальные настройки потоков
+    VlcPlayer::DecodePolicy m_decodePolicy = VlcPlayer::DecodeAuto;
+    int m_decodeThreads = 2;
+    QHash<QString, VlcPlayer::DecodePolicy> m_streamDecodePolicies;
+
+    // RTP transport and per-stream overrides; TCP unless asked otherwise, as it passes any NAT
+    // Транспорт RTP и индивидуальные настройки потоков; TCP, если не задано иное, так как он проходит любой NAT
+    VlcPlayer::Transport m_transport = VlcPlayer::TransportTcp;
+    QHash<QString, VlcPlayer::Transport> m_streamTransports;
+
+    // Stream variants per logical camera and the debounce of tile resizes
+    // Варианты потоков для каждой логической камеры и подавление дребезга изменений размера плитки
+    QHash<QString, StreamVariants> m_cameras;
+    QTimer m_variantTimer;
+
+    // Visibility shedding: modes for the background and for a hidden video, and the QML visibility hint
+    // Сброс нагрузки по видимости: режимы для фона и для скрытого видео и подсказка видимости из QML
+    VlcPlayer::Visibility m_backgroundMode = VlcPlayer::HiddenAudioOnly;
+    VlcPlayer::Visibility m_hiddenMode = VlcPlayer::HiddenNoRender;
+    bool m_videoVisible = true;
+
+    // Writes the active stream to disk; fed by the active player's stream output
+    // Записывает активный поток на диск; питается потоковым выводом активного плеера
+    StreamRecorder m_recorder;
+
+    // Replay rings of the active and the standby player, swapped with them; the replay player
+    // plays from the active ring and m_replayAnchorMs is the arrival time of its first key frame
+    // Кольца повтора активного и резервного плеера, меняются местами вместе с ними; плеер повтора
+    // воспроизводит из активного кольца, m_replayAnchorMs - время прихода его первого ключевого кадра
+    int m_replayWindowSeconds = 0;
+    ReplayBuffer *m_replay = nullptr;
+    ReplayBuffer *m_standbyReplay = nullptr;
+    VlcPlayer *m_replayPlayer = nullptr;
+    bool m_isReplaying = false;
+    qint64 m_replayAnchorMs = 0;
+    QTimer m_replayTimer;
+
+    // Thumbnails for camera pickers, from playing streams or short keyframe-only connections
+    // Миниатюры для выбора камер из играющих потоков или коротких подключений только по ключевым кадрам
+    SnapshotService m_snapshots;
+
+    // Consumers of the active player's frames; the sink of the active player holds a reference
+    // Потребители кадров активного плеера; приемник активного плеера держит ссылку на него
+    std::shared_ptr<FrameTap> m_frameTap;
+
+    // Keeps the TextureView on top of its container with at most one relayout per frame
+    // Удерживает TextureView над его контейнером не более чем с одной перекомпоновкой за кадр
+    SurfaceGeometrySync m_geometrySync;
+
+#ifdef Q_OS_ANDROID
+    // True while the current stream plays in the Java TextureView instead of the native player
+    // True, пока текущий поток воспроизводится в Java TextureView вместо нативного плеера
+    bool m_usesSurface = false;
+#endif
 };
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <vlc/vlc.h>
+
+// VlcEngine: Process-wide owner of the single libvlc instance used by the native backend
+// The instance is created lazily on first use and shared by every VlcPlayer
+// VlcEngine: Владелец единственного экземпляра libvlc на весь процесс для нативного бэкенда
+// Экземпляр создается лениво при первом использовании и разделяется всеми VlcPlayer
+class VlcEngine
+{
+public:
+    // All methods are static - the engine lives for the whole process lifetime
+    // Все методы статические - движок живет все время работы процесса
+
+    // Return the shared libvlc instance, creating it on first call
+    // Returns nullptr if libvlc could not be initialized (see lastError())
+    // Вернуть общий экземпляр libvlc, создав его при первом вызове
+    // Возвращает nullptr, если libvlc не удалось инициализировать (см. lastError())
+    static libvlc_instance_t *instance();
+
+    // Create the instance on a background thread, so the plugin scan overlaps application start-up
+    // instead of delaying the first play(); a caller of instance() meanwhile waits for it to finish
+    // Создать экземпляр в фоновом потоке, чтобы сканирование плагинов шло параллельно запуску
+    // приложения, а не задерживало первый play(); вызвавший instance() тем временем ждет его завершения
+    static void prewarm();
+
+    // True once the instance exists; a player opened before that pays for the engine start-up
+    // True, когда экземпляр создан; плеер, открытый раньше, платит за запуск движка
+    static bool isReady();
+
+    // How long libvlc_new() took, ms (-1 until created), and whether prewarm() created the instance
+    // Сколько занял libvlc_new(), мс (-1 до создания), и создал ли экземпляр prewarm()
+    static qint64 initMs();
+    static bool wasPrewarmed();
+
+    // Human-readable description of the last libvlc failure
+    // Удобочитаемое описание последней ошибки libvlc
+    static QString lastError();
+
+private:
+    // Shared by instance() and the prewarm thread; prewarmed only labels who paid for the start-up
+    // Общая часть instance() и потока прогрева; prewarmed лишь отмечает, кто заплатил за запуск
+    static libvlc_instance_t *obtain(bool prewarmed);
+
+    // Command line options passed to libvlc_new(); mirrors VlcSurfaceHelper on Android
+    // Параметры командной строки для libvlc_new(); повторяют VlcSurfaceHelper на Android
+    static QStringList defaultOptions();
+};
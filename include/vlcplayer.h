@@ -0,0 +1,415 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QTimer>
+#include "playbackmetrics.h"
+#include "playerworker.h"
+#include <QtQml/qqmlregistration.h>
+#include <atomic>
+#include <vlc/vlc.h>
+
+class ReconnectSupervisor;
+class VideoFrameSink;
+
+// VlcPlayer: Thin C++ wrapper around one libvlc_media_player_t from the shared VlcEngine
+// Decoded frames are delivered into a VideoFrameSink and shown by VlcVideoItem
+// Control calls that may block on the decoder run on the PlayerWorker thread
+// VlcPlayer: Тонкая C++ обертка вокруг одного libvlc_media_player_t из общего VlcEngine
+// Декодированные кадры доставляются в VideoFrameSink и отображаются VlcVideoItem
+// Управляющие вызовы, которые могут блокироваться на декодере, выполняются в потоке PlayerWorker
+class VlcPlayer : public QObject
+{
+    Q_OBJECT
+    QML_ELEMENT
+    QML_UNCREATABLE("VlcPlayer instances are owned by VLCBridge")
+
+    // What the decoder is actually doing, driven by libvlc player events
+    // Что на самом деле делает декодер; управляется событиями плеера libvlc
+    Q_PROPERTY(State state READ state NOTIFY stateChanged)
+
+public:
+    // Playback state machine; every transition comes from a libvlc event, not from the command
+    // Машина состояний воспроизведения; каждый переход вызван событием libvlc, а не командой
+    enum State {
+        Idle,       // Nothing opened or stopped
+        Opening,    // open() issued, connecting / negotiating the session
+        Buffering,  // Filling the buffer before the first frame or after an underrun
+        Playing,    // Decoding and presenting frames
+        Paused,     // Paused by setPaused(true)
+        Ended,      // The source closed the stream (end of file or camera hung up)
+        Error       // libvlc reported an error; see the error() signal
+    };
+    Q_ENUM(State)
+
+    // Which decoder path a stream may use
+    // Какой путь декодирования может использовать поток
+    enum DecodePolicy {
+        DecodeAuto,             // Try hardware, fall back to software on decoder errors
+        DecodeHardware,         // Hardware only, no fallback
+        DecodeSoftware,         // Software, libvlc picks the thread count
+        DecodeSoftwareCapped    // Software with at most decodeThreads threads per stream
+    };
+    Q_ENUM(DecodePolicy)
+
+    // How RTP of an RTSP stream reaches the player. The UDP modes fall back to TCP when no packets
+    // arrive in time (firewall, NAT, a camera ignoring the client ports)
+    // Как RTP потока RTSP доходит до плеера. Режимы UDP переходят на TCP, если пакеты не приходят
+    // вовремя (межсетевой экран, NAT, камера, игнорирующая порты клиента)
+    enum Transport {
+        TransportAuto,      // UDP first; a stream that needed TCP starts on TCP next time
+        TransportTcp,       // RTP interleaved in the RTSP connection; passes NAT, adds head-of-line blocking
+        TransportUdp,       // Unicast UDP, tried again on every open()
+        TransportMulticast  // Multicast group of the camera, shared by every viewer on the segment
+    };
+    Q_ENUM(Transport)
+
+    // How much work a player does while its picture cannot be seen (application in the background,
+    // tile scrolled off or covered). Every hidden mode stops rendering and keeps the RTSP session,
+    // except HiddenKeyframes, whose decoder option needs the media reopened
+    // Сколько работы выполняет плеер, пока его картинку не видно (приложение в фоне, плитка
+    // прокручена или перекрыта). Любой скрытый режим прекращает отрисовку и сохраняет RTSP сессию,
+    // кроме HiddenKeyframes, параметр декодера которого требует переоткрытия медиа
+    enum Visibility {
+        Visible,            // Full decoding and rendering
+        HiddenNoRender,     // Decode everything, render nothing; resumes with the newest frame
+        HiddenKeyframes,    // Decode key frames only; entering and leaving reopen the media
+        HiddenAudioOnly     // Video track off, network and audio keep running; video resumes at the next key frame
+    };
+    Q_ENUM(Visibility)
+
+    explicit VlcPlayer(QObject *parent = nullptr);
+    ~VlcPlayer() override;
+
+    // Open the given MRL (rtsp://, file://, ...) and start playback
+    // options are per-media libvlc options such as ":avcodec-threads=2"
+    // Returns false and emits error() if libvlc rejected the media
+    // The stream is supervised from here on and reopened automatically after outages
+    // Открыть указанный MRL (rtsp://, file://, ...) и начать воспроизведение
+    // options - параметры libvlc для медиа, например ":avcodec-threads=2"
+    // Возвращает false и выпускает error(), если libvlc отклонил медиа
+    // С этого момента поток под наблюдением и автоматически переоткрывается после обрывов
+    bool open(const QString &url, const QStringList &options = {});
+
+    // Reopen the last URL with the same options, keeping the reconnect statistics
+    // Used by the reconnect supervisor; the engine, the libvlc player and the sink are reused
+    // Переоткрыть последний URL с теми же параметрами, сохранив статистику переподключений
+    // Используется супервизором переподключений; движок, плеер libvlc и приемник переиспользуются
+    bool reconnect();
+
+    // Pause (true) or resume (false) the current media
+    // Приостановить (true) или возобновить (false) текущее медиа
+    void setPaused(bool paused);
+
+    // Stop playback and supervision; the libvlc player itself is kept for the next open()
+    // Остановить воспроизведение и наблюдение; сам плеер libvlc сохраняется для следующего open()
+    void stop();
+
+    // Mute or unmute audio output without touching the video pipeline
+    // Включить или выключить звук, не затрагивая видеоконвейер
+    void setMuted(bool muted);
+
+    // Current state and its name for status texts and logs
+    // Текущее состояние и его имя для текстов статуса и логов
+    State state() const;
+    static QString stateName(State state);
+
+    // True once the current media has produced its first decoded frame
+    // True, как только текущее медиа выдало первый декодированный кадр
+    bool hasFrame() const;
+
+    // Receiver of decoded frames; lives as long as the player
+    // Приемник декодированных кадров; живет столько же, сколько плеер
+    VideoFrameSink *videoSink() const;
+
+    // URL passed to the last successful open()
+    // URL, переданный в последний успешный open()
+    QString url() const;
+
+    // Current media time reported by libvlc, ms (-1 without media)
+    // Текущее время медиа по данным libvlc, мс (-1 без медиа)
+    qint64 mediaTimeMs() const;
+
+    // Watchdog that detects stalls and reopens the stream with backoff
+    // Сторож, обнаруживающий зависания и переоткрывающий поток с задержкой
+    ReconnectSupervisor *supervisor() const;
+
+    // Latest metrics snapshot, refreshed every second while a media is open
+    // Последний снимок метрик, обновляется каждую секунду, пока медиа открыто
+    PlaybackMetrics metrics() const;
+
+    // Decoder selection for the next open() or reconnect; maxThreads is used by DecodeSoftwareCapped
+    // Выбор декодера для следующего open() или переподключения; maxThreads используется DecodeSoftwareCapped
+    void setDecodePolicy(DecodePolicy policy, int maxThreads = 0);
+    DecodePolicy decodePolicy() const;
+
+    // Decoder path the stream is on: "hardware", "software", "software (N threads)"
+    // or "software (fallback)" after DecodeAuto gave up on the hardware decoder
+    // Путь декодирования потока: "hardware", "software", "software (N threads)"
+    // или "software (fallback)" после того, как DecodeAuto отказался от аппаратного декодера
+    QString decoderPath() const;
+
+    // RTP transport for the next open() or reconnect
+    // Транспорт RTP для следующего open() или переподключения
+    void setTransport(Transport transport);
+    Transport transport() const;
+
+    // Transport the stream runs on: "tcp", "udp", "multicast" or "tcp (fallback)" after the UDP
+    // packets did not arrive; empty for media from application callbacks
+    // Транспорт, на котором идет поток: "tcp", "udp", "multicast" или "tcp (fallback)" после того,
+    // как пакеты UDP не пришли; пусто для медиа из колбэков приложения
+    QString transportPath() const;
+
+    // Shed or restore work according to visibility. HiddenAudioOnly acts as HiddenNoRender while
+    // stream outputs are attached: turning the video track off would cut it from them as well.
+    // The last picture stays on screen through a HiddenKeyframes reopen
+    // Сбросить или восстановить работу в соответствии с visibility. HiddenAudioOnly действует как
+    // HiddenNoRender, пока подключены потоковые выводы: выключение видеодорожки отрезало бы ее и от них.
+    // Последняя картинка остается на экране во время переоткрытия HiddenKeyframes
+    void setVisibility(Visibility visibility);
+    Visibility visibility() const;
+
+    // The mode in effect after the stream output rule above
+    // Режим, действующий с учетом правила потоковых выводов выше
+    Visibility effectiveVisibility() const;
+    static QString visibilityName(Visibility visibility);
+
+    // Duplicate the received elementary streams, without transcoding, into stream output chains
+    // (e.g. "std{access=file,mux=ts,dst=...}") next to the display; an empty list removes them. libvlc
+    // only applies stream output when a media starts, so a change restarts the current stream
+    // Дублировать принятые элементарные потоки без перекодирования в цепочки потокового вывода
+    // (например, "std{access=file,mux=ts,dst=...}") рядом с показом; пустой список убирает их. libvlc
+    // применяет потоковый вывод только при запуске медиа, поэтому изменение перезапускает текущий поток
+    void setStreamOutputs(const QStringList &chains);
+    QStringList streamOutputs() const;
+
+    // Play a media whose bytes come from the application (see libvlc_media_new_callbacks) instead
+    // of a URL; name only labels it in logs. Such a media is local, so it is not supervised
+    // Воспроизвести медиа, байты которого поставляет приложение (см. libvlc_media_new_callbacks),
+    // вместо URL; name лишь обозначает его в логах. Такое медиа локальное, поэтому не наблюдается
+    struct MediaCallbacks
+    {
+        libvlc_media_open_cb open = nullptr;
+        libvlc_media_read_cb read = nullptr;
+        libvlc_media_seek_cb seek = nullptr;
+        libvlc_media_close_cb close = nullptr;
+        void *opaque = nullptr;
+    };
+    bool openCallbacks(const QString &name, const MediaCallbacks &callbacks, const QStringList &options = {});
+
+    // Caching currently configured for the stream, used for the buffering delay estimate
+    // Кэширование, заданное для потока; используется для оценки задержки буферизации
+    void setCachingMs(int cachingMs);
+
+signals:
+    // Emitted with the libvlc error message when an operation fails
+    // Выпущено с сообщением об ошибке libvlc, когда операция не удалась
+    void error(const QString &message);
+
+    // Emitted once per open() when the first decoded frame reaches the sink
+    // elapsedMs - time from open() to that frame
+    // Выпущено один раз на open(), когда первый декодированный кадр доходит до приемника
+    // elapsedMs - время от open() до этого кадра
+    void firstFrame(qint64 elapsedMs);
+
+    // Emitted on every state transition (queued from the libvlc event thread)
+    // Выпущено при каждом переходе состояния (ставится в очередь из потока событий libvlc)
+    void stateChanged(VlcPlayer::State state);
+
+    // Forwarded from the supervisor: a reopen is scheduled / the stream came back
+    // Перенаправлено от супервизора: переоткрытие запланировано / поток восстановлен
+    void reconnectScheduled(int attempt, int delayMs);
+    void reconnected(qint64 outageMs);
+
+    // Emitted when the decoder path changes (new policy or automatic fallback)
+    // Выпущено при изменении пути декодирования (новая политика или автоматический откат)
+    void decoderPathChanged(const QString &path);
+
+    // Emitted when the transport path changes (new transport or automatic fallback)
+    // Выпущено при изменении пути транспорта (новый транспорт или автоматический откат)
+    void transportPathChanged(const QString &path);
+
+    // Emitted when setVisibility() changed the mode
+    // Выпущено, когда setVisibility() изменил режим
+    void visibilityChanged(VlcPlayer::Visibility visibility);
+
+    // Emitted after every metrics refresh
+    // Выпущено после каждого обновления метрик
+    void metricsUpdated();
+
+private slots:
+    // Queued from the sink for every frame; detects the first one after open()
+    // Ставится в очередь приемником для каждого кадра; определяет первый после open()
+    void onFrameReady();
+
+    // Poll libvlc media statistics and refresh the metrics snapshot
+    // Опросить статистику медиа libvlc и обновить снимок метрик
+    void updateMetrics();
+
+private:
+    friend class PlayerWorker;
+
+    // libvlc event callback; runs on a libvlc thread and forwards to onPlayerEvent()
+    // Колбэк событий libvlc; выполняется в потоке libvlc и передает управление onPlayerEvent()
+    static void handleEvent(const libvlc_event_t *event, void *opaque);
+
+    // Handle a player event on the thread of this object
+    // generation identifies the open() the event belongs to; events of older media are dropped
+    // value carries the event payload (buffering percent for libvlc_MediaPlayerBuffering)
+    // Обработать событие плеера в потоке этого объекта
+    // generation определяет open(), к которому относится событие; события старых медиа отбрасываются
+    // value содержит данные события (процент буферизации для libvlc_MediaPlayerBuffering)
+    void onPlayerEvent(int generation, int type, float value);
+
+    // Store a new state and notify listeners if it changed
+    // Сохранить новое состояние и уведомить слушателей, если оно изменилось
+    void setState(State state);
+
+    // Create a media for m_url (or m_callbacks) / m_options and hand it to the PlayerWorker; shared
+    // by open(), openCallbacks() and reconnect(). Unless restart is set, the worker keeps the media
+    // that is already running when it is the same one
+    // Создать медиа для m_url (или m_callbacks) / m_options и передать его PlayerWorker; общая часть
+    // open(), openCallbacks() и reconnect(). Если restart не задан, поток обработки сохраняет уже
+    // идущее медиа, когда это то же самое медиа
+    bool start(bool restart = true);
+
+    // Outcome of the play() start() posted for generation, back from the PlayerWorker; failure is
+    // the libvlc error, resumed means the running media was kept
+    // Результат запуска, отправленного start() для generation, вернувшийся от PlayerWorker; failure -
+    // ошибка libvlc, resumed означает, что идущее медиа сохранено
+    void onStartApplied(int generation, const QString &failure, bool resumed);
+
+    // True while commands posted to the PlayerWorker are queued or running; libvlc getters may
+    // wait for the worker then, so they are not called
+    // True, пока команды, отправленные PlayerWorker, стоят в очереди или выполняются; геттеры libvlc
+    // могут тогда ждать поток обработки, поэтому не вызываются
+    bool commandsPending() const;
+
+    // Decoder options for the current policy; appended after the caller's options so a cap wins
+    // Параметры декодера для текущей политики; добавляются после параметров вызывающего, чтобы ограничение победило
+    bool usesHardware() const;
+    QStringList decodeOptions() const;
+    void updateDecoderPath();
+
+    // RTP transport options for the current mode and fallback
+    // Параметры транспорта RTP для текущего режима и отката
+    bool usesUdp() const;
+    QStringList transportOptions() const;
+    void updateTransportPath();
+
+    // UDP modes: give up on UDP for this URL; the caller restarts the stream
+    // Режимы UDP: отказаться от UDP для этого URL; поток перезапускает вызывающий
+    bool fallBackToTcp(const char *reason);
+
+    // DecodeAuto: abandon the hardware decoder for this URL; the caller restarts the stream
+    // DecodeAuto: отказаться от аппаратного декодера для этого URL; поток перезапускает вызывающий
+    bool fallBackToSoftware(const char *reason);
+
+    // Bring the sink and the video track in line with the effective visibility; the track can only
+    // be turned off once the media has created it, so this is repeated on the first frame
+    // Привести приемник и видеодорожку в соответствие с действующей видимостью; дорожку можно
+    // выключить только после того, как медиа ее создало, поэтому это повторяется на первом кадре
+    void applyVisibility();
+
+    // Hand what this session found out about its stream to the SessionCache, on the first frame
+    // Передать SessionCache то, что эта сессия узнала о своем потоке, на первом кадре
+    void learnSession();
+
+    // Drop the cache entry a start used when it ends before the first frame; a stale address or
+    // stream parameters may be the cause, so the next attempt starts cold
+    // Удалить запись кэша, использованную стартом, если он завершился до первого кадра; причиной
+    // может быть устаревший адрес или параметры потока, поэтому следующая попытка стартует холодной
+    void forgetFailedStart();
+
+    // Start the shedding figures over for a new stream
+    // Начать показатели сброса нагрузки заново для нового потока
+    void resetShedding();
+
+    // Media options of the effective visibility
+    // Параметры медиа действующей видимости
+    QStringList visibilityOptions() const;
+
+    // Create the libvlc player on demand; returns false if the engine is unavailable
+    // Создать плеер libvlc по требованию; возвращает false, если движок недоступен
+    bool ensurePlayer();
+
+    // Build an error message from libvlc_errmsg() with a fallback text
+    // Сформировать сообщение об ошибке из libvlc_errmsg() с запасным текстом
+    static QString vlcError(const char *fallback);
+
+    libvlc_media_player_t *m_player = nullptr;
+    PlayerWorker::Target m_target;
+    VideoFrameSink *m_sink = nullptr;
+    ReconnectSupervisor *m_supervisor = nullptr;
+    QString m_url;
+    QStringList m_options;
+    QStringList m_streamOutputs;
+    MediaCallbacks m_callbacks;
+
+    // Decoder selection and its outcome
+    // Выбор декодера и его результат
+    DecodePolicy m_decodePolicy = DecodeAuto;
+    int m_decodeThreads = 0;
+    bool m_hardwareFailed = false;
+    QString m_decoderPath;
+
+    // Transport selection, its outcome and the UDP fallbacks since open()
+    // Выбор транспорта, его результат и откаты с UDP с момента open()
+    Transport m_transport = TransportTcp;
+    bool m_udpFailed = false;
+    QString m_transportPath;
+    int m_transportFallbacks = 0;
+
+    // Visibility and whether HiddenAudioOnly asked the worker to turn the video track off
+    // Видимость и то, просил ли HiddenAudioOnly поток обработки выключить видеодорожку
+    Visibility m_visibility = Visible;
+    bool m_videoOff = false;
+    State m_state = Idle;
+
+    // Bumped by open() and stop(); events are tagged with the generation the PlayerWorker last applied
+    // Увеличивается в open() и stop(); события помечаются поколением, последним примененным PlayerWorker
+    std::atomic<int> m_generation{0};
+
+    // Measures open() to first frame; m_hasFrame flips once per open()
+    // Измеряет время от open() до первого кадра; m_hasFrame переключается один раз на open()
+    QElapsedTimer m_openTimer;
+    bool m_hasFrame = false;
+
+    // The current start found the engine up and the stream in the SessionCache (warm), and whether
+    // it used anything from the cache at all; such an entry is dropped if the start fails
+    // Текущий старт застал движок запущенным и поток в SessionCache (теплый), и использовал ли он
+    // вообще что-либо из кэша; такая запись удаляется, если старт не удался
+    bool m_warmStart = false;
+    bool m_cacheUsed = false;
+
+    // Metrics state: snapshot, sampling timer and the previous byte counters for bitrates
+    // Состояние метрик: снимок, таймер выборки и предыдущие счетчики байтов для битрейтов
+    PlaybackMetrics m_metrics;
+    QTimer m_statsTimer;
+    QElapsedTimer m_statsClock;
+    qint64 m_lastReadBytes = 0;
+    qint64 m_lastDemuxBytes = 0;
+
+    // Shedding figures; unlike the other metrics they span the reopens of HiddenKeyframes and
+    // start over on open(). m_visibleFps is the decode rate last seen while visible
+    // Показатели сброса нагрузки; в отличие от остальных метрик они переживают переоткрытия
+    // HiddenKeyframes и начинаются заново в open(). m_visibleFps - темп декодирования, замеченный видимым
+    qint64 m_hiddenMs = 0;
+    qint64 m_rendersSkipped = 0;
+    double m_decodesSkipped = 0.0;
+    double m_visibleFps = 0.0;
+    qint64 m_lastDecodedFrames = 0;
+    qint64 m_lastUnrenderedFrames = 0;
+
+    // Reference points for the buffering delay: wall clock and media time at the first frame
+    // Опорные точки для задержки буферизации: реальное время и время медиа на первом кадре
+    qint64 m_firstFrameMediaMs = -1;
+    QElapsedTimer m_sinceFirstFrame;
+
+    // Media time last read from libvlc, reported while commands are pending
+    // Время медиа, последним прочитанное из libvlc; сообщается, пока команды не выполнены
+    mutable qint64 m_mediaTimeMs = -1;
+    int m_cachingMs = 150;
+};
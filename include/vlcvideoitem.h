@@ -0,0 +1,69 @@
+#pragma once
+
+#include <QImage>
+#include <QPointer>
+#include <QQuickItem>
+#include <QtQml/qqmlregistration.h>
+
+class VlcPlayer;
+
+// VlcVideoItem: Scene graph item that shows the frames decoded by a VlcPlayer
+// Frames arrive from libvlc video callbacks and are uploaded into a texture owned by the
+// scene graph, so the video follows QML layout, transforms and effects like any other item
+// VlcVideoItem: Элемент графа сцены, отображающий кадры, декодированные VlcPlayer
+// Кадры приходят из видео-колбэков libvlc и загружаются в текстуру, принадлежащую графу сцены,
+// поэтому видео следует QML-макету, трансформациям и эффектам, как любой другой элемент
+class VlcVideoItem : public QQuickItem
+{
+    Q_OBJECT
+    QML_ELEMENT
+
+    // Player whose frames are rendered; assigned by VLCBridge::play() or bound from QML
+    // Плеер, чьи кадры отрисовываются; назначается VLCBridge::play() или привязывается из QML
+    Q_PROPERTY(VlcPlayer *player READ player WRITE setPlayer NOTIFY playerChanged)
+
+    // Size of the decoded video in pixels (empty until the first frame arrives)
+    // Размер декодированного видео в пикселях (пустой до прихода первого кадра)
+    Q_PROPERTY(QSize videoSize READ videoSize NOTIFY videoSizeChanged)
+
+public:
+    explicit VlcVideoItem(QQuickItem *parent = nullptr);
+
+    VlcPlayer *player() const;
+    void setPlayer(VlcPlayer *player);
+
+    QSize videoSize() const;
+
+signals:
+    void playerChanged();
+    void videoSizeChanged();
+
+protected:
+    // Runs on the render thread while the GUI thread is blocked
+    // Выполняется в потоке рендеринга, пока поток GUI заблокирован
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data) override;
+
+    // Size and screen changes resize the frames the sink produces
+    // Изменения размера и экрана меняют размер кадров, которые выдает приемник
+    void geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry) override;
+    void itemChange(ItemChange change, const ItemChangeData &value) override;
+
+private slots:
+    // Called on the GUI thread for every decoded frame; schedules a repaint
+    // Вызывается в потоке GUI для каждого декодированного кадра; планирует перерисовку
+    void onFrameReady();
+
+private:
+    // Rectangle inside the item that keeps the video aspect ratio
+    // Прямоугольник внутри элемента, сохраняющий соотношение сторон видео
+    QRectF videoRect(const QSize &frameSize) const;
+
+    // Hand the item's size in physical pixels to the player's sink, so frames are converted at
+    // the size they are shown at instead of being uploaded at full resolution
+    // Передать размер элемента в физических пикселях приемнику плеера, чтобы кадры преобразовывались
+    // в том размере, в котором показываются, а не загружались в полном разрешении
+    void updateTargetSize();
+
+    QPointer<VlcPlayer> m_player;
+    QSize m_videoSize;
+};
@@ -86,47 +86,14 @@ Window {
             anchors.margins: 5
             spacing: 5
 
-            // Container where the VLC video surface will be rendered
-            // Контейнер, где будет отображаться видеоповерхность VLC
-            Item {
+            // Scene graph item that renders frames decoded by libvlc
+            // Follows the layout on its own, so no position updates have to be sent to VLCBridge
+            // Элемент графа сцены, отображающий кадры, декодированные libvlc
+            // Сам следует макету, поэтому отправлять обновления позиции в VLCBridge не нужно
+            VlcVideoItem {
                 id: videoContainer
                 Layout.fillWidth: true
                 Layout.fillHeight: true
-
-                // Monitor width changes and update VLC surface position if playing
-                // Контролировать изменения ширины и обновить позицию поверхности VLC, если воспроизведение
-                onWidthChanged: {
-                    if (vlcBridge.isPlaying) {
-                        var rect = videoContainer.mapToItem(null, 0, 0);
-                        vlcBridge.updatePosition(videoContainer, rect.x, rect.y, videoContainer.width, videoContainer.height);
-                        console.log("videoContainer width:", videoContainer.width)
-                    }
-                }
-                // Monitor height changes and update VLC surface position if playing
-                // Контролировать изменения высоты и обновить позицию поверхности VLC, если воспроизведение
-                onHeightChanged: {
-                    if (vlcBridge.isPlaying) {
-                        var rect = videoContainer.mapToItem(null, 0, 0);
-                        vlcBridge.updatePosition(videoContainer, rect.x, rect.y, videoContainer.width, videoContainer.height);
-                        console.log("videoContainer height:", videoContainer.height)
-                    }
-                }
-                // Monitor X position changes and update VLC surface position if playing
-                // Контролировать изменения позиции X и обновить позицию поверхности VLC, если воспроизведение
-                onXChanged: {
-                    if (vlcBridge.isPlaying) {
-                        var rect = videoContainer.mapToItem(null, 0, 0);
-                        vlcBridge.updatePosition(videoContainer, rect.x, rect.y, videoContainer.width, videoContainer.height);
-                    }
-                }
-                // Monitor Y position changes and update VLC surface position if playing
-                // Контролировать изменения позиции Y и обновить позицию поверхности VLC, если воспроизведение
-                onYChanged: {
-                    if (vlcBridge.isPlaying) {
-                        var rect = videoContainer.mapToItem(null, 0, 0);
-                        vlcBridge.updatePosition(videoContainer, rect.x, rect.y, videoContainer.width, videoContainer.height);
-                    }
-                }
             }
 
             // Bottom control panel containing URL input field and playback buttons
@@ -186,6 +153,18 @@ Window {
                                 // Use Qt.callLater to defer execution until next event cycle
                                 // Использовать Qt.callLater для отсрочки выполнения до следующего цикла событий
                                 Qt.callLater(function() {
+                                    // Already playing: switch cameras on the warm player without a black gap
+                                    // Уже воспроизводится: переключить камеру на прогретом плеере без черного промежутка
+                                    // Paused: continue where it stopped
+                                    // На паузе: продолжить с места остановки
+                                    if (vlcBridge.isPaused) {
+                                        vlcBridge.resume();
+                                        return;
+                                    }
+                                    if (vlcBridge.isPlaying) {
+                                        vlcBridge.switchTo(root.streamUrl);
+                                        return;
+                                    }
                                     // Get container position relative to screen root
                                     // Получить позицию контейнера относительно корневого экрана
                                     var rect = videoContainer.mapToItem(null, 0, 0);
@@ -234,9 +213,9 @@ Window {
                     Button {
                         Layout.preferredWidth: 50
                         Layout.fillHeight: true
-                        // Enable stop button when video is playing or paused
-                        // Включить кнопку остановки, когда видео воспроизводится или приостановлено
-                        enabled: root.isPlaying || root.isPaused
+                        // Enable stop button whenever a stream is open, including while it reconnects
+                        // Включить кнопку остановки, пока поток открыт, в том числе во время переподключения
+                        enabled: vlcBridge.state !== VlcPlayer.Idle
                         padding: 0
                         background: Rectangle {
                             anchors.fill: parent
@@ -259,6 +238,16 @@ Window {
                         }
                         onClicked: vlcBridge.stop()
                     }
+
+                    // Latency profile selector; the order matches VLCBridge.LatencyProfile
+                    // Выбор профиля задержки; порядок соответствует VLCBridge.LatencyProfile
+                    ComboBox {
+                        Layout.preferredWidth: 130
+                        Layout.fillHeight: true
+                        model: [qsTr("Ultra-low"), qsTr("Balanced"), qsTr("Smooth"), qsTr("Auto")]
+                        currentIndex: vlcBridge.latencyProfile
+                        onActivated: (index) => vlcBridge.latencyProfile = index
+                    }
                 }
             }
         }
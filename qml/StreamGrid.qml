@@ -0,0 +1,46 @@
+import QtQuick
+
+// Camera wall: one tile per session of the streamSessions model
+// Стена камер: одна плитка на каждую сессию модели streamSessions
+Item {
+    id: streamGrid
+
+    // Session model to display (normally the streamSessions context property)
+    // Модель сессий для отображения (обычно контекстное свойство streamSessions)
+    property var model: streamSessions
+
+    // Spacing between tiles in pixels
+    // Расстояние между плитками в пикселях
+    property int spacing: 2
+
+    // Smallest square grid that fits every session (1, 2x2, 3x3, 4x4, ...)
+    // Наименьшая квадратная сетка, вмещающая все сессии (1, 2x2, 3x3, 4x4, ...)
+    readonly property int columns: Math.max(1, Math.ceil(Math.sqrt(model ? model.count : 0)))
+
+    Grid {
+        anchors.fill: parent
+        columns: streamGrid.columns
+        spacing: streamGrid.spacing
+
+        Repeater {
+            model: streamGrid.model
+
+            // Each tile renders the frames of its own session player
+            // Каждая плитка отображает кадры плеера своей сессии
+            VlcVideoItem {
+                width: (streamGrid.width - (streamGrid.columns - 1) * streamGrid.spacing) / streamGrid.columns
+                height: (streamGrid.height - (streamGrid.columns - 1) * streamGrid.spacing) / streamGrid.columns
+                player: model.player
+
+                // Show the session state until the first frame arrives
+                // Показывать состояние сессии до прихода первого кадра
+                Text {
+                    anchors.centerIn: parent
+                    visible: parent.videoSize.width === 0
+                    color: "#888888"
+                    text: model.state
+                }
+            }
+        }
+    }
+}
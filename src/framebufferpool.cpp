@@ -0,0 +1,144 @@
+#include "framebufferpool.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <algorithm>
+
+FrameBufferPool::FrameBufferPool(qint64 idleBudgetBytes)
+    : m_idleBudgetBytes(qMax<qint64>(0, idleBudgetBytes))
+{
+}
+
+FrameBufferPool::~FrameBufferPool()
+{
+    // Buffers still in use belong to their owners; only idle ones are freed here
+    // Используемые буферы принадлежат владельцам; здесь освобождаются только простаивающие
+    for (Bucket &bucket : m_buckets) {
+        for (uchar *buffer : bucket.idle)
+            qFreeAligned(buffer);
+    }
+}
+
+FrameBufferPool &FrameBufferPool::shared()
+{
+    static FrameBufferPool pool;
+    return pool;
+}
+
+FrameBufferPool::Bucket *FrameBufferPool::bucketFor(const Key &key)
+{
+    for (Bucket &bucket : m_buckets) {
+        if (bucket.key == key)
+            return &bucket;
+    }
+    Bucket bucket;
+    bucket.key = key;
+    m_buckets.push_back(std::move(bucket));
+    return &m_buckets.back();
+}
+
+uchar *FrameBufferPool::acquire(const Key &key)
+{
+    if (key.bytes() <= 0)
+        return nullptr;
+
+    QMutexLocker locker(&m_mutex);
+    Bucket *bucket = bucketFor(key);
+    bucket->lastUsed = ++m_tick;
+    ++bucket->inUse;
+    ++m_stats.buffersInUse;
+    m_stats.bytesInUse += key.bytes();
+
+    if (!bucket->idle.empty()) {
+        uchar *buffer = bucket->idle.back();
+        bucket->idle.pop_back();
+        --m_stats.buffersIdle;
+        m_stats.bytesIdle -= key.bytes();
+        ++m_stats.reuses;
+        return buffer;
+    }
+
+    ++m_stats.allocations;
+    m_stats.highWaterBuffers = qMax(m_stats.highWaterBuffers, m_stats.buffersInUse + m_stats.buffersIdle);
+    m_stats.highWaterBytes = qMax(m_stats.highWaterBytes, m_stats.bytesInUse + m_stats.bytesIdle);
+    return static_cast<uchar *>(qMallocAligned(size_t(key.bytes()), kAlignment));
+}
+
+void FrameBufferPool::release(const Key &key, uchar *buffer)
+{
+    if (!buffer)
+        return;
+
+    QMutexLocker locker(&m_mutex);
+    Bucket *bucket = bucketFor(key);
+    bucket->lastUsed = ++m_tick;
+    bucket->inUse = qMax(0, bucket->inUse - 1);
+    bucket->idle.push_back(buffer);
+    --m_stats.buffersInUse;
+    m_stats.bytesInUse -= key.bytes();
+    ++m_stats.buffersIdle;
+    m_stats.bytesIdle += key.bytes();
+
+    if (m_stats.bytesIdle > m_idleBudgetBytes)
+        evictTo(m_idleBudgetBytes);
+}
+
+void FrameBufferPool::setIdleBudgetBytes(qint64 bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_idleBudgetBytes = qMax<qint64>(0, bytes);
+    evictTo(m_idleBudgetBytes);
+}
+
+qint64 FrameBufferPool::idleBudgetBytes() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_idleBudgetBytes;
+}
+
+void FrameBufferPool::trim()
+{
+    QMutexLocker locker(&m_mutex);
+    evictTo(0);
+}
+
+void FrameBufferPool::evictTo(qint64 budget)
+{
+    if (m_stats.bytesIdle <= budget)
+        return;
+
+    // Buckets of a resolution nobody decodes any more are the oldest and go first
+    // Корзины разрешения, которое больше никто не декодирует, самые старые и уходят первыми
+    std::sort(m_buckets.begin(), m_buckets.end(),
+              [](const Bucket &a, const Bucket &b) { return a.lastUsed < b.lastUsed; });
+
+    qint64 freed = 0;
+    for (Bucket &bucket : m_buckets) {
+        while (!bucket.idle.empty() && m_stats.bytesIdle > budget) {
+            qFreeAligned(bucket.idle.back());
+            bucket.idle.pop_back();
+            --m_stats.buffersIdle;
+            m_stats.bytesIdle -= bucket.key.bytes();
+            ++m_stats.evictions;
+            freed += bucket.key.bytes();
+        }
+        if (m_stats.bytesIdle <= budget)
+            break;
+    }
+    dropEmptyBuckets();
+
+    if (freed > 0)
+        qDebug() << "FrameBufferPool: freed" << freed / 1024 << "KiB of idle buffers";
+}
+
+void FrameBufferPool::dropEmptyBuckets()
+{
+    m_buckets.erase(std::remove_if(m_buckets.begin(), m_buckets.end(),
+                                   [](const Bucket &bucket) { return bucket.idle.empty() && bucket.inUse == 0; }),
+                    m_buckets.end());
+}
+
+FrameBufferPool::Stats FrameBufferPool::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
@@ -0,0 +1,319 @@
+#include "frametap.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <QThread>
+#include <cstring>
+
+namespace {
+
+constexpr int kMinRingSize = 2;
+constexpr int kMaxRingSize = 8;
+
+// Frames arriving this early relative to the rate limit still count as on time (display jitter)
+// Кадры, пришедшие настолько раньше срока ограничения частоты, считаются вовремя (дрожание показа)
+constexpr double kRateTolerance = 0.25;
+
+QImage::Format supportedFormat(QImage::Format format)
+{
+    switch (format) {
+    case QImage::Format_RGB32:
+    case QImage::Format_RGB888:
+    case QImage::Format_Grayscale8:
+        return format;
+    default:
+        return QImage::Format_RGB32;
+    }
+}
+
+} // namespace
+
+struct FrameTap::Subscription
+{
+    enum class SlotState { Free, Filling, Queued, Consuming };
+
+    struct Slot
+    {
+        QImage image;
+        SlotState state = SlotState::Free;
+        qint64 sequence = 0;
+        qint64 timestampMs = 0;
+    };
+
+    int id = 0;
+    FrameConsumer *consumer = nullptr;
+    Request request;
+    QThread *thread = nullptr;
+
+    // Slot states, counters and the stop flag; the ring never changes length after subscribe()
+    // Состояния слотов, счетчики и флаг остановки; длина кольца не меняется после subscribe()
+    QMutex mutex;
+    QWaitCondition wake;
+    bool stopping = false;
+    std::vector<Slot> slots;
+    Stats stats;
+
+    // Scaling state, only touched by deliver() under FrameTap::m_mutex
+    // Состояние масштабирования, используется только в deliver() под FrameTap::m_mutex
+    QSize sourceSize;
+    QSize targetSize;
+    std::vector<int> columns;   // Byte offset of the source pixel for every target column
+    double nextDueMs = -1.0;
+};
+
+FrameTap::FrameTap()
+{
+    m_clock.start();
+}
+
+FrameTap::~FrameTap()
+{
+    std::vector<int> ids;
+    {
+        QMutexLocker locker(&m_mutex);
+        for (const auto &subscription : m_subscriptions)
+            ids.push_back(subscription->id);
+    }
+    for (int id : ids)
+        unsubscribe(id);
+}
+
+int FrameTap::subscribe(FrameConsumer *consumer, const Request &request)
+{
+    if (!consumer)
+        return -1;
+
+    auto subscription = std::make_unique<Subscription>();
+    subscription->consumer = consumer;
+    subscription->request = request;
+    subscription->request.format = supportedFormat(request.format);
+    subscription->request.ringSize = qBound(kMinRingSize, request.ringSize, kMaxRingSize);
+    subscription->slots.resize(size_t(subscription->request.ringSize));
+
+    Subscription *raw = subscription.get();
+    raw->thread = QThread::create([raw]() { run(raw); });
+    raw->thread->setObjectName(QStringLiteral("FrameTapConsumer"));
+    raw->thread->start();
+
+    QMutexLocker locker(&m_mutex);
+    raw->id = m_nextId++;
+    m_subscriptions.push_back(std::move(subscription));
+    m_subscriberCount.store(int(m_subscriptions.size()), std::memory_order_release);
+    qDebug() << "FrameTap: consumer" << raw->id << "subscribed, max size" << raw->request.maxSize
+             << "format" << raw->request.format << "max fps" << raw->request.maxFps;
+    return raw->id;
+}
+
+void FrameTap::unsubscribe(int id)
+{
+    std::unique_ptr<Subscription> subscription;
+    {
+        // Holding m_mutex guarantees deliver() is not filling one of its slots right now
+        // Удержание m_mutex гарантирует, что deliver() сейчас не заполняет один из его слотов
+        QMutexLocker locker(&m_mutex);
+        for (auto it = m_subscriptions.begin(); it != m_subscriptions.end(); ++it) {
+            if ((*it)->id == id) {
+                subscription = std::move(*it);
+                m_subscriptions.erase(it);
+                break;
+            }
+        }
+        m_subscriberCount.store(int(m_subscriptions.size()), std::memory_order_release);
+    }
+    if (!subscription)
+        return;
+
+    {
+        QMutexLocker locker(&subscription->mutex);
+        subscription->stopping = true;
+        subscription->wake.wakeAll();
+    }
+    subscription->thread->wait();
+    delete subscription->thread;
+}
+
+FrameTap::Stats FrameTap::stats(int id) const
+{
+    QMutexLocker locker(&m_mutex);
+    for (const auto &subscription : m_subscriptions) {
+        if (subscription->id == id) {
+            QMutexLocker slotLocker(&subscription->mutex);
+            return subscription->stats;
+        }
+    }
+    return Stats();
+}
+
+bool FrameTap::isActive() const
+{
+    return m_subscriberCount.load(std::memory_order_acquire) > 0;
+}
+
+QSize FrameTap::requiredSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    QSize size;
+    for (const auto &subscription : m_subscriptions) {
+        const QSize bound = subscription->request.maxSize;
+        if (bound.isEmpty())
+            return QSize();
+        size = size.expandedTo(bound);
+    }
+    return size;
+}
+
+void FrameTap::deliver(const uchar *data, const QSize &size, int stride)
+{
+    if (!isActive() || !data || size.isEmpty())
+        return;
+
+    QMutexLocker locker(&m_mutex);
+    const qint64 nowMs = m_clock.elapsed();
+    const qint64 sequence = ++m_sequence;
+
+    for (const auto &entry : m_subscriptions) {
+        Subscription *s = entry.get();
+
+        // Rate limit: deliver on schedule, tolerating a little display jitter
+        // Ограничение частоты: доставлять по расписанию, допуская небольшое дрожание показа
+        if (s->request.maxFps > 0.0) {
+            const double intervalMs = 1000.0 / s->request.maxFps;
+            if (s->nextDueMs >= 0.0 && nowMs < s->nextDueMs - intervalMs * kRateTolerance) {
+                QMutexLocker slotLocker(&s->mutex);
+                ++s->stats.rateSkipped;
+                continue;
+            }
+            // Resynchronise after a pause instead of bursting to catch up
+            // После паузы синхронизироваться заново, а не догонять пачкой
+            s->nextDueMs = nowMs > s->nextDueMs + intervalMs ? nowMs + intervalMs : s->nextDueMs + intervalMs;
+        }
+
+        int index = -1;
+        {
+            QMutexLocker slotLocker(&s->mutex);
+            for (int i = 0; i < int(s->slots.size()); ++i) {
+                if (s->slots[i].state == Subscription::SlotState::Free) {
+                    index = i;
+                    break;
+                }
+            }
+            // Consumer is behind: drop this frame for it rather than wait or grow the ring
+            // Потребитель отстает: отбросить для него этот кадр, а не ждать и не расширять кольцо
+            if (index < 0) {
+                ++s->stats.dropped;
+                continue;
+            }
+            s->slots[index].state = Subscription::SlotState::Filling;
+        }
+
+        // Target size and column table only change with the source or request
+        // Размер цели и таблица столбцов меняются только вместе с источником или запросом
+        if (size != s->sourceSize) {
+            s->sourceSize = size;
+            const QSize bound = s->request.maxSize;
+            s->targetSize = bound.isEmpty() || (size.width() <= bound.width() && size.height() <= bound.height())
+                ? size
+                : size.scaled(bound, Qt::KeepAspectRatio).expandedTo(QSize(1, 1));
+            s->columns.resize(size_t(s->targetSize.width()));
+            for (int x = 0; x < s->targetSize.width(); ++x)
+                s->columns[size_t(x)] = int(qint64(x) * size.width() / s->targetSize.width()) * 4;
+        }
+
+        Subscription::Slot &slot = s->slots[size_t(index)];
+        if (slot.image.size() != s->targetSize || slot.image.format() != s->request.format) {
+            slot.image = QImage(s->targetSize, s->request.format);
+            QMutexLocker slotLocker(&s->mutex);
+            ++s->stats.allocations;
+        }
+        convert(data, size, stride, s->columns, &slot.image);
+
+        QMutexLocker slotLocker(&s->mutex);
+        slot.state = Subscription::SlotState::Queued;
+        slot.sequence = sequence;
+        slot.timestampMs = nowMs;
+        s->wake.wakeOne();
+    }
+}
+
+void FrameTap::convert(const uchar *data, const QSize &size, int stride,
+                       const std::vector<int> &columns, QImage *target)
+{
+    const int width = target->width();
+    const int height = target->height();
+    const QImage::Format format = target->format();
+
+    for (int y = 0; y < height; ++y) {
+        const uchar *src = data + qsizetype(qint64(y) * size.height() / height) * stride;
+        uchar *dst = target->scanLine(y);
+
+        switch (format) {
+        case QImage::Format_RGB32:
+            // Same layout as RV32: rows can be copied as a whole when the width is unchanged
+            // Та же раскладка, что и у RV32: при неизменной ширине строки копируются целиком
+            if (width == size.width()) {
+                std::memcpy(dst, src, size_t(width) * 4);
+            } else {
+                auto *out = reinterpret_cast<QRgb *>(dst);
+                for (int x = 0; x < width; ++x)
+                    out[x] = *reinterpret_cast<const QRgb *>(src + columns[size_t(x)]) | 0xff000000u;
+            }
+            break;
+        case QImage::Format_RGB888:
+            for (int x = 0; x < width; ++x) {
+                const QRgb pixel = *reinterpret_cast<const QRgb *>(src + columns[size_t(x)]);
+                dst[x * 3] = uchar(qRed(pixel));
+                dst[x * 3 + 1] = uchar(qGreen(pixel));
+                dst[x * 3 + 2] = uchar(qBlue(pixel));
+            }
+            break;
+        case QImage::Format_Grayscale8:
+            // BT.601 luma in 8-bit fixed point
+            // Яркость BT.601 в 8-битной фиксированной точке
+            for (int x = 0; x < width; ++x) {
+                const QRgb pixel = *reinterpret_cast<const QRgb *>(src + columns[size_t(x)]);
+                dst[x] = uchar((77 * qRed(pixel) + 150 * qGreen(pixel) + 29 * qBlue(pixel)) >> 8);
+            }
+            break;
+        default:
+            break;
+        }
+    }
+}
+
+void FrameTap::run(Subscription *subscription)
+{
+    using SlotState = Subscription::SlotState;
+    QMutexLocker locker(&subscription->mutex);
+
+    for (;;) {
+        // Oldest queued frame first, so consumers see frames in display order
+        // Сначала самый старый кадр в очереди, чтобы потребители видели кадры в порядке показа
+        int next = -1;
+        while (!subscription->stopping) {
+            for (int i = 0; i < int(subscription->slots.size()); ++i) {
+                const Subscription::Slot &slot = subscription->slots[size_t(i)];
+                if (slot.state == SlotState::Queued
+                    && (next < 0 || slot.sequence < subscription->slots[size_t(next)].sequence))
+                    next = i;
+            }
+            if (next >= 0)
+                break;
+            subscription->wake.wait(&subscription->mutex);
+        }
+        if (subscription->stopping)
+            return;
+
+        Subscription::Slot &slot = subscription->slots[size_t(next)];
+        slot.state = SlotState::Consuming;
+        FrameConsumer::Frame frame { slot.image, slot.sequence, slot.timestampMs };
+        locker.unlock();
+
+        subscription->consumer->consumeFrame(frame);
+
+        // Drop our reference before the slot is refilled, so the refill does not detach
+        // Отпустить свою ссылку до повторного заполнения слота, чтобы заполнение не вызвало отсоединения
+        frame.image = QImage();
+        locker.relock();
+        slot.state = SlotState::Free;
+        ++subscription->stats.delivered;
+    }
+}
@@ -0,0 +1,76 @@
+#include "latencycontroller.h"
+#include <QtGlobal>
+#include <cmath>
+
+namespace {
+
+// A clean link must stay stall-free this long before the buffer is shrunk, ms
+// Чистый канал должен оставаться без остановок столько времени, прежде чем буфер уменьшится, мс
+constexpr qint64 kQuietPeriodMs = 30000;
+
+// Growth after a stall and shrink step on a quiet link
+// Рост после остановки и шаг уменьшения на спокойном канале
+constexpr double kGrowFactor = 1.5;
+constexpr double kShrinkFactor = 0.7;
+
+// Headroom over the measured jitter: the buffer should absorb about four jitter periods
+// Запас над измеренным джиттером: буфер должен поглощать около четырех периодов джиттера
+constexpr double kJitterHeadroom = 4.0;
+constexpr int kJitterFloorMs = 20;
+
+// Ignore changes below this fraction of the current caching; a retune costs a reopen
+// Игнорировать изменения меньше этой доли текущего кэширования; перенастройка стоит переоткрытия
+constexpr double kMinRelativeChange = 0.25;
+
+// Below this caching late frames are dropped rather than shown late
+// Ниже этого кэширования опоздавшие кадры отбрасываются, а не показываются с опозданием
+constexpr int kDropLateBelowMs = 100;
+
+} // namespace
+
+LatencyController::LatencyController(int cachingMs)
+    : m_cachingMs(cachingMs)
+{
+    m_quietTimer.start();
+}
+
+bool LatencyController::update(const PlaybackMetrics &metrics)
+{
+    int target = m_cachingMs;
+
+    if (metrics.stallCount > m_lastStallCount) {
+        // Underrun: the buffer was too small for this link, grow right away
+        // Опустошение: буфер мал для этого канала, увеличить сразу
+        target = int(std::lround(m_cachingMs * kGrowFactor));
+        m_quietTimer.restart();
+    } else if (m_quietTimer.elapsed() >= kQuietPeriodMs) {
+        // Quiet link: shrink towards what the measured jitter actually needs
+        // Спокойный канал: уменьшить до того, что реально требует измеренный джиттер
+        const int needed = int(std::lround(metrics.jitterMs * kJitterHeadroom)) + kJitterFloorMs;
+        target = qMax(needed, int(std::lround(m_cachingMs * kShrinkFactor)));
+    }
+    m_lastStallCount = metrics.stallCount;
+
+    target = qBound(kMinCachingMs, target, kMaxCachingMs);
+    if (std::abs(target - m_cachingMs) < m_cachingMs * kMinRelativeChange)
+        return false;
+
+    m_cachingMs = target;
+    m_quietTimer.restart();
+    return true;
+}
+
+int LatencyController::cachingMs() const
+{
+    return m_cachingMs;
+}
+
+bool LatencyController::dropLateFrames() const
+{
+    return m_cachingMs < kDropLateBelowMs;
+}
+
+void LatencyController::restartMeasurement()
+{
+    m_lastStallCount = 0;
+}
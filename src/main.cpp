@@ -3,6 +3,7 @@
 #include <QQmlContext>
 #include <vlc/vlc.h>
 #include "vlcbridge.h"
+#include "streamsessionmodel.h"
 #include "androidhelper.h"
 
 int main(int argc, char *argv[])
@@ -18,6 +19,17 @@ int main(int argc, char *argv[])
     // Создать экземпляр VLCBridge для обработки функциональности потокового вещания VLC
     VLCBridge vlcBridge;
 
+    // Bring libvlc up in the background while QML loads; RTSPSTREAM_PREWARM=0 leaves it to the first play()
+    // Запустить libvlc в фоне, пока загружается QML; RTSPSTREAM_PREWARM=0 оставляет это первому play()
+    if (qgetenv("RTSPSTREAM_PREWARM") != "0")
+        vlcBridge.prewarm();
+
+    // Create the session model used by multi-camera grid layouts
+    // All of its players share the libvlc instance with vlcBridge
+    // Создать модель сессий для многокамерных сеток
+    // Все ее плееры разделяют экземпляр libvlc с vlcBridge
+    StreamSessionModel streamSessions;
+
     // Create the QML engine that will load and manage the user interface
     // Создать движок QML, который будет загружать и управлять пользовательским интерфейсом
     QQmlApplicationEngine engine;
@@ -26,6 +38,7 @@ int main(int argc, char *argv[])
     // Зарегистрировать объект vlcBridge как контекстное свойство, доступное из QML
     // Это позволяет коду QML вызывать методы vlcBridge напрямую
     engine.rootContext()->setContextProperty("vlcBridge", &vlcBridge);
+    engine.rootContext()->setContextProperty("streamSessions", &streamSessions);
 
     // Connect to the objectCreationFailed signal to handle QML loading errors
     // If QML fails to load, exit the application with error code -1
@@ -0,0 +1,228 @@
+#include "pixelkernels.h"
+#include <QByteArray>
+#include <QDebug>
+
+#if defined(RTSPSTREAM_PIXEL_X86) && defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+namespace PixelKernels {
+
+namespace detail {
+
+void i420RowTail(const uchar *y, const uchar *u, const uchar *v, quint32 *dst, int from, int width)
+{
+    for (int x = from; x < width; ++x)
+        dst[x] = yuvToRgb32(y[x], u[x / 2], v[x / 2]);
+}
+
+void nv12RowTail(const uchar *y, const uchar *uv, quint32 *dst, int from, int width)
+{
+    for (int x = from; x < width; ++x)
+        dst[x] = yuvToRgb32(y[x], uv[(x / 2) * 2], uv[(x / 2) * 2 + 1]);
+}
+
+void halveRowTail(const uchar *row0, const uchar *row1, uchar *dst, int from, int width, int pixelBytes)
+{
+    for (int x = from; x < width; ++x) {
+        for (int c = 0; c < pixelBytes; ++c) {
+            const int left = (2 * x) * pixelBytes + c;
+            const int right = left + pixelBytes;
+            dst[x * pixelBytes + c] = uchar(average(average(row0[left], row1[left]),
+                                                    average(row0[right], row1[right])));
+        }
+    }
+}
+
+void blendRowsTail(const uchar *row0, const uchar *row1, uchar *dst, int from, int bytes, int weight)
+{
+    for (int i = from; i < bytes; ++i)
+        dst[i] = uchar(blend(row0[i], row1[i], weight));
+}
+
+void blendColumnsTail(const uchar *row, const int *table, quint32 *dst, int from, int width)
+{
+    for (int x = from; x < width; ++x) {
+        const uchar *left = row + qsizetype(table[2 * x]) * 4;
+        const int weight = table[2 * x + 1];
+        auto *out = reinterpret_cast<uchar *>(dst + x);
+        for (int c = 0; c < 4; ++c)
+            out[c] = uchar(blend(left[c], left[c + 4], weight));
+    }
+}
+
+namespace {
+
+// ========== SCALAR REFERENCE ==========
+
+void i420ToRgb32(const uchar *y, int yStride, const uchar *u, int uStride, const uchar *v, int vStride,
+                 uchar *dst, int dstStride, int width, int height)
+{
+    for (int row = 0; row < height; ++row) {
+        i420RowTail(y + qsizetype(row) * yStride, u + qsizetype(row / 2) * uStride, v + qsizetype(row / 2) * vStride,
+                    reinterpret_cast<quint32 *>(dst + qsizetype(row) * dstStride), 0, width);
+    }
+}
+
+void nv12ToRgb32(const uchar *y, int yStride, const uchar *uv, int uvStride,
+                 uchar *dst, int dstStride, int width, int height)
+{
+    for (int row = 0; row < height; ++row) {
+        nv12RowTail(y + qsizetype(row) * yStride, uv + qsizetype(row / 2) * uvStride,
+                    reinterpret_cast<quint32 *>(dst + qsizetype(row) * dstStride), 0, width);
+    }
+}
+
+void halvePlane(const uchar *src, int srcStride, uchar *dst, int dstStride, int width, int height, int pixelBytes)
+{
+    for (int row = 0; row < height; ++row) {
+        const uchar *row0 = src + qsizetype(2 * row) * srcStride;
+        halveRowTail(row0, row0 + srcStride, dst + qsizetype(row) * dstStride, 0, width, pixelBytes);
+    }
+}
+
+void scaleRgb32(const uchar *src, int srcStride, int srcWidth, int srcHeight,
+                uchar *dst, int dstStride, int dstWidth, int dstHeight, uchar *scratch)
+{
+    uchar *line = columnTable(srcWidth, dstWidth, scratch);
+    const auto *table = reinterpret_cast<const int *>(scratch);
+    for (int row = 0; row < dstHeight; ++row) {
+        int first = 0;
+        int weight = 0;
+        samplePosition(row, srcHeight, dstHeight, &first, &weight);
+        const uchar *row0 = src + qsizetype(first) * srcStride;
+        blendRowsTail(row0, row0 + srcStride, line, 0, srcWidth * 4, weight);
+        blendColumnsTail(line, table, reinterpret_cast<quint32 *>(dst + qsizetype(row) * dstStride), 0, dstWidth);
+    }
+}
+
+} // namespace
+
+const Kernels &scalarKernels()
+{
+    static const Kernels table { Isa::Scalar, &i420ToRgb32, &nv12ToRgb32, &halvePlane, &scaleRgb32 };
+    return table;
+}
+
+} // namespace detail
+
+namespace {
+
+// ========== CPU FEATURES ==========
+
+// Both checks include the OS saving the wider registers on context switches
+// Обе проверки учитывают, что ОС сохраняет расширенные регистры при переключении контекста
+bool cpuHas(Isa isa)
+{
+    switch (isa) {
+    case Isa::Scalar:
+        return true;
+#if defined(RTSPSTREAM_PIXEL_X86) && defined(_MSC_VER)
+    case Isa::Sse41:
+    case Isa::Avx2: {
+        int info[4] = {};
+        __cpuid(info, 1);
+        const bool sse41 = (info[2] & (1 << 19)) != 0;
+        if (isa == Isa::Sse41)
+            return sse41;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+        if (!sse41 || !osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+            return false;
+        __cpuidex(info, 7, 0);
+        return (info[1] & (1 << 5)) != 0;
+    }
+#elif defined(RTSPSTREAM_PIXEL_X86)
+    case Isa::Sse41:
+        return __builtin_cpu_supports("sse4.1");
+    case Isa::Avx2:
+        return __builtin_cpu_supports("sse4.1") && __builtin_cpu_supports("avx2");
+#endif
+#ifdef RTSPSTREAM_PIXEL_NEON
+    case Isa::Neon:
+        return true;    // Mandatory on arm64
+#endif
+    default:
+        return false;
+    }
+}
+
+const Kernels *builtIn(Isa isa)
+{
+    switch (isa) {
+    case Isa::Scalar:
+        return &detail::scalarKernels();
+#ifdef RTSPSTREAM_PIXEL_X86
+    case Isa::Sse41:
+        return &detail::sse41Kernels();
+    case Isa::Avx2:
+        return &detail::avx2Kernels();
+#endif
+#ifdef RTSPSTREAM_PIXEL_NEON
+    case Isa::Neon:
+        return &detail::neonKernels();
+#endif
+    default:
+        return nullptr;
+    }
+}
+
+const Kernels &select()
+{
+    // Fastest first; the override only removes candidates, it cannot enable a missing feature
+    // Сначала самые быстрые; переопределение только убирает кандидатов, но не включает отсутствующее
+    const QByteArray forced = qgetenv("RTSPSTREAM_PIXEL_ISA").toLower();
+    for (Isa isa : { Isa::Avx2, Isa::Neon, Isa::Sse41, Isa::Scalar }) {
+        if (!forced.isEmpty() && forced != isaName(isa))
+            continue;
+        if (const Kernels *table = kernelsFor(isa)) {
+            qDebug() << "PixelKernels: using" << isaName(isa);
+            return *table;
+        }
+    }
+    if (!forced.isEmpty())
+        qWarning() << "PixelKernels: RTSPSTREAM_PIXEL_ISA" << forced << "is not available, using scalar";
+    return detail::scalarKernels();
+}
+
+} // namespace
+
+const Kernels &kernels()
+{
+    static const Kernels &table = select();
+    return table;
+}
+
+const Kernels *kernelsFor(Isa isa)
+{
+    const Kernels *table = builtIn(isa);
+    return table && cpuHas(isa) ? table : nullptr;
+}
+
+std::vector<Isa> supportedIsas()
+{
+    std::vector<Isa> isas;
+    for (Isa isa : { Isa::Scalar, Isa::Sse41, Isa::Avx2, Isa::Neon }) {
+        if (kernelsFor(isa))
+            isas.push_back(isa);
+    }
+    return isas;
+}
+
+const char *isaName(Isa isa)
+{
+    switch (isa) {
+    case Isa::Scalar:
+        return "scalar";
+    case Isa::Sse41:
+        return "sse4.1";
+    case Isa::Avx2:
+        return "avx2";
+    case Isa::Neon:
+        return "neon";
+    }
+    return "unknown";
+}
+
+} // namespace PixelKernels
@@ -0,0 +1,212 @@
+// Built with -mavx2; only reached after the CPU check in pixelkernels.cpp
+// Собирается с -mavx2; вызывается только после проверки процессора в pixelkernels.cpp
+#include "pixelkernels.h"
+
+#ifdef RTSPSTREAM_PIXEL_X86
+
+#include <immintrin.h>
+
+namespace PixelKernels {
+namespace detail {
+namespace {
+
+// 256-bit packs work per 128-bit lane; this puts the four 64-bit quarters back in source order
+// 256-битные упаковки работают по 128-битным половинам; это возвращает четверти в порядок источника
+constexpr int kQuarterOrder = 0xd8;   // 0, 2, 1, 3
+
+// Convert 32 pixels: y holds 32 luma bytes, u and v 16 chroma samples as 16-bit lanes already
+// centred on zero. Each chroma sample covers two neighbouring pixels
+// Преобразовать 32 пикселя: y - 32 байта яркости, u и v - 16 отсчетов цветности в 16-битных дорожках,
+// уже смещенные к нулю. Каждый отсчет цветности покрывает два соседних пикселя
+inline void convert32(__m256i y, __m256i u, __m256i v, uchar *dst)
+{
+    // Chroma quarters reordered so the in-lane unpacks duplicate samples 0-7 and 8-15
+    // Четверти цветности переставлены, чтобы распаковки внутри половин дублировали отсчеты 0-7 и 8-15
+    const __m256i rc = _mm256_permute4x64_epi64(_mm256_mullo_epi16(v, _mm256_set1_epi16(kVToR)), kQuarterOrder);
+    const __m256i gc = _mm256_permute4x64_epi64(_mm256_add_epi16(_mm256_mullo_epi16(u, _mm256_set1_epi16(kUToG)),
+                                                                 _mm256_mullo_epi16(v, _mm256_set1_epi16(kVToG))), kQuarterOrder);
+    const __m256i bc = _mm256_permute4x64_epi64(_mm256_mullo_epi16(u, _mm256_set1_epi16(kUToB)), kQuarterOrder);
+
+    const __m256i black = _mm256_set1_epi16(16);
+    const __m256i scale = _mm256_set1_epi16(kYScale);
+    const __m256i rounding = _mm256_set1_epi16(32);
+    const __m256i yLo = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(y)), black);
+    const __m256i yHi = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(y, 1)), black);
+    const __m256i lumaLo = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(yLo, scale), _mm256_srai_epi16(yLo, 1)), rounding);
+    const __m256i lumaHi = _mm256_add_epi16(_mm256_add_epi16(_mm256_mullo_epi16(yHi, scale), _mm256_srai_epi16(yHi, 1)), rounding);
+
+    // Packed bytes come out as pixels 0-7, 16-23 | 8-15, 24-31
+    // Упакованные байты выходят как пиксели 0-7, 16-23 | 8-15, 24-31
+    const __m256i r = _mm256_packus_epi16(_mm256_srai_epi16(_mm256_adds_epi16(lumaLo, _mm256_unpacklo_epi16(rc, rc)), 6),
+                                          _mm256_srai_epi16(_mm256_adds_epi16(lumaHi, _mm256_unpackhi_epi16(rc, rc)), 6));
+    const __m256i g = _mm256_packus_epi16(_mm256_srai_epi16(_mm256_subs_epi16(lumaLo, _mm256_unpacklo_epi16(gc, gc)), 6),
+                                          _mm256_srai_epi16(_mm256_subs_epi16(lumaHi, _mm256_unpackhi_epi16(gc, gc)), 6));
+    const __m256i b = _mm256_packus_epi16(_mm256_srai_epi16(_mm256_adds_epi16(lumaLo, _mm256_unpacklo_epi16(bc, bc)), 6),
+                                          _mm256_srai_epi16(_mm256_adds_epi16(lumaHi, _mm256_unpackhi_epi16(bc, bc)), 6));
+
+    const __m256i alpha = _mm256_set1_epi8(char(0xff));
+    const __m256i bgLo = _mm256_unpacklo_epi8(b, g);       // 0-7 | 8-15
+    const __m256i bgHi = _mm256_unpackhi_epi8(b, g);       // 16-23 | 24-31
+    const __m256i raLo = _mm256_unpacklo_epi8(r, alpha);
+    const __m256i raHi = _mm256_unpackhi_epi8(r, alpha);
+    const __m256i p0 = _mm256_unpacklo_epi16(bgLo, raLo);  // 0-3 | 8-11
+    const __m256i p1 = _mm256_unpackhi_epi16(bgLo, raLo);  // 4-7 | 12-15
+    const __m256i p2 = _mm256_unpacklo_epi16(bgHi, raHi);  // 16-19 | 24-27
+    const __m256i p3 = _mm256_unpackhi_epi16(bgHi, raHi);  // 20-23 | 28-31
+
+    auto *out = reinterpret_cast<__m256i *>(dst);
+    _mm256_storeu_si256(out, _mm256_permute2x128_si256(p0, p1, 0x20));
+    _mm256_storeu_si256(out + 1, _mm256_permute2x128_si256(p0, p1, 0x31));
+    _mm256_storeu_si256(out + 2, _mm256_permute2x128_si256(p2, p3, 0x20));
+    _mm256_storeu_si256(out + 3, _mm256_permute2x128_si256(p2, p3, 0x31));
+}
+
+void i420ToRgb32(const uchar *y, int yStride, const uchar *u, int uStride, const uchar *v, int vStride,
+                 uchar *dst, int dstStride, int width, int height)
+{
+    const __m256i centre = _mm256_set1_epi16(128);
+    for (int row = 0; row < height; ++row) {
+        const uchar *yRow = y + qsizetype(row) * yStride;
+        const uchar *uRow = u + qsizetype(row / 2) * uStride;
+        const uchar *vRow = v + qsizetype(row / 2) * vStride;
+        uchar *out = dst + qsizetype(row) * dstStride;
+
+        int x = 0;
+        for (; x + 32 <= width; x += 32) {
+            const __m256i uc = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(uRow + x / 2))), centre);
+            const __m256i vc = _mm256_sub_epi16(_mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(vRow + x / 2))), centre);
+            convert32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(yRow + x)), uc, vc, out + qsizetype(x) * 4);
+        }
+        i420RowTail(yRow, uRow, vRow, reinterpret_cast<quint32 *>(out), x, width);
+    }
+}
+
+void nv12ToRgb32(const uchar *y, int yStride, const uchar *uv, int uvStride,
+                 uchar *dst, int dstStride, int width, int height)
+{
+    const __m256i centre = _mm256_set1_epi16(128);
+    const __m256i lowBytes = _mm256_set1_epi16(0x00ff);
+    for (int row = 0; row < height; ++row) {
+        const uchar *yRow = y + qsizetype(row) * yStride;
+        const uchar *uvRow = uv + qsizetype(row / 2) * uvStride;
+        uchar *out = dst + qsizetype(row) * dstStride;
+
+        int x = 0;
+        for (; x + 32 <= width; x += 32) {
+            const __m256i pairs = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(uvRow + x));
+            const __m256i uc = _mm256_sub_epi16(_mm256_and_si256(pairs, lowBytes), centre);
+            const __m256i vc = _mm256_sub_epi16(_mm256_srli_epi16(pairs, 8), centre);
+            convert32(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(yRow + x)), uc, vc, out + qsizetype(x) * 4);
+        }
+        nv12RowTail(yRow, uvRow, reinterpret_cast<quint32 *>(out), x, width);
+    }
+}
+
+// 64 source bytes give 32 destination bytes
+// 64 байта источника дают 32 байта приемника
+inline __m256i halve32(const uchar *row0, const uchar *row1, int pixelBytes)
+{
+    __m256i a = _mm256_avg_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(row0)),
+                                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row1)));
+    __m256i b = _mm256_avg_epu8(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(row0 + 32)),
+                                _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row1 + 32)));
+    if (pixelBytes == 1) {
+        const __m256i mask = _mm256_set1_epi16(0x00ff);
+        a = _mm256_avg_epu16(_mm256_and_si256(a, mask), _mm256_srli_epi16(a, 8));
+        b = _mm256_avg_epu16(_mm256_and_si256(b, mask), _mm256_srli_epi16(b, 8));
+        return _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), kQuarterOrder);
+    }
+    const __m256i mask = _mm256_set1_epi32(0x0000ffff);
+    a = _mm256_avg_epu8(_mm256_and_si256(a, mask), _mm256_srli_epi32(a, 16));
+    b = _mm256_avg_epu8(_mm256_and_si256(b, mask), _mm256_srli_epi32(b, 16));
+    return _mm256_permute4x64_epi64(_mm256_packus_epi32(a, b), kQuarterOrder);
+}
+
+void halvePlane(const uchar *src, int srcStride, uchar *dst, int dstStride, int width, int height, int pixelBytes)
+{
+    const int step = 32 / pixelBytes;
+    for (int row = 0; row < height; ++row) {
+        const uchar *row0 = src + qsizetype(2 * row) * srcStride;
+        const uchar *row1 = row0 + srcStride;
+        uchar *out = dst + qsizetype(row) * dstStride;
+
+        int x = 0;
+        for (; x + step <= width; x += step) {
+            const qsizetype offset = qsizetype(x) * pixelBytes;
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + offset), halve32(row0 + 2 * offset, row1 + 2 * offset, pixelBytes));
+        }
+        halveRowTail(row0, row1, out, x, width, pixelBytes);
+    }
+}
+
+void blendRows(const uchar *row0, const uchar *row1, uchar *dst, int bytes, int weight)
+{
+    const __m256i w0 = _mm256_set1_epi16(short(256 - weight));
+    const __m256i w1 = _mm256_set1_epi16(short(weight));
+    const __m256i rounding = _mm256_set1_epi16(128);
+
+    int i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row0 + i));
+        const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(row1 + i));
+        const __m256i lo = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(
+            _mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(a)), w0),
+            _mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(b)), w1)), rounding), 8);
+        const __m256i hi = _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(
+            _mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(a, 1)), w0),
+            _mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(b, 1)), w1)), rounding), 8);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), kQuarterOrder));
+    }
+    blendRowsTail(row0, row1, dst, i, bytes, weight);
+}
+
+void scaleRgb32(const uchar *src, int srcStride, int srcWidth, int srcHeight,
+                uchar *dst, int dstStride, int dstWidth, int dstHeight, uchar *scratch)
+{
+    uchar *line = columnTable(srcWidth, dstWidth, scratch);
+    const auto *table = reinterpret_cast<const int *>(scratch);
+    const __m256i rounding = _mm256_set1_epi16(128);
+
+    for (int row = 0; row < dstHeight; ++row) {
+        int first = 0;
+        int weight = 0;
+        samplePosition(row, srcHeight, dstHeight, &first, &weight);
+        const uchar *row0 = src + qsizetype(first) * srcStride;
+        blendRows(row0, row0 + srcStride, line, srcWidth * 4, weight);
+
+        // Two destination pixels per step, one neighbour pair in each 128-bit lane
+        // Два пикселя приемника за шаг, по одной паре соседей в каждой 128-битной половине
+        auto *out = reinterpret_cast<quint32 *>(dst + qsizetype(row) * dstStride);
+        int x = 0;
+        for (; x + 2 <= dstWidth; x += 2) {
+            const short w0 = short(table[2 * x + 1]);
+            const short w1 = short(table[2 * x + 3]);
+            const short rest0 = short(256 - w0);
+            const short rest1 = short(256 - w1);
+            const __m128i left = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(line + qsizetype(table[2 * x]) * 4));
+            const __m128i right = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(line + qsizetype(table[2 * x + 2]) * 4));
+            const __m256i pairs = _mm256_cvtepu8_epi16(_mm_unpacklo_epi64(left, right));
+            __m256i sum = _mm256_mullo_epi16(pairs, _mm256_setr_epi16(rest0, rest0, rest0, rest0, w0, w0, w0, w0,
+                                                                     rest1, rest1, rest1, rest1, w1, w1, w1, w1));
+            sum = _mm256_add_epi16(sum, _mm256_srli_si256(sum, 8));
+            sum = _mm256_srli_epi16(_mm256_add_epi16(sum, rounding), 8);
+            sum = _mm256_packus_epi16(sum, sum);
+            out[x] = quint32(_mm_cvtsi128_si32(_mm256_castsi256_si128(sum)));
+            out[x + 1] = quint32(_mm_cvtsi128_si32(_mm256_extracti128_si256(sum, 1)));
+        }
+        blendColumnsTail(line, table, out, x, dstWidth);
+    }
+}
+
+} // namespace
+
+const Kernels &avx2Kernels()
+{
+    static const Kernels table { Isa::Avx2, &i420ToRgb32, &nv12ToRgb32, &halvePlane, &scaleRgb32 };
+    return table;
+}
+
+} // namespace detail
+} // namespace PixelKernels
+
+#endif // RTSPSTREAM_PIXEL_X86
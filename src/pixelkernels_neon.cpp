@@ -0,0 +1,170 @@
+// NEON is part of the arm64 baseline, so no extra flags or CPU check are needed
+// NEON входит в базовый набор arm64, поэтому дополнительные флаги и проверка процессора не нужны
+#include "pixelkernels.h"
+
+#ifdef RTSPSTREAM_PIXEL_NEON
+
+#include <arm_neon.h>
+
+namespace PixelKernels {
+namespace detail {
+namespace {
+
+inline int16x8_t widen(uint8x8_t bytes)
+{
+    return vreinterpretq_s16_u16(vmovl_u8(bytes));
+}
+
+// Convert 16 pixels: y holds 16 luma bytes, u and v 8 chroma samples already centred on zero
+// Преобразовать 16 пикселей: y - 16 байт яркости, u и v - 8 отсчетов цветности, уже смещенные к нулю
+inline void convert16(uint8x16_t y, int16x8_t u, int16x8_t v, uchar *dst)
+{
+    const int16x8_t rc = vmulq_n_s16(v, kVToR);
+    const int16x8_t gc = vaddq_s16(vmulq_n_s16(u, kUToG), vmulq_n_s16(v, kVToG));
+    const int16x8_t bc = vmulq_n_s16(u, kUToB);
+
+    const int16x8_t black = vdupq_n_s16(16);
+    const int16x8_t rounding = vdupq_n_s16(32);
+    const int16x8_t yLo = vsubq_s16(widen(vget_low_u8(y)), black);
+    const int16x8_t yHi = vsubq_s16(widen(vget_high_u8(y)), black);
+    const int16x8_t lumaLo = vaddq_s16(vaddq_s16(vmulq_n_s16(yLo, kYScale), vshrq_n_s16(yLo, 1)), rounding);
+    const int16x8_t lumaHi = vaddq_s16(vaddq_s16(vmulq_n_s16(yHi, kYScale), vshrq_n_s16(yHi, 1)), rounding);
+
+    // Zipping a chroma vector with itself covers both pixels of each sample
+    // Чередование вектора цветности с самим собой покрывает оба пикселя каждого отсчета
+    uint8x16x4_t pixels;
+    pixels.val[0] = vcombine_u8(vqmovun_s16(vshrq_n_s16(vqaddq_s16(lumaLo, vzip1q_s16(bc, bc)), 6)),
+                                vqmovun_s16(vshrq_n_s16(vqaddq_s16(lumaHi, vzip2q_s16(bc, bc)), 6)));
+    pixels.val[1] = vcombine_u8(vqmovun_s16(vshrq_n_s16(vqsubq_s16(lumaLo, vzip1q_s16(gc, gc)), 6)),
+                                vqmovun_s16(vshrq_n_s16(vqsubq_s16(lumaHi, vzip2q_s16(gc, gc)), 6)));
+    pixels.val[2] = vcombine_u8(vqmovun_s16(vshrq_n_s16(vqaddq_s16(lumaLo, vzip1q_s16(rc, rc)), 6)),
+                                vqmovun_s16(vshrq_n_s16(vqaddq_s16(lumaHi, vzip2q_s16(rc, rc)), 6)));
+    pixels.val[3] = vdupq_n_u8(0xff);
+    vst4q_u8(dst, pixels);
+}
+
+void i420ToRgb32(const uchar *y, int yStride, const uchar *u, int uStride, const uchar *v, int vStride,
+                 uchar *dst, int dstStride, int width, int height)
+{
+    const int16x8_t centre = vdupq_n_s16(128);
+    for (int row = 0; row < height; ++row) {
+        const uchar *yRow = y + qsizetype(row) * yStride;
+        const uchar *uRow = u + qsizetype(row / 2) * uStride;
+        const uchar *vRow = v + qsizetype(row / 2) * vStride;
+        uchar *out = dst + qsizetype(row) * dstStride;
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16) {
+            convert16(vld1q_u8(yRow + x), vsubq_s16(widen(vld1_u8(uRow + x / 2)), centre),
+                      vsubq_s16(widen(vld1_u8(vRow + x / 2)), centre), out + qsizetype(x) * 4);
+        }
+        i420RowTail(yRow, uRow, vRow, reinterpret_cast<quint32 *>(out), x, width);
+    }
+}
+
+void nv12ToRgb32(const uchar *y, int yStride, const uchar *uv, int uvStride,
+                 uchar *dst, int dstStride, int width, int height)
+{
+    const int16x8_t centre = vdupq_n_s16(128);
+    for (int row = 0; row < height; ++row) {
+        const uchar *yRow = y + qsizetype(row) * yStride;
+        const uchar *uvRow = uv + qsizetype(row / 2) * uvStride;
+        uchar *out = dst + qsizetype(row) * dstStride;
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16) {
+            const uint8x8x2_t pairs = vld2_u8(uvRow + x);
+            convert16(vld1q_u8(yRow + x), vsubq_s16(widen(pairs.val[0]), centre),
+                      vsubq_s16(widen(pairs.val[1]), centre), out + qsizetype(x) * 4);
+        }
+        nv12RowTail(yRow, uvRow, reinterpret_cast<quint32 *>(out), x, width);
+    }
+}
+
+// De-interleaving loads split even and odd pixels, so 32 source bytes give 16 destination bytes
+// Загрузки с разделением отделяют четные пиксели от нечетных, 32 байта источника дают 16 байт приемника
+inline uint8x16_t halve16(const uchar *row0, const uchar *row1, int pixelBytes)
+{
+    if (pixelBytes == 1) {
+        const uint8x16x2_t a = vld2q_u8(row0);
+        const uint8x16x2_t b = vld2q_u8(row1);
+        return vrhaddq_u8(vrhaddq_u8(a.val[0], b.val[0]), vrhaddq_u8(a.val[1], b.val[1]));
+    }
+    const uint16x8x2_t a = vld2q_u16(reinterpret_cast<const uint16_t *>(row0));
+    const uint16x8x2_t b = vld2q_u16(reinterpret_cast<const uint16_t *>(row1));
+    return vrhaddq_u8(vrhaddq_u8(vreinterpretq_u8_u16(a.val[0]), vreinterpretq_u8_u16(b.val[0])),
+                      vrhaddq_u8(vreinterpretq_u8_u16(a.val[1]), vreinterpretq_u8_u16(b.val[1])));
+}
+
+void halvePlane(const uchar *src, int srcStride, uchar *dst, int dstStride, int width, int height, int pixelBytes)
+{
+    const int step = 16 / pixelBytes;
+    for (int row = 0; row < height; ++row) {
+        const uchar *row0 = src + qsizetype(2 * row) * srcStride;
+        const uchar *row1 = row0 + srcStride;
+        uchar *out = dst + qsizetype(row) * dstStride;
+
+        int x = 0;
+        for (; x + step <= width; x += step) {
+            const qsizetype offset = qsizetype(x) * pixelBytes;
+            vst1q_u8(out + offset, halve16(row0 + 2 * offset, row1 + 2 * offset, pixelBytes));
+        }
+        halveRowTail(row0, row1, out, x, width, pixelBytes);
+    }
+}
+
+void blendRows(const uchar *row0, const uchar *row1, uchar *dst, int bytes, int weight)
+{
+    const uint16x8_t w0 = vdupq_n_u16(uint16_t(256 - weight));
+    const uint16x8_t w1 = vdupq_n_u16(uint16_t(weight));
+
+    int i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        const uint8x16_t a = vld1q_u8(row0 + i);
+        const uint8x16_t b = vld1q_u8(row1 + i);
+        const uint16x8_t lo = vmlaq_u16(vmulq_u16(vmovl_u8(vget_low_u8(a)), w0), vmovl_u8(vget_low_u8(b)), w1);
+        const uint16x8_t hi = vmlaq_u16(vmulq_u16(vmovl_u8(vget_high_u8(a)), w0), vmovl_u8(vget_high_u8(b)), w1);
+        vst1q_u8(dst + i, vcombine_u8(vrshrn_n_u16(lo, 8), vrshrn_n_u16(hi, 8)));
+    }
+    blendRowsTail(row0, row1, dst, i, bytes, weight);
+}
+
+void scaleRgb32(const uchar *src, int srcStride, int srcWidth, int srcHeight,
+                uchar *dst, int dstStride, int dstWidth, int dstHeight, uchar *scratch)
+{
+    uchar *line = columnTable(srcWidth, dstWidth, scratch);
+    const auto *table = reinterpret_cast<const int *>(scratch);
+
+    for (int row = 0; row < dstHeight; ++row) {
+        int first = 0;
+        int weight = 0;
+        samplePosition(row, srcHeight, dstHeight, &first, &weight);
+        const uchar *row0 = src + qsizetype(first) * srcStride;
+        blendRows(row0, row0 + srcStride, line, srcWidth * 4, weight);
+
+        // One load brings both neighbours: left pixel in the low half, right pixel in the high half
+        // Одна загрузка приносит обоих соседей: левый пиксель в нижней половине, правый - в верхней
+        auto *out = reinterpret_cast<uint32_t *>(dst + qsizetype(row) * dstStride);
+        for (int x = 0; x < dstWidth; ++x) {
+            const uint16_t w = uint16_t(table[2 * x + 1]);
+            const uint16x8_t pair = vmovl_u8(vld1_u8(line + qsizetype(table[2 * x]) * 4));
+            const uint16x8_t products = vmulq_u16(pair, vcombine_u16(vdup_n_u16(uint16_t(256 - w)), vdup_n_u16(w)));
+            const uint16x4_t sum = vadd_u16(vget_low_u16(products), vget_high_u16(products));
+            const uint8x8_t pixel = vrshrn_n_u16(vcombine_u16(sum, sum), 8);
+            vst1_lane_u32(out + x, vreinterpret_u32_u8(pixel), 0);
+        }
+    }
+}
+
+} // namespace
+
+const Kernels &neonKernels()
+{
+    static const Kernels table { Isa::Neon, &i420ToRgb32, &nv12ToRgb32, &halvePlane, &scaleRgb32 };
+    return table;
+}
+
+} // namespace detail
+} // namespace PixelKernels
+
+#endif // RTSPSTREAM_PIXEL_NEON
@@ -0,0 +1,193 @@
+// Built with -msse4.1; only reached after the CPU check in pixelkernels.cpp
+// Собирается с -msse4.1; вызывается только после проверки процессора в pixelkernels.cpp
+#include "pixelkernels.h"
+
+#ifdef RTSPSTREAM_PIXEL_X86
+
+#include <smmintrin.h>
+
+namespace PixelKernels {
+namespace detail {
+namespace {
+
+// Convert 16 pixels: y holds 16 luma bytes, u and v 8 chroma samples as 16-bit lanes already
+// centred on zero. Each chroma sample covers two neighbouring pixels
+// Преобразовать 16 пикселей: y - 16 байт яркости, u и v - 8 отсчетов цветности в 16-битных дорожках,
+// уже смещенные к нулю. Каждый отсчет цветности покрывает два соседних пикселя
+inline void convert16(__m128i y, __m128i u, __m128i v, uchar *dst)
+{
+    const __m128i rc = _mm_mullo_epi16(v, _mm_set1_epi16(kVToR));
+    const __m128i gc = _mm_add_epi16(_mm_mullo_epi16(u, _mm_set1_epi16(kUToG)),
+                                     _mm_mullo_epi16(v, _mm_set1_epi16(kVToG)));
+    const __m128i bc = _mm_mullo_epi16(u, _mm_set1_epi16(kUToB));
+
+    const __m128i black = _mm_set1_epi16(16);
+    const __m128i scale = _mm_set1_epi16(kYScale);
+    const __m128i rounding = _mm_set1_epi16(32);
+    const __m128i yLo = _mm_sub_epi16(_mm_cvtepu8_epi16(y), black);
+    const __m128i yHi = _mm_sub_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(y, 8)), black);
+    const __m128i lumaLo = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(yLo, scale), _mm_srai_epi16(yLo, 1)), rounding);
+    const __m128i lumaHi = _mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(yHi, scale), _mm_srai_epi16(yHi, 1)), rounding);
+
+    // Saturation only clips values that land above 255 after the shift anyway
+    // Насыщение обрезает только значения, которые и так оказываются выше 255 после сдвига
+    const __m128i r = _mm_packus_epi16(_mm_srai_epi16(_mm_adds_epi16(lumaLo, _mm_unpacklo_epi16(rc, rc)), 6),
+                                       _mm_srai_epi16(_mm_adds_epi16(lumaHi, _mm_unpackhi_epi16(rc, rc)), 6));
+    const __m128i g = _mm_packus_epi16(_mm_srai_epi16(_mm_subs_epi16(lumaLo, _mm_unpacklo_epi16(gc, gc)), 6),
+                                       _mm_srai_epi16(_mm_subs_epi16(lumaHi, _mm_unpackhi_epi16(gc, gc)), 6));
+    const __m128i b = _mm_packus_epi16(_mm_srai_epi16(_mm_adds_epi16(lumaLo, _mm_unpacklo_epi16(bc, bc)), 6),
+                                       _mm_srai_epi16(_mm_adds_epi16(lumaHi, _mm_unpackhi_epi16(bc, bc)), 6));
+
+    // B, G, R, A in memory is 0xAARRGGBB on little-endian
+    // B, G, R, A в памяти - это 0xAARRGGBB на little-endian
+    const __m128i alpha = _mm_set1_epi8(char(0xff));
+    const __m128i bgLo = _mm_unpacklo_epi8(b, g);
+    const __m128i bgHi = _mm_unpackhi_epi8(b, g);
+    const __m128i raLo = _mm_unpacklo_epi8(r, alpha);
+    const __m128i raHi = _mm_unpackhi_epi8(r, alpha);
+    auto *out = reinterpret_cast<__m128i *>(dst);
+    _mm_storeu_si128(out, _mm_unpacklo_epi16(bgLo, raLo));
+    _mm_storeu_si128(out + 1, _mm_unpackhi_epi16(bgLo, raLo));
+    _mm_storeu_si128(out + 2, _mm_unpacklo_epi16(bgHi, raHi));
+    _mm_storeu_si128(out + 3, _mm_unpackhi_epi16(bgHi, raHi));
+}
+
+void i420ToRgb32(const uchar *y, int yStride, const uchar *u, int uStride, const uchar *v, int vStride,
+                 uchar *dst, int dstStride, int width, int height)
+{
+    const __m128i centre = _mm_set1_epi16(128);
+    for (int row = 0; row < height; ++row) {
+        const uchar *yRow = y + qsizetype(row) * yStride;
+        const uchar *uRow = u + qsizetype(row / 2) * uStride;
+        const uchar *vRow = v + qsizetype(row / 2) * vStride;
+        uchar *out = dst + qsizetype(row) * dstStride;
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16) {
+            const __m128i uc = _mm_sub_epi16(_mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(uRow + x / 2))), centre);
+            const __m128i vc = _mm_sub_epi16(_mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(vRow + x / 2))), centre);
+            convert16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(yRow + x)), uc, vc, out + qsizetype(x) * 4);
+        }
+        i420RowTail(yRow, uRow, vRow, reinterpret_cast<quint32 *>(out), x, width);
+    }
+}
+
+void nv12ToRgb32(const uchar *y, int yStride, const uchar *uv, int uvStride,
+                 uchar *dst, int dstStride, int width, int height)
+{
+    const __m128i centre = _mm_set1_epi16(128);
+    const __m128i lowBytes = _mm_set1_epi16(0x00ff);
+    for (int row = 0; row < height; ++row) {
+        const uchar *yRow = y + qsizetype(row) * yStride;
+        const uchar *uvRow = uv + qsizetype(row / 2) * uvStride;
+        uchar *out = dst + qsizetype(row) * dstStride;
+
+        int x = 0;
+        for (; x + 16 <= width; x += 16) {
+            const __m128i pairs = _mm_loadu_si128(reinterpret_cast<const __m128i *>(uvRow + x));
+            const __m128i uc = _mm_sub_epi16(_mm_and_si128(pairs, lowBytes), centre);
+            const __m128i vc = _mm_sub_epi16(_mm_srli_epi16(pairs, 8), centre);
+            convert16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(yRow + x)), uc, vc, out + qsizetype(x) * 4);
+        }
+        nv12RowTail(yRow, uvRow, reinterpret_cast<quint32 *>(out), x, width);
+    }
+}
+
+// Average two source rows, then neighbouring pixels: 32 source bytes give 16 destination bytes
+// Усреднить две строки источника, затем соседние пиксели: 32 байта источника дают 16 байт приемника
+inline __m128i halve16(const uchar *row0, const uchar *row1, int pixelBytes)
+{
+    __m128i a = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row0)),
+                             _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1)));
+    __m128i b = _mm_avg_epu8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + 16)),
+                             _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + 16)));
+    if (pixelBytes == 1) {
+        const __m128i mask = _mm_set1_epi16(0x00ff);
+        a = _mm_avg_epu16(_mm_and_si128(a, mask), _mm_srli_epi16(a, 8));
+        b = _mm_avg_epu16(_mm_and_si128(b, mask), _mm_srli_epi16(b, 8));
+        return _mm_packus_epi16(a, b);
+    }
+    const __m128i mask = _mm_set1_epi32(0x0000ffff);
+    a = _mm_avg_epu8(_mm_and_si128(a, mask), _mm_srli_epi32(a, 16));
+    b = _mm_avg_epu8(_mm_and_si128(b, mask), _mm_srli_epi32(b, 16));
+    return _mm_packus_epi32(a, b);
+}
+
+void halvePlane(const uchar *src, int srcStride, uchar *dst, int dstStride, int width, int height, int pixelBytes)
+{
+    const int step = 16 / pixelBytes;
+    for (int row = 0; row < height; ++row) {
+        const uchar *row0 = src + qsizetype(2 * row) * srcStride;
+        const uchar *row1 = row0 + srcStride;
+        uchar *out = dst + qsizetype(row) * dstStride;
+
+        int x = 0;
+        for (; x + step <= width; x += step) {
+            const qsizetype offset = qsizetype(x) * pixelBytes;
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(out + offset), halve16(row0 + 2 * offset, row1 + 2 * offset, pixelBytes));
+        }
+        halveRowTail(row0, row1, out, x, width, pixelBytes);
+    }
+}
+
+void blendRows(const uchar *row0, const uchar *row1, uchar *dst, int bytes, int weight)
+{
+    const __m128i w0 = _mm_set1_epi16(short(256 - weight));
+    const __m128i w1 = _mm_set1_epi16(short(weight));
+    const __m128i rounding = _mm_set1_epi16(128);
+    const __m128i zero = _mm_setzero_si128();
+
+    int i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row0 + i));
+        const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(row1 + i));
+        const __m128i lo = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpacklo_epi8(a, zero), w0),
+                                                                      _mm_mullo_epi16(_mm_unpacklo_epi8(b, zero), w1)), rounding), 8);
+        const __m128i hi = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(_mm_mullo_epi16(_mm_unpackhi_epi8(a, zero), w0),
+                                                                      _mm_mullo_epi16(_mm_unpackhi_epi8(b, zero), w1)), rounding), 8);
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_packus_epi16(lo, hi));
+    }
+    blendRowsTail(row0, row1, dst, i, bytes, weight);
+}
+
+void scaleRgb32(const uchar *src, int srcStride, int srcWidth, int srcHeight,
+                uchar *dst, int dstStride, int dstWidth, int dstHeight, uchar *scratch)
+{
+    uchar *line = columnTable(srcWidth, dstWidth, scratch);
+    const auto *table = reinterpret_cast<const int *>(scratch);
+    const __m128i rounding = _mm_set1_epi16(128);
+
+    for (int row = 0; row < dstHeight; ++row) {
+        int first = 0;
+        int weight = 0;
+        samplePosition(row, srcHeight, dstHeight, &first, &weight);
+        const uchar *row0 = src + qsizetype(first) * srcStride;
+        blendRows(row0, row0 + srcStride, line, srcWidth * 4, weight);
+
+        // Both neighbours come in with one load: left pixel in lanes 0-3, right pixel in lanes 4-7
+        // Оба соседа читаются одной загрузкой: левый пиксель в дорожках 0-3, правый - в 4-7
+        auto *out = reinterpret_cast<quint32 *>(dst + qsizetype(row) * dstStride);
+        for (int x = 0; x < dstWidth; ++x) {
+            const short w = short(table[2 * x + 1]);
+            const short rest = short(256 - w);
+            const __m128i pair = _mm_cvtepu8_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(line + qsizetype(table[2 * x]) * 4)));
+            __m128i sum = _mm_mullo_epi16(pair, _mm_set_epi16(w, w, w, w, rest, rest, rest, rest));
+            sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+            sum = _mm_srli_epi16(_mm_add_epi16(sum, rounding), 8);
+            out[x] = quint32(_mm_cvtsi128_si32(_mm_packus_epi16(sum, sum)));
+        }
+    }
+}
+
+} // namespace
+
+const Kernels &sse41Kernels()
+{
+    static const Kernels table { Isa::Sse41, &i420ToRgb32, &nv12ToRgb32, &halvePlane, &scaleRgb32 };
+    return table;
+}
+
+} // namespace detail
+} // namespace PixelKernels
+
+#endif // RTSPSTREAM_PIXEL_X86
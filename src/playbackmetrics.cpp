@@ -0,0 +1,15 @@
+#include "playbackmetrics.h"
+#include <QMetaProperty>
+
+QVariantMap PlaybackMetrics::toVariantMap() const
+{
+    // Walk the gadget properties so new metrics are exported without touching this code
+    // Обойти свойства гаджета, чтобы новые метрики экспортировались без изменения этого кода
+    QVariantMap map;
+    const QMetaObject &meta = staticMetaObject;
+    for (int i = meta.propertyOffset(); i < meta.propertyCount(); ++i) {
+        const QMetaProperty property = meta.property(i);
+        map.insert(QString::fromLatin1(property.name()), property.readOnGadget(this));
+    }
+    return map;
+}
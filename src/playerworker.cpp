@@ -0,0 +1,420 @@
+#include "playerworker.h"
+#include "vlcplayer.h"
+#include <QCoreApplication>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
+#include <algorithm>
+
+namespace {
+
+// A libvlc call slower than this holds up every player queued behind it and is logged
+// Вызов libvlc медленнее этого задерживает все плееры в очереди за ним и попадает в лог
+constexpr double kSlowApplyMs = 500.0;
+
+// Running mean over count samples, the last of which is sample
+// Скользящее среднее по count отсчетам, последний из которых sample
+double runningMean(double mean, qint64 count, double sample)
+{
+    return mean + (sample - mean) / double(count);
+}
+
+} // namespace
+
+struct PlayerWorker::Command
+{
+    enum Type {
+        Play,
+        Stop,
+        Pause,
+        Mute,
+        Video,
+        Release,
+        Quit
+    };
+
+    std::atomic<Command *> next { nullptr };
+    Type type = Quit;
+    Target target;
+    libvlc_media_t *media = nullptr;    // Play: reference owned by the command
+    QString key;
+    bool restart = false;
+    int generation = 0;
+    bool flag = false;                  // Pause: paused, Mute: muted, Video: enabled
+    QObject *sink = nullptr;            // Release: deleted once the player is gone
+    QElapsedTimer posted;
+};
+
+PlayerWorker::PlayerWorker()
+    : m_stub(std::make_unique<Command>())
+{
+    m_head.store(m_stub.get());
+    m_tail = m_stub.get();
+
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName(QStringLiteral("PlayerWorker"));
+    m_thread->start();
+}
+
+PlayerWorker::~PlayerWorker()
+{
+    // Whatever was posted before still reaches libvlc, players are released in order
+    // Все отправленное ранее еще доходит до libvlc, плееры освобождаются по порядку
+    push(new Command());
+    m_wake.release();
+    m_thread->wait();
+    delete m_thread;
+
+    while (Command *command = pop())
+        discard(command);
+}
+
+PlayerWorker &PlayerWorker::shared()
+{
+    static PlayerWorker worker;
+    return worker;
+}
+
+void PlayerWorker::push(Command *command)
+{
+    command->next.store(nullptr, std::memory_order_relaxed);
+    Command *previous = m_head.exchange(command, std::memory_order_acq_rel);
+    previous->next.store(command, std::memory_order_release);
+}
+
+PlayerWorker::Command *PlayerWorker::pop()
+{
+    Command *tail = m_tail;
+    Command *next = tail->next.load(std::memory_order_acquire);
+    if (tail == m_stub.get()) {
+        if (!next)
+            return nullptr;
+        m_tail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+    if (next) {
+        m_tail = next;
+        return tail;
+    }
+
+    // A producer that swapped the head but has not linked its command yet releases the
+    // semaphore afterwards, so the worker comes back for it
+    // Производитель, сменивший голову, но еще не связавший свою команду, освобождает семафор
+    // после этого, поэтому поток обработки вернется за ней
+    if (tail != m_head.load(std::memory_order_acquire))
+        return nullptr;
+
+    push(m_stub.get());
+    next = tail->next.load(std::memory_order_acquire);
+    if (next) {
+        m_tail = next;
+        return tail;
+    }
+    return nullptr;
+}
+
+void PlayerWorker::post(Command *command)
+{
+    command->posted.start();
+    command->target.pending->fetch_add(1);
+    m_posted.fetch_add(1, std::memory_order_relaxed);
+
+    const int depth = m_depth.fetch_add(1) + 1;
+    int highWater = m_highWaterDepth.load(std::memory_order_relaxed);
+    while (depth > highWater && !m_highWaterDepth.compare_exchange_weak(highWater, depth)) {
+    }
+
+    push(command);
+    m_wake.release();
+}
+
+void PlayerWorker::play(const Target &target, libvlc_media_t *media, const QString &key, bool restart, int generation)
+{
+    auto *command = new Command();
+    command->type = Command::Play;
+    command->target = target;
+    command->media = media;
+    command->key = key;
+    command->restart = restart;
+    command->generation = generation;
+    post(command);
+}
+
+void PlayerWorker::stop(const Target &target)
+{
+    auto *command = new Command();
+    command->type = Command::Stop;
+    command->target = target;
+    post(command);
+}
+
+void PlayerWorker::setPaused(const Target &target, bool paused)
+{
+    auto *command = new Command();
+    command->type = Command::Pause;
+    command->target = target;
+    command->flag = paused;
+    post(command);
+}
+
+void PlayerWorker::setMuted(const Target &target, bool muted)
+{
+    auto *command = new Command();
+    command->type = Command::Mute;
+    command->target = target;
+    command->flag = muted;
+    post(command);
+}
+
+void PlayerWorker::setVideoEnabled(const Target &target, bool enabled)
+{
+    auto *command = new Command();
+    command->type = Command::Video;
+    command->target = target;
+    command->flag = enabled;
+    post(command);
+}
+
+void PlayerWorker::release(const Target &target, QObject *sink)
+{
+    auto *command = new Command();
+    command->type = Command::Release;
+    command->target = target;
+    command->sink = sink;
+    post(command);
+}
+
+void PlayerWorker::run()
+{
+    std::vector<Command *> batch;
+    bool quit = false;
+    while (!quit) {
+        // One wake-up takes everything posted so far; the releases it covered are spent with it
+        // Одно пробуждение забирает все, что отправлено к этому моменту; покрытые им освобождения расходуются вместе с ним
+        m_wake.acquire();
+        m_wake.tryAcquire(m_wake.available());
+
+        while (Command *command = pop()) {
+            if (command->type == Command::Quit) {
+                quit = true;
+                delete command;
+                continue;
+            }
+            batch.push_back(command);
+        }
+        if (batch.empty())
+            continue;
+
+        m_depth.fetch_sub(int(batch.size()));
+        applyBatch(batch);
+        batch.clear();
+    }
+}
+
+void PlayerWorker::applyBatch(std::vector<Command *> &batch)
+{
+    // Players in order of their first command, each with its commands in posting order
+    // Плееры в порядке их первой команды, у каждого команды в порядке отправки
+    std::vector<libvlc_media_player_t *> players;
+    QHash<libvlc_media_player_t *, std::vector<Command *>> commands;
+    for (Command *command : batch) {
+        std::vector<Command *> &list = commands[command->target.player];
+        if (list.empty())
+            players.push_back(command->target.player);
+        list.push_back(command);
+    }
+
+    for (libvlc_media_player_t *player : players) {
+        const std::vector<Command *> &list = commands[player];
+
+        // A release makes everything else moot. Otherwise the last play or stop wins; pause and
+        // video commands before it belonged to the media it replaces, mute outlives media changes
+        // Освобождение делает все остальное бессмысленным. Иначе побеждает последний запуск или
+        // остановка; команды паузы и видео до нее относились к заменяемому медиа, звук переживает смену медиа
+        std::vector<Command *> keep;
+        const auto release = std::find_if(list.begin(), list.end(), [](const Command *command) {
+            return command->type == Command::Release;
+        });
+        if (release != list.end()) {
+            keep.push_back(*release);
+        } else {
+            Command *media = nullptr;
+            Command *mute = nullptr;
+            Command *video = nullptr;
+            Command *pause = nullptr;
+            for (Command *command : list) {
+                switch (command->type) {
+                case Command::Play:
+                case Command::Stop:
+                    media = command;
+                    video = nullptr;
+                    pause = nullptr;
+                    break;
+                case Command::Mute:
+                    mute = command;
+                    break;
+                case Command::Video:
+                    video = command;
+                    break;
+                case Command::Pause:
+                    pause = command;
+                    break;
+                default:
+                    break;
+                }
+            }
+            for (Command *command : { media, mute, video, pause }) {
+                if (command)
+                    keep.push_back(command);
+            }
+        }
+
+        for (Command *command : list) {
+            if (std::find(keep.begin(), keep.end(), command) == keep.end())
+                discard(command);
+        }
+        for (Command *command : keep)
+            apply(command);
+    }
+}
+
+void PlayerWorker::apply(Command *command)
+{
+    const double latencyMs = double(command->posted.nsecsElapsed()) / 1e6;
+    QElapsedTimer clock;
+    clock.start();
+
+    libvlc_media_player_t *player = command->target.player;
+    bool skipped = false;
+    switch (command->type) {
+    case Command::Play: {
+        // The media asked for is already connecting or running: keep the session, only the
+        // video track a hidden player turned off comes back as for a new media
+        // Запрошенное медиа уже соединяется или идет: сохранить сессию, только видеодорожка,
+        // выключенная скрытым плеером, возвращается, как для нового медиа
+        PlayerState &state = m_players[player];
+        const libvlc_state_t current = libvlc_media_player_get_state(player);
+        const bool running = current == libvlc_Opening || current == libvlc_Buffering || current == libvlc_Playing;
+        QString failure;
+        if (!command->restart && !command->key.isEmpty() && command->key == state.key && running) {
+            skipped = true;
+            command->target.generation->store(command->generation);
+            if (state.disabledTrack >= 0) {
+                libvlc_video_set_track(player, state.disabledTrack);
+                state.disabledTrack = -1;
+            }
+        } else {
+            // The player keeps its own reference to the media, so ours can be dropped right away
+            // Плеер хранит собственную ссылку на медиа, поэтому нашу можно сразу освободить
+            // Events the previous media raised while it was stopped here keep the old generation
+            // События, выпущенные предыдущим медиа во время его остановки здесь, сохраняют старое поколение
+            libvlc_media_player_set_media(player, command->media);
+            command->target.generation->store(command->generation);
+            state = PlayerState();
+            if (libvlc_media_player_play(player) == 0) {
+                state.key = command->key;
+            } else {
+                // libvlc_errmsg() is per thread, so it is read here
+                // libvlc_errmsg() свой для каждого потока, поэтому читается здесь
+                const char *msg = libvlc_errmsg();
+                failure = QString::fromUtf8(msg ? msg : "Failed to start playback");
+            }
+        }
+        libvlc_media_release(command->media);
+        command->media = nullptr;
+
+        // The owner is only looked at on its own thread; the answer is dropped if it is gone
+        // Владелец проверяется только в его собственном потоке; ответ отбрасывается, если его уже нет
+        if (QCoreApplication *app = QCoreApplication::instance()) {
+            QPointer<VlcPlayer> owner = command->target.owner;
+            const int generation = command->generation;
+            QMetaObject::invokeMethod(app, [owner, generation, failure, skipped]() {
+                if (owner)
+                    owner->onStartApplied(generation, failure, skipped);
+            }, Qt::QueuedConnection);
+        }
+        break;
+    }
+    case Command::Stop:
+        libvlc_media_player_stop(player);
+        m_players[player] = PlayerState();
+        break;
+    case Command::Pause:
+        libvlc_media_player_set_pause(player, command->flag ? 1 : 0);
+        break;
+    case Command::Mute:
+        libvlc_audio_set_mute(player, command->flag ? 1 : 0);
+        break;
+    case Command::Video: {
+        PlayerState &state = m_players[player];
+        if (!command->flag) {
+            if (state.disabledTrack < 0) {
+                const int track = libvlc_video_get_track(player);
+                if (track >= 0 && libvlc_video_set_track(player, -1) == 0)
+                    state.disabledTrack = track;
+            }
+        } else if (state.disabledTrack >= 0) {
+            // The decoder restarts and shows the next key frame; until then the last picture stays
+            // Декодер перезапускается и покажет следующий ключевой кадр; до тех пор остается последняя картинка
+            libvlc_video_set_track(player, state.disabledTrack);
+            state.disabledTrack = -1;
+        }
+        break;
+    }
+    case Command::Release:
+        // Stop before release so libvlc joins its video output thread while the sink still exists
+        // Остановить перед освобождением, чтобы libvlc завершил поток видеовывода, пока приемник еще существует
+        libvlc_media_player_stop(player);
+        libvlc_media_player_release(player);
+        m_players.remove(player);
+        if (command->sink)
+            command->sink->deleteLater();
+        break;
+    case Command::Quit:
+        break;
+    }
+
+    command->target.pending->fetch_sub(1);
+    account(latencyMs, double(clock.nsecsElapsed()) / 1e6, skipped);
+    delete command;
+}
+
+void PlayerWorker::discard(Command *command)
+{
+    if (command->media)
+        libvlc_media_release(command->media);
+    command->target.pending->fetch_sub(1);
+    {
+        QMutexLocker locker(&m_statsMutex);
+        ++m_stats.coalesced;
+    }
+    delete command;
+}
+
+void PlayerWorker::account(double latencyMs, double applyMs, bool restartSkipped)
+{
+    QMutexLocker locker(&m_statsMutex);
+    ++m_stats.applied;
+    if (restartSkipped)
+        ++m_stats.restartsSkipped;
+    m_stats.lastLatencyMs = latencyMs;
+    m_stats.meanLatencyMs = runningMean(m_stats.meanLatencyMs, m_stats.applied, latencyMs);
+    m_stats.maxLatencyMs = qMax(m_stats.maxLatencyMs, latencyMs);
+    m_stats.meanApplyMs = runningMean(m_stats.meanApplyMs, m_stats.applied, applyMs);
+    m_stats.maxApplyMs = qMax(m_stats.maxApplyMs, applyMs);
+
+    if (applyMs > kSlowApplyMs)
+        qDebug() << "PlayerWorker: libvlc call took" << qRound(applyMs) << "ms";
+}
+
+PlayerWorker::Stats PlayerWorker::stats() const
+{
+    QMutexLocker locker(&m_statsMutex);
+    Stats stats = m_stats;
+    stats.depth = qMax(0, m_depth.load());
+    stats.highWaterDepth = m_highWaterDepth.load();
+    stats.posted = m_posted.load();
+    return stats;
+}
@@ -0,0 +1,228 @@
+#include "reconnectsupervisor.h"
+#include "vlcplayer.h"
+#include "videoframesink.h"
+#include <QDebug>
+#include <QRandomGenerator>
+
+namespace {
+
+// How often the player is inspected
+// Как часто проверяется плеер
+constexpr int kCheckIntervalMs = 500;
+
+// Default stall threshold: a few GOPs of a typical camera stream
+// Порог зависания по умолчанию: несколько GOP типичного потока камеры
+constexpr int kDefaultStallTimeoutMs = 4000;
+
+// A connection attempt that shows no frame within this time is given up
+// Попытка соединения, не показавшая кадр за это время, считается неудачной
+constexpr int kConnectTimeoutMs = 10000;
+
+// Backoff grows from the base delay up to the cap: 0.5, 1, 2, 4, ... 30 s
+// Задержка растет от базовой до предела: 0.5, 1, 2, 4, ... 30 с
+constexpr int kBaseBackoffMs = 500;
+constexpr int kMaxBackoffMs = 30000;
+
+} // namespace
+
+ReconnectSupervisor::ReconnectSupervisor(VlcPlayer *player)
+    : QObject(player)
+    , m_player(player)
+    , m_stallTimeoutMs(kDefaultStallTimeoutMs)
+{
+    m_checkTimer.setInterval(kCheckIntervalMs);
+    connect(&m_checkTimer, &QTimer::timeout, this, &ReconnectSupervisor::check);
+
+    m_retryTimer.setSingleShot(true);
+    connect(&m_retryTimer, &QTimer::timeout, this, &ReconnectSupervisor::retry);
+
+    connect(m_player, &VlcPlayer::stateChanged, this, &ReconnectSupervisor::onStateChanged);
+    connect(m_player, &VlcPlayer::firstFrame, this, &ReconnectSupervisor::onFirstFrame);
+}
+
+void ReconnectSupervisor::arm()
+{
+    m_armed = true;
+    m_stats = Stats();
+    m_outageClock.invalidate();
+    m_attempt = 0;
+    m_retryTimer.stop();
+    m_attemptClock.start();
+    resetProgress();
+    m_checkTimer.start();
+}
+
+void ReconnectSupervisor::disarm()
+{
+    m_armed = false;
+    m_checkTimer.stop();
+    m_retryTimer.stop();
+    m_outageClock.invalidate();
+    m_stats.currentOutageMs = 0;
+}
+
+void ReconnectSupervisor::setStallTimeoutMs(int ms)
+{
+    m_stallTimeoutMs = qMax(kCheckIntervalMs, ms);
+}
+
+int ReconnectSupervisor::stallTimeoutMs() const
+{
+    return m_stallTimeoutMs;
+}
+
+ReconnectSupervisor::Stats ReconnectSupervisor::stats() const
+{
+    Stats stats = m_stats;
+    if (m_outageClock.isValid())
+        stats.currentOutageMs = m_outageClock.elapsed();
+    return stats;
+}
+
+void ReconnectSupervisor::resetProgress()
+{
+    m_lastFrames = -1;
+    m_lastMediaTimeMs = -1;
+    m_frameClock.start();
+    m_mediaTimeClock.start();
+}
+
+void ReconnectSupervisor::onStateChanged()
+{
+    if (!m_armed)
+        return;
+
+    switch (m_player->state()) {
+    case VlcPlayer::Opening:
+        // Any restart of the stream (retry or decoder fallback) is a new connection attempt
+        // Любой перезапуск потока (повтор или откат декодера) - новая попытка соединения
+        m_attemptClock.restart();
+        resetProgress();
+        break;
+    case VlcPlayer::Ended:
+        beginOutage("stream ended");
+        break;
+    case VlcPlayer::Error:
+        beginOutage("playback error");
+        break;
+    case VlcPlayer::Playing:
+        // Coming back from pause or rebuffering must not count the idle time as a stall
+        // Возврат из паузы или повторной буферизации не должен засчитывать простой как зависание
+        resetProgress();
+        break;
+    default:
+        break;
+    }
+}
+
+void ReconnectSupervisor::onFirstFrame()
+{
+    if (!m_armed || !m_outageClock.isValid())
+        return;
+
+    m_stats.lastOutageMs = m_outageClock.elapsed();
+    m_stats.totalOutageMs += m_stats.lastOutageMs;
+    m_stats.currentOutageMs = 0;
+    ++m_stats.reconnectCount;
+    m_outageClock.invalidate();
+    m_attempt = 0;
+    resetProgress();
+
+    qDebug() << "ReconnectSupervisor:" << m_player->url() << "recovered after" << m_stats.lastOutageMs << "ms";
+    emit reconnected(m_stats.lastOutageMs);
+}
+
+void ReconnectSupervisor::check()
+{
+    if (!m_armed || m_retryTimer.isActive())
+        return;
+
+    const VlcPlayer::State state = m_player->state();
+
+    // Still connecting (first open or a retry): give it kConnectTimeoutMs to show a frame
+    // Еще соединяется (первое открытие или повтор): дать kConnectTimeoutMs на показ кадра
+    if (!m_player->hasFrame()) {
+        if (state != VlcPlayer::Paused && m_attemptClock.elapsed() > kConnectTimeoutMs)
+            beginOutage("no frame after connecting");
+        return;
+    }
+
+    if (state != VlcPlayer::Playing && state != VlcPlayer::Buffering) {
+        resetProgress();
+        return;
+    }
+
+    // A live stream must keep delivering frames and advancing its clock
+    // Живой поток должен продолжать выдавать кадры и продвигать свои часы
+    // A hidden player decoding key frames only or no video at all is judged by media time alone
+    // Скрытый плеер, декодирующий только ключевые кадры или вовсе без видео, оценивается только по времени медиа
+    const VlcPlayer::Visibility visibility = m_player->effectiveVisibility();
+    const bool everyFrame = visibility == VlcPlayer::Visible || visibility == VlcPlayer::HiddenNoRender;
+    const qint64 frames = m_player->videoSink()->timing().displayedFrames;
+    if (frames != m_lastFrames || !everyFrame) {
+        m_lastFrames = frames;
+        m_frameClock.restart();
+    }
+    const qint64 mediaTimeMs = m_player->mediaTimeMs();
+    if (mediaTimeMs != m_lastMediaTimeMs) {
+        m_lastMediaTimeMs = mediaTimeMs;
+        m_mediaTimeClock.restart();
+    }
+
+    if (m_frameClock.elapsed() > m_stallTimeoutMs)
+        beginOutage("no new frames");
+    else if (m_mediaTimeClock.elapsed() > m_stallTimeoutMs)
+        beginOutage("media time stuck");
+}
+
+void ReconnectSupervisor::beginOutage(const char *reason)
+{
+    if (m_retryTimer.isActive())
+        return;
+
+    if (m_outageClock.isValid()) {
+        // The retry in flight failed as well
+        // Выполняемый повтор тоже не удался
+        ++m_stats.failedAttempts;
+    } else {
+        m_outageClock.start();
+        m_attempt = 0;
+    }
+
+    qDebug() << "ReconnectSupervisor:" << m_player->url() << "outage:" << reason;
+    scheduleRetry();
+}
+
+int ReconnectSupervisor::backoffDelayMs(int attempt) const
+{
+    // Equal jitter: half of the exponential step is fixed, the other half random, so cameras
+    // that dropped together (switch reboot, NVR restart) do not reconnect in lockstep
+    // Равный разброс: половина экспоненциального шага фиксирована, другая случайна, чтобы камеры,
+    // отвалившиеся одновременно (перезагрузка коммутатора, NVR), не переподключались синхронно
+    const int step = int(qMin<qint64>(kMaxBackoffMs, qint64(kBaseBackoffMs) << qMin(attempt, 16)));
+    const int half = step / 2;
+    return half + int(QRandomGenerator::global()->bounded(half + 1));
+}
+
+void ReconnectSupervisor::scheduleRetry()
+{
+    const int delayMs = backoffDelayMs(m_attempt);
+    ++m_attempt;
+    m_retryTimer.start(delayMs);
+    emit reconnectScheduled(m_attempt, delayMs);
+}
+
+void ReconnectSupervisor::retry()
+{
+    if (!m_armed)
+        return;
+
+    qDebug() << "ReconnectSupervisor: reopening" << m_player->url() << "attempt" << m_attempt;
+    m_attemptClock.restart();
+    resetProgress();
+
+    // A synchronous failure (media rejected) goes straight to the next backoff step
+    // Синхронный сбой (медиа отклонено) сразу переходит к следующему шагу задержки
+    if (!m_player->reconnect())
+        beginOutage("reopen failed");
+}
@@ -0,0 +1,330 @@
+#include "replaybuffer.h"
+#include "tspacket.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <QThread>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+constexpr int kPacketSize = TsPacket::kSize;
+
+// Largest block taken from the pipe in one step
+// Наибольший блок, забираемый из канала за один шаг
+constexpr int kChunkBytes = 64 * 1024;
+
+// How often waiting threads look at the stop and interrupt flags
+// Как часто ждущие потоки проверяют флаги остановки и прерывания
+constexpr int kIdleWaitMs = 200;
+
+// Smallest ring worth having: a few seconds of a low bitrate camera
+// Наименьшее осмысленное кольцо: несколько секунд камеры с низким битрейтом
+constexpr qint64 kMinRingBytes = 1024 * 1024;
+
+} // namespace
+
+ReplayBuffer::ReplayBuffer(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ReplayBuffer::~ReplayBuffer()
+{
+    stop();
+}
+
+bool ReplayBuffer::start(const Config &config)
+{
+    if (isActive())
+        return false;
+
+    m_config = config;
+    m_config.windowSeconds = qMax(1, m_config.windowSeconds);
+    m_config.maxBytes = qMax(kMinRingBytes, m_config.maxBytes) / kPacketSize * kPacketSize;
+
+    QString message;
+    if (!m_pipe.open(QStringLiteral("rtspreplay-%1").arg(quintptr(this), 0, 16), &message)) {
+        emit error(message);
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_ring.assign(size_t(m_config.maxBytes), 0);
+        m_written = 0;
+        m_keyFrames.clear();
+        m_pat.clear();
+        m_pmt.clear();
+        m_pmtPid = -1;
+        m_nextReaderOffset = -1;
+        m_stats = Stats();
+    }
+    m_clock.start();
+    m_stopping = false;
+
+    m_thread = QThread::create([this]() { readLoop(); });
+    m_thread->setObjectName(QStringLiteral("ReplayReader"));
+    m_thread->start();
+
+    qDebug() << "ReplayBuffer: keeping" << m_config.windowSeconds << "s in up to" << m_config.maxBytes << "bytes";
+    return true;
+}
+
+void ReplayBuffer::stop()
+{
+    if (!isActive())
+        return;
+
+    m_stopping = true;
+    interruptReaders();
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+    m_pipe.close();
+
+    // Give the memory back; a replay window is only worth its ring while it is in use
+    // Вернуть память; окно повтора стоит своего кольца, только пока используется
+    QMutexLocker locker(&m_mutex);
+    std::vector<char>().swap(m_ring);
+    m_keyFrames.clear();
+    m_written = 0;
+}
+
+bool ReplayBuffer::isActive() const
+{
+    return m_thread != nullptr;
+}
+
+void ReplayBuffer::setWindowSeconds(int seconds)
+{
+    QMutexLocker locker(&m_mutex);
+    m_config.windowSeconds = qMax(1, seconds);
+}
+
+QString ReplayBuffer::streamOutput() const
+{
+    return m_pipe.streamOutput();
+}
+
+void ReplayBuffer::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_keyFrames.clear();
+    m_pat.clear();
+    m_pmt.clear();
+    m_pmtPid = -1;
+    m_nextReaderOffset = -1;
+}
+
+qint64 ReplayBuffer::nowMs() const
+{
+    return m_clock.isValid() ? m_clock.elapsed() : 0;
+}
+
+qint64 ReplayBuffer::prepareReader(qint64 msBehindLive)
+{
+    const qint64 now = nowMs();
+    QMutexLocker locker(&m_mutex);
+    trimIndex(now);
+    if (m_keyFrames.empty())
+        return -1;
+
+    // The index is ordered by arrival: the last key frame not newer than the target wins
+    // Индекс упорядочен по приходу: побеждает последний ключевой кадр не новее цели
+    const qint64 target = now - qMax<qint64>(0, msBehindLive);
+    auto chosen = m_keyFrames.cbegin();
+    for (auto it = m_keyFrames.cbegin(); it != m_keyFrames.cend() && it->arrivalMs <= target; ++it)
+        chosen = it;
+
+    m_nextReaderOffset = chosen->offset;
+    return chosen->arrivalMs;
+}
+
+VlcPlayer::MediaCallbacks ReplayBuffer::mediaCallbacks()
+{
+    VlcPlayer::MediaCallbacks callbacks;
+    callbacks.open = &ReplayBuffer::openReader;
+    callbacks.read = &ReplayBuffer::readReader;
+    callbacks.close = &ReplayBuffer::closeReader;   // No seek: positioning goes through prepareReader()
+    callbacks.opaque = this;
+    return callbacks;
+}
+
+void ReplayBuffer::interruptReaders()
+{
+    QMutexLocker locker(&m_mutex);
+    for (Reader *reader : m_readers)
+        reader->interrupted = true;
+    m_dataAvailable.wakeAll();
+}
+
+ReplayBuffer::Stats ReplayBuffer::stats() const
+{
+    const qint64 now = nowMs();
+    QMutexLocker locker(&m_mutex);
+    Stats stats = m_stats;
+    stats.bytesBuffered = qMin<qint64>(m_written, qint64(m_ring.size()));
+    stats.keyFrames = int(m_keyFrames.size());
+    stats.availableMs = m_keyFrames.empty() ? 0 : now - m_keyFrames.front().arrivalMs;
+    stats.readers = int(m_readers.size());
+    return stats;
+}
+
+int ReplayBuffer::openReader(void *opaque, void **datap, uint64_t *sizep)
+{
+    auto *self = static_cast<ReplayBuffer *>(opaque);
+    auto *reader = new Reader;
+    reader->buffer = self;
+
+    QMutexLocker locker(&self->m_mutex);
+    if (self->m_ring.empty()) {
+        delete reader;
+        return -1;
+    }
+
+    // A start that has been overwritten in the meantime falls back to the oldest key frame
+    // Начало, перезаписанное за это время, заменяется самым старым ключевым кадром
+    reader->position = self->m_nextReaderOffset >= self->oldestOffset() ? self->m_nextReaderOffset
+        : !self->m_keyFrames.empty() ? self->m_keyFrames.front().offset
+        : self->m_written;
+
+    // Tables first, so the demuxer knows the programme before the first key frame arrives
+    // Сначала таблицы, чтобы демультиплексор знал программу до прихода первого ключевого кадра
+    reader->tables = self->m_pat;
+    reader->tables.insert(reader->tables.end(), self->m_pmt.cbegin(), self->m_pmt.cend());
+    self->m_readers.push_back(reader);
+
+    *datap = reader;
+    *sizep = std::numeric_limits<uint64_t>::max();   // Unknown length: a live stream
+    return 0;
+}
+
+ssize_t ReplayBuffer::readReader(void *opaque, unsigned char *buffer, size_t length)
+{
+    auto *reader = static_cast<Reader *>(opaque);
+    ReplayBuffer *self = reader->buffer;
+
+    if (reader->tablesRead < reader->tables.size()) {
+        const size_t n = qMin(length, reader->tables.size() - reader->tablesRead);
+        std::memcpy(buffer, reader->tables.data() + reader->tablesRead, n);
+        reader->tablesRead += n;
+        return ssize_t(n);
+    }
+
+    // At the live edge a replay simply waits for the next packets, like a delayed live view
+    // У живого края повтор просто ждет следующих пакетов, как отложенный живой просмотр
+    QMutexLocker locker(&self->m_mutex);
+    while (reader->position >= self->m_written && !reader->interrupted && !self->m_stopping)
+        self->m_dataAvailable.wait(&self->m_mutex, kIdleWaitMs);
+    if (reader->interrupted || self->m_stopping)
+        return 0;
+
+    // Overtaken by the live edge (e.g. paused for longer than the ring lasts): continue at the oldest key frame
+    // Обогнан живым краем (например, пауза дольше, чем хватает кольца): продолжить с самого старого ключевого кадра
+    if (reader->position < self->oldestOffset()) {
+        reader->position = !self->m_keyFrames.empty() ? self->m_keyFrames.front().offset : self->oldestOffset();
+        ++self->m_stats.readerResyncs;
+    }
+
+    const qint64 capacity = qint64(self->m_ring.size());
+    const qint64 n = qMin<qint64>(qint64(length), self->m_written - reader->position);
+    const qint64 start = reader->position % capacity;
+    const qint64 first = qMin(n, capacity - start);
+    std::memcpy(buffer, self->m_ring.data() + start, size_t(first));
+    std::memcpy(buffer + first, self->m_ring.data(), size_t(n - first));
+    reader->position += n;
+    return ssize_t(n);
+}
+
+void ReplayBuffer::closeReader(void *opaque)
+{
+    auto *reader = static_cast<Reader *>(opaque);
+    ReplayBuffer *self = reader->buffer;
+    {
+        QMutexLocker locker(&self->m_mutex);
+        self->m_readers.erase(std::remove(self->m_readers.begin(), self->m_readers.end(), reader), self->m_readers.end());
+    }
+    delete reader;
+}
+
+void ReplayBuffer::readLoop()
+{
+    // Packets may straddle reads; the tail of one read waits in front of the next
+    // Пакеты могут пересекать границы чтений; хвост одного чтения ждет перед следующим
+    std::vector<uchar> work(size_t(kChunkBytes + kPacketSize));
+    qsizetype carried = 0;
+
+    while (!m_stopping) {
+        const qsizetype n = m_pipe.read(reinterpret_cast<char *>(work.data()) + carried, kChunkBytes, kIdleWaitMs);
+        if (n <= 0)
+            continue;
+
+        const qsizetype length = carried + n;
+        qsizetype pos = 0;
+        const qint64 now = nowMs();
+        {
+            QMutexLocker locker(&m_mutex);
+            m_stats.bytesReceived += n;
+            while (length - pos >= kPacketSize) {
+                if (!TsPacket::isSynced(work.data() + pos, length - pos)) {
+                    ++pos;
+                    ++m_stats.bytesSkipped;
+                    continue;
+                }
+                appendPacket(work.data() + pos, now);
+                pos += kPacketSize;
+            }
+            trimIndex(now);
+            m_dataAvailable.wakeAll();
+        }
+        carried = length - pos;
+        std::memmove(work.data(), work.data() + pos, size_t(carried));
+    }
+}
+
+void ReplayBuffer::appendPacket(const uchar *packet, qint64 now)
+{
+    const int pid = TsPacket::pid(packet);
+
+    // Remember the latest PAT and PMT so a replay can start at any key frame
+    // Запоминать последние PAT и PMT, чтобы повтор мог начаться с любого ключевого кадра
+    if (TsPacket::startsPayload(packet)) {
+        if (pid == 0) {
+            m_pat.assign(packet, packet + kPacketSize);
+            const int pmtPid = TsPacket::pmtPidFromPat(packet);
+            if (pmtPid >= 0)
+                m_pmtPid = pmtPid;
+        } else if (pid == m_pmtPid) {
+            m_pmt.assign(packet, packet + kPacketSize);
+        }
+    }
+
+    if (TsPacket::isRandomAccess(packet) && !m_pmt.empty())
+        m_keyFrames.push_back({ m_written, now });
+
+    // The capacity is a multiple of the packet size, so a packet never wraps
+    // Емкость кратна размеру пакета, поэтому пакет никогда не переходит через край
+    const qint64 at = m_written % qint64(m_ring.size());
+    std::memcpy(m_ring.data() + at, packet, size_t(kPacketSize));
+    m_written += kPacketSize;
+}
+
+void ReplayBuffer::trimIndex(qint64 now)
+{
+    const qint64 oldest = oldestOffset();
+    while (!m_keyFrames.empty() && m_keyFrames.front().offset < oldest)
+        m_keyFrames.pop_front();
+
+    // Keep the newest key frame at or before the window start, so the whole window stays reachable
+    // Сохранять самый новый ключевой кадр на начале окна или раньше, чтобы все окно оставалось доступным
+    const qint64 windowStart = now - qint64(m_config.windowSeconds) * 1000;
+    while (m_keyFrames.size() > 1 && m_keyFrames[1].arrivalMs <= windowStart)
+        m_keyFrames.pop_front();
+}
+
+qint64 ReplayBuffer::oldestOffset() const
+{
+    return qMax<qint64>(0, m_written - qint64(m_ring.size()));
+}
@@ -0,0 +1,237 @@
+#include "snapshotservice.h"
+#include "videoframesink.h"
+#include "vlcplayer.h"
+#include <QBuffer>
+#include <QDebug>
+#include <QTimer>
+#include <iterator>
+
+namespace {
+
+// Encoding is short and bursty (a picker asks for every camera at once); two threads keep up
+// without competing with the decoders
+// Кодирование короткое и пачками (выбор камер запрашивает все камеры сразу); двух потоков
+// достаточно, чтобы не конкурировать с декодерами
+constexpr int kEncodeThreads = 2;
+
+// Media options of a probe: no audio, only key frames decoded, a short network buffer
+// Параметры медиа зонда: без звука, декодируются только ключевые кадры, короткий сетевой буфер
+const QStringList kProbeOptions = {
+    QStringLiteral(":no-audio"),
+    QStringLiteral(":avcodec-skip-frame=3"),
+    QStringLiteral(":network-caching=300"),
+};
+
+} // namespace
+
+SnapshotService::SnapshotService(QObject *parent)
+    : QObject(parent)
+{
+    m_pool.setMaxThreadCount(kEncodeThreads);
+}
+
+SnapshotService::~SnapshotService()
+{
+    // Encoders post their results to this object; let them finish before it goes away
+    // Кодировщики отправляют результаты этому объекту; дать им завершиться до его удаления
+    m_pool.waitForDone();
+    for (Probe &probe : m_probes)
+        probe.player->stop();
+}
+
+void SnapshotService::setConfig(const Config &config)
+{
+    // Cached images were encoded with the old settings
+    // Кэшированные изображения закодированы со старыми настройками
+    if (config.maxSize != m_config.maxSize || config.format != m_config.format || config.quality != m_config.quality)
+        m_cache.clear();
+    m_config = config;
+    m_config.maxProbes = qMax(1, m_config.maxProbes);
+}
+
+SnapshotService::Config SnapshotService::config() const
+{
+    return m_config;
+}
+
+void SnapshotService::request(const QString &url, VideoFrameSink *liveSink)
+{
+    ++m_stats.requests;
+
+    const QByteArray data = cached(url);
+    if (!data.isEmpty()) {
+        ++m_stats.cacheHits;
+        QMetaObject::invokeMethod(this, [this, url, data]() { emit ready(url, data); }, Qt::QueuedConnection);
+        return;
+    }
+
+    // Whoever asked first gets the same ready() as everybody who joins later
+    // Кто спросил первым, получит тот же ready(), что и все присоединившиеся позже
+    if (m_inFlight.contains(url)) {
+        ++m_stats.merged;
+        return;
+    }
+    m_inFlight << url;
+
+    // A probe would open a second session to a camera that is already streaming to us
+    // Зонд открыл бы второй сеанс с камерой, которая уже передает нам поток
+    if (liveSink) {
+        const QImage frame = liveSink->grabFrame(m_config.maxSize);
+        if (frame.isNull()) {
+            fail(url, QStringLiteral("No frame yet"));
+            return;
+        }
+        ++m_stats.liveGrabs;
+        encode(url, frame);
+        return;
+    }
+
+    m_probeQueue << url;
+    startProbes();
+}
+
+QByteArray SnapshotService::cached(const QString &url) const
+{
+    const auto it = m_cache.constFind(url);
+    if (it == m_cache.cend() || it->age.hasExpired(m_config.ttlMs))
+        return QByteArray();
+    return it->data;
+}
+
+QString SnapshotService::mimeType() const
+{
+    return m_config.format == Png ? QStringLiteral("image/png") : QStringLiteral("image/jpeg");
+}
+
+void SnapshotService::clear()
+{
+    m_cache.clear();
+}
+
+SnapshotService::Stats SnapshotService::stats() const
+{
+    return m_stats;
+}
+
+void SnapshotService::startProbes()
+{
+    while (!m_probeQueue.isEmpty()) {
+        int index = -1;
+        for (int i = 0; i < int(m_probes.size()); ++i) {
+            if (m_probes[size_t(i)].url.isEmpty()) {
+                index = i;
+                break;
+            }
+        }
+        if (index < 0 && int(m_probes.size()) < m_config.maxProbes) {
+            index = int(m_probes.size());
+            Probe probe;
+            probe.player = new VlcPlayer(this);
+            probe.timeout = new QTimer(this);
+            probe.timeout->setSingleShot(true);
+
+            // A key frame only needs one decoder thread, and software decoding keeps the
+            // hardware decoders free for the streams on screen
+            // Для ключевого кадра достаточно одного потока декодера, а программное декодирование
+            // оставляет аппаратные декодеры потокам на экране
+            probe.player->setDecodePolicy(VlcPlayer::DecodeSoftwareCapped, 1);
+
+            connect(probe.player, &VlcPlayer::firstFrame, this, [this, index]() {
+                finishProbe(index, m_probes[size_t(index)].player->videoSink()->grabFrame(m_config.maxSize), QString());
+            });
+            connect(probe.player, &VlcPlayer::stateChanged, this, [this, index](VlcPlayer::State state) {
+                if (state == VlcPlayer::Error || state == VlcPlayer::Ended)
+                    finishProbe(index, QImage(), QStringLiteral("Stream %1").arg(VlcPlayer::stateName(state).toLower()));
+            });
+            connect(probe.timeout, &QTimer::timeout, this, [this, index]() {
+                finishProbe(index, QImage(), QStringLiteral("No key frame within %1 ms").arg(m_config.probeTimeoutMs));
+            });
+            m_probes.push_back(probe);
+        }
+        if (index < 0)
+            return;
+
+        Probe &probe = m_probes[size_t(index)];
+        probe.url = m_probeQueue.takeFirst();
+        ++m_stats.probes;
+        probe.timeout->start(m_config.probeTimeoutMs);
+
+        // The player reports open failures through its state; finishProbe() handles both
+        // Плеер сообщает об ошибках открытия через состояние; finishProbe() обрабатывает оба случая
+        if (!probe.player->open(probe.url, kProbeOptions))
+            finishProbe(index, QImage(), QStringLiteral("Cannot open stream"));
+    }
+}
+
+void SnapshotService::finishProbe(int index, const QImage &frame, const QString &message)
+{
+    Probe &probe = m_probes[size_t(index)];
+    if (probe.url.isEmpty())
+        return;
+
+    const QString url = probe.url;
+    probe.url.clear();
+    probe.timeout->stop();
+    probe.player->stop();
+
+    if (frame.isNull())
+        fail(url, message.isEmpty() ? QStringLiteral("No picture") : message);
+    else
+        encode(url, frame);
+
+    // Defer so a probe is never reopened from inside one of its own signals
+    // Отложить, чтобы зонд никогда не переоткрывался изнутри одного из своих сигналов
+    QMetaObject::invokeMethod(this, &SnapshotService::startProbes, Qt::QueuedConnection);
+}
+
+void SnapshotService::encode(const QString &url, const QImage &image)
+{
+    const Config config = m_config;
+
+    // The destructor waits for the pool, so the service outlives every task
+    // Деструктор ждет пул, поэтому сервис переживает каждую задачу
+    m_pool.start([this, url, image, config]() {
+        const QImage scaled = image.width() > config.maxSize.width() || image.height() > config.maxSize.height()
+            ? image.scaled(config.maxSize, Qt::KeepAspectRatio, Qt::SmoothTransformation)
+            : image;
+
+        QByteArray data;
+        QBuffer buffer(&data);
+        buffer.open(QIODevice::WriteOnly);
+        if (config.format == Png)
+            scaled.save(&buffer, "PNG");
+        else
+            scaled.save(&buffer, "JPEG", config.quality);
+
+        QMetaObject::invokeMethod(this, [this, url, data]() { onEncoded(url, data); }, Qt::QueuedConnection);
+    });
+}
+
+void SnapshotService::onEncoded(const QString &url, const QByteArray &data)
+{
+    if (data.isEmpty()) {
+        fail(url, QStringLiteral("Encoding failed"));
+        return;
+    }
+
+    ++m_stats.encoded;
+    m_inFlight.removeAll(url);
+
+    // Expired entries are dropped here, so the cache never outgrows the set of cameras in use
+    // Просроченные записи удаляются здесь, поэтому кэш не перерастает набор используемых камер
+    for (auto it = m_cache.begin(); it != m_cache.end();)
+        it = it->age.hasExpired(m_config.ttlMs) ? m_cache.erase(it) : std::next(it);
+
+    Entry &entry = m_cache[url];
+    entry.data = data;
+    entry.age.start();
+    emit ready(url, data);
+}
+
+void SnapshotService::fail(const QString &url, const QString &message)
+{
+    ++m_stats.failures;
+    m_inFlight.removeAll(url);
+    qWarning() << "SnapshotService:" << url << message;
+    emit failed(url, message);
+}
@@ -0,0 +1,350 @@
+#include "streamrecorder.h"
+#include "tspacket.h"
+#include <QDateTime>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QMutexLocker>
+#include <QThread>
+#include <cstring>
+
+namespace {
+
+constexpr int kPacketSize = TsPacket::kSize;
+
+// Largest block moved between the pipe, the ring and the writer in one step
+// Наибольший блок, перемещаемый между каналом, кольцом и записью за один шаг
+constexpr int kChunkBytes = 64 * 1024;
+
+// How often the threads look at the stop flag while idle
+// Как часто потоки проверяют флаг остановки в простое
+constexpr int kIdleWaitMs = 200;
+
+// A segment that found no key frame for this many target lengths is cut anyway
+// Сегмент, не встретивший ключевой кадр за столько целевых длительностей, режется принудительно
+constexpr int kOverdueFactor = 2;
+
+} // namespace
+
+StreamRecorder::StreamRecorder(QObject *parent)
+    : QObject(parent)
+{
+}
+
+StreamRecorder::~StreamRecorder()
+{
+    stop();
+}
+
+bool StreamRecorder::start(const Config &config)
+{
+    if (isRecording())
+        return false;
+
+    m_config = config;
+    m_config.segmentSeconds = qMax(1, m_config.segmentSeconds);
+    m_config.bufferBytes = qMax(kChunkBytes * 4, m_config.bufferBytes);
+    if (m_config.directory.isEmpty() || !QDir().mkpath(m_config.directory)) {
+        emit error(QStringLiteral("Cannot create recording directory %1").arg(m_config.directory));
+        return false;
+    }
+
+    QString message;
+    if (!m_pipe.open(QStringLiteral("rtsprec-%1").arg(quintptr(this), 0, 16), &message)) {
+        emit error(message);
+        return false;
+    }
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_ring.assign(size_t(m_config.bufferBytes), 0);
+        m_ringHead = 0;
+        m_ringSize = 0;
+        m_stats = Stats();
+    }
+    m_segmentBytes = 0;
+    m_bytesWritten = 0;
+    m_finishedSegments.clear();
+    m_pat.clear();
+    m_pmt.clear();
+    m_pmtPid = -1;
+    m_failed = false;
+    m_stopping = false;
+
+    m_reader = QThread::create([this]() { readLoop(); });
+    m_writer = QThread::create([this]() { writeLoop(); });
+    m_reader->setObjectName(QStringLiteral("RecorderReader"));
+    m_writer->setObjectName(QStringLiteral("RecorderWriter"));
+    m_reader->start();
+    m_writer->start();
+
+    qDebug() << "StreamRecorder: recording to" << m_config.directory << "segments of" << m_config.segmentSeconds << "s";
+    return true;
+}
+
+void StreamRecorder::stop()
+{
+    if (!isRecording())
+        return;
+
+    // The writer drains what is left in the ring, then closes the last segment
+    // Поток записи дописывает остаток кольца, затем закрывает последний сегмент
+    m_stopping = true;
+    m_dataAvailable.wakeAll();
+    m_reader->wait();
+    m_writer->wait();
+    delete m_reader;
+    delete m_writer;
+    m_reader = nullptr;
+    m_writer = nullptr;
+
+    m_pipe.close();
+
+    const Stats final = stats();
+    qDebug() << "StreamRecorder: stopped," << final.bytesWritten << "bytes in" << final.segments
+             << "segments," << final.bytesDropped << "bytes dropped";
+}
+
+bool StreamRecorder::isRecording() const
+{
+    return m_reader != nullptr;
+}
+
+QString StreamRecorder::streamOutput() const
+{
+    return m_pipe.streamOutput();
+}
+
+StreamRecorder::Stats StreamRecorder::stats() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_stats;
+}
+
+void StreamRecorder::readLoop()
+{
+    std::vector<char> chunk(kChunkBytes);
+
+    while (!m_stopping) {
+        const qsizetype n = m_pipe.read(chunk.data(), kChunkBytes, kIdleWaitMs);
+        if (n <= 0)
+            continue;
+
+        bool pressureStarted = false;
+        {
+            QMutexLocker locker(&m_mutex);
+            const qsizetype capacity = qsizetype(m_ring.size());
+
+            // Disk is behind: drop this chunk, the writer resynchronises on the next packet
+            // Диск отстает: отбросить этот блок, поток записи синхронизируется на следующем пакете
+            if (capacity - m_ringSize < n) {
+                m_stats.bytesDropped += n;
+                pressureStarted = !m_stats.backpressure;
+                m_stats.backpressure = true;
+            } else {
+                const qsizetype tail = (m_ringHead + m_ringSize) % capacity;
+                const qsizetype first = qMin<qsizetype>(n, capacity - tail);
+                std::memcpy(m_ring.data() + tail, chunk.data(), size_t(first));
+                std::memcpy(m_ring.data(), chunk.data() + first, size_t(n - first));
+                m_ringSize += n;
+                m_stats.backlogBytes = int(m_ringSize);
+                m_stats.backlogHighWater = qMax(m_stats.backlogHighWater, m_stats.backlogBytes);
+                m_dataAvailable.wakeOne();
+            }
+        }
+        if (pressureStarted) {
+            qWarning() << "StreamRecorder: disk cannot keep up, dropping data";
+            emit backpressureChanged(true);
+        }
+    }
+}
+
+void StreamRecorder::writeLoop()
+{
+    // Packets may straddle chunks; the tail of one chunk waits in front of the next
+    // Пакеты могут пересекать границы блоков; хвост одного блока ждет перед следующим
+    std::vector<uchar> work(size_t(kChunkBytes + kPacketSize));
+    qsizetype carried = 0;
+
+    for (;;) {
+        qsizetype n = 0;
+        bool pressureEnded = false;
+        {
+            QMutexLocker locker(&m_mutex);
+            while (m_ringSize == 0 && !m_stopping)
+                m_dataAvailable.wait(&m_mutex, kIdleWaitMs);
+            if (m_ringSize == 0 && m_stopping)
+                break;
+
+            const qsizetype capacity = qsizetype(m_ring.size());
+            n = qMin<qsizetype>(m_ringSize, qsizetype(work.size()) - carried);
+            const qsizetype first = qMin(n, capacity - m_ringHead);
+            std::memcpy(work.data() + carried, m_ring.data() + m_ringHead, size_t(first));
+            std::memcpy(work.data() + carried + first, m_ring.data(), size_t(n - first));
+            m_ringHead = (m_ringHead + n) % capacity;
+            m_ringSize -= n;
+            m_stats.backlogBytes = int(m_ringSize);
+
+            // Clear the flag with hysteresis, once half of the ring is free again
+            // Снять флаг с гистерезисом, когда половина кольца снова свободна
+            if (m_stats.backpressure && m_ringSize < capacity / 2) {
+                m_stats.backpressure = false;
+                pressureEnded = true;
+            }
+        }
+        if (pressureEnded)
+            emit backpressureChanged(false);
+
+        const qsizetype length = carried + n;
+        qsizetype pos = 0;
+        while (length - pos >= kPacketSize) {
+            // Resynchronise after dropped data: a packet starts with the sync byte and so does the next
+            // Синхронизация после потерь: пакет начинается с байта синхронизации, как и следующий
+            if (!TsPacket::isSynced(work.data() + pos, length - pos)) {
+                ++pos;
+                continue;
+            }
+            writePacket(work.data() + pos);
+            pos += kPacketSize;
+        }
+        carried = length - pos;
+        std::memmove(work.data(), work.data() + pos, size_t(carried));
+
+        QMutexLocker locker(&m_mutex);
+        m_stats.bytesWritten = m_bytesWritten;
+        if (m_failed)
+            m_stats.bytesDropped += n;
+    }
+
+    closeSegment();
+}
+
+void StreamRecorder::writePacket(const uchar *packet)
+{
+    const int pid = TsPacket::pid(packet);
+
+    // Remember the latest PAT and PMT; each is assumed to fit one packet, as from libvlc's TS mux
+    // Запоминать последние PAT и PMT; каждая считается умещающейся в один пакет, как у мультиплексора TS libvlc
+    if (TsPacket::startsPayload(packet)) {
+        if (pid == 0) {
+            m_pat.assign(packet, packet + kPacketSize);
+            const int pmtPid = TsPacket::pmtPidFromPat(packet);
+            if (pmtPid >= 0)
+                m_pmtPid = pmtPid;
+        } else if (pid == m_pmtPid) {
+            m_pmt.assign(packet, packet + kPacketSize);
+        }
+    }
+
+    if (m_failed)
+        return;
+
+    // Cut at the first key frame after the target length so each segment starts decodable
+    // Резать на первом ключевом кадре после целевой длины, чтобы каждый сегмент начинался декодируемым
+    if (m_segment) {
+        const qint64 targetMs = qint64(m_config.segmentSeconds) * 1000;
+        const qint64 elapsedMs = m_segmentClock.elapsed();
+        const bool full = m_segmentBytes + kPacketSize > m_config.segmentMaxBytes;
+        const bool due = elapsedMs >= targetMs && TsPacket::isRandomAccess(packet);
+        const bool overdue = elapsedMs >= targetMs * kOverdueFactor;
+        if (full || due || overdue)
+            closeSegment();
+    }
+    if (!m_segment && !openSegment())
+        return;
+
+    const auto write = [this](const uchar *data) {
+        if (m_segment->write(reinterpret_cast<const char *>(data), kPacketSize) != kPacketSize) {
+            fail(QStringLiteral("Write to %1 failed: %2").arg(m_segment->fileName(), m_segment->errorString()));
+            return false;
+        }
+        m_segmentBytes += kPacketSize;
+        m_bytesWritten += kPacketSize;
+        return true;
+    };
+
+    // A fresh segment starts with the tables so players can open it on its own
+    // Новый сегмент начинается с таблиц, чтобы плееры могли открыть его отдельно
+    if (m_segmentBytes == 0 && pid != 0 && !m_pat.empty()) {
+        if (!write(m_pat.data()))
+            return;
+        if (!m_pmt.empty() && pid != m_pmtPid && !write(m_pmt.data()))
+            return;
+    }
+    write(packet);
+}
+
+bool StreamRecorder::openSegment()
+{
+    const QString name = QStringLiteral("%1_%2.ts")
+        .arg(m_config.prefix, QDateTime::currentDateTime().toString(QStringLiteral("yyyyMMdd-HHmmss-zzz")));
+    auto *file = new QFile(QDir(m_config.directory).filePath(name));
+    if (!file->open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        fail(QStringLiteral("Cannot create %1: %2").arg(file->fileName(), file->errorString()));
+        delete file;
+        return false;
+    }
+
+    m_segment = file;
+    m_segmentBytes = 0;
+    m_segmentClock.start();
+    {
+        QMutexLocker locker(&m_mutex);
+        ++m_stats.segments;
+        m_stats.currentSegment = file->fileName();
+    }
+    emit segmentStarted(file->fileName());
+    return true;
+}
+
+void StreamRecorder::closeSegment()
+{
+    if (!m_segment)
+        return;
+
+    const QString path = m_segment->fileName();
+    const qint64 bytes = m_segmentBytes;
+    m_segment->close();
+    delete m_segment;
+    m_segment = nullptr;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        m_stats.bytesWritten = m_bytesWritten;
+        m_stats.currentSegment.clear();
+    }
+    m_segmentBytes = 0;
+    m_finishedSegments << path;
+    emit segmentFinished(path, bytes);
+    rotateSegments();
+}
+
+void StreamRecorder::rotateSegments()
+{
+    if (m_config.maxSegments <= 0)
+        return;
+
+    int deleted = 0;
+    while (m_finishedSegments.size() > m_config.maxSegments) {
+        QFile::remove(m_finishedSegments.takeFirst());
+        ++deleted;
+    }
+    if (deleted > 0) {
+        QMutexLocker locker(&m_mutex);
+        m_stats.deletedSegments += deleted;
+    }
+}
+
+void StreamRecorder::fail(const QString &message)
+{
+    // Keep draining the pipe so libvlc is never blocked, but stop touching the disk
+    // Продолжать вычерпывать канал, чтобы libvlc не блокировался, но больше не трогать диск
+    m_failed = true;
+    if (m_segment) {
+        m_segment->close();
+        delete m_segment;
+        m_segment = nullptr;
+    }
+    qWarning() << "StreamRecorder:" << message;
+    emit error(message);
+}
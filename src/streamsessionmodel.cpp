@@ -0,0 +1,452 @@
+#include "streamsessionmodel.h"
+#include <QDebug>
+#include <QGuiApplication>
+
+namespace {
+
+// Enough parallel decodes for a 4x4 camera wall
+// Достаточно параллельных декодеров для стены камер 4x4
+constexpr int kDefaultMaxActiveDecodes = 16;
+
+// Software decoders of a full wall share the CPU; two threads per tile keeps 16 tiles near 32 threads
+// Программные декодеры полной стены делят процессор; два потока на плитку держат 16 плиток около 32 потоков
+constexpr int kDefaultDecodeThreads = 2;
+
+// Retries of one outage before a tile gives its decode slot to a queued one
+// Повторов одного обрыва, после которых плитка отдает свой слот декодирования ожидающей
+constexpr int kMaxReconnectAttempts = 5;
+
+} // namespace
+
+StreamSessionModel::StreamSessionModel(QObject *parent)
+    : QAbstractListModel(parent)
+    , m_maxActiveDecodes(kDefaultMaxActiveDecodes)
+    , m_decodeThreads(kDefaultDecodeThreads)
+{
+    if (qGuiApp)
+        connect(qGuiApp, &QGuiApplication::applicationStateChanged, this, &StreamSessionModel::updateVisibility);
+}
+
+StreamSessionModel::~StreamSessionModel()
+{
+    // Players are children of the model; stop them explicitly before QObject cleanup
+    // Плееры - дочерние объекты модели; явно остановить их до очистки QObject
+    for (Session &session : m_sessions)
+        delete session.player;
+}
+
+int StreamSessionModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : int(m_sessions.size());
+}
+
+QVariant StreamSessionModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_sessions.size())
+        return QVariant();
+
+    const Session &session = m_sessions.at(index.row());
+    switch (role) {
+    case UrlRole:
+        return session.url;
+    case PlayerRole:
+        return QVariant::fromValue(session.player);
+    case StateRole:
+        // The supervisor is still retrying; the tile keeps its slot meanwhile
+        // Супервизор еще повторяет попытки; плитка тем временем сохраняет свой слот
+        if (session.state == State::Playing
+            && (session.player->state() == VlcPlayer::Error || session.player->state() == VlcPlayer::Ended))
+            return QStringLiteral("Reconnecting");
+        return stateName(session.state);
+    case QualityRole:
+        return int(session.quality);
+    case EffectiveQualityRole:
+        return int(effectiveQuality(session));
+    case DecoderPathRole:
+        return session.player->decoderPath();
+    case VisibilityRole:
+        return int(session.player->effectiveVisibility());
+    default:
+        return QVariant();
+    }
+}
+
+QHash<int, QByteArray> StreamSessionModel::roleNames() const
+{
+    return {
+        { UrlRole, "url" },
+        { PlayerRole, "player" },
+        { StateRole, "state" },
+        { QualityRole, "quality" },
+        { EffectiveQualityRole, "effectiveQuality" },
+        { DecoderPathRole, "decoderPath" },
+        { VisibilityRole, "visibility" },
+    };
+}
+
+int StreamSessionModel::addStream(const QString &url, int quality)
+{
+    const int row = int(m_sessions.size());
+
+    Session session;
+    session.url = url;
+    session.quality = static_cast<Quality>(quality);
+    session.player = new VlcPlayer(this);
+
+    // Resolve the row at signal time, rows shift when sessions are removed
+    // Определять строку в момент сигнала, строки сдвигаются при удалении сессий
+    VlcPlayer *player = session.player;
+    connect(player, &VlcPlayer::error, this, [this, player](const QString &message) {
+        const int i = rowOf(player);
+        if (i >= 0)
+            emit error(i, message);
+    });
+    connect(player, &VlcPlayer::decoderPathChanged, this, [this, player]() {
+        const int i = rowOf(player);
+        if (i >= 0)
+            emit dataChanged(index(i), index(i), { DecoderPathRole });
+    });
+    connect(player, &VlcPlayer::visibilityChanged, this, [this, player]() {
+        const int i = rowOf(player);
+        if (i >= 0)
+            emit dataChanged(index(i), index(i), { VisibilityRole });
+    });
+    connect(player, &VlcPlayer::stateChanged, this, [this, player]() {
+        const int i = rowOf(player);
+        if (i >= 0)
+            emit dataChanged(index(i), index(i), { StateRole });
+    });
+
+    // A camera that stays down must not hold a decode slot queued tiles are waiting for; queued,
+    // so the player is not stopped from inside its own supervisor
+    // Камера, которая не поднимается, не должна занимать слот, которого ждут плитки в очереди; через
+    // очередь, чтобы плеер не останавливался изнутри собственного супервизора
+    connect(player, &VlcPlayer::reconnectScheduled, this, [this, player](int attempt) {
+        const int i = rowOf(player);
+        if (i >= 0 && attempt > kMaxReconnectAttempts)
+            giveUp(i);
+    }, Qt::QueuedConnection);
+
+    beginInsertRows(QModelIndex(), row, row);
+    m_sessions.append(session);
+    endInsertRows();
+    emit countChanged();
+
+    // A session added in the background starts in the background mode
+    // Сессия, добавленная в фоне, стартует в фоновом режиме
+    updateVisibility();
+
+    schedule();
+    return row;
+}
+
+void StreamSessionModel::removeStream(int row)
+{
+    if (row < 0 || row >= m_sessions.size())
+        return;
+
+    beginRemoveRows(QModelIndex(), row, row);
+    Session session = m_sessions.takeAt(row);
+    endRemoveRows();
+
+    // Deleting the player stops it and releases its libvlc media player
+    // Удаление плеера останавливает его и освобождает медиаплеер libvlc
+    delete session.player;
+    emit countChanged();
+
+    // A decode slot may have been freed and Auto tiles may move to a higher quality
+    // Мог освободиться слот декодирования, а плитки Auto могут перейти на более высокое качество
+    schedule();
+    emit activeDecodesChanged();
+}
+
+void StreamSessionModel::clear()
+{
+    if (m_sessions.isEmpty())
+        return;
+
+    beginResetModel();
+    for (Session &session : m_sessions)
+        delete session.player;
+    m_sessions.clear();
+    endResetModel();
+
+    emit countChanged();
+    emit activeDecodesChanged();
+}
+
+void StreamSessionModel::setQuality(int row, int quality)
+{
+    if (row < 0 || row >= m_sessions.size())
+        return;
+
+    Session &session = m_sessions[row];
+    if (session.quality == quality)
+        return;
+
+    session.quality = static_cast<Quality>(quality);
+    const QModelIndex idx = index(row);
+    emit dataChanged(idx, idx, { QualityRole, EffectiveQualityRole });
+
+    // A playing tile picks up the new decoder options right away
+    // Воспроизводящаяся плитка сразу применяет новые параметры декодера
+    if (session.state == State::Playing && effectiveQuality(session) != session.appliedQuality)
+        startSession(row);
+}
+
+void StreamSessionModel::setTileVisible(int row, bool visible)
+{
+    if (row < 0 || row >= m_sessions.size() || m_sessions.at(row).visible == visible)
+        return;
+
+    m_sessions[row].visible = visible;
+    updateVisibility();
+}
+
+int StreamSessionModel::maxActiveDecodes() const
+{
+    return m_maxActiveDecodes;
+}
+
+void StreamSessionModel::setMaxActiveDecodes(int value)
+{
+    value = qMax(1, value);
+    if (value == m_maxActiveDecodes)
+        return;
+
+    m_maxActiveDecodes = value;
+    emit maxActiveDecodesChanged();
+
+    // Over the new limit: send the most recently added sessions back to the queue
+    // Превышен новый лимит: вернуть в очередь последние добавленные сессии
+    int active = activeDecodes();
+    for (int row = int(m_sessions.size()) - 1; row >= 0 && active > m_maxActiveDecodes; --row) {
+        Session &session = m_sessions[row];
+        if (session.state != State::Playing)
+            continue;
+        session.player->stop();
+        session.state = State::Queued;
+        --active;
+        const QModelIndex idx = index(row);
+        emit dataChanged(idx, idx, { StateRole });
+    }
+
+    schedule();
+    emit activeDecodesChanged();
+}
+
+int StreamSessionModel::activeDecodes() const
+{
+    int active = 0;
+    for (const Session &session : m_sessions) {
+        if (session.state == State::Playing)
+            ++active;
+    }
+    return active;
+}
+
+VlcPlayer::DecodePolicy StreamSessionModel::decodePolicy() const
+{
+    return m_decodePolicy;
+}
+
+void StreamSessionModel::setDecodePolicy(VlcPlayer::DecodePolicy policy)
+{
+    if (policy == m_decodePolicy)
+        return;
+
+    m_decodePolicy = policy;
+    emit decodePolicyChanged();
+    restartPlaying();
+}
+
+int StreamSessionModel::decodeThreads() const
+{
+    return m_decodeThreads;
+}
+
+void StreamSessionModel::setDecodeThreads(int threads)
+{
+    threads = qMax(1, threads);
+    if (threads == m_decodeThreads)
+        return;
+
+    m_decodeThreads = threads;
+    emit decodeThreadsChanged();
+    if (m_decodePolicy == VlcPlayer::DecodeSoftwareCapped)
+        restartPlaying();
+}
+
+VlcPlayer::Transport StreamSessionModel::transport() const
+{
+    return m_transport;
+}
+
+void StreamSessionModel::setTransport(VlcPlayer::Transport transport)
+{
+    if (transport == m_transport)
+        return;
+
+    m_transport = transport;
+    emit transportChanged();
+    restartPlaying();
+}
+
+VlcPlayer::Visibility StreamSessionModel::hiddenMode() const
+{
+    return m_hiddenMode;
+}
+
+void StreamSessionModel::setHiddenMode(VlcPlayer::Visibility mode)
+{
+    if (mode == m_hiddenMode)
+        return;
+
+    m_hiddenMode = mode;
+    emit hiddenModeChanged();
+    updateVisibility();
+}
+
+void StreamSessionModel::updateVisibility()
+{
+    // Inactive only means another window has the focus; the wall is still on screen
+    // Inactive означает лишь, что фокус у другого окна; стена по-прежнему на экране
+    const Qt::ApplicationState appState = qGuiApp ? qGuiApp->applicationState() : Qt::ApplicationActive;
+    const bool background = appState == Qt::ApplicationHidden || appState == Qt::ApplicationSuspended;
+
+    for (Session &session : m_sessions)
+        session.player->setVisibility(background || !session.visible ? m_hiddenMode : VlcPlayer::Visible);
+}
+
+int StreamSessionModel::rowOf(const VlcPlayer *player) const
+{
+    for (int i = 0; i < m_sessions.size(); ++i) {
+        if (m_sessions.at(i).player == player)
+            return i;
+    }
+    return -1;
+}
+
+void StreamSessionModel::restartPlaying()
+{
+    for (int row = 0; row < m_sessions.size(); ++row) {
+        if (m_sessions.at(row).state == State::Playing)
+            startSession(row);
+    }
+}
+
+StreamSessionModel::Quality StreamSessionModel::effectiveQuality(const Session &session) const
+{
+    if (session.quality != Auto)
+        return session.quality;
+
+    // Decode cost grows with the tile count while each tile gets smaller on screen
+    // Стоимость декодирования растет с количеством плиток, а каждая плитка на экране уменьшается
+    const int tiles = int(m_sessions.size());
+    if (tiles <= 4)
+        return Full;
+    if (tiles <= 9)
+        return Reduced;
+    return Low;
+}
+
+QStringList StreamSessionModel::qualityOptions(Quality quality)
+{
+    // avcodec-skip-frame / avcodec-skiploopfilter: 1 = non-ref, 3 = non-key, 4 = all
+    // avcodec-skip-frame / avcodec-skiploopfilter: 1 = неопорные, 3 = неключевые, 4 = все
+    switch (quality) {
+    case Reduced:
+        return { QStringLiteral(":avcodec-skiploopfilter=4"),
+                 QStringLiteral(":avcodec-threads=2") };
+    case Low:
+        return { QStringLiteral(":avcodec-skiploopfilter=4"),
+                 QStringLiteral(":avcodec-skip-frame=1"),
+                 QStringLiteral(":avcodec-threads=1") };
+    case KeyframesOnly:
+        return { QStringLiteral(":avcodec-skip-frame=3"),
+                 QStringLiteral(":avcodec-threads=1") };
+    case Auto:
+    case Full:
+        break;
+    }
+    return {};
+}
+
+QString StreamSessionModel::stateName(State state)
+{
+    switch (state) {
+    case State::Queued:
+        return QStringLiteral("Queued");
+    case State::Playing:
+        return QStringLiteral("Playing");
+    case State::Error:
+        return QStringLiteral("Error");
+    }
+    return QString();
+}
+
+void StreamSessionModel::schedule()
+{
+    int active = activeDecodes();
+
+    for (int row = 0; row < m_sessions.size(); ++row) {
+        Session &session = m_sessions[row];
+
+        if (session.state == State::Queued && active < m_maxActiveDecodes) {
+            startSession(row);
+            if (session.state == State::Playing)
+                ++active;
+            continue;
+        }
+
+        // The tile count changed: move Auto tiles to the quality level that now applies
+        // Количество плиток изменилось: перевести плитки Auto на актуальный уровень качества
+        if (session.state == State::Playing && effectiveQuality(session) != session.appliedQuality)
+            startSession(row);
+    }
+
+    // Auto tiles resolve against the tile count, so their effective level may have changed
+    // Плитки Auto зависят от количества плиток, поэтому их эффективный уровень мог измениться
+    if (!m_sessions.isEmpty())
+        emit dataChanged(index(0), index(int(m_sessions.size()) - 1), { EffectiveQualityRole });
+    emit activeDecodesChanged();
+}
+
+void StreamSessionModel::giveUp(int row)
+{
+    Session &session = m_sessions[row];
+    if (session.state != State::Playing)
+        return;
+
+    qDebug() << "StreamSessionModel: session" << row << "gave up on" << session.url
+             << "after" << kMaxReconnectAttempts << "reconnect attempts";
+    session.player->stop();
+    session.state = State::Error;
+    const QModelIndex idx = index(row);
+    emit dataChanged(idx, idx, { StateRole });
+    emit error(row, QStringLiteral("Stream did not come back after %1 attempts").arg(kMaxReconnectAttempts));
+
+    // The freed slot goes to the next queued session
+    // Освободившийся слот переходит к следующей сессии в очереди
+    schedule();
+}
+
+void StreamSessionModel::startSession(int row)
+{
+    Session &session = m_sessions[row];
+    session.appliedQuality = effectiveQuality(session);
+
+    // Grid tiles are muted: mixing audio from many cameras only costs decode time
+    // Плитки сетки без звука: смешивание звука многих камер только тратит время декодирования
+    QStringList options = qualityOptions(session.appliedQuality);
+    options << QStringLiteral(":no-audio");
+
+    session.player->setDecodePolicy(m_decodePolicy, m_decodeThreads);
+    session.player->setTransport(m_transport);
+    session.state = session.player->open(session.url, options) ? State::Playing : State::Error;
+    qDebug() << "StreamSessionModel: session" << row << stateName(session.state)
+             << "quality" << session.appliedQuality << "decoder" << session.player->decoderPath();
+
+    const QModelIndex idx = index(row);
+    emit dataChanged(idx, idx, { StateRole, EffectiveQualityRole });
+}
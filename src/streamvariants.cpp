@@ -0,0 +1,98 @@
+#include "streamvariants.h"
+#include <QVariantMap>
+#include <algorithm>
+
+namespace {
+
+// A variant still counts as covering a tile up to 10% smaller than it: upscaling that little is
+// invisible and saves pulling the next stream up
+// Вариант считается покрывающим плитку, даже если он до 10% меньше ее: такое увеличение незаметно
+// и избавляет от перехода на следующий поток
+constexpr double kCoverTolerance = 0.9;
+
+// Stepping down to a smaller variant needs it to cover the tile with 25% to spare
+// Переход на меньший вариант требует, чтобы он покрывал плитку с запасом 25%
+constexpr double kDownswitchMargin = 1.25;
+
+} // namespace
+
+StreamVariants::StreamVariants(std::vector<Variant> variants)
+    : m_variants(std::move(variants))
+{
+    std::stable_sort(m_variants.begin(), m_variants.end(), [](const Variant &a, const Variant &b) {
+        return qint64(a.size.width()) * a.size.height() < qint64(b.size.width()) * b.size.height();
+    });
+}
+
+StreamVariants StreamVariants::fromVariantList(const QVariantList &list)
+{
+    std::vector<Variant> variants;
+    for (const QVariant &value : list) {
+        const QVariantMap map = value.toMap();
+        const QString url = map.value(QStringLiteral("url")).toString();
+        if (url.isEmpty())
+            continue;
+        variants.push_back({ url, QSize(map.value(QStringLiteral("width")).toInt(),
+                                        map.value(QStringLiteral("height")).toInt()) });
+    }
+    return StreamVariants(std::move(variants));
+}
+
+bool StreamVariants::isEmpty() const
+{
+    return m_variants.empty();
+}
+
+bool StreamVariants::contains(const QString &url) const
+{
+    return std::any_of(m_variants.cbegin(), m_variants.cend(), [&url](const Variant &v) { return v.url == url; });
+}
+
+QStringList StreamVariants::urls() const
+{
+    QStringList urls;
+    for (const Variant &variant : m_variants)
+        urls << variant.url;
+    return urls;
+}
+
+QString StreamVariants::largest() const
+{
+    return m_variants.empty() ? QString() : m_variants.back().url;
+}
+
+QString StreamVariants::select(const QSize &targetPx, const QString &current) const
+{
+    if (m_variants.empty())
+        return QString();
+    if (targetPx.isEmpty())
+        return contains(current) ? current : largest();
+
+    const int ideal = smallestCovering(targetPx, 1.0);
+    const auto it = std::find_if(m_variants.cbegin(), m_variants.cend(), [&current](const Variant &v) { return v.url == current; });
+    if (it == m_variants.cend())
+        return m_variants[size_t(ideal)].url;
+
+    // Up as soon as the current one falls short; down only with a margin
+    // Вверх, как только текущего не хватает; вниз - только с запасом
+    const int currentIndex = int(it - m_variants.cbegin());
+    if (ideal > currentIndex)
+        return m_variants[size_t(ideal)].url;
+    const int comfortable = smallestCovering(targetPx, kDownswitchMargin);
+    return m_variants[size_t(qMin(comfortable, currentIndex))].url;
+}
+
+int StreamVariants::smallestCovering(const QSize &target, double factor) const
+{
+    // The picture is letterboxed into the tile, so what counts is the scale that fits it inside
+    // Картинка вписывается в плитку с полями, поэтому важен масштаб, при котором она помещается внутрь
+    for (int i = 0; i < int(m_variants.size()); ++i) {
+        const QSize size = m_variants[size_t(i)].size;
+        if (size.isEmpty())
+            continue;
+        const double scale = qMin(double(target.width()) / size.width(), double(target.height()) / size.height());
+        if (scale * factor * kCoverTolerance <= 1.0)
+            return i;
+    }
+    return int(m_variants.size()) - 1;
+}
@@ -0,0 +1,123 @@
+#include "surfacegeometrysync.h"
+#include <QQuickItem>
+#include <QQuickWindow>
+#include <utility>
+
+SurfaceGeometrySync::SurfaceGeometrySync(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void SurfaceGeometrySync::setItem(QQuickItem *item)
+{
+    if (item == m_item)
+        return;
+
+    for (const QMetaObject::Connection &connection : std::as_const(m_itemConnections))
+        disconnect(connection);
+    m_itemConnections.clear();
+
+    m_item = item;
+    m_stats = Stats();
+    m_pending = false;
+    attachWindow(item ? item->window() : nullptr);
+    if (!item)
+        return;
+
+    // Only mark the sync dirty here; the actual read happens once per frame in flush()
+    // Здесь только пометить синхронизацию как грязную; само чтение происходит раз за кадр в flush()
+    const auto request = [this]() { requestUpdate(); };
+    m_itemConnections << connect(item, &QQuickItem::xChanged, this, request)
+                      << connect(item, &QQuickItem::yChanged, this, request)
+                      << connect(item, &QQuickItem::widthChanged, this, request)
+                      << connect(item, &QQuickItem::heightChanged, this, request)
+                      << connect(item, &QQuickItem::windowChanged, this, [this](QQuickWindow *window) {
+                             attachWindow(window);
+                             requestUpdate();
+                         });
+
+    // The caller has just placed the native view at this rectangle
+    // Вызывающий только что разместил нативное представление в этом прямоугольнике
+    m_lastRect = currentRect();
+}
+
+QQuickItem *SurfaceGeometrySync::item() const
+{
+    return m_item;
+}
+
+void SurfaceGeometrySync::attachWindow(QQuickWindow *window)
+{
+    if (window == m_window)
+        return;
+
+    for (const QMetaObject::Connection &connection : std::as_const(m_windowConnections))
+        disconnect(connection);
+    m_windowConnections.clear();
+
+    m_window = window;
+    if (!window)
+        return;
+
+    // afterAnimating is emitted on the GUI thread once per frame, after animations advanced;
+    // checking there also catches ancestors that moved without the item noticing
+    // afterAnimating выпускается в потоке GUI раз за кадр после продвижения анимаций;
+    // проверка там ловит и предков, сдвинувшихся без ведома элемента
+    const auto request = [this]() { requestUpdate(); };
+    m_windowConnections << connect(window, &QQuickWindow::afterAnimating, this, &SurfaceGeometrySync::flush)
+                        << connect(window, &QWindow::widthChanged, this, request)
+                        << connect(window, &QWindow::heightChanged, this, request);
+}
+
+void SurfaceGeometrySync::requestUpdate()
+{
+    if (!m_item)
+        return;
+
+    ++m_stats.requested;
+    if (m_pending) {
+        ++m_stats.coalesced;
+        return;
+    }
+
+    // Make sure a frame comes even if nothing else is animating
+    // Гарантировать кадр, даже если больше ничего не анимируется
+    m_pending = true;
+    if (m_window)
+        m_window->update();
+}
+
+QRectF SurfaceGeometrySync::currentRect() const
+{
+    if (!m_item || !m_window)
+        return QRectF();
+
+    const QRectF sceneRect = m_item->mapRectToScene(QRectF(0, 0, m_item->width(), m_item->height()));
+    const qreal dpr = m_window->effectiveDevicePixelRatio();
+    return QRectF(sceneRect.x() * dpr, sceneRect.y() * dpr, sceneRect.width() * dpr, sceneRect.height() * dpr);
+}
+
+void SurfaceGeometrySync::flush()
+{
+    if (!m_item)
+        return;
+
+    const bool requested = m_pending;
+    m_pending = false;
+
+    const QRectF rect = currentRect();
+    if (rect == m_lastRect) {
+        if (requested)
+            ++m_stats.skipped;
+        return;
+    }
+
+    m_lastRect = rect;
+    ++m_stats.sent;
+    emit geometryChanged(rect);
+}
+
+SurfaceGeometrySync::Stats SurfaceGeometrySync::stats() const
+{
+    return m_stats;
+}
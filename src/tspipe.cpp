@@ -0,0 +1,95 @@
+#include "tspipe.h"
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <cerrno>
+#include <cstring>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+TsPipe::~TsPipe()
+{
+    close();
+}
+
+bool TsPipe::open(const QString &name, QString *errorMessage)
+{
+    close();
+
+#ifdef Q_OS_UNIX
+    m_path = QDir(QDir::tempPath()).filePath(QStringLiteral("%1-%2.ts").arg(name).arg(QCoreApplication::applicationPid()));
+    QFile::remove(m_path);
+    const QByteArray path = QFile::encodeName(m_path);
+    if (::mkfifo(path.constData(), 0600) != 0) {
+        *errorMessage = QStringLiteral("Cannot create pipe %1: %2").arg(m_path, QString::fromLocal8Bit(strerror(errno)));
+        m_path.clear();
+        return false;
+    }
+
+    // The owner holds a write end of its own, so the pipe never reports end-of-file between
+    // libvlc restarts and the reader can simply wait for data
+    // Владелец держит собственный конец для записи, поэтому канал не сообщает о конце файла между
+    // перезапусками libvlc, и читатель может просто ждать данные
+    m_readFd = ::open(path.constData(), O_RDONLY | O_NONBLOCK);
+    m_keepAliveFd = m_readFd >= 0 ? ::open(path.constData(), O_WRONLY | O_NONBLOCK) : -1;
+    if (m_readFd < 0 || m_keepAliveFd < 0) {
+        *errorMessage = QStringLiteral("Cannot open pipe %1").arg(m_path);
+        close();
+        return false;
+    }
+    return true;
+#else
+    Q_UNUSED(name)
+    *errorMessage = QStringLiteral("Stream capture is not supported on this platform");
+    return false;
+#endif
+}
+
+void TsPipe::close()
+{
+#ifdef Q_OS_UNIX
+    if (m_keepAliveFd >= 0)
+        ::close(m_keepAliveFd);
+    if (m_readFd >= 0)
+        ::close(m_readFd);
+    if (!m_path.isEmpty())
+        ::unlink(QFile::encodeName(m_path).constData());
+#endif
+    m_keepAliveFd = -1;
+    m_readFd = -1;
+    m_path.clear();
+}
+
+bool TsPipe::isOpen() const
+{
+    return m_readFd >= 0;
+}
+
+QString TsPipe::streamOutput() const
+{
+    return QStringLiteral("std{access=file,mux=ts,dst=\"%1\"}").arg(m_path);
+}
+
+qsizetype TsPipe::read(char *buffer, qsizetype size, int timeoutMs)
+{
+#ifdef Q_OS_UNIX
+    pollfd fd { m_readFd, POLLIN, 0 };
+    const int ready = ::poll(&fd, 1, timeoutMs);
+    if (ready < 0)
+        return errno == EINTR ? 0 : -1;
+    if (ready == 0)
+        return 0;
+    const ssize_t n = ::read(m_readFd, buffer, size_t(size));
+    if (n < 0)
+        return errno == EAGAIN || errno == EINTR ? 0 : -1;
+    return qsizetype(n);
+#else
+    Q_UNUSED(buffer) Q_UNUSED(size) Q_UNUSED(timeoutMs)
+    return -1;
+#endif
+}
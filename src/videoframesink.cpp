@@ -0,0 +1,754 @@
+#include "videoframesink.h"
+#include "framebufferpool.h"
+#include "frametap.h"
+#include "pixelkernels.h"
+#include <QDebug>
+#include <QMutexLocker>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Number of picture slots: one being decoded, one ready, one being uploaded, one spare
+// Количество слотов: один декодируется, один готов, один загружается, один запасной
+constexpr int kSlotCount = 4;
+
+// Row alignment that keeps every line on its own cache line boundary
+// Выравнивание строк, чтобы каждая строка начиналась на границе кэш-линии
+constexpr int kRowAlignment = FrameBufferPool::kAlignment;
+
+// Decode buffers are allocated in whole macroblock rows, so decoders may write the padding
+// Буферы декодирования выделяются целыми рядами макроблоков, чтобы декодеры могли писать в дополнение
+constexpr int kLineAlignment = 16;
+
+// libvlc never has more pictures out than its vout pool holds (reference frames plus a few);
+// decode buffers grow on demand up to this bound
+// libvlc никогда не выдает больше кадров, чем вмещает пул его видеовывода (опорные кадры и еще
+// несколько); буферы декодирования растут по требованию до этой границы
+constexpr int kMaxDecodeBuffers = 32;
+
+constexpr quint32 kChromaRV32 = 0x32335652; // 'R' 'V' '3' '2' in memory order
+constexpr quint32 kChromaI420 = 0x30323449; // 'I' '4' '2' '0'
+constexpr quint32 kChromaNV12 = 0x3231564e; // 'N' 'V' '1' '2'
+
+int alignUp(int value, int alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// Grow-only scratch; the display path reuses it frame after frame
+// Растущий рабочий буфер; путь показа переиспользует его от кадра к кадру
+uchar *scratch(std::vector<uchar> &buffer, qsizetype bytes)
+{
+    if (qsizetype(buffer.size()) < bytes)
+        buffer.resize(size_t(bytes));
+    return buffer.data();
+}
+
+} // namespace
+
+// Reference from a handed-out QImage back to its slot; one per slot, allocated with the slot
+// Ссылка из выданного QImage обратно на его слот; по одной на слот, создается вместе со слотом
+struct VideoFrameSink::FrameRef
+{
+    std::shared_ptr<Storage> storage;   // Set while the frame is out, keeps the storage alive
+    int slot = -1;
+};
+
+// YUV pictures libvlc decodes into, for one negotiated format. A buffer is busy from lock() until
+// unlock(), which libvlc calls after display() or instead of it for a picture it drops; the 4:2:0
+// planes follow each other in one pooled allocation
+// YUV-кадры, в которые декодирует libvlc, для одного согласованного формата. Буфер занят от lock()
+// до unlock(), который libvlc вызывает после display() или вместо него для отброшенного кадра;
+// плоскости 4:2:0 идут друг за другом в одном выделении из пула
+struct VideoFrameSink::Input
+{
+    enum class Format { I420, Nv12 };
+
+    ~Input()
+    {
+        for (uchar *buffer : buffers)
+            FrameBufferPool::shared().release(key, buffer);
+    }
+
+    void addBuffer()
+    {
+        buffers.push_back(FrameBufferPool::shared().acquire(key));
+        busy.push_back(false);
+    }
+
+    // Planes of one buffer: Y, then U and V (I420) or the interleaved UV plane (NV12)
+    // Плоскости одного буфера: Y, затем U и V (I420) или чередующаяся плоскость UV (NV12)
+    uchar *plane(int buffer, int index) const
+    {
+        uchar *data = buffers[size_t(buffer)];
+        if (index == 0)
+            return data;
+        data += qsizetype(stride) * lines;
+        if (index == 2)
+            data += qsizetype(chromaStride()) * (lines / 2);
+        return data;
+    }
+
+    int chromaStride() const
+    {
+        return format == Format::Nv12 ? stride : stride / 2;
+    }
+
+    // Shrink and convert one buffer into an RGB32 slot of outSize (even, at most size); call with
+    // convertMutex held
+    // Уменьшить и преобразовать один буфер в слот RGB32 размера outSize (четный, не больше size);
+    // вызывать под convertMutex
+    void convert(int buffer, uchar *dst, int dstStride, const QSize &outSize);
+
+    // Pin the kept picture for a conversion outside the video output thread, -1 if there is none;
+    // unpin() gives it back and, when consumed, forgets it unless a newer one was kept meanwhile
+    // Закрепить сохраненный кадр для преобразования вне потока видеовывода, -1, если его нет;
+    // unpin() возвращает его и, если он израсходован, забывает, если тем временем не сохранен более новый
+    int pinKept()
+    {
+        QMutexLocker locker(&mutex);
+        pinned = kept;
+        return pinned;
+    }
+
+    void unpin(bool consumed)
+    {
+        QMutexLocker locker(&mutex);
+        if (consumed && kept == pinned)
+            kept = -1;
+        pinned = -1;
+    }
+
+    bool isFree(int buffer) const
+    {
+        return !busy[size_t(buffer)] && buffer != kept && buffer != pinned;
+    }
+
+    QMutex mutex;
+    Format format = Format::I420;
+    FrameBufferPool::Key key;
+    QSize size;
+    int stride = 0;     // Luma row pitch
+    int lines = 0;      // Luma rows allocated, chroma planes have half as many
+    std::vector<uchar *> buffers;
+    std::vector<bool> busy;
+    int kept = -1;      // Newest picture left unconverted while rendering is off
+    int pinned = -1;    // Kept picture being converted on demand
+
+    // Scratch of convert(); the display path and on-demand conversions share it
+    // Рабочие буферы convert(); их делят путь показа и преобразования по требованию
+    QMutex convertMutex;
+    std::vector<uchar> halved[2];
+    std::vector<uchar> rgb;
+    std::vector<uchar> scaleScratch;
+};
+
+void VideoFrameSink::Input::convert(int buffer, uchar *dst, int dstStride, const QSize &outSize)
+{
+    const PixelKernels::Kernels &kernels = PixelKernels::kernels();
+    const bool nv12 = format == Format::Nv12;
+
+    // Whole 2x2 passes while the picture stays at least the output size, then the rest bilinearly.
+    // Cropping to a multiple of 2^(passes + 1) keeps every plane, chroma included, halving evenly;
+    // it costs a few edge columns at most
+    // Целые проходы 2x2, пока картинка не меньше выходного размера, остальное билинейно. Обрезка до
+    // кратного 2^(passes + 1) сохраняет четное деление всех плоскостей, включая цветность; она стоит
+    // не более нескольких крайних столбцов
+    int passes = 0;
+    while ((size.width() >> (passes + 1)) >= outSize.width() && (size.height() >> (passes + 1)) >= outSize.height())
+        ++passes;
+    const int crop = 2 << passes;
+    int width = size.width() / crop * crop;
+    int height = size.height() / crop * crop;
+    if (width < 2 || height < 2)
+        return;
+
+    const uchar *y = plane(buffer, 0);
+    const uchar *u = plane(buffer, 1);
+    const uchar *v = nv12 ? nullptr : plane(buffer, 2);
+    int yStride = stride;
+    int cStride = chromaStride();
+
+    for (int pass = 0; pass < passes; ++pass) {
+        const int halfWidth = width / 2;
+        const int halfHeight = height / 2;
+        const int nextStride = alignUp(halfWidth, 32);
+        const int nextCStride = nv12 ? nextStride : nextStride / 2;
+        uchar *next = scratch(halved[pass % 2], qsizetype(nextStride) * halfHeight * 3 / 2);
+        uchar *nextU = next + qsizetype(nextStride) * halfHeight;
+        uchar *nextV = nextU + qsizetype(nextCStride) * (halfHeight / 2);
+
+        kernels.halvePlane(y, yStride, next, nextStride, halfWidth, halfHeight, 1);
+        if (nv12) {
+            kernels.halvePlane(u, cStride, nextU, nextCStride, halfWidth / 2, halfHeight / 2, 2);
+        } else {
+            kernels.halvePlane(u, cStride, nextU, nextCStride, halfWidth / 2, halfHeight / 2, 1);
+            kernels.halvePlane(v, cStride, nextV, nextCStride, halfWidth / 2, halfHeight / 2, 1);
+        }
+
+        y = next;
+        u = nextU;
+        v = nextV;
+        yStride = nextStride;
+        cStride = nextCStride;
+        width = halfWidth;
+        height = halfHeight;
+    }
+
+    // Straight into the slot when the passes already hit the output size
+    // Сразу в слот, если проходы уже дали выходной размер
+    const bool exact = QSize(width, height) == outSize;
+    const int rgbStride = width * 4;
+    uchar *rgbOut = exact ? dst : scratch(rgb, qsizetype(rgbStride) * height);
+    const int rgbOutStride = exact ? dstStride : rgbStride;
+    if (nv12)
+        kernels.nv12ToRgb32(y, yStride, u, cStride, rgbOut, rgbOutStride, width, height);
+    else
+        kernels.i420ToRgb32(y, yStride, u, cStride, v, cStride, rgbOut, rgbOutStride, width, height);
+
+    if (!exact) {
+        kernels.scaleRgb32(rgbOut, rgbStride, width, height, dst, dstStride, outSize.width(), outSize.height(),
+                           scratch(scaleScratch, PixelKernels::scaleScratchBytes(width, outSize.width())));
+    }
+}
+
+// RGB32 frames for one output size; outlives the sink while frames are still in use
+// Picture memory comes from the shared FrameBufferPool and goes back to it with the storage
+// Кадры RGB32 для одного выходного размера; живут дольше приемника, пока кадры используются
+// Память кадров берется из общего FrameBufferPool и возвращается в него вместе с хранилищем
+struct VideoFrameSink::Storage
+{
+    // Shown: given back by the renderer but still the newest frame, kept for grabFrame() until a
+    // newer one is published
+    // Shown: возвращен рендерером, но все еще самый новый кадр; хранится для grabFrame(), пока не
+    // опубликован более новый
+    enum class SlotState { Free, Filling, Ready, Rendering, Shown };
+
+    struct Slot
+    {
+        uchar *data = nullptr;
+        SlotState state = SlotState::Free;
+        std::unique_ptr<FrameRef> ref;
+    };
+
+    ~Storage()
+    {
+        for (Slot &slot : slots)
+            FrameBufferPool::shared().release(key, slot.data);
+    }
+
+    // Take one more slot of the output size from the pool
+    // Взять из пула еще один слот выходного размера
+    void addSlot()
+    {
+        Slot slot;
+        slot.data = FrameBufferPool::shared().acquire(key);
+        slot.ref = std::make_unique<FrameRef>();
+        slot.ref->slot = int(slots.size());
+        slots.push_back(std::move(slot));
+    }
+
+    // Slot to write the next frame into, marked Filling; called with mutex held
+    // Слот для записи следующего кадра, помечается как Filling; вызывается под mutex
+    int acquireSlot()
+    {
+        int index = -1;
+        for (int i = 0; i < int(slots.size()); ++i) {
+            if (slots[i].state == SlotState::Free) {
+                index = i;
+                break;
+            }
+        }
+
+        // Renderer is behind: overwrite the frame it has not picked up yet
+        // Рендерер отстает: перезаписать кадр, который он еще не забрал
+        if (index < 0 && ready >= 0) {
+            index = ready;
+            ready = -1;
+        }
+
+        // Every slot is busy (renderer holds several frames): grow instead of tearing a frame
+        // Все слоты заняты (рендерер держит несколько кадров): расшириться, а не портить кадр
+        if (index < 0) {
+            addSlot();
+            index = int(slots.size()) - 1;
+        }
+
+        slots[index].state = SlotState::Filling;
+        return index;
+    }
+
+    QMutex mutex;
+    FrameBufferPool::Key key;
+    QSize size;
+    int stride = 0;
+    std::vector<Slot> slots;
+    int ready = -1;
+    int displayed = -1;   // Slot of the last displayed frame, valid while Ready, Rendering or Shown
+};
+
+VideoFrameSink::VideoFrameSink(QObject *parent)
+    : QObject(parent)
+{
+    m_clock.start();
+}
+
+VideoFrameSink::~VideoFrameSink() = default;
+
+void VideoFrameSink::attach(libvlc_media_player_t *player)
+{
+    libvlc_video_set_callbacks(player, &VideoFrameSink::lockCallback,
+                               &VideoFrameSink::unlockCallback,
+                               &VideoFrameSink::displayCallback, this);
+    libvlc_video_set_format_callbacks(player, &VideoFrameSink::setupCallback,
+                                      &VideoFrameSink::cleanupCallback);
+}
+
+QImage VideoFrameSink::takeFrame()
+{
+    std::shared_ptr<Storage> storage;
+    {
+        QMutexLocker locker(&m_mutex);
+        if (!m_rendering)
+            return QImage();
+        storage = m_storage;
+    }
+    if (!storage)
+        return QImage();
+
+    QMutexLocker locker(&storage->mutex);
+    if (storage->ready < 0)
+        return QImage();
+
+    const int index = storage->ready;
+    storage->ready = -1;
+    Storage::Slot &slot = storage->slots[index];
+    slot.state = Storage::SlotState::Rendering;
+    slot.ref->storage = storage;
+
+    // Wrap the slot directly; releaseFrame() recycles it afterwards
+    // Обернуть слот напрямую; releaseFrame() затем возвращает его в оборот
+    return QImage(slot.data, storage->size.width(), storage->size.height(),
+                  storage->stride, QImage::Format_RGB32,
+                  &VideoFrameSink::releaseFrame, slot.ref.get());
+}
+
+QImage VideoFrameSink::grabFrame(const QSize &maxSize) const
+{
+    std::shared_ptr<Input> input;
+    std::shared_ptr<Storage> storage;
+    {
+        QMutexLocker locker(&m_mutex);
+        input = m_input;
+        storage = m_storage;
+    }
+
+    // While rendering is off the newest picture is still YUV; convert it straight at maxSize
+    // Пока отрисовка выключена, самый новый кадр еще в YUV; преобразовать его сразу в maxSize
+    if (input) {
+        const int buffer = input->pinKept();
+        if (buffer >= 0) {
+            const QSize outSize = outputSizeFor(input->size, maxSize);
+            QImage image(outSize, QImage::Format_RGB32);
+            {
+                QMutexLocker locker(&input->convertMutex);
+                input->convert(buffer, image.bits(), int(image.bytesPerLine()), outSize);
+            }
+            input->unpin(false);
+            return image;
+        }
+        input->unpin(false);
+    }
+    if (!storage)
+        return QImage();
+
+    int step = 1;
+    if (!maxSize.isEmpty()) {
+        while (storage->size.width() / (step + 1) >= 2 * maxSize.width()
+               && storage->size.height() / (step + 1) >= 2 * maxSize.height())
+            ++step;
+    }
+
+    // A Ready, Rendering or Shown slot is not written to while the storage mutex is held
+    // В слот в состоянии Ready, Rendering или Shown не пишут, пока удерживается мьютекс хранилища
+    QMutexLocker locker(&storage->mutex);
+    if (storage->displayed < 0)
+        return QImage();
+    const Storage::Slot &slot = storage->slots[storage->displayed];
+    if (slot.state == Storage::SlotState::Free || slot.state == Storage::SlotState::Filling)
+        return QImage();
+
+    QImage image(storage->size.width() / step, storage->size.height() / step, QImage::Format_RGB32);
+    for (int y = 0; y < image.height(); ++y) {
+        const auto *src = reinterpret_cast<const quint32 *>(slot.data + qsizetype(y) * step * storage->stride);
+        auto *dst = reinterpret_cast<quint32 *>(image.scanLine(y));
+        if (step == 1) {
+            std::memcpy(dst, src, size_t(image.width()) * 4);
+            continue;
+        }
+        for (int x = 0; x < image.width(); ++x)
+            dst[x] = src[x * step];
+    }
+    return image;
+}
+
+QSize VideoFrameSink::frameSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_input ? m_input->size : QSize();
+}
+
+QSize VideoFrameSink::outputSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_storage ? m_storage->size : QSize();
+}
+
+QString VideoFrameSink::chroma() const
+{
+    QMutexLocker locker(&m_mutex);
+    if (!m_input)
+        return QString();
+    return m_input->format == Input::Format::Nv12 ? QStringLiteral("NV12") : QStringLiteral("I420");
+}
+
+void VideoFrameSink::setTargetSize(const QSize &size)
+{
+    QMutexLocker locker(&m_mutex);
+    m_targetSize = size;
+}
+
+QSize VideoFrameSink::targetSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_targetSize;
+}
+
+VideoFrameSink::Timing VideoFrameSink::timing() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_timing;
+}
+
+void VideoFrameSink::setFrameTap(std::shared_ptr<FrameTap> tap)
+{
+    QMutexLocker locker(&m_mutex);
+    m_tap = std::move(tap);
+}
+
+void VideoFrameSink::setRendering(bool rendering)
+{
+    {
+        QMutexLocker locker(&m_mutex);
+        if (rendering == m_rendering)
+            return;
+        m_rendering = rendering;
+    }
+
+    if (!rendering)
+        return;
+
+    // The newest picture kept meanwhile is converted and shown without waiting for the decoder
+    // Сохраненный за это время самый новый кадр преобразуется и показывается, не дожидаясь декодера
+    std::shared_ptr<Input> input;
+    std::shared_ptr<Storage> storage;
+    std::shared_ptr<FrameTap> tap;
+    QSize target;
+    {
+        QMutexLocker locker(&m_mutex);
+        input = m_input;
+        storage = m_storage;
+        tap = m_tap;
+        target = m_targetSize;
+    }
+    if (input) {
+        const int buffer = input->pinKept();
+        if (buffer >= 0)
+            present(input, buffer, storage, tap, target);
+        input->unpin(true);
+    }
+    emit frameReady();
+}
+
+bool VideoFrameSink::isRendering() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_rendering;
+}
+
+void VideoFrameSink::resetTiming()
+{
+    QMutexLocker locker(&m_mutex);
+    m_timing = Timing();
+    m_lastDisplayNs = -1;
+    m_meanIntervalMs = 0.0;
+}
+
+unsigned VideoFrameSink::setupCallback(void **opaque, char *chroma, unsigned *width, unsigned *height,
+                                       unsigned *pitches, unsigned *lines)
+{
+    auto *self = static_cast<VideoFrameSink *>(*opaque);
+
+    // NV12 is what hardware decoders copy back and is taken as-is; anything else is asked for as
+    // I420, the usual software decoder output. RGB conversion happens in display() at tile size
+    // NV12 - то, что копируют обратно аппаратные декодеры, и оно принимается как есть; все остальное
+    // запрашивается как I420, обычный вывод программных декодеров. Преобразование в RGB - в display() в размере плитки
+    auto input = std::make_shared<Input>();
+    input->format = std::memcmp(chroma, "NV12", 4) == 0 ? Input::Format::Nv12 : Input::Format::I420;
+    std::memcpy(chroma, input->format == Input::Format::Nv12 ? "NV12" : "I420", 4);
+
+    input->size = QSize(int(*width), int(*height));
+    input->stride = alignUp(int(*width), kRowAlignment);
+    input->lines = alignUp(int(*height), kLineAlignment);
+    input->key = FrameBufferPool::Key { input->format == Input::Format::Nv12 ? kChromaNV12 : kChromaI420,
+                                        QSize(input->size.width(), input->lines * 3 / 2), input->stride };
+    for (int i = 0; i < kSlotCount; ++i)
+        input->addBuffer();
+
+    pitches[0] = unsigned(input->stride);
+    lines[0] = unsigned(input->lines);
+    pitches[1] = unsigned(input->chromaStride());
+    lines[1] = unsigned(input->lines / 2);
+    pitches[2] = pitches[1];
+    lines[2] = lines[1];
+
+    QMutexLocker locker(&self->m_mutex);
+    self->m_input = input;
+    self->m_storage.reset();
+    qDebug() << "VideoFrameSink: format" << input->size << (input->format == Input::Format::Nv12 ? "NV12" : "I420")
+             << "kernels" << PixelKernels::isaName(PixelKernels::kernels().isa);
+    return 1;
+}
+
+void VideoFrameSink::cleanupCallback(void *opaque)
+{
+    // Frames still held by the renderer keep their storage alive through FrameRef
+    // Кадры, удерживаемые рендерером, сохраняют свое хранилище через FrameRef
+    auto *self = static_cast<VideoFrameSink *>(opaque);
+    QMutexLocker locker(&self->m_mutex);
+    self->m_input.reset();
+    self->m_storage.reset();
+}
+
+void *VideoFrameSink::lockCallback(void *opaque, void **planes)
+{
+    auto *self = static_cast<VideoFrameSink *>(opaque);
+    std::shared_ptr<Input> input;
+    {
+        QMutexLocker locker(&self->m_mutex);
+        input = self->m_input;
+    }
+
+    QMutexLocker locker(&input->mutex);
+    int index = -1;
+    for (int i = 0; i < int(input->buffers.size()); ++i) {
+        if (input->isFree(i)) {
+            index = i;
+            break;
+        }
+    }
+
+    // Decoder runs ahead of display: grow instead of overwriting a picture not converted yet
+    // Декодер опережает показ: расшириться, а не перезаписывать еще не преобразованный кадр
+    if (index < 0 && int(input->buffers.size()) < kMaxDecodeBuffers) {
+        input->addBuffer();
+        index = int(input->buffers.size()) - 1;
+    }
+
+    // More pictures out than the vout pool holds: share a buffer rather than grow without bound
+    // Выдано больше кадров, чем вмещает пул видеовывода: разделить буфер, а не расти без предела
+    if (index < 0) {
+        qWarning() << "VideoFrameSink: all" << kMaxDecodeBuffers << "decode buffers are locked";
+        index = int(input->buffers.size()) - 1;
+    }
+
+    input->busy[size_t(index)] = true;
+    planes[0] = input->plane(index, 0);
+    planes[1] = input->plane(index, 1);
+    planes[2] = input->plane(index, 2);
+    return reinterpret_cast<void *>(quintptr(index));
+}
+
+void VideoFrameSink::unlockCallback(void *opaque, void *picture, void *const *planes)
+{
+    Q_UNUSED(planes)
+
+    // Runs for every locked picture, shown or dropped as late, so no buffer stays busy forever
+    // Вызывается для каждого заблокированного кадра, показанного или отброшенного как опоздавший,
+    // поэтому ни один буфер не остается занятым навсегда
+    auto *self = static_cast<VideoFrameSink *>(opaque);
+    std::shared_ptr<Input> input;
+    {
+        QMutexLocker locker(&self->m_mutex);
+        input = self->m_input;
+    }
+    if (!input)
+        return;
+
+    const size_t index = size_t(reinterpret_cast<quintptr>(picture));
+    QMutexLocker locker(&input->mutex);
+    if (index < input->busy.size())
+        input->busy[index] = false;
+}
+
+void VideoFrameSink::displayCallback(void *opaque, void *picture)
+{
+    auto *self = static_cast<VideoFrameSink *>(opaque);
+    std::shared_ptr<Input> input;
+    std::shared_ptr<Storage> storage;
+    std::shared_ptr<FrameTap> tap;
+    QSize target;
+    bool rendering = true;
+    bool notify = true;
+    {
+        QMutexLocker locker(&self->m_mutex);
+        input = self->m_input;
+        storage = self->m_storage;
+        tap = self->m_tap;
+        target = self->m_targetSize;
+        rendering = self->m_rendering;
+
+        // libvlc calls display at presentation time, so the gaps between calls show
+        // how evenly frames reach the screen
+        // libvlc вызывает display в момент показа, поэтому промежутки между вызовами
+        // показывают, насколько равномерно кадры доходят до экрана
+        const qint64 now = self->m_clock.nsecsElapsed();
+        if (self->m_lastDisplayNs >= 0) {
+            const double interval = double(now - self->m_lastDisplayNs) / 1e6;
+            if (self->m_meanIntervalMs <= 0.0)
+                self->m_meanIntervalMs = interval;
+            if (interval > self->m_meanIntervalMs * 1.5)
+                ++self->m_timing.lateFrames;
+            self->m_timing.jitterMs += (std::abs(interval - self->m_meanIntervalMs) - self->m_timing.jitterMs) / 16.0;
+            self->m_meanIntervalMs += (interval - self->m_meanIntervalMs) / 16.0;
+        }
+        self->m_lastDisplayNs = now;
+        ++self->m_timing.displayedFrames;
+
+        // The first frame is still announced, the player counts its start from it
+        // О первом кадре все равно сообщается, от него плеер отсчитывает старт
+        if (!self->m_rendering) {
+            ++self->m_timing.unrenderedFrames;
+            notify = self->m_timing.displayedFrames == 1;
+        }
+    }
+
+    const int buffer = int(reinterpret_cast<quintptr>(picture));
+    const bool tapActive = tap && tap->isActive();
+
+    // Nobody looks at the picture: only remember which buffer holds it, so hidden streams skip the
+    // conversion as well as the upload; setRendering(true) and grabFrame() convert it on demand
+    // Картинку никто не смотрит: только запомнить, в каком буфере она лежит, чтобы скрытые потоки
+    // пропускали и преобразование, и загрузку; setRendering(true) и grabFrame() преобразуют ее по требованию
+    {
+        QMutexLocker locker(&input->mutex);
+        input->kept = rendering || tapActive ? -1 : buffer;
+    }
+    if (rendering || tapActive)
+        self->present(input, buffer, storage, tap, target);
+
+    if (notify)
+        emit self->frameReady();
+}
+
+void VideoFrameSink::present(const std::shared_ptr<Input> &input, int buffer, std::shared_ptr<Storage> storage,
+                             const std::shared_ptr<FrameTap> &tap, QSize target)
+{
+    const bool tapActive = tap && tap->isActive();
+
+    // Tap consumers are served from the same frame: convert at the largest size any of them or the
+    // tile needs, the decoded size only when one of them asks for full detail
+    // Потребители отвода обслуживаются из того же кадра: преобразовывать в наибольшем размере,
+    // нужном кому-то из них или плитке, в размере декодирования - только если кто-то просит полную детализацию
+    if (tapActive && !target.isEmpty()) {
+        const QSize tapSize = tap->requiredSize();
+        target = tapSize.isEmpty() ? QSize() : target.expandedTo(tapSize);
+    }
+
+    // A new tile size gets new slots; frames still out keep the old storage alive
+    // Новый размер плитки получает новые слоты; выданные кадры сохраняют старое хранилище
+    const QSize outSize = outputSizeFor(input->size, target);
+    if (!storage || storage->size != outSize) {
+        storage = std::make_shared<Storage>();
+        storage->size = outSize;
+        storage->stride = alignUp(outSize.width() * 4, kRowAlignment);
+        storage->key = FrameBufferPool::Key { kChromaRV32, storage->size, storage->stride };
+        for (int i = 0; i < kSlotCount; ++i)
+            storage->addSlot();
+
+        QMutexLocker locker(&m_mutex);
+        if (m_input == input)
+            m_storage = storage;
+    }
+
+    int index = -1;
+    uchar *data = nullptr;
+    {
+        QMutexLocker locker(&storage->mutex);
+        index = storage->acquireSlot();
+        data = storage->slots[index].data;
+    }
+
+    // The slot is marked Filling, so neither the renderer nor the next display can touch it while
+    // it is written and while consumers copy from it
+    // Слот помечен как Filling, поэтому ни рендерер, ни следующий display не трогают его, пока
+    // он записывается и пока потребители копируют из него
+    {
+        QMutexLocker locker(&input->convertMutex);
+        input->convert(buffer, data, storage->stride, outSize);
+    }
+
+    if (tapActive)
+        tap->deliver(data, storage->size, storage->stride);
+
+    {
+        QMutexLocker locker(&storage->mutex);
+        // The previous ready frame was never rendered; return it to the free list
+        // Предыдущий готовый кадр так и не был отрисован; вернуть его в список свободных
+        if (storage->ready >= 0 && storage->ready != index)
+            storage->slots[storage->ready].state = Storage::SlotState::Free;
+
+        // The frame kept for grabFrame() is superseded by this one
+        // Кадр, хранимый для grabFrame(), заменяется этим
+        if (storage->displayed >= 0 && storage->displayed != index
+            && storage->slots[storage->displayed].state == Storage::SlotState::Shown)
+            storage->slots[storage->displayed].state = Storage::SlotState::Free;
+        storage->slots[index].state = Storage::SlotState::Ready;
+        storage->ready = index;
+        storage->displayed = index;
+    }
+}
+
+void VideoFrameSink::releaseFrame(void *info)
+{
+    // The reference is reused for the next frame of the slot; the storage pointer moves out so the
+    // storage can be destroyed (and its buffers pooled) after its mutex is unlocked
+    // Ссылка используется для следующего кадра слота; указатель на хранилище выносится наружу,
+    // чтобы хранилище могло уничтожиться (и вернуть буферы в пул) после разблокировки его мьютекса
+    auto *ref = static_cast<FrameRef *>(info);
+    std::shared_ptr<Storage> storage;
+    {
+        QMutexLocker locker(&ref->storage->mutex);
+        storage = std::move(ref->storage);
+        Storage::Slot &slot = storage->slots[ref->slot];
+        // The newest frame stays grabbable after the renderer has uploaded it
+        // Самый новый кадр остается доступным для grabFrame() после того, как рендерер его загрузил
+        if (slot.state == Storage::SlotState::Rendering)
+            slot.state = ref->slot == storage->displayed ? Storage::SlotState::Shown : Storage::SlotState::Free;
+    }
+}
+
+QSize VideoFrameSink::outputSizeFor(const QSize &decoded, const QSize &target)
+{
+    // Even sizes keep the 4:2:0 chroma aligned with the luma; the odd last row or column is dropped
+    // Четные размеры сохраняют выравнивание цветности 4:2:0 с яркостью; нечетная последняя строка или столбец отбрасываются
+    QSize size(qMax(2, decoded.width() & ~1), qMax(2, decoded.height() & ~1));
+    if (target.isEmpty())
+        return size;
+
+    const QSize fitted = size.scaled(target, Qt::KeepAspectRatio);
+    if (fitted.width() >= size.width() || fitted.height() >= size.height())
+        return size;
+    return QSize(qMax(2, fitted.width() & ~1), qMax(2, fitted.height() & ~1));
+}
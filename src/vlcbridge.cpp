@@ -1,16 +1,118 @@
 #include "vlcbridge.h"
+#include "framebufferpool.h"
+#include "pixelkernels.h"
+#include "playerworker.h"
+#include "sessioncache.h"
+#include "videoframesink.h"
+#include "vlcengine.h"
+#include "vlcplayer.h"
+#include "vlcvideoitem.h"
 #include <QDebug>
+#include <QGuiApplication>
+#include <QMetaEnum>
 #include <QQuickWindow>
 #include <QTimer>
+#include <utility>
+
+#ifdef Q_OS_ANDROID
+namespace {
+
+// Bridge that receives the state callbacks of VlcSurfaceHelper (one per application)
+// Мост, получающий колбэки состояния VlcSurfaceHelper (один на приложение)
+QPointer<VLCBridge> s_surfaceBridge;
+
+} // namespace
+
+// Called by VlcSurfaceHelper on the Android main thread for every MediaPlayer event
+// Parameters: state - VlcPlayer::State value, message - failure text or null
+// Вызывается VlcSurfaceHelper в главном потоке Android для каждого события MediaPlayer
+// Параметры: state - значение VlcPlayer::State, message - текст сбоя или null
+extern "C" JNIEXPORT void JNICALL
+Java_org_qtproject_example_vlc_VlcSurfaceHelper_nativeStateChanged(JNIEnv *, jclass, jint state, jstring message)
+{
+    const QString text = message ? QJniObject(message).toString() : QString();
+    VLCBridge *bridge = s_surfaceBridge.data();
+    if (!bridge)
+        return;
+
+    // Hop to the Qt GUI thread; the call is dropped if the bridge is gone
+    // Перейти в поток GUI Qt; вызов отбрасывается, если моста уже нет
+    QMetaObject::invokeMethod(bridge, [bridge, state, text]() {
+        bridge->onSurfaceState(int(state), text);
+    }, Qt::QueuedConnection);
+}
+#endif
 
 // Constructor: Initialize the VLCBridge object and log its creation
 // Конструктор: Инициализировать объект VLCBridge и залогировать его создание
 VLCBridge::VLCBridge(QObject *parent)
     : QObject(parent)
+    , m_replay(new ReplayBuffer(this))
+    , m_standbyReplay(new ReplayBuffer(this))
+    , m_frameTap(std::make_shared<FrameTap>())
 {
+    // A camera that never delivers a frame must not leave the switch pending forever
+    // Камера, которая так и не выдала кадр, не должна оставлять переключение в ожидании навсегда
+    m_switchTimeout.setSingleShot(true);
+    m_switchTimeout.setInterval(10000);
+    connect(&m_switchTimeout, &QTimer::timeout, this, [this]() {
+        emit error(QStringLiteral("Switch to %1 timed out").arg(m_pendingSwitchUrl));
+        cancelSwitch();
+    });
+
+    // Recorder signals come from its writer thread and are queued to the GUI thread
+    // Сигналы рекордера приходят из его потока записи и ставятся в очередь потока GUI
+    connect(&m_recorder, &StreamRecorder::segmentStarted, this, &VLCBridge::recordingSegmentStarted);
+    connect(&m_recorder, &StreamRecorder::segmentFinished, this, &VLCBridge::recordingSegmentFinished);
+    connect(&m_recorder, &StreamRecorder::backpressureChanged, this, &VLCBridge::recordingBackpressureChanged);
+    connect(&m_recorder, &StreamRecorder::error, this, &VLCBridge::error);
+
+    connect(m_replay, &ReplayBuffer::error, this, &VLCBridge::error);
+    connect(m_standbyReplay, &ReplayBuffer::error, this, &VLCBridge::error);
+    m_replayTimer.setInterval(500);
+    connect(&m_replayTimer, &QTimer::timeout, this, &VLCBridge::replayPositionChanged);
+
+    connect(&m_snapshots, &SnapshotService::ready, this, [this](const QString &url, const QByteArray &data) {
+        emit snapshotReady(url, QStringLiteral("data:%1;base64,%2").arg(m_snapshots.mimeType(), QString::fromLatin1(data.toBase64())));
+    });
+    connect(&m_snapshots, &SnapshotService::failed, this, &VLCBridge::snapshotFailed);
+
+    // A tile being dragged or animated to fullscreen resizes many times; pick the variant once it settles
+    // Плитка, которую тянут или анимируют на весь экран, меняет размер много раз; выбрать вариант, когда она успокоится
+    m_variantTimer.setSingleShot(true);
+    m_variantTimer.setInterval(300);
+    connect(&m_variantTimer, &QTimer::timeout, this, &VLCBridge::reselectVariant);
+
+    // Going to the background sheds work right away and coming back restores it
+    // Уход в фон сразу сбрасывает нагрузку, а возврат восстанавливает ее
+    if (qGuiApp)
+        connect(qGuiApp, &QGuiApplication::applicationStateChanged, this, &VLCBridge::updateVisibility);
+
+#ifdef Q_OS_ANDROID
+    s_surfaceBridge = this;
+    connect(&m_geometrySync, &SurfaceGeometrySync::geometryChanged, this, &VLCBridge::sendSurfaceGeometry);
+#endif
+
     qDebug("✅ VLCBridge constructed");
 }
 
+VLCBridge::~VLCBridge()
+{
+#ifdef Q_OS_ANDROID
+    // The Java LibVLC, MediaPlayer and TextureView outlive stop() on purpose; free them with the bridge
+    // Java LibVLC, MediaPlayer и TextureView намеренно переживают stop(); освободить их вместе с мостом
+    if (m_usesSurface)
+        QJniObject::callStaticMethod<void>("org/qtproject/example/vlc/VlcSurfaceHelper", "release", "()V");
+#endif
+
+    returnToLive();
+    cancelSwitch();
+    if (m_player)
+        m_player->stop();
+    stopRecording();
+    stopReplayBuffers();
+}
+
 // Getter: Returns the current playing state
 // Геттер: Возвращает текущее состояние воспроизведения
 bool VLCBridge::isPlaying() const
@@ -25,6 +127,167 @@ bool VLCBridge::isPaused() const
     return m_isPaused;
 }
 
+// Getter: Returns the state of the active stream
+// Геттер: Возвращает состояние активного потока
+VlcPlayer::State VLCBridge::state() const
+{
+    return m_state;
+}
+
+// Getters: Return the measured start-up and switch times in milliseconds
+// Геттеры: Возвращают измеренные времена запуска и переключения в миллисекундах
+qint64 VLCBridge::startupMs() const
+{
+    return m_startupMs;
+}
+
+qint64 VLCBridge::lastSwitchMs() const
+{
+    return m_lastSwitchMs;
+}
+
+// Getter: Returns the selected latency profile
+// Геттер: Возвращает выбранный профиль задержки
+VLCBridge::LatencyProfile VLCBridge::latencyProfile() const
+{
+    return m_latencyProfile;
+}
+
+// Setter: Select a latency profile and apply it to the running stream
+// Сеттер: Выбрать профиль задержки и применить его к текущему потоку
+void VLCBridge::setLatencyProfile(LatencyProfile profile)
+{
+    if (profile == m_latencyProfile)
+        return;
+
+    m_latencyProfile = profile;
+    emit latencyProfileChanged(m_latencyProfile);
+    emit cachingMsChanged(cachingMs());
+
+#ifdef Q_OS_ANDROID
+    // The Java helper applies the values to every Media it creates from now on
+    // Java помощник применяет значения ко всем Media, которые он создает с этого момента
+    QJniObject::callStaticMethod<void>(
+        "org/qtproject/example/vlc/VlcSurfaceHelper",
+        "setLatencyOptions",
+        "(IZ)V",
+        jint(cachingFor(QString())),
+        jboolean(dropLateFramesFor(QString())));
+#endif
+
+    retune();
+}
+
+// Getter: Returns the caching in effect for the active stream
+// Геттер: Возвращает кэширование, действующее для активного потока
+int VLCBridge::cachingMs() const
+{
+    return cachingFor(m_player ? m_player->url() : QString());
+}
+
+// Getter: Returns the global decoder policy
+// Геттер: Возвращает общую политику декодера
+VlcPlayer::DecodePolicy VLCBridge::decodePolicy() const
+{
+    return m_decodePolicy;
+}
+
+// Setter: Change the global decoder policy and apply it to the running stream
+// Сеттер: Изменить общую политику декодера и применить ее к текущему потоку
+void VLCBridge::setDecodePolicy(VlcPlayer::DecodePolicy policy)
+{
+    if (policy == m_decodePolicy)
+        return;
+
+    m_decodePolicy = policy;
+    emit decodePolicyChanged(m_decodePolicy);
+
+#ifdef Q_OS_ANDROID
+    QJniObject::callStaticMethod<void>(
+        "org/qtproject/example/vlc/VlcSurfaceHelper",
+        "setDecodeOptions",
+        "(II)V",
+        jint(m_decodePolicy),
+        jint(m_decodeThreads));
+#endif
+
+    if (m_player && !m_streamDecodePolicies.contains(m_player->url()))
+        retune();
+}
+
+// Getter: Returns the thread cap of VlcPlayer::DecodeSoftwareCapped
+// Геттер: Возвращает ограничение потоков для VlcPlayer::DecodeSoftwareCapped
+int VLCBridge::decodeThreads() const
+{
+    return m_decodeThreads;
+}
+
+// Setter: Change the thread cap; a capped stream on screen is reopened with it
+// Сеттер: Изменить ограничение потоков; ограниченный поток на экране переоткрывается с ним
+void VLCBridge::setDecodeThreads(int threads)
+{
+    threads = qMax(1, threads);
+    if (threads == m_decodeThreads)
+        return;
+
+    m_decodeThreads = threads;
+    emit decodeThreadsChanged(m_decodeThreads);
+
+#ifdef Q_OS_ANDROID
+    QJniObject::callStaticMethod<void>(
+        "org/qtproject/example/vlc/VlcSurfaceHelper",
+        "setDecodeOptions",
+        "(II)V",
+        jint(m_decodePolicy),
+        jint(m_decodeThreads));
+#endif
+
+    if (m_player && decodePolicyFor(m_player->url()) == VlcPlayer::DecodeSoftwareCapped)
+        retune();
+}
+
+// Getter: Returns the decoder path of the active stream
+// Геттер: Возвращает путь декодирования активного потока
+QString VLCBridge::decoderPath() const
+{
+    return m_player ? m_player->decoderPath() : QString();
+}
+
+// Getter: Returns the global RTP transport
+// Геттер: Возвращает общий транспорт RTP
+VlcPlayer::Transport VLCBridge::transport() const
+{
+    return m_transport;
+}
+
+// Setter: Change the global RTP transport and apply it to the running stream
+// Сеттер: Изменить общий транспорт RTP и применить его к текущему потоку
+void VLCBridge::setTransport(VlcPlayer::Transport transport)
+{
+    if (transport == m_transport)
+        return;
+
+    m_transport = transport;
+    emit transportChanged(m_transport);
+
+    if (m_player && !m_streamTransports.contains(m_player->url()))
+        retune();
+}
+
+// Getter: Returns the transport of the active stream
+// Геттер: Возвращает транспорт активного потока
+QString VLCBridge::transportPath() const
+{
+    return m_player ? m_player->transportPath() : QString();
+}
+
+// Getter: Returns the latest metrics of the active stream
+// Геттер: Возвращает последние метрики активного потока
+PlaybackMetrics VLCBridge::metrics() const
+{
+    return m_metrics;
+}
+
 // Convert device-independent pixels (DP) to physical pixels (PX)
 // based on the screen's device pixel ratio (DPI scaling)
 // Преобразовать аппаратно-независимые пиксели (DP) в физические пиксели (PX)
@@ -50,153 +313,1436 @@ QRectF VLCBridge::toPx(QObject *videoContainer, const QRectF &rectDp)
                   rectDp.height() * dpi);
 }
 
+// Adopt the state reported by the active decoder and notify QML about it
+// Parameters: state - new state of the active stream
+// Принять состояние, сообщенное активным декодером, и уведомить о нем QML
+// Параметры: state - новое состояние активного потока
+void VLCBridge::applyState(VlcPlayer::State state)
+{
+    const bool playing = state == VlcPlayer::Buffering || state == VlcPlayer::Playing;
+    const bool paused = state == VlcPlayer::Paused;
+
+    // Emit signals to notify QML layer of state changes
+    // Отправить сигналы для уведомления QML слоя об изменениях состояния
+    if (playing != m_isPlaying) {
+        m_isPlaying = playing;
+        emit isPlayingChanged(m_isPlaying);
+
+        // Settings changed while paused take effect on resume
+        // Настройки, измененные во время паузы, вступают в силу при возобновлении
+        if (m_isPlaying)
+            applyPendingRetune();
+    }
+    if (paused != m_isPaused) {
+        m_isPaused = paused;
+        emit isPausedChanged(m_isPaused);
+    }
+    if (state != m_state) {
+        m_state = state;
+        emit stateChanged(m_state);
+    }
+
+    // Always refresh the text: it may still show a transient "Switching"
+    // Всегда обновлять текст: он может еще показывать временное "Switching"
+    emit statusChanged(VlcPlayer::stateName(m_state));
+}
+
+// Route a player state change: the active player drives the bridge, a failing standby aborts the switch
+// Parameters: player - player that changed, state - its new state
+// Направить изменение состояния плеера: активный управляет мостом, упавший резервный прерывает переключение
+// Параметры: player - изменившийся плеер, state - его новое состояние
+void VLCBridge::onPlayerState(VlcPlayer *player, VlcPlayer::State state)
+{
+    if (player == m_player) {
+        applyState(state);
+        return;
+    }
+
+    // No need to wait for the switch timeout once the target camera has failed
+    // Не нужно ждать таймаута переключения, если целевая камера уже отказала
+    if (player == m_standby && !m_pendingSwitchUrl.isEmpty() && player->url() == m_pendingSwitchUrl
+        && (state == VlcPlayer::Error || state == VlcPlayer::Ended)) {
+        qDebug() << "VLCBridge: switch to" << m_pendingSwitchUrl << "aborted:" << VlcPlayer::stateName(state);
+        cancelSwitch();
+        applyState(m_state);
+    }
+}
+
+// True while the active stream is opening, playing or paused
+// True, пока активный поток открывается, воспроизводится или приостановлен
+bool VLCBridge::hasActiveStream() const
+{
+    switch (m_state) {
+    case VlcPlayer::Opening:
+    case VlcPlayer::Buffering:
+    case VlcPlayer::Playing:
+    case VlcPlayer::Paused:
+        return true;
+    case VlcPlayer::Idle:
+    case VlcPlayer::Ended:
+    case VlcPlayer::Error:
+        break;
+    }
+    return false;
+}
+
 // Start playback of RTSP stream at specified position and size
-// Parameters: url - stream URL, videoContainer - QML item for DPI scaling,
+// A VlcVideoItem container is rendered through the Qt Quick scene graph on every platform;
+// on Android any other container falls back to the overlaid TextureView of VlcSurfaceHelper
+// Parameters: urlOrCamera - stream URL or camera, videoContainer - QML item for DPI scaling,
 //             x, y - position in DP, width, height - size in DP
 // Начать воспроизведение RTSP потока в указанной позиции и размере
-// Параметры: url - URL потока, videoContainer - элемент QML для масштабирования DPI,
+// Контейнер VlcVideoItem отрисовывается через граф сцены Qt Quick на всех платформах;
+// на Android любой другой контейнер использует накладываемый TextureView из VlcSurfaceHelper
+// Параметры: urlOrCamera - URL потока или камера, videoContainer - элемент QML для масштабирования DPI,
 //            x, y - позиция в DP, width, height - размер в DP
-void VLCBridge::play(const QString &url, QObject *videoContainer, qreal x, qreal y, qreal width, qreal height)
+void VLCBridge::play(const QString &urlOrCamera, QObject *videoContainer, qreal x, qreal y, qreal width, qreal height)
 {
+    auto *videoItem = qobject_cast<VlcVideoItem *>(videoContainer);
+
+    // A video item knows its own size; the explicit rectangle describes the surface path
+    // Элемент видео знает свой размер; явный прямоугольник описывает путь с поверхностью
+    const QRectF rectDp = videoItem ? QRectF(0, 0, videoItem->width(), videoItem->height())
+                                    : QRectF(x, y, width, height);
+    const QString url = variantFor(urlOrCamera, toPx(videoContainer, rectDp).size().toSize());
+
 #ifdef Q_OS_ANDROID
-    // Get the current Android Activity from QtNative
-    // Получить текущий объект Activity из QtNative
-    QJniObject activity = QJniObject::callStaticObjectMethod(
-        "org/qtproject/qt/android/QtNative", "activity", "()Landroid/app/Activity;");
-    // Check if Activity was successfully retrieved
-    // Проверить, был ли Activity успешно получен
-    if (!activity.isValid()) {
-        emit error("Failed to get Android activity");
+    if (!videoItem) {
+        playInSurface(url, videoContainer, rectDp);
         return;
     }
+    // Leaving the legacy surface: tear it down before the native player takes over
+    // Уход с устаревшей поверхности: освободить ее до того, как управление примет нативный плеер
+    if (m_usesSurface) {
+        QJniObject::callStaticMethod<void>("org/qtproject/example/vlc/VlcSurfaceHelper", "release", "()V");
+        m_geometrySync.setItem(nullptr);
+        m_usesSurface = false;
+    }
+#endif
 
-    // Convert QString to JNI string
-    // Преобразовать QString в JNI строку
-    QJniObject jUrl = QJniObject::fromString(url);
+    // Create the native libvlc player on first use
+    // Создать нативный плеер libvlc при первом использовании
+    if (!m_player) {
+        m_player = createPlayer();
+        m_player->videoSink()->setFrameTap(m_frameTap);
+    }
 
-    // Convert DP coordinates to physical pixels using DPI scaling
-    // Преобразовать DP координаты в физические пиксели с использованием DPI масштабирования
-    auto rect = toPx(videoContainer, QRectF(x, y, width, height));
+    // An explicit play() supersedes any camera switch still in flight
+    // Явный play() отменяет любое еще не завершенное переключение камеры
+    if (!m_pendingSwitchUrl.isEmpty())
+        cancelSwitch();
 
-    // Call the native Java method to start VLC playback in a SurfaceView
-    // JNI signature: (Activity, URL string, x, y, width, height) -> void
-    // Вызвать нативный Java метод для запуска воспроизведения VLC в SurfaceView
-    // JNI сигнатура: (Activity, URL строка, x, y, ширина, высота) -> void
-    QJniObject::callStaticMethod<void>(
-        "org/qtproject/example/vlc/VlcSurfaceHelper",
-        "startPlaybackInSurface",
-        "(Landroid/app/Activity;Ljava/lang/String;FFFF)V",
-        activity.object<jobject>(),
-        jUrl.object<jstring>(),
-        static_cast<jfloat>(rect.x()),
-        static_cast<jfloat>(rect.y()),
-        static_cast<jfloat>(rect.width()),
-        static_cast<jfloat>(rect.height())
-        );
+    // Frames go straight into the item's scene graph texture; without an item playback is headless
+    // Кадры идут прямо в текстуру графа сцены элемента; без элемента воспроизведение идет без вывода
+    if (m_videoItem != videoItem) {
+        if (m_videoItem) {
+            disconnect(m_videoItem, nullptr, &m_variantTimer, nullptr);
+            disconnect(m_videoItem, &QQuickItem::visibleChanged, this, nullptr);
+        }
+        if (videoItem) {
+            connect(videoItem, &QQuickItem::widthChanged, &m_variantTimer, qOverload<>(&QTimer::start));
+            connect(videoItem, &QQuickItem::heightChanged, &m_variantTimer, qOverload<>(&QTimer::start));
+            connect(videoItem, &QQuickItem::visibleChanged, this, &VLCBridge::updateVisibility);
+        }
+    }
+    m_videoItem = videoItem;
+    if (videoItem)
+        videoItem->setPlayer(m_player);
 
-    // Update internal state to reflect that playback has started
-    // Обновить внутреннее состояние, чтобы отразить, что воспроизведение началось
-    m_isPlaying = true;
-    m_isPaused = false;
+    // Set before open(), so a stream started hidden is opened in its hidden mode right away
+    // Задается до open(), чтобы поток, запущенный скрытым, сразу открылся в скрытом режиме
+    updateVisibility();
 
-    // Emit signals to notify QML layer of state changes
-    // Отправить сигналы для уведомления QML слоя об изменениях состояния
-    emit isPlayingChanged(m_isPlaying);
-    emit isPausedChanged(m_isPaused);
-    emit statusChanged("Playing");
-#else
-    // Mark unused parameters to avoid compiler warnings on non-Android platforms
-    // Отметить неиспользуемые параметры, чтобы избежать предупреждений компилятора на платформах, отличных от Android
-    Q_UNUSED(url) Q_UNUSED(videoContainer) Q_UNUSED(x) Q_UNUSED(y) Q_UNUSED(width) Q_UNUSED(height)
-    emit error("Android only");
-#endif
+    applyDecodePolicy(m_player, url);
+    m_player->setTransport(transportFor(url));
+
+    // The open below takes the current settings, so a deferred retune has nothing left to do
+    // Открытие ниже берет текущие настройки, поэтому отложенной перенастройке делать нечего
+    m_retunePending = false;
+    returnToLive();
+
+    // A recording belongs to the stream it was started on
+    // Запись принадлежит потоку, на котором она была начата
+    if (m_recorder.isRecording()) {
+        m_player->stop();
+        stopRecording();
+    }
+
+    // So does the replay window; the ring is kept but starts over with the new stream
+    // Как и окно повтора; кольцо сохраняется, но начинается заново с новым потоком
+    m_replay->clear();
+    ensureReplayBuffer(m_replay);
+    if (m_player->streamOutputs() != streamOutputsFor(m_player)) {
+        m_player->stop();
+        m_player->setStreamOutputs(streamOutputsFor(m_player));
+    }
+
+    // Open the stream directly through libvlc; the player reports the failure reason itself
+    // The state moves on from Opening only when libvlc says so
+    // Открыть поток напрямую через libvlc; плеер сам сообщает причину ошибки
+    // Состояние уходит из Opening только тогда, когда об этом сообщит libvlc
+    if (!m_player->open(url, streamOptions(url)))
+        return;
+    m_player->setCachingMs(cachingFor(url));
+    m_latencyControllers[url].restartMeasurement();
+    emit cachingMsChanged(cachingMs());
 }
 
 // Update the position and size of the currently playing video surface
+// Only the Android TextureView needs this; a VlcVideoItem follows the QML layout by itself
 // Parameters: x, y - new position in DP, width, height - new size in DP
 // Обновить позицию и размер текущей поверхности воспроизведения видео
+// Нужно только для Android TextureView; VlcVideoItem сам следует QML-макету
 // Параметры: x, y - новая позиция в DP, width, height - новый размер в DP
 void VLCBridge::updatePosition(QObject *videoContainer, qreal x, qreal y, qreal width, qreal height)
 {
 #ifdef Q_OS_ANDROID
+    if (!m_usesSurface)
+        return;
+
+    // The followed container: merge into the check on the next frame
+    // Отслеживаемый контейнер: объединить с проверкой на следующем кадре
+    if (videoContainer && videoContainer == m_geometrySync.item()) {
+        m_geometrySync.requestUpdate();
+        return;
+    }
+
     // Convert DP coordinates to physical pixels using DPI scaling
     // Преобразовать DP координаты в физические пиксели с использованием DPI масштабирования
-    auto rect = toPx(videoContainer, QRectF(x, y, width, height));
-
-    // Call the native Java method to update the video surface position
-    // JNI signature: (x, y, width, height) -> void
-    // Вызвать нативный Java метод для обновления позиции видеоповерхности
-    // JNI сигнатура: (x, y, ширина, высота) -> void
-    QJniObject::callStaticMethod<void>(
-        "org/qtproject/example/vlc/VlcSurfaceHelper",
-        "updateSurfacePosition",
-        "(FFFF)V",
-        static_cast<jfloat>(rect.x()),
-        static_cast<jfloat>(rect.y()),
-        static_cast<jfloat>(rect.width()),
-        static_cast<jfloat>(rect.height())
-        );
+    sendSurfaceGeometry(toPx(videoContainer, QRectF(x, y, width, height)));
 #else
-    // Mark unused parameters to avoid compiler warnings on non-Android platforms
-    // Отметить неиспользуемые параметры, чтобы избежать предупреждений компилятора на платформах, отличных от Android
-    Q_UNUSED(x) Q_UNUSED(y) Q_UNUSED(width) Q_UNUSED(height)
+    Q_UNUSED(videoContainer) Q_UNUSED(x) Q_UNUSED(y) Q_UNUSED(width) Q_UNUSED(height)
 #endif
 }
 
-// Pause the currently playing video stream
-// Приостановить текущий воспроизводящийся видео поток
-void VLCBridge::pause()
+// Report the surface geometry sync counters for diagnostics
+// Сообщить счетчики синхронизации геометрии поверхности для диагностики
+QVariantMap VLCBridge::geometryStats() const
 {
-#ifdef Q_OS_ANDROID
-    // Call the native Java method to pause VLC playback
-    // JNI signature: () -> void (no parameters)
-    // Вызвать нативный Java метод для паузы воспроизведения VLC
-    // JNI сигнатура: () -> void (без параметров)
-    QJniObject::callStaticMethod<void>(
-        "org/qtproject/example/vlc/VlcSurfaceHelper",
-        "pause",
-        "()V");
+    const SurfaceGeometrySync::Stats stats = m_geometrySync.stats();
+    return {
+        { QStringLiteral("requested"), stats.requested },
+        { QStringLiteral("coalesced"), stats.coalesced },
+        { QStringLiteral("skipped"), stats.skipped },
+        { QStringLiteral("sent"), stats.sent },
+    };
+}
+
+QVariantMap VLCBridge::frameBufferStats() const
+{
+    const FrameBufferPool::Stats stats = FrameBufferPool::shared().stats();
+    return {
+        { QStringLiteral("allocations"), stats.allocations },
+        { QStringLiteral("reuses"), stats.reuses },
+        { QStringLiteral("evictions"), stats.evictions },
+        { QStringLiteral("buffersInUse"), stats.buffersInUse },
+        { QStringLiteral("buffersIdle"), stats.buffersIdle },
+        { QStringLiteral("bytesInUse"), stats.bytesInUse },
+        { QStringLiteral("bytesIdle"), stats.bytesIdle },
+        { QStringLiteral("highWaterBuffers"), stats.highWaterBuffers },
+        { QStringLiteral("highWaterBytes"), stats.highWaterBytes },
+    };
+}
 
-    // Update internal state to reflect that playback is paused
-    // Обновить внутреннее состояние, чтобы отразить, что воспроизведение приостановлено
-    m_isPaused = true;
-    m_isPlaying = false;
+QVariantMap VLCBridge::videoPathStats() const
+{
+    QStringList supported;
+    for (PixelKernels::Isa isa : PixelKernels::supportedIsas())
+        supported << QString::fromLatin1(PixelKernels::isaName(isa));
 
-    // Emit signals to notify QML layer of state changes
-    // Отправить сигналы для уведомления QML слоя об изменениях состояния
-    emit isPausedChanged(m_isPaused);
-    emit isPlayingChanged(m_isPlaying);
-    emit statusChanged("Paused");
-#else
-    emit error("Android only");
-#endif
+    QVariantMap stats {
+        { QStringLiteral("kernels"), QString::fromLatin1(PixelKernels::isaName(PixelKernels::kernels().isa)) },
+        { QStringLiteral("supportedKernels"), supported },
+    };
+    if (m_player) {
+        const VideoFrameSink *sink = m_player->videoSink();
+        stats.insert(QStringLiteral("chroma"), sink->chroma());
+        stats.insert(QStringLiteral("decodedSize"), sink->frameSize());
+        stats.insert(QStringLiteral("outputSize"), sink->outputSize());
+        stats.insert(QStringLiteral("targetSize"), sink->targetSize());
+    }
+    return stats;
 }
 
-// Stop the currently playing video stream and release resources
-// Остановить текущий воспроизводящийся видео поток и освободить ресурсы
-void VLCBridge::stop()
+bool VLCBridge::isRecording() const
+{
+    return m_recorder.isRecording();
+}
+
+// Start recording the active stream into rotating segments
+// Начать запись активного потока в сменяющиеся сегменты
+bool VLCBridge::startRecording(const QString &directory, int segmentSeconds, int maxSegments)
 {
 #ifdef Q_OS_ANDROID
-    // Call the native Java method to stop VLC playback
-    // JNI signature: () -> void (no parameters)
-    // Вызвать нативный Java метод для остановки воспроизведения VLC
-    // JNI сигнатура: () -> void (без параметров)
-    QJniObject::callStaticMethod<void>(
-        "org/qtproject/example/vlc/VlcSurfaceHelper",
-        "stop",
-        "()V");
+    if (m_usesSurface) {
+        emit error(QStringLiteral("Recording needs the native player"));
+        return false;
+    }
+#endif
+    if (m_recorder.isRecording())
+        return true;
+    if (!m_player || !hasActiveStream()) {
+        emit error(QStringLiteral("Nothing to record"));
+        return false;
+    }
 
-    // Update internal state to reflect that playback has stopped
-    // Обновить внутреннее состояние, чтобы отразить, что воспроизведение остановлено
-    m_isPlaying = false;
-    m_isPaused = false;
+    StreamRecorder::Config config;
+    config.directory = directory;
+    config.segmentSeconds = segmentSeconds;
+    config.maxSegments = maxSegments;
+    if (!m_recorder.start(config))
+        return false;
 
-    // Emit signals to notify QML layer of state changes
-    // Отправить сигналы для уведомления QML слоя об изменениях состояния
-    emit isPlayingChanged(m_isPlaying);
-    emit isPausedChanged(m_isPaused);
-    emit statusChanged("Stopped");
-#else
-    emit error("Android only");
+    m_player->setStreamOutputs(streamOutputsFor(m_player));
+    emit recordingChanged(true);
+    return true;
+}
+
+// Stop recording; the stream itself keeps playing
+// Остановить запись; сам поток продолжает воспроизводиться
+void VLCBridge::stopRecording()
+{
+    if (!m_recorder.isRecording())
+        return;
+
+    // libvlc must stop writing into the pipe before the recorder closes it
+    // libvlc должен прекратить запись в канал до того, как рекордер его закроет
+    detachStreamOutput(m_recorder.streamOutput());
+    m_recorder.stop();
+    emit recordingChanged(false);
+    applyPendingRetune();
+}
+
+QVariantMap VLCBridge::recordingStats() const
+{
+    const StreamRecorder::Stats stats = m_recorder.stats();
+    return {
+        { QStringLiteral("bytesWritten"), stats.bytesWritten },
+        { QStringLiteral("bytesDropped"), stats.bytesDropped },
+        { QStringLiteral("segments"), stats.segments },
+        { QStringLiteral("deletedSegments"), stats.deletedSegments },
+        { QStringLiteral("backlogBytes"), stats.backlogBytes },
+        { QStringLiteral("backlogHighWater"), stats.backlogHighWater },
+        { QStringLiteral("backpressure"), stats.backpressure },
+        { QStringLiteral("currentSegment"), stats.currentSegment },
+    };
+}
+
+int VLCBridge::replayWindowSeconds() const
+{
+    return m_replayWindowSeconds;
+}
+
+// Enable, resize or disable the replay window; enabling restarts a playing stream once
+// Включить, изменить или отключить окно повтора; включение один раз перезапускает играющий поток
+void VLCBridge::setReplayWindowSeconds(int seconds)
+{
+    seconds = qMax(0, seconds);
+    if (seconds == m_replayWindowSeconds)
+        return;
+
+    const bool wasEnabled = m_replayWindowSeconds > 0;
+    m_replayWindowSeconds = seconds;
+    emit replayWindowSecondsChanged(m_replayWindowSeconds);
+
+    if (seconds == 0) {
+        returnToLive();
+        stopReplayBuffers();
+        m_replayTimer.stop();
+        emit replayPositionChanged();
+        return;
+    }
+    if (wasEnabled) {
+        m_replay->setWindowSeconds(seconds);
+        m_standbyReplay->setWindowSeconds(seconds);
+        return;
+    }
+
+    m_replayTimer.start();
+#ifdef Q_OS_ANDROID
+    if (m_usesSurface)
+        return;
 #endif
+    // The buffers start with the stream they belong to; a stream already running is restarted once
+    // Буферы запускаются вместе со своим потоком; уже идущий поток перезапускается один раз
+    if (m_player && hasActiveStream() && ensureReplayBuffer(m_replay))
+        m_player->setStreamOutputs(streamOutputsFor(m_player));
+    if (m_standby && !m_standbyUrl.isEmpty() && ensureReplayBuffer(m_standbyReplay))
+        m_standby->setStreamOutputs(streamOutputsFor(m_standby));
+}
+
+bool VLCBridge::isReplaying() const
+{
+    return m_isReplaying;
 }
+
+// Live clock minus the position of the replay: the key frame it started at plus what it has played since
+// Живые часы минус позиция повтора: ключевой кадр, с которого он начат, плюс то, что он проиграл с тех пор
+qint64 VLCBridge::replayOffsetMs() const
+{
+    if (!m_isReplaying)
+        return 0;
+    const qint64 played = qMax<qint64>(0, m_replayPlayer->mediaTimeMs());
+    return qMax<qint64>(0, m_replay->nowMs() - (m_replayAnchorMs + played));
+}
+
+qint64 VLCBridge::replayAvailableMs() const
+{
+    return m_replay->isActive() ? m_replay->stats().availableMs : 0;
+}
+
+// Replay or scrub: reopen the replay player at the key frame secondsBack behind live
+// Повтор или перемотка: переоткрыть плеер повтора на ключевом кадре secondsBack назад от живого
+bool VLCBridge::replay(qreal secondsBack)
+{
+#ifdef Q_OS_ANDROID
+    if (m_usesSurface) {
+        emit error(QStringLiteral("Replay needs the native player"));
+        return false;
+    }
+#endif
+    if (!m_player || !hasActiveStream() || !m_replay->isActive()) {
+        emit error(QStringLiteral("Nothing to replay"));
+        return false;
+    }
+
+    const qint64 anchorMs = m_replay->prepareReader(qRound64(secondsBack * 1000));
+    if (anchorMs < 0) {
+        emit error(QStringLiteral("No key frame buffered yet"));
+        return false;
+    }
+
+    if (!m_replayPlayer) {
+        m_replayPlayer = new VlcPlayer(this);
+        connect(m_replayPlayer, &VlcPlayer::error, this, &VLCBridge::error);
+
+        // The item changes over on the first replayed frame, so a scrub never shows black
+        // Элемент переключается на первом кадре повтора, поэтому перемотка никогда не показывает черное
+        connect(m_replayPlayer, &VlcPlayer::firstFrame, this, [this]() {
+            if (m_isReplaying && m_videoItem)
+                m_videoItem->setPlayer(m_replayPlayer);
+        });
+        connect(m_replayPlayer, &VlcPlayer::stateChanged, this, [this](VlcPlayer::State state) {
+            if (m_isReplaying && state == VlcPlayer::Error)
+                returnToLive();
+        });
+        updateVisibility();
+    }
+
+    // A reader blocked at the live edge would hold up stop(); release it first
+    // Читатель, заблокированный у живого края, задержал бы stop(); сначала освободить его
+    m_replay->interruptReaders();
+    m_replayPlayer->stop();
+    if (!m_replayPlayer->openCallbacks(QStringLiteral("replay:") + m_player->url(), m_replay->mediaCallbacks(),
+                                       { QStringLiteral(":demux=ts") })) {
+        returnToLive();
+        return false;
+    }
+    m_replayAnchorMs = anchorMs;
+
+    if (!m_isReplaying) {
+        m_isReplaying = true;
+        m_player->setMuted(true);
+        emit replayingChanged(true);
+    }
+    emit replayPositionChanged();
+    return true;
+}
+
+// Back to the live player, which has kept its session and its picture up to date all along
+// Назад к живому плееру, который все это время сохранял свою сессию и актуальную картинку
+void VLCBridge::returnToLive()
+{
+    if (!m_isReplaying)
+        return;
+
+    m_isReplaying = false;
+    m_replay->interruptReaders();
+    m_replayPlayer->stop();
+    if (m_videoItem)
+        m_videoItem->setPlayer(m_player);
+    if (m_player)
+        m_player->setMuted(false);
+    emit replayingChanged(false);
+    emit replayPositionChanged();
+    applyPendingRetune();
+}
+
+QVariantMap VLCBridge::replayStats() const
+{
+    const ReplayBuffer::Stats stats = m_replay->stats();
+    return {
+        { QStringLiteral("bytesReceived"), stats.bytesReceived },
+        { QStringLiteral("bytesBuffered"), stats.bytesBuffered },
+        { QStringLiteral("bytesSkipped"), stats.bytesSkipped },
+        { QStringLiteral("keyFrames"), stats.keyFrames },
+        { QStringLiteral("availableMs"), stats.availableMs },
+        { QStringLiteral("readers"), stats.readers },
+        { QStringLiteral("readerResyncs"), stats.readerResyncs },
+    };
+}
+
+// Take the thumbnail from a player already connected to url if there is one, otherwise probe the stream
+// Взять миниатюру из плеера, уже подключенного к url, если такой есть, иначе зондировать поток
+void VLCBridge::requestSnapshot(const QString &url)
+{
+    if (url.isEmpty())
+        return;
+
+    // A player still opening url counts too: the camera should not see a second session
+    // Плеер, еще открывающий url, тоже учитывается: камера не должна видеть второй сеанс
+    VideoFrameSink *liveSink = nullptr;
+    for (VlcPlayer *player : { m_player, m_standby }) {
+        if (!player || player->url() != url)
+            continue;
+        const VlcPlayer::State state = player->state();
+        if (player->hasFrame() || state == VlcPlayer::Opening || state == VlcPlayer::Buffering) {
+            liveSink = player->videoSink();
+            break;
+        }
+    }
+    m_snapshots.request(url, liveSink);
+}
+
+QVariantMap VLCBridge::snapshotStats() const
+{
+    const SnapshotService::Stats stats = m_snapshots.stats();
+    return {
+        { QStringLiteral("requests"), stats.requests },
+        { QStringLiteral("cacheHits"), stats.cacheHits },
+        { QStringLiteral("merged"), stats.merged },
+        { QStringLiteral("liveGrabs"), stats.liveGrabs },
+        { QStringLiteral("probes"), stats.probes },
+        { QStringLiteral("failures"), stats.failures },
+        { QStringLiteral("encoded"), stats.encoded },
+    };
+}
+
+// Outputs of player: the recorder follows the active stream, each ring follows its own player
+// Выводы плеера: рекордер следует за активным потоком, каждое кольцо - за своим плеером
+QStringList VLCBridge::streamOutputsFor(VlcPlayer *player) const
+{
+    QStringList outputs;
+    if (player == m_player && m_recorder.isRecording())
+        outputs << m_recorder.streamOutput();
+    ReplayBuffer *buffer = player == m_player ? m_replay : player == m_standby ? m_standbyReplay : nullptr;
+    if (buffer && buffer->isActive())
+        outputs << buffer->streamOutput();
+    return outputs;
+}
+
+void VLCBridge::detachStreamOutput(const QString &chain)
+{
+    for (VlcPlayer *player : { m_player, m_standby }) {
+        if (!player)
+            continue;
+        QStringList outputs = player->streamOutputs();
+        if (outputs.removeAll(chain) > 0)
+            player->setStreamOutputs(outputs);
+    }
+}
+
+bool VLCBridge::ensureReplayBuffer(ReplayBuffer *buffer)
+{
+    if (m_replayWindowSeconds <= 0)
+        return false;
+    if (buffer->isActive())
+        return true;
+
+    ReplayBuffer::Config config;
+    config.windowSeconds = m_replayWindowSeconds;
+    return buffer->start(config);
+}
+
+void VLCBridge::stopReplayBuffers()
+{
+    for (ReplayBuffer *buffer : { m_replay, m_standbyReplay }) {
+        if (!buffer->isActive())
+            continue;
+        detachStreamOutput(buffer->streamOutput());
+        buffer->stop();
+    }
+}
+
+// Register an analytics consumer of the active stream's decoded frames
+// Зарегистрировать потребителя аналитики декодированных кадров активного потока
+int VLCBridge::addFrameConsumer(FrameConsumer *consumer, const FrameTap::Request &request)
+{
+    return m_frameTap->subscribe(consumer, request);
+}
+
+void VLCBridge::removeFrameConsumer(int id)
+{
+    m_frameTap->unsubscribe(id);
+}
+
+FrameTap::Stats VLCBridge::frameConsumerStats(int id) const
+{
+    return m_frameTap->stats(id);
+}
+
+// Pause the currently playing video stream
+// Приостановить текущий воспроизводящийся видео поток
+void VLCBridge::pause()
+{
+#ifdef Q_OS_ANDROID
+    if (m_usesSurface) {
+        // Call the native Java method to pause VLC playback
+        // JNI signature: () -> void (no parameters)
+        // Вызвать нативный Java метод для паузы воспроизведения VLC
+        // JNI сигнатура: () -> void (без параметров)
+        QJniObject::callStaticMethod<void>(
+            "org/qtproject/example/vlc/VlcSurfaceHelper",
+            "pause",
+            "()V");
+        return;
+    }
+#endif
+
+    // Same semantics as VlcSurfaceHelper.pause(): only a playing stream can be paused
+    // isPaused follows once libvlc confirms with its Paused event
+    // Та же семантика, что и у VlcSurfaceHelper.pause(): приостановить можно только воспроизводимый поток
+    // isPaused меняется, когда libvlc подтвердит это событием Paused
+    if (!m_player || !m_isPlaying)
+        return;
+
+    // During a replay the replayed picture freezes; the live session and the ring keep going
+    // Во время повтора замирает повторяемая картинка; живая сессия и кольцо продолжают работать
+    if (m_isReplaying) {
+        m_replayPlayer->setPaused(true);
+        return;
+    }
+    m_player->setPaused(true);
+}
+
+// Continue the paused stream; settings changed meanwhile are applied once it plays again
+// Продолжить приостановленный поток; измененные за это время настройки применяются, когда он снова заиграет
+void VLCBridge::resume()
+{
+#ifdef Q_OS_ANDROID
+    if (m_usesSurface) {
+        // Call the native Java method to resume VLC playback
+        // JNI signature: () -> void (no parameters)
+        // Вызвать нативный Java метод для возобновления воспроизведения VLC
+        // JNI сигнатура: () -> void (без параметров)
+        QJniObject::callStaticMethod<void>(
+            "org/qtproject/example/vlc/VlcSurfaceHelper",
+            "resume",
+            "()V");
+        return;
+    }
+#endif
+
+    // A paused replay resumes in the replay; the live player was never paused
+    // Приостановленный повтор продолжается в повторе; живой плеер на паузу не ставился
+    if (m_isReplaying) {
+        if (m_replayPlayer->state() == VlcPlayer::Paused)
+            m_replayPlayer->setPaused(false);
+        return;
+    }
+    if (m_player && m_isPaused)
+        m_player->setPaused(false);
+}
+
+// Stop the currently playing video stream and release resources
+// Остановить текущий воспроизводящийся видео поток и освободить ресурсы
+void VLCBridge::stop()
+{
+#ifdef Q_OS_ANDROID
+    if (m_usesSurface) {
+        // Call the native Java method to stop VLC playback
+        // JNI signature: () -> void (no parameters)
+        // Вызвать нативный Java метод для остановки воспроизведения VLC
+        // JNI сигнатура: () -> void (без параметров)
+        QJniObject::callStaticMethod<void>(
+            "org/qtproject/example/vlc/VlcSurfaceHelper",
+            "stop",
+            "()V");
+
+        // The warm TextureView stays in charge until the next play(); its Stopped event updates the state
+        // Прогретый TextureView остается главным до следующего play(); его событие Stopped обновит состояние
+        return;
+    }
+#endif
+
+    // Stop decoding; the players and their frame buffers are kept for the next play()
+    // Остановить декодирование; плееры и их буферы кадров сохраняются для следующего play()
+    m_retunePending = false;
+    returnToLive();
+    cancelSwitch();
+    if (m_player)
+        m_player->stop();
+    stopRecording();
+    stopReplayBuffers();
+}
+
+// Pre-open url in the standby player; it decodes muted and invisible until switchTo(url)
+// Parameters: urlOrCamera - stream URL or camera that will be shown next
+// Заранее открыть url в резервном плеере; он декодирует без звука и невидимо до switchTo(url)
+// Параметры: urlOrCamera - URL потока или камера, которая будет показана следующей
+void VLCBridge::preload(const QString &urlOrCamera)
+{
+    const QString url = variantFor(urlOrCamera, tilePixelSize());
+    if (url.isEmpty() || url == m_standbyUrl)
+        return;
+    if (m_player && hasActiveStream() && url == m_player->url())
+        return;
+
+    // The standby is busy with the pending switch; preload once it has completed
+    // Резервный плеер занят ожидающим переключением; предзагрузить, когда оно завершится
+    if (!m_pendingSwitchUrl.isEmpty()) {
+        m_queuedPreload = urlOrCamera;
+        return;
+    }
+
+    openStandby(url);
+}
+
+// Warm the engine and the host lookups of urlsOrCameras; every variant of a camera is warmed
+// Parameters: urlsOrCameras - stream URLs or camera names likely to be played soon
+// Прогреть движок и разрешение хостов urlsOrCameras; у камеры прогреваются все варианты
+// Параметры: urlsOrCameras - URL потоков или имена камер, которые скоро, вероятно, будут воспроизводиться
+void VLCBridge::prewarm(const QStringList &urlsOrCameras)
+{
+    VlcEngine::prewarm();
+
+    for (const QString &urlOrCamera : urlsOrCameras) {
+        const QString camera = cameraFor(urlOrCamera);
+        const QStringList urls = camera.isEmpty() ? QStringList { urlOrCamera } : m_cameras.value(camera).urls();
+        for (const QString &url : urls)
+            SessionCache::shared().resolve(url);
+    }
+}
+
+QVariantMap VLCBridge::startupStats() const
+{
+    const SessionCache::Stats cache = SessionCache::shared().stats();
+    return {
+        { QStringLiteral("engineReady"), VlcEngine::isReady() },
+        { QStringLiteral("engineInitMs"), VlcEngine::initMs() },
+        { QStringLiteral("prewarmed"), VlcEngine::wasPrewarmed() },
+        { QStringLiteral("coldStarts"), cache.coldStarts },
+        { QStringLiteral("lastColdMs"), cache.lastColdMs },
+        { QStringLiteral("meanColdMs"), cache.meanColdMs },
+        { QStringLiteral("warmStarts"), cache.warmStarts },
+        { QStringLiteral("lastWarmMs"), cache.lastWarmMs },
+        { QStringLiteral("meanWarmMs"), cache.meanWarmMs },
+        { QStringLiteral("cacheEntries"), cache.entries },
+        { QStringLiteral("cacheHits"), cache.hits },
+        { QStringLiteral("cacheMisses"), cache.misses },
+        { QStringLiteral("cacheInvalidations"), cache.invalidations },
+        { QStringLiteral("hostLookups"), cache.lookups },
+    };
+}
+
+QVariantMap VLCBridge::playerQueueStats() const
+{
+    const PlayerWorker::Stats queue = PlayerWorker::shared().stats();
+    return {
+        { QStringLiteral("depth"), queue.depth },
+        { QStringLiteral("highWaterDepth"), queue.highWaterDepth },
+        { QStringLiteral("posted"), queue.posted },
+        { QStringLiteral("applied"), queue.applied },
+        { QStringLiteral("coalesced"), queue.coalesced },
+        { QStringLiteral("restartsSkipped"), queue.restartsSkipped },
+        { QStringLiteral("lastLatencyMs"), queue.lastLatencyMs },
+        { QStringLiteral("meanLatencyMs"), queue.meanLatencyMs },
+        { QStringLiteral("maxLatencyMs"), queue.maxLatencyMs },
+        { QStringLiteral("meanApplyMs"), queue.meanApplyMs },
+        { QStringLiteral("maxApplyMs"), queue.maxApplyMs },
+    };
+}
+
+// Switch the active video container to another camera
+// The engine, the video item and the texture are reused; only the RTSP session is new
+// Parameters: urlOrCamera - stream URL or camera to switch to
+// Переключить активный контейнер видео на другую камеру
+// Движок, элемент видео и текстура переиспользуются; новой является только RTSP сессия
+// Параметры: urlOrCamera - URL потока или камера, на которую нужно переключиться
+void VLCBridge::switchTo(const QString &urlOrCamera)
+{
+    if (urlOrCamera.isEmpty())
+        return;
+    const QString url = variantFor(urlOrCamera, tilePixelSize());
+
+#ifdef Q_OS_ANDROID
+    if (m_usesSurface) {
+        // The Java helper reuses its warm LibVLC, MediaPlayer and TextureView
+        // Java помощник переиспользует прогретые LibVLC, MediaPlayer и TextureView
+        QJniObject jUrl = QJniObject::fromString(url);
+        QJniObject::callStaticMethod<void>(
+            "org/qtproject/example/vlc/VlcSurfaceHelper",
+            "switchTo",
+            "(Ljava/lang/String;)V",
+            jUrl.object<jstring>());
+        return;
+    }
+#endif
+
+    // Nothing is running yet: this is a regular start in the last used container
+    // Ничего еще не запущено: это обычный запуск в последнем использованном контейнере
+    if (!m_player || !hasActiveStream()) {
+        play(urlOrCamera, m_videoItem.data(), 0, 0, 0, 0);
+        return;
+    }
+    // Picking the camera on screen again continues it if it was paused
+    // Повторный выбор камеры на экране продолжает ее, если она была приостановлена
+    if (url == m_player->url() && m_pendingSwitchUrl.isEmpty()) {
+        resume();
+        return;
+    }
+
+    // Coming back to the current camera while another one is still opening: just cancel
+    // Возврат к текущей камере, пока другая еще открывается: просто отменить
+    if (url == m_player->url()) {
+        cancelSwitch();
+        return;
+    }
+
+    emit statusChanged("Switching");
+    beginSwitch(url);
+}
+
+// Pin or release the decoder policy of one stream
+// Parameters: url - stream URL, policy - VlcPlayer::DecodePolicy value or -1 for the global policy
+// Закрепить или снять политику декодера одного потока
+// Параметры: url - URL потока, policy - значение VlcPlayer::DecodePolicy или -1 для общей политики
+void VLCBridge::setStreamDecodePolicy(const QString &url, int policy)
+{
+    if (policy < VlcPlayer::DecodeAuto || policy > VlcPlayer::DecodeSoftwareCapped)
+        m_streamDecodePolicies.remove(url);
+    else
+        m_streamDecodePolicies.insert(url, static_cast<VlcPlayer::DecodePolicy>(policy));
+
+    if (m_player && m_player->url() == url && m_player->decodePolicy() != decodePolicyFor(url))
+        retune();
+}
+
+// Pin or release the RTP transport of one stream
+// Parameters: url - stream URL, transport - VlcPlayer::Transport value or -1 for the global transport
+// Закрепить или снять транспорт RTP одного потока
+// Параметры: url - URL потока, transport - значение VlcPlayer::Transport или -1 для общего транспорта
+void VLCBridge::setStreamTransport(const QString &url, int transport)
+{
+    if (transport < VlcPlayer::TransportAuto || transport > VlcPlayer::TransportMulticast)
+        m_streamTransports.remove(url);
+    else
+        m_streamTransports.insert(url, static_cast<VlcPlayer::Transport>(transport));
+
+    if (m_player && m_player->url() == url && m_player->transport() != transportFor(url))
+        retune();
+}
+
+QVariantMap VLCBridge::transportStats() const
+{
+    const QString url = m_player ? m_player->url() : QString();
+    const char *requested = QMetaEnum::fromType<VlcPlayer::Transport>().valueToKey(transportFor(url));
+    return {
+        { QStringLiteral("requested"), QString::fromLatin1(requested) },
+        { QStringLiteral("transport"), transportPath() },
+        { QStringLiteral("fallbacks"), m_metrics.transportFallbacks },
+        { QStringLiteral("lossEvents"), m_metrics.corruptedBlocks },
+        { QStringLiteral("discontinuities"), m_metrics.discontinuities },
+    };
+}
+
+VlcPlayer::Visibility VLCBridge::backgroundMode() const
+{
+    return m_backgroundMode;
+}
+
+void VLCBridge::setBackgroundMode(VlcPlayer::Visibility mode)
+{
+    if (mode == m_backgroundMode)
+        return;
+    m_backgroundMode = mode;
+    emit backgroundModeChanged(mode);
+    updateVisibility();
+}
+
+VlcPlayer::Visibility VLCBridge::hiddenMode() const
+{
+    return m_hiddenMode;
+}
+
+void VLCBridge::setHiddenMode(VlcPlayer::Visibility mode)
+{
+    if (mode == m_hiddenMode)
+        return;
+    m_hiddenMode = mode;
+    emit hiddenModeChanged(mode);
+    updateVisibility();
+}
+
+bool VLCBridge::videoVisible() const
+{
+    return m_videoVisible;
+}
+
+void VLCBridge::setVideoVisible(bool visible)
+{
+    if (visible == m_videoVisible)
+        return;
+    m_videoVisible = visible;
+    emit videoVisibleChanged(visible);
+    updateVisibility();
+}
+
+VlcPlayer::Visibility VLCBridge::currentVisibility() const
+{
+    // Inactive only means another window has the focus; the picture is still on screen
+    // Inactive означает лишь, что фокус у другого окна; картинка по-прежнему на экране
+    const Qt::ApplicationState appState = qGuiApp ? qGuiApp->applicationState() : Qt::ApplicationActive;
+    if (appState == Qt::ApplicationHidden || appState == Qt::ApplicationSuspended)
+        return m_backgroundMode;
+    if (!m_videoVisible || (m_videoItem && !m_videoItem->isVisible()))
+        return m_hiddenMode;
+    return VlcPlayer::Visible;
+}
+
+// Shed or restore the work of whatever is on screen; the standby player keeps decoding so a
+// switch stays instant
+// Сбросить или восстановить работу того, что на экране; резервный плеер продолжает декодировать,
+// чтобы переключение оставалось мгновенным
+void VLCBridge::updateVisibility()
+{
+    const VlcPlayer::Visibility visibility = currentVisibility();
+
+#ifdef Q_OS_ANDROID
+    if (m_usesSurface) {
+        QJniObject::callStaticMethod<void>(
+            "org/qtproject/example/vlc/VlcSurfaceHelper",
+            "setVisibility",
+            "(I)V",
+            jint(visibility));
+        return;
+    }
+#endif
+
+    if (m_player)
+        m_player->setVisibility(visibility);
+
+    // The replay player reads from memory: skipping its rendering is all there is to save
+    // Плеер повтора читает из памяти: пропуск его отрисовки - все, что можно сэкономить
+    if (m_replayPlayer)
+        m_replayPlayer->setVisibility(visibility == VlcPlayer::Visible ? VlcPlayer::Visible : VlcPlayer::HiddenNoRender);
+}
+
+// Register, replace or forget the stream variants of a camera
+// Parameters: camera - logical camera name, variants - list of { url, width, height } maps
+// Зарегистрировать, заменить или забыть варианты потоков камеры
+// Параметры: camera - имя логической камеры, variants - список карт { url, width, height }
+void VLCBridge::setCameraVariants(const QString &camera, const QVariantList &variants)
+{
+    if (camera.isEmpty())
+        return;
+
+    const StreamVariants parsed = StreamVariants::fromVariantList(variants);
+    if (parsed.isEmpty())
+        m_cameras.remove(camera);
+    else
+        m_cameras.insert(camera, parsed);
+
+    // The camera on screen may now have a better fitting stream
+    // У камеры на экране теперь может быть лучше подходящий поток
+    if (m_player && m_cameras.value(camera).contains(m_player->url()))
+        m_variantTimer.start();
+}
+
+QString VLCBridge::cameraFor(const QString &urlOrCamera) const
+{
+    if (m_cameras.contains(urlOrCamera))
+        return urlOrCamera;
+    for (auto it = m_cameras.cbegin(); it != m_cameras.cend(); ++it) {
+        if (it->contains(urlOrCamera))
+            return it.key();
+    }
+    return QString();
+}
+
+QString VLCBridge::variantFor(const QString &urlOrCamera, const QSize &sizePx) const
+{
+    const QString camera = cameraFor(urlOrCamera);
+    if (camera.isEmpty())
+        return urlOrCamera;
+
+    // An explicit variant URL is where the choice starts, so it is kept unless it clearly does not fit
+    // Явно указанный URL варианта - отправная точка выбора, он сохраняется, если явно не подходит
+    return m_cameras.value(camera).select(sizePx, camera == urlOrCamera ? QString() : urlOrCamera);
+}
+
+QSize VLCBridge::tilePixelSize() const
+{
+    if (!m_videoItem)
+        return QSize();
+    return toPx(m_videoItem.data(), QRectF(0, 0, m_videoItem->width(), m_videoItem->height())).size().toSize();
+}
+
+// Follow the tile size with the stream variant, through the same gapless swap as switchTo()
+// Следовать за размером плитки вариантом потока через ту же бесшовную замену, что и switchTo()
+void VLCBridge::reselectVariant()
+{
+    if (!m_player || !hasActiveStream() || !m_pendingSwitchUrl.isEmpty())
+        return;
+
+    // A recording or a replay belongs to the encoding it started on; the swap would end it
+    // Запись или повтор принадлежат кодировке, на которой начались; замена завершила бы их
+    if (m_recorder.isRecording() || m_isReplaying)
+        return;
+
+    const QString current = m_player->url();
+    const QString camera = cameraFor(current);
+    if (camera.isEmpty())
+        return;
+
+    const QString url = m_cameras.value(camera).select(tilePixelSize(), current);
+    if (url == current)
+        return;
+
+    qDebug() << "VLCBridge:" << camera << "tile is" << tilePixelSize() << "- switching to" << url;
+    beginSwitch(url);
+}
+
+// Open url in the standby player with the current latency options and swap on its first frame
+// Also used to retune the active camera: url may equal the URL that is playing right now
+// Parameters: url - stream URL to switch to
+// Открыть url в резервном плеере с текущими параметрами задержки и переключиться на его первом кадре
+// Также используется для перенастройки активной камеры: url может совпадать с текущим
+// Параметры: url - URL потока, на который нужно переключиться
+void VLCBridge::beginSwitch(const QString &url)
+{
+    // The standby opens with the current settings, so nothing is left to retune
+    // Резервный плеер открывается с текущими настройками, поэтому перенастраивать нечего
+    m_retunePending = false;
+    m_pendingSwitchUrl = url;
+    m_switchTimer.start();
+
+    if (m_standbyUrl != url)
+        openStandby(url);
+    if (m_standbyUrl != url) {
+        cancelSwitch();
+        return;
+    }
+
+    // Already preloaded and decoding: swap right away, otherwise wait for its first frame
+    // Уже предзагружен и декодирует: переключиться сразу, иначе ждать его первого кадра
+    if (m_standby->hasFrame())
+        finishSwitch();
+    else
+        m_switchTimeout.start();
+}
+
+// Open url muted in the standby player, creating the player on first use
+// Parameters: url - stream URL to pre-open
+// Открыть url без звука в резервном плеере, создав плеер при первом использовании
+// Параметры: url - URL потока для предварительного открытия
+void VLCBridge::openStandby(const QString &url)
+{
+    if (!m_standby)
+        m_standby = createPlayer();
+
+    applyDecodePolicy(m_standby, url);
+    m_standby->setTransport(transportFor(url));
+
+    // The standby fills a ring of its own, so a replay is available right after the switch
+    // Резервный плеер заполняет собственное кольцо, поэтому повтор доступен сразу после переключения
+    m_standbyReplay->clear();
+    ensureReplayBuffer(m_standbyReplay);
+    m_standby->stop();
+    m_standby->setStreamOutputs(streamOutputsFor(m_standby));
+
+    // Converted at tile size from the first frame, before the item takes the standby over
+    // Преобразуется в размере плитки с первого кадра, еще до того, как элемент примет резервный плеер
+    m_standby->videoSink()->setTargetSize(tilePixelSize());
+    if (!m_standby->open(url, streamOptions(url))) {
+        m_standbyUrl.clear();
+        return;
+    }
+
+    m_standby->setCachingMs(cachingFor(url));
+    m_standby->setMuted(true);
+    m_standbyUrl = url;
+}
+
+// Caching for a stream: fixed by the profile, or learned per URL in automatic mode
+// Parameters: url - stream URL
+// Кэширование для потока: фиксировано профилем или подбирается для каждого URL в автоматическом режиме
+// Параметры: url - URL потока
+int VLCBridge::cachingFor(const QString &url) const
+{
+    switch (m_latencyProfile) {
+    case LatencyUltraLow:
+        return 50;
+    case LatencyBalanced:
+        return 150;
+    case LatencySmooth:
+        return 600;
+    case LatencyAuto:
+        break;
+    }
+    return m_latencyControllers.value(url).cachingMs();
+}
+
+// Late-frame policy for a stream: small buffers drop late frames instead of showing them late
+// Parameters: url - stream URL
+// Политика опоздавших кадров: малые буферы отбрасывают опоздавшие кадры, а не показывают их с опозданием
+// Параметры: url - URL потока
+bool VLCBridge::dropLateFramesFor(const QString &url) const
+{
+    if (m_latencyProfile == LatencyAuto)
+        return m_latencyControllers.value(url).dropLateFrames();
+    return m_latencyProfile == LatencyUltraLow;
+}
+
+// Per-media libvlc options implementing the latency settings of a stream
+// They override the engine defaults without recreating the libvlc instance
+// Parameters: url - stream URL
+// Параметры libvlc для медиа, реализующие настройки задержки потока
+// Они переопределяют значения движка по умолчанию без пересоздания экземпляра libvlc
+// Параметры: url - URL потока
+QStringList VLCBridge::streamOptions(const QString &url) const
+{
+    const QString caching = QString::number(cachingFor(url));
+    return {
+        QStringLiteral(":network-caching=") + caching,
+        QStringLiteral(":live-caching=") + caching,
+        dropLateFramesFor(url) ? QStringLiteral(":drop-late-frames") : QStringLiteral(":no-drop-late-frames"),
+    };
+}
+
+// Decoder policy of a stream: its override if one was set, otherwise the global policy
+// Parameters: url - stream URL
+// Политика декодера потока: индивидуальная, если задана, иначе общая
+// Параметры: url - URL потока
+VlcPlayer::DecodePolicy VLCBridge::decodePolicyFor(const QString &url) const
+{
+    return m_streamDecodePolicies.value(url, m_decodePolicy);
+}
+
+// RTP transport of a stream: its override if one was set, otherwise the global transport
+// Parameters: url - stream URL
+// Транспорт RTP потока: индивидуальный, если задан, иначе общий
+// Параметры: url - URL потока
+VlcPlayer::Transport VLCBridge::transportFor(const QString &url) const
+{
+    return m_streamTransports.value(url, m_transport);
+}
+
+// Configure the decoder of player for url before it is opened
+// Parameters: player - player about to open url, url - stream URL
+// Настроить декодер плеера для url перед его открытием
+// Параметры: player - плеер, который откроет url, url - URL потока
+void VLCBridge::applyDecodePolicy(VlcPlayer *player, const QString &url) const
+{
+    player->setDecodePolicy(decodePolicyFor(url), m_decodeThreads);
+}
+
+// Reopen the stream on screen with the current settings without tearing down the engine
+// Переоткрыть поток на экране с текущими настройками без уничтожения движка
+void VLCBridge::retune()
+{
+    // Without a stream the next open picks the settings up anyway
+    // Без потока следующее открытие и так подхватит настройки
+    if (!m_player || !hasActiveStream())
+        return;
+
+    // The swap would end a recording or a replay, and a paused or still opening stream is not
+    // swapped; the new settings wait until the stream plays on its own again
+    // Замена завершила бы запись или повтор, а приостановленный или еще открывающийся поток не
+    // заменяется; новые настройки ждут, пока поток снова просто не заиграет
+    if (!m_isPlaying || !m_pendingSwitchUrl.isEmpty() || m_recorder.isRecording() || m_isReplaying) {
+        m_retunePending = true;
+        return;
+    }
+
+    beginSwitch(m_player->url());
+}
+
+// Run a retune held back by a pause, a switch, a recording or a replay once none is left
+// Выполнить перенастройку, отложенную паузой, переключением, записью или повтором, когда их не осталось
+void VLCBridge::applyPendingRetune()
+{
+    if (!m_retunePending)
+        return;
+
+    // Queued: the caller may be in the middle of a switch or a stop
+    // Через очередь: вызывающий может находиться посреди переключения или остановки
+    QMetaObject::invokeMethod(this, [this]() {
+        if (m_retunePending)
+            retune();
+    }, Qt::QueuedConnection);
+}
+
+// Automatic mode: let the controller of the active stream react to the latest metrics
+// A retune reopens the same URL in the standby player and swaps on its first frame,
+// so the engine, the video item and the picture on screen all stay in place
+// Автоматический режим: дать контроллеру активного потока отреагировать на свежие метрики
+// Перенастройка переоткрывает тот же URL в резервном плеере и переключается на его первом кадре,
+// поэтому движок, элемент видео и картинка на экране остаются на месте
+void VLCBridge::adaptLatency()
+{
+    if (m_latencyProfile != LatencyAuto || !m_player || !m_isPlaying || !m_pendingSwitchUrl.isEmpty())
+        return;
+
+    const QString url = m_player->url();
+    LatencyController &controller = m_latencyControllers[url];
+    if (!controller.update(m_metrics))
+        return;
+
+    qDebug() << "VLCBridge: retuning" << url << "to" << controller.cachingMs() << "ms caching,"
+             << (controller.dropLateFrames() ? "dropping" : "keeping") << "late frames";
+
+    // The controller keeps its advice; the swap waits for the recording or the replay to end
+    // Контроллер сохраняет свой совет; замена ждет окончания записи или повтора
+    if (m_recorder.isRecording() || m_isReplaying) {
+        m_retunePending = true;
+        return;
+    }
+    beginSwitch(url);
+}
+
+// Create a native player and route its signals to the bridge
+// Создать нативный плеер и направить его сигналы в мост
+VlcPlayer *VLCBridge::createPlayer()
+{
+    auto *player = new VlcPlayer(this);
+    connect(player, &VlcPlayer::error, this, &VLCBridge::error);
+    connect(player, &VlcPlayer::stateChanged, this, [this, player](VlcPlayer::State state) {
+        onPlayerState(player, state);
+    });
+
+    // The supervisor keeps the engine, the player and the video item while it reconnects
+    // Супервизор сохраняет движок, плеер и элемент видео на время переподключения
+    connect(player, &VlcPlayer::reconnectScheduled, this, [this, player](int attempt, int delayMs) {
+        if (player == m_player)
+            emit statusChanged(QStringLiteral("Reconnecting in %1 s (attempt %2)")
+                                   .arg(QString::number(delayMs / 1000.0, 'f', 1)).arg(attempt));
+    });
+    connect(player, &VlcPlayer::decoderPathChanged, this, [this, player](const QString &path) {
+        if (player == m_player)
+            emit decoderPathChanged(path);
+    });
+    connect(player, &VlcPlayer::transportPathChanged, this, [this, player](const QString &path) {
+        if (player == m_player)
+            emit transportPathChanged(path);
+    });
+    connect(player, &VlcPlayer::reconnected, this, [this, player](qint64 outageMs) {
+        if (player != m_player)
+            return;
+        qDebug() << "VLCBridge: stream recovered after" << outageMs << "ms";
+        applyState(player->state());
+    });
+    connect(player, &VlcPlayer::firstFrame, this, [this, player](qint64 elapsedMs) {
+        onFirstFrame(player, elapsedMs);
+    });
+
+    // Only the player on screen feeds the bridge metrics; a preloading standby stays silent
+    // Метрики моста питает только плеер на экране; предзагружаемый резервный молчит
+    connect(player, &VlcPlayer::metricsUpdated, this, [this, player]() {
+        if (player != m_player)
+            return;
+        m_metrics = player->metrics();
+        emit metricsChanged();
+        emit metricsUpdated(m_metrics.toVariantMap());
+        adaptLatency();
+    });
+    return player;
+}
+
+// Handle the first decoded frame of the active or the standby player
+// Обработать первый декодированный кадр активного или резервного плеера
+void VLCBridge::onFirstFrame(VlcPlayer *player, qint64 elapsedMs)
+{
+    if (player == m_player) {
+        m_startupMs = elapsedMs;
+        emit startupMsChanged(m_startupMs);
+        qDebug() << "VLCBridge: first frame after" << elapsedMs << "ms"
+                 << (player->metrics().warmStart ? "(warm start)" : "(cold start)");
+        return;
+    }
+
+    if (player != m_standby)
+        return;
+
+    if (!m_pendingSwitchUrl.isEmpty() && player->url() == m_pendingSwitchUrl) {
+        finishSwitch();
+        return;
+    }
+
+    // Preloaded only: the audio output exists now, make sure it stays silent
+    // Только предзагружен: аудиовывод уже создан, убедиться, что он остается беззвучным
+    player->setMuted(true);
+}
+
+// Make the standby player active and recycle the old one as the next standby
+// Сделать резервный плеер активным, а старый использовать как следующий резервный
+void VLCBridge::finishSwitch()
+{
+    m_switchTimeout.stop();
+    returnToLive();
+
+    std::swap(m_player, m_standby);
+    std::swap(m_replay, m_standbyReplay);
+    m_player->setMuted(false);
+    m_player->videoSink()->setFrameTap(m_frameTap);
+    m_standby->videoSink()->setFrameTap(nullptr);
+    if (m_videoItem)
+        m_videoItem->setPlayer(m_player);
+
+    m_standby->stop();
+    m_standby->setVisibility(VlcPlayer::Visible);
+    m_standbyUrl.clear();
+    stopRecording();
+    if (m_standbyReplay->isActive()) {
+        detachStreamOutput(m_standbyReplay->streamOutput());
+        m_standbyReplay->stop();
+    }
+
+    const QString url = m_pendingSwitchUrl;
+    m_pendingSwitchUrl.clear();
+
+    // The new player counts stalls from zero again
+    // Новый плеер снова считает остановки с нуля
+    m_latencyControllers[url].restartMeasurement();
+    emit cachingMsChanged(cachingMs());
+    emit decoderPathChanged(decoderPath());
+    emit transportPathChanged(transportPath());
+
+    m_lastSwitchMs = m_switchTimer.elapsed();
+    emit lastSwitchMsChanged(m_lastSwitchMs);
+    emit switchCompleted(url, m_lastSwitchMs);
+    qDebug() << "VLCBridge: switched to" << url << "in" << m_lastSwitchMs << "ms";
+
+    applyState(m_player->state());
+    updateVisibility();
+
+    // The tile may have been resized while the new stream was opening
+    // Плитка могла изменить размер, пока открывался новый поток
+    m_variantTimer.start();
+
+    if (!m_queuedPreload.isEmpty())
+        preload(std::exchange(m_queuedPreload, QString()));
+
+    // Settings may have changed while the new stream was opening
+    // Настройки могли измениться, пока открывался новый поток
+    applyPendingRetune();
+}
+
+// Drop a pending switch; the current stream simply keeps playing
+// Отменить ожидающее переключение; текущий поток просто продолжает играть
+void VLCBridge::cancelSwitch()
+{
+    m_switchTimeout.stop();
+    m_pendingSwitchUrl.clear();
+    m_standbyUrl.clear();
+    m_queuedPreload.clear();
+    if (m_standby)
+        m_standby->stop();
+    if (m_standbyReplay->isActive()) {
+        detachStreamOutput(m_standbyReplay->streamOutput());
+        m_standbyReplay->stop();
+    }
+    applyPendingRetune();
+}
+
+#ifdef Q_OS_ANDROID
+// Legacy path: play inside a native TextureView overlaid on top of the Qt window
+// Parameters: url - stream URL, videoContainer - QML item for DPI scaling, rectDp - geometry in DP
+// Устаревший путь: воспроизведение в нативном TextureView поверх окна Qt
+// Параметры: url - URL потока, videoContainer - элемент QML для масштабирования DPI, rectDp - геометрия в DP
+void VLCBridge::playInSurface(const QString &url, QObject *videoContainer, const QRectF &rectDp)
+{
+    // Get the current Android Activity from QtNative
+    // Получить текущий объект Activity из QtNative
+    QJniObject activity = QJniObject::callStaticObjectMethod(
+        "org/qtproject/qt/android/QtNative", "activity", "()Landroid/app/Activity;");
+    // Check if Activity was successfully retrieved
+    // Проверить, был ли Activity успешно получен
+    if (!activity.isValid()) {
+        emit error("Failed to get Android activity");
+        return;
+    }
+
+    // The native player must not keep decoding underneath the surface
+    // Нативный плеер не должен продолжать декодирование под поверхностью
+    returnToLive();
+    if (m_player)
+        m_player->stop();
+    stopRecording();
+    stopReplayBuffers();
+
+    // Convert QString to JNI string
+    // Преобразовать QString в JNI строку
+    QJniObject jUrl = QJniObject::fromString(url);
+
+    // Convert DP coordinates to physical pixels using DPI scaling
+    // Преобразовать DP координаты в физические пиксели с использованием DPI масштабирования
+    auto rect = toPx(videoContainer, rectDp);
+
+    // The helper reads the transport for every media it creates
+    // Помощник читает транспорт для каждого создаваемого медиа
+    QJniObject::callStaticMethod<void>(
+        "org/qtproject/example/vlc/VlcSurfaceHelper",
+        "setTransport",
+        "(I)V",
+        jint(transportFor(url)));
+
+    // Call the native Java method to start VLC playback in a SurfaceView
+    // JNI signature: (Activity, URL string, x, y, width, height) -> void
+    // Вызвать нативный Java метод для запуска воспроизведения VLC в SurfaceView
+    // JNI сигнатура: (Activity, URL строка, x, y, ширина, высота) -> void
+    QJniObject::callStaticMethod<void>(
+        "org/qtproject/example/vlc/VlcSurfaceHelper",
+        "startPlaybackInSurface",
+        "(Landroid/app/Activity;Ljava/lang/String;FFFF)V",
+        activity.object<jobject>(),
+        jUrl.object<jstring>(),
+        static_cast<jfloat>(rect.x()),
+        static_cast<jfloat>(rect.y()),
+        static_cast<jfloat>(rect.width()),
+        static_cast<jfloat>(rect.height())
+        );
+
+    // From here on the state comes from the MediaPlayer events of the Java helper
+    // and the TextureView follows the container on its own
+    // С этого момента состояние приходит из событий MediaPlayer Java помощника,
+    // а TextureView сам следует за контейнером
+    m_usesSurface = true;
+    m_geometrySync.setItem(qobject_cast<QQuickItem *>(videoContainer));
+    updateVisibility();
+}
+
+// Move the TextureView; called at most once per frame by the geometry sync
+// Parameters: rectPx - new geometry in physical pixels
+// Переместить TextureView; вызывается синхронизацией геометрии не чаще раза за кадр
+// Параметры: rectPx - новая геометрия в физических пикселях
+void VLCBridge::sendSurfaceGeometry(const QRectF &rectPx)
+{
+    // Call the native Java method to update the video surface position
+    // JNI signature: (x, y, width, height) -> void
+    // Вызвать нативный Java метод для обновления позиции видеоповерхности
+    // JNI сигнатура: (x, y, ширина, высота) -> void
+    QJniObject::callStaticMethod<void>(
+        "org/qtproject/example/vlc/VlcSurfaceHelper",
+        "updateSurfacePosition",
+        "(FFFF)V",
+        static_cast<jfloat>(rectPx.x()),
+        static_cast<jfloat>(rectPx.y()),
+        static_cast<jfloat>(rectPx.width()),
+        static_cast<jfloat>(rectPx.height())
+        );
+}
+
+// Adopt a state reported by the Java helper while the surface path is in use
+// Parameters: state - VlcPlayer::State value, message - failure text (empty on success)
+// Принять состояние, сообщенное Java помощником, пока используется путь с поверхностью
+// Параметры: state - значение VlcPlayer::State, message - текст сбоя (пуст при успехе)
+void VLCBridge::onSurfaceState(int state, const QString &message)
+{
+    if (!m_usesSurface)
+        return;
+    if (!message.isEmpty())
+        emit error(message);
+    applyState(static_cast<VlcPlayer::State>(state));
+}
+#endif
@@ -0,0 +1,141 @@
+#include "vlcengine.h"
+#include <QDebug>
+#include <QMutex>
+#include <QElapsedTimer>
+#include <QMutexLocker>
+#include <QThread>
+#include <atomic>
+#include <vector>
+
+namespace {
+
+// Holder that owns the libvlc instance and releases it when the process exits
+// Владелец экземпляра libvlc, освобождающий его при завершении процесса
+struct EngineHolder
+{
+    ~EngineHolder()
+    {
+        // A prewarm still running at exit must finish before the instance goes away
+        // Прогрев, еще идущий при выходе, должен завершиться до освобождения экземпляра
+        if (prewarmThread) {
+            prewarmThread->wait();
+            delete prewarmThread;
+        }
+        if (instance)
+            libvlc_release(instance);
+    }
+
+    libvlc_instance_t *instance = nullptr;
+    QString lastError;
+    QMutex mutex;
+
+    // Readable without the mutex, which the prewarm thread holds during libvlc_new()
+    // Читаются без мьютекса, который поток прогрева удерживает во время libvlc_new()
+    std::atomic<bool> ready { false };
+    std::atomic<qint64> initMs { -1 };
+    std::atomic<bool> prewarmed { false };
+    QThread *prewarmThread = nullptr;
+};
+
+EngineHolder &holder()
+{
+    static EngineHolder h;
+    return h;
+}
+
+} // namespace
+
+QStringList VlcEngine::defaultOptions()
+{
+    // Keep these in sync with the option list in VlcSurfaceHelper.startPlaybackInSurface
+    // Держать в синхронизации со списком параметров в VlcSurfaceHelper.startPlaybackInSurface
+    return {
+        QStringLiteral("--no-drop-late-frames"),
+        QStringLiteral("--rtsp-tcp"),
+        QStringLiteral("--network-caching=150"),
+        QStringLiteral("--live-caching=150"),
+        QStringLiteral("--no-video-title-show"),
+    };
+}
+
+libvlc_instance_t *VlcEngine::instance()
+{
+    return obtain(false);
+}
+
+libvlc_instance_t *VlcEngine::obtain(bool prewarmed)
+{
+    EngineHolder &h = holder();
+    QMutexLocker locker(&h.mutex);
+
+    if (h.instance)
+        return h.instance;
+
+    // libvlc_new() expects a plain argv array; keep the UTF-8 buffers alive for the call
+    // libvlc_new() ожидает обычный массив argv; UTF-8 буферы должны жить во время вызова
+    const QStringList options = defaultOptions();
+    std::vector<QByteArray> utf8;
+    std::vector<const char *> argv;
+    utf8.reserve(options.size());
+    argv.reserve(options.size());
+    for (const QString &option : options) {
+        utf8.push_back(option.toUtf8());
+        argv.push_back(utf8.back().constData());
+    }
+
+    QElapsedTimer clock;
+    clock.start();
+    h.instance = libvlc_new(static_cast<int>(argv.size()), argv.data());
+    if (!h.instance) {
+        const char *msg = libvlc_errmsg();
+        h.lastError = msg ? QString::fromUtf8(msg) : QStringLiteral("libvlc_new failed");
+        qWarning() << "VlcEngine: failed to create libvlc instance:" << h.lastError;
+        return nullptr;
+    }
+
+    h.initMs = clock.elapsed();
+    h.prewarmed = prewarmed;
+    h.ready = true;
+    qDebug() << "✅ VlcEngine: libvlc instance created in" << h.initMs.load() << "ms"
+             << (prewarmed ? "(prewarmed)" : "");
+    return h.instance;
+}
+
+void VlcEngine::prewarm()
+{
+    EngineHolder &h = holder();
+    if (h.ready)
+        return;
+
+    QMutexLocker locker(&h.mutex);
+    if (h.instance || h.prewarmThread)
+        return;
+
+    // A failure is kept in lastError() and retried by the first instance() call
+    // Ошибка сохраняется в lastError(), а первый вызов instance() повторяет попытку
+    h.prewarmThread = QThread::create([]() { obtain(true); });
+    h.prewarmThread->setObjectName(QStringLiteral("VlcEnginePrewarm"));
+    h.prewarmThread->start();
+}
+
+bool VlcEngine::isReady()
+{
+    return holder().ready;
+}
+
+qint64 VlcEngine::initMs()
+{
+    return holder().initMs;
+}
+
+bool VlcEngine::wasPrewarmed()
+{
+    return holder().prewarmed;
+}
+
+QString VlcEngine::lastError()
+{
+    EngineHolder &h = holder();
+    QMutexLocker locker(&h.mutex);
+    return h.lastError;
+}
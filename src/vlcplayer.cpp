@@ -0,0 +1,918 @@
+#include "vlcplayer.h"
+#include "playerworker.h"
+#include "vlcengine.h"
+#include "videoframesink.h"
+#include "reconnectsupervisor.h"
+#include "sessioncache.h"
+#include <QDebug>
+
+namespace {
+
+// Player events forwarded to onPlayerEvent()
+// События плеера, передаваемые в onPlayerEvent()
+constexpr libvlc_event_type_t kPlayerEvents[] = {
+    libvlc_MediaPlayerOpening,
+    libvlc_MediaPlayerBuffering,
+    libvlc_MediaPlayerPlaying,
+    libvlc_MediaPlayerPaused,
+    libvlc_MediaPlayerStopped,
+    libvlc_MediaPlayerEndReached,
+    libvlc_MediaPlayerEncounteredError,
+};
+
+// Media statistics are sampled once a second
+// Статистика медиа снимается раз в секунду
+constexpr int kStatsIntervalMs = 1000;
+
+// DecodeAuto gives up on the hardware decoder when it loses more than half of the pictures
+// once at least this many have gone through it
+// DecodeAuto отказывается от аппаратного декодера, если он теряет больше половины кадров
+// после того, как через него прошло хотя бы столько кадров
+constexpr qint64 kFallbackMinPictures = 25;
+
+// A UDP session that has not received a byte this long after open() is moved to TCP; well before
+// the supervisor's connect timeout and live555's own 10 s rollover
+// UDP сессия, не получившая ни байта за это время после open(), переводится на TCP; задолго до
+// тайм-аута соединения супервизора и собственного переключения live555 через 10 с
+constexpr qint64 kUdpTimeoutMs = 3000;
+
+// libvlc starts the RTSP frame buffer at 250 kB and only grows it after truncating a frame, which
+// costs the first key frame of a large stream; a known resolution sizes it up front
+// libvlc начинает буфер кадра RTSP с 250 кБ и увеличивает его только после обрезания кадра, что
+// стоит первого ключевого кадра крупного потока; известное разрешение задает размер заранее
+constexpr qint64 kMinFrameBufferBytes = 250000;
+constexpr qint64 kMaxFrameBufferBytes = 8 * 1024 * 1024;
+
+// Media options derived from what an earlier session of the stream learned
+// Параметры медиа, выведенные из того, что узнала прошлая сессия потока
+QStringList cachedOptions(const SessionCache::Entry &entry)
+{
+    const qint64 keyFrameBytes = qint64(entry.videoSize.width()) * entry.videoSize.height() / 2;
+    if (keyFrameBytes <= kMinFrameBufferBytes)
+        return {};
+    return { QStringLiteral(":rtsp-frame-buffer-size=%1").arg(qMin(keyFrameBytes, kMaxFrameBufferBytes)) };
+}
+
+// libvlc fourcc as text, e.g. "h264"
+// fourcc libvlc в виде текста, например "h264"
+QString fourccName(uint32_t fourcc)
+{
+    const char text[] = { char(fourcc & 0xff), char((fourcc >> 8) & 0xff),
+                          char((fourcc >> 16) & 0xff), char((fourcc >> 24) & 0xff) };
+    return QString::fromLatin1(text, 4).trimmed();
+}
+
+} // namespace
+
+VlcPlayer::VlcPlayer(QObject *parent)
+    : QObject(parent)
+    , m_sink(new VideoFrameSink(this))
+    , m_supervisor(new ReconnectSupervisor(this))
+{
+    updateDecoderPath();
+    updateTransportPath();
+
+    connect(m_sink, &VideoFrameSink::frameReady, this, &VlcPlayer::onFrameReady, Qt::QueuedConnection);
+    connect(m_supervisor, &ReconnectSupervisor::reconnectScheduled, this, &VlcPlayer::reconnectScheduled);
+    connect(m_supervisor, &ReconnectSupervisor::reconnected, this, &VlcPlayer::reconnected);
+
+    m_statsTimer.setInterval(kStatsIntervalMs);
+    connect(&m_statsTimer, &QTimer::timeout, this, &VlcPlayer::updateMetrics);
+}
+
+VlcPlayer::~VlcPlayer()
+{
+    // Events stop here; stopping the decoder may take a while, so the worker does it and takes
+    // the sink along, which must outlive the video output thread
+    // События прекращаются здесь; остановка декодера может занять время, поэтому ее выполняет
+    // поток обработки и забирает с собой приемник, который должен пережить поток видеовывода
+    if (m_player) {
+        libvlc_event_manager_t *events = libvlc_media_player_event_manager(m_player);
+        for (libvlc_event_type_t type : kPlayerEvents)
+            libvlc_event_detach(events, type, &VlcPlayer::handleEvent, this);
+
+        m_sink->setParent(nullptr);
+        PlayerWorker::shared().release(m_target, m_sink);
+    }
+}
+
+QString VlcPlayer::vlcError(const char *fallback)
+{
+    const char *msg = libvlc_errmsg();
+    return QString::fromUtf8(msg ? msg : fallback);
+}
+
+bool VlcPlayer::ensurePlayer()
+{
+    if (m_player)
+        return true;
+
+    libvlc_instance_t *vlc = VlcEngine::instance();
+    if (!vlc) {
+        emit error(VlcEngine::lastError());
+        return false;
+    }
+
+    m_player = libvlc_media_player_new(vlc);
+    if (!m_player) {
+        emit error(vlcError("Failed to create media player"));
+        return false;
+    }
+    m_target.player = m_player;
+    m_target.owner = this;
+
+    // Decode into application buffers instead of a native window
+    // Декодировать в буферы приложения вместо нативного окна
+    m_sink->attach(m_player);
+
+    libvlc_event_manager_t *events = libvlc_media_player_event_manager(m_player);
+    for (libvlc_event_type_t type : kPlayerEvents)
+        libvlc_event_attach(events, type, &VlcPlayer::handleEvent, this);
+    return true;
+}
+
+bool VlcPlayer::open(const QString &url, const QStringList &options)
+{
+    m_supervisor->disarm();
+    if (url != m_url) {
+        m_hardwareFailed = false;
+        m_udpFailed = false;
+    }
+    m_url = url;
+    m_options = options;
+    m_callbacks = MediaCallbacks();
+    m_transportFallbacks = 0;
+    resetShedding();
+    if (!start(false))
+        return false;
+
+    m_supervisor->arm();
+    qDebug() << "VlcPlayer: playback started" << url;
+    return true;
+}
+
+bool VlcPlayer::openCallbacks(const QString &name, const MediaCallbacks &callbacks, const QStringList &options)
+{
+    m_supervisor->disarm();
+    m_url = name;
+    m_options = options;
+    m_callbacks = callbacks;
+    m_transportFallbacks = 0;
+    resetShedding();
+    if (!start())
+        return false;
+
+    qDebug() << "VlcPlayer: playback started" << name;
+    return true;
+}
+
+bool VlcPlayer::reconnect()
+{
+    if (m_url.isEmpty())
+        return false;
+
+    // Data arrived but nothing was decoded: blame the hardware decoder rather than the network
+    // Данные пришли, но ничего не декодировано: винить аппаратный декодер, а не сеть
+    if (!m_hasFrame && m_lastDemuxBytes > 0)
+        fallBackToSoftware("no picture decoded");
+    return start();
+}
+
+bool VlcPlayer::start(bool restart)
+{
+    const bool engineReady = VlcEngine::isReady();
+    if (!ensurePlayer())
+        return false;
+
+    // A stream seen before skips the host lookup, a hardware decoder that already failed on it
+    // and the truncated first key frame; application callbacks have nothing to cache
+    // Уже виденный поток пропускает разрешение хоста, аппаратный декодер, уже отказавший на нем,
+    // и обрезанный первый ключевой кадр; для колбэков приложения кэшировать нечего
+    SessionCache &cache = SessionCache::shared();
+    SessionCache::Entry cached;
+    const bool known = !m_callbacks.read && cache.lookup(m_url, &cached);
+    if (known && cached.hardwareFailed && m_decodePolicy == DecodeAuto && !m_hardwareFailed) {
+        m_hardwareFailed = true;
+        updateDecoderPath();
+    }
+    if (known && cached.udpFailed && m_transport == TransportAuto)
+        m_udpFailed = true;
+    updateTransportPath();
+    const QString mrl = m_callbacks.read ? m_url : cache.mrlFor(m_url);
+    m_warmStart = engineReady && known;
+    m_cacheUsed = known || mrl != m_url;
+    if (!m_callbacks.read)
+        cache.resolve(m_url);
+
+    libvlc_media_t *media = m_callbacks.read
+        ? libvlc_media_new_callbacks(VlcEngine::instance(), m_callbacks.open, m_callbacks.read,
+                                     m_callbacks.seek, m_callbacks.close, m_callbacks.opaque)
+        : libvlc_media_new_location(VlcEngine::instance(), mrl.toUtf8().constData());
+    if (!media) {
+        emit error(vlcError("Invalid media location"));
+        return false;
+    }
+
+    QStringList options = m_options + transportOptions() + decodeOptions() + visibilityOptions();
+
+    // Recording and replay tap the demuxed streams; the display branch keeps feeding the sink as before
+    // Запись и повтор отводят демультиплексированные потоки; ветка display по-прежнему питает приемник
+    if (!m_streamOutputs.isEmpty()) {
+        QString sout = QStringLiteral(":sout=#duplicate{dst=display");
+        for (const QString &chain : m_streamOutputs)
+            sout += QStringLiteral(",dst=") + chain;
+        sout += QLatin1Char('}');
+        options << sout;
+    }
+
+    // Cache-derived options go first, so the caller's options override them
+    // Параметры из кэша идут первыми, чтобы параметры вызывающего их переопределяли
+    for (const QString &option : (known ? cachedOptions(cached) : QStringList()) + options)
+        libvlc_media_add_option(media, option.toUtf8().constData());
+
+    // The same URL and options are the same media, whatever the cache contributed; bytes from
+    // application callbacks cannot be compared, so they always restart
+    // Тот же URL и параметры - то же медиа, что бы ни добавил кэш; байты из колбэков приложения
+    // сравнить нельзя, поэтому они всегда перезапускаются
+    const QString key = m_callbacks.read ? QString() : m_url + QLatin1Char('\n') + options.join(QLatin1Char('\n'));
+
+    // Events still queued for the previous media must not override the new one
+    // События, еще стоящие в очереди для предыдущего медиа, не должны перекрывать новое
+    ++m_generation;
+
+    // Every connection starts a fresh set of metrics; outage figures are kept by the supervisor
+    // Каждое соединение начинает новый набор метрик; данные об обрывах хранит супервизор
+    m_hasFrame = false;
+    m_openTimer.start();
+    m_metrics = PlaybackMetrics();
+    m_metrics.warmStart = m_warmStart;
+    m_metrics.decoderPath = m_decoderPath;
+    m_metrics.transport = m_transportPath;
+    m_metrics.transportFallbacks = m_transportFallbacks;
+    m_metrics.visibility = visibilityName(effectiveVisibility());
+    m_lastReadBytes = 0;
+    m_lastDemuxBytes = 0;
+    m_lastDecodedFrames = 0;
+    m_lastUnrenderedFrames = 0;
+    m_videoOff = false;
+    m_firstFrameMediaMs = -1;
+    m_sink->resetTiming();
+
+    // The worker sets the media and starts it; progress is reported through player events and a
+    // failure to start through onStartApplied()
+    // Поток обработки устанавливает медиа и запускает его; ход выполнения сообщается через события
+    // плеера, а неудачный запуск - через onStartApplied()
+    PlayerWorker::shared().play(m_target, media, key, restart, m_generation.load());
+    setState(Opening);
+
+    m_statsClock.start();
+    m_statsTimer.start();
+    return true;
+}
+
+void VlcPlayer::onStartApplied(int generation, const QString &failure, bool resumed)
+{
+    if (generation != m_generation.load())
+        return;
+
+    if (!failure.isEmpty()) {
+        forgetFailedStart();
+        setState(Error);
+        emit error(failure);
+    } else if (resumed && m_state == Opening) {
+        // No Opening or Playing event comes for a media that kept running
+        // Для медиа, продолжившего работу, событий Opening и Playing не будет
+        setState(m_hasFrame ? Playing : Buffering);
+    }
+}
+
+bool VlcPlayer::commandsPending() const
+{
+    return m_target.pending->load() > 0;
+}
+
+void VlcPlayer::setPaused(bool paused)
+{
+    if (m_player)
+        PlayerWorker::shared().setPaused(m_target, paused);
+}
+
+void VlcPlayer::stop()
+{
+    m_supervisor->disarm();
+    if (m_player)
+        PlayerWorker::shared().stop(m_target);
+    ++m_generation;
+    m_hasFrame = false;
+    m_openTimer.invalidate();
+    m_statsTimer.stop();
+
+    // Events of the stopped media carry the old generation and are dropped
+    // События остановленного медиа несут старое поколение и отбрасываются
+    setState(Idle);
+}
+
+void VlcPlayer::setMuted(bool muted)
+{
+    if (m_player)
+        PlayerWorker::shared().setMuted(m_target, muted);
+}
+
+VlcPlayer::State VlcPlayer::state() const
+{
+    return m_state;
+}
+
+QString VlcPlayer::stateName(State state)
+{
+    switch (state) {
+    case Idle:
+        return QStringLiteral("Stopped");
+    case Opening:
+        return QStringLiteral("Opening");
+    case Buffering:
+        return QStringLiteral("Buffering");
+    case Playing:
+        return QStringLiteral("Playing");
+    case Paused:
+        return QStringLiteral("Paused");
+    case Ended:
+        return QStringLiteral("Ended");
+    case Error:
+        return QStringLiteral("Error");
+    }
+    return QString();
+}
+
+void VlcPlayer::setState(State state)
+{
+    if (state == m_state)
+        return;
+    m_state = state;
+    emit stateChanged(m_state);
+}
+
+bool VlcPlayer::hasFrame() const
+{
+    return m_hasFrame;
+}
+
+void VlcPlayer::onFrameReady()
+{
+    // Frames queued before stop() may still arrive; only count frames of a running open()
+    // Кадры, поставленные в очередь до stop(), еще могут прийти; учитывать только кадры активного open()
+    if (m_hasFrame || !m_openTimer.isValid())
+        return;
+
+    m_hasFrame = true;
+    m_metrics.timeToFirstFrameMs = m_openTimer.elapsed();
+    m_firstFrameMediaMs = commandsPending() ? -1 : mediaTimeMs();
+    m_sinceFirstFrame.start();
+    applyVisibility();
+    learnSession();
+
+    // A frame on screen is the real start of playback, whatever the buffering events said
+    // Кадр на экране - настоящее начало воспроизведения, что бы ни говорили события буферизации
+    if (m_state == Opening || m_state == Buffering)
+        setState(Playing);
+    emit firstFrame(m_metrics.timeToFirstFrameMs);
+}
+
+void VlcPlayer::learnSession()
+{
+    if (m_callbacks.read || commandsPending())
+        return;
+
+    SessionCache::Entry learned;
+    learned.transport = !usesUdp() ? QStringLiteral("tcp")
+        : m_transport == TransportMulticast ? QStringLiteral("multicast") : QStringLiteral("udp");
+    learned.hardwareFailed = m_hardwareFailed;
+    learned.udpFailed = m_udpFailed;
+
+    // libvlc_media_player_get_media() returns a new reference
+    // libvlc_media_player_get_media() возвращает новую ссылку
+    if (libvlc_media_t *media = libvlc_media_player_get_media(m_player)) {
+        libvlc_media_track_t **tracks = nullptr;
+        const unsigned count = libvlc_media_tracks_get(media, &tracks);
+        for (unsigned i = 0; i < count; ++i) {
+            const libvlc_media_track_t *track = tracks[i];
+            if (track->i_type == libvlc_track_video && learned.videoCodec.isEmpty()) {
+                learned.videoCodec = fourccName(track->i_codec);
+                learned.videoSize = QSize(int(track->video->i_width), int(track->video->i_height));
+                if (track->video->i_frame_rate_den > 0)
+                    learned.frameRate = double(track->video->i_frame_rate_num) / track->video->i_frame_rate_den;
+            } else if (track->i_type == libvlc_track_audio && learned.audioCodec.isEmpty()) {
+                learned.audioCodec = fourccName(track->i_codec);
+            }
+        }
+        if (tracks)
+            libvlc_media_tracks_release(tracks, count);
+        libvlc_media_release(media);
+    }
+
+    // Packetized streams may not report a size before the decoder does
+    // Пакетированные потоки могут не сообщать размер раньше декодера
+    if (learned.videoSize.isEmpty())
+        learned.videoSize = m_sink->frameSize();
+
+    SessionCache &cache = SessionCache::shared();
+    cache.learn(m_url, learned);
+    cache.recordFirstFrame(m_url, m_warmStart, m_metrics.timeToFirstFrameMs);
+}
+
+void VlcPlayer::forgetFailedStart()
+{
+    if (m_hasFrame || !m_cacheUsed)
+        return;
+    m_cacheUsed = false;
+    SessionCache::shared().invalidate(m_url);
+}
+
+void VlcPlayer::handleEvent(const libvlc_event_t *event, void *opaque)
+{
+    auto *self = static_cast<VlcPlayer *>(opaque);
+    const int generation = self->m_target.generation->load();
+    const int type = event->type;
+    const float value = type == libvlc_MediaPlayerBuffering ? event->u.media_player_buffering.new_cache : 0.0f;
+
+    // Never touch Qt state on the libvlc thread; the call is dropped if the player is gone
+    // Никогда не трогать состояние Qt в потоке libvlc; вызов отбрасывается, если плеера уже нет
+    QMetaObject::invokeMethod(self, [self, generation, type, value]() {
+        self->onPlayerEvent(generation, type, value);
+    }, Qt::QueuedConnection);
+}
+
+void VlcPlayer::onPlayerEvent(int generation, int type, float value)
+{
+    if (generation != m_generation.load())
+        return;
+
+    switch (type) {
+    case libvlc_MediaPlayerOpening:
+        setState(Opening);
+        break;
+    case libvlc_MediaPlayerBuffering:
+        m_metrics.bufferingPercent = value;
+        if (m_state == Paused || m_state == Error || m_state == Ended)
+            break;
+        if (value < 100.0f) {
+            // Dropping below 100% after the first frame means the buffer ran dry
+            // Падение ниже 100% после первого кадра означает, что буфер опустел
+            if (m_hasFrame && m_state == Playing)
+                ++m_metrics.stallCount;
+            setState(Buffering);
+        } else if (m_state == Buffering && m_hasFrame) {
+            setState(Playing);
+        }
+        break;
+    case libvlc_MediaPlayerPlaying:
+        // libvlc reports Playing as soon as the input runs; frames may still be buffering
+        // libvlc сообщает Playing, как только вход запущен; кадры могут еще буферизоваться
+        setState(m_hasFrame ? Playing : Buffering);
+        break;
+    case libvlc_MediaPlayerPaused:
+        setState(Paused);
+        break;
+    case libvlc_MediaPlayerStopped:
+        setState(Idle);
+        break;
+    case libvlc_MediaPlayerEndReached:
+        forgetFailedStart();
+        setState(Ended);
+        break;
+    case libvlc_MediaPlayerEncounteredError:
+        // libvlc_errmsg() is per thread and empty here, so name the stream instead
+        // libvlc_errmsg() свой для каждого потока и здесь пуст, поэтому назвать поток
+        forgetFailedStart();
+        if (!m_hasFrame && m_lastDemuxBytes > 0)
+            fallBackToSoftware("error before the first picture");
+
+        // A camera that refuses the multicast setup usually serves the stream over TCP
+        // Камера, отказавшая в настройке multicast, обычно отдает поток по TCP
+        if (!m_hasFrame && m_lastDemuxBytes == 0 && m_transport == TransportMulticast)
+            fallBackToTcp("multicast setup failed");
+        setState(Error);
+        emit error(QStringLiteral("Playback of %1 failed").arg(m_url));
+        break;
+    default:
+        break;
+    }
+}
+
+void VlcPlayer::updateMetrics()
+{
+    // While the worker changes the media, libvlc still reports the old one; the next tick catches up
+    // Пока поток обработки меняет медиа, libvlc еще сообщает о старом; следующий такт наверстает
+    if (!m_player || commandsPending())
+        return;
+
+    // Safety net: the state libvlc reports itself wins over a missed terminal event
+    // Страховка: состояние, которое сообщает сам libvlc, важнее пропущенного финального события
+    // Statistics keep flowing during an outage so the reconnect figures stay current
+    // Статистика продолжает обновляться во время обрыва, чтобы цифры переподключений были актуальны
+    const libvlc_state_t vlcState = libvlc_media_player_get_state(m_player);
+    if (vlcState == libvlc_Error && m_state != Error)
+        onPlayerEvent(m_generation.load(), libvlc_MediaPlayerEncounteredError, 0.0f);
+    else if (vlcState == libvlc_Ended && m_state != Ended)
+        onPlayerEvent(m_generation.load(), libvlc_MediaPlayerEndReached, 0.0f);
+
+    const ReconnectSupervisor::Stats outages = m_supervisor->stats();
+    m_metrics.reconnectCount = outages.reconnectCount;
+    m_metrics.failedReconnects = outages.failedAttempts;
+    m_metrics.outageMs = outages.currentOutageMs;
+    m_metrics.lastOutageMs = outages.lastOutageMs;
+    m_metrics.totalOutageMs = outages.totalOutageMs;
+
+    // libvlc_media_player_get_media() returns a new reference
+    // libvlc_media_player_get_media() возвращает новую ссылку
+    libvlc_media_t *media = libvlc_media_player_get_media(m_player);
+    if (!media)
+        return;
+
+    libvlc_media_stats_t stats = {};
+    const bool haveStats = libvlc_media_get_stats(media, &stats) != 0;
+    libvlc_media_release(media);
+
+    const qint64 intervalMs = qMax<qint64>(1, m_statsClock.restart());
+    if (haveStats) {
+        m_metrics.decodedFrames = stats.i_decoded_video;
+        m_metrics.droppedFrames = stats.i_lost_pictures;
+        m_metrics.corruptedBlocks = stats.i_demux_corrupted;
+        m_metrics.discontinuities = stats.i_demux_discontinuity;
+
+        // Bits per millisecond equals kbit/s
+        // Биты в миллисекунду равны кбит/с
+        m_metrics.inputBitrateKbps = double(stats.i_read_bytes - m_lastReadBytes) * 8.0 / double(intervalMs);
+        m_metrics.demuxBitrateKbps = double(stats.i_demux_read_bytes - m_lastDemuxBytes) * 8.0 / double(intervalMs);
+        m_lastReadBytes = stats.i_read_bytes;
+        m_lastDemuxBytes = stats.i_demux_read_bytes;
+
+        // What hiding saved: time hidden, and the pictures a visible player would have decoded at
+        // the rate it last had but a keyframe-only or audio-only one did not
+        // Что сэкономило скрытие: время в скрытом режиме и кадры, которые видимый плеер декодировал
+        // бы в своем последнем темпе, а плеер только с ключевыми кадрами или только со звуком - нет
+        const qint64 decoded = stats.i_decoded_video - m_lastDecodedFrames;
+        m_lastDecodedFrames = stats.i_decoded_video;
+        const Visibility visibility = effectiveVisibility();
+        if (visibility == Visible) {
+            const double fps = double(decoded) * 1000.0 / double(intervalMs);
+            if (m_hasFrame)
+                m_visibleFps = m_visibleFps <= 0.0 ? fps : m_visibleFps + (fps - m_visibleFps) / 4.0;
+        } else {
+            m_hiddenMs += intervalMs;
+            if (visibility != HiddenNoRender)
+                m_decodesSkipped += qMax(0.0, m_visibleFps * double(intervalMs) / 1000.0 - double(decoded));
+        }
+
+        // Nothing at all over UDP: the packets are blocked somewhere between the camera and us
+        // По UDP вообще ничего: пакеты блокируются где-то между камерой и нами
+        if (!m_hasFrame && stats.i_demux_read_bytes == 0 && m_openTimer.isValid()
+            && m_openTimer.elapsed() > kUdpTimeoutMs && fallBackToTcp("no UDP packets")) {
+            start();
+            return;
+        }
+
+        // A hardware decoder that keeps losing pictures is worse than a busy CPU. Lost pictures are
+        // counted by the video output, so they only blame the decoder when pictures actually come
+        // from one (hardware decoders hand back NV12) and late frames are not being dropped on purpose;
+        // otherwise an overloaded CPU would be pushed onto software decoding and get even busier
+        // Аппаратный декодер, постоянно теряющий кадры, хуже загруженного процессора. Потерянные кадры
+        // считает видеовывод, поэтому они указывают на декодер, только когда кадры действительно идут
+        // от него (аппаратные декодеры отдают NV12) и опоздавшие кадры не отбрасываются намеренно;
+        // иначе перегруженный процессор перевели бы на программное декодирование и загрузили еще сильнее
+        const bool hardwarePictures = usesHardware() && m_sink->chroma() == QLatin1String("NV12");
+        const bool dropsLate = m_options.contains(QStringLiteral(":drop-late-frames"));
+        const qint64 pictures = stats.i_decoded_video + stats.i_lost_pictures;
+        if (hardwarePictures && !dropsLate && pictures >= kFallbackMinPictures && stats.i_lost_pictures * 2 > pictures
+            && fallBackToSoftware("decoder losing pictures")) {
+            start();
+            return;
+        }
+    }
+
+    const VideoFrameSink::Timing timing = m_sink->timing();
+    m_metrics.displayedFrames = timing.displayedFrames;
+    m_metrics.lateFrames = timing.lateFrames;
+    m_metrics.jitterMs = timing.jitterMs;
+    m_rendersSkipped += timing.unrenderedFrames - m_lastUnrenderedFrames;
+    m_lastUnrenderedFrames = timing.unrenderedFrames;
+    m_metrics.visibility = visibilityName(effectiveVisibility());
+    m_metrics.hiddenMs = m_hiddenMs;
+    m_metrics.rendersSkipped = m_rendersSkipped;
+    m_metrics.decodesSkipped = qint64(m_decodesSkipped);
+
+    // A live stream advances media time at wall-clock speed; whatever wall time is not covered
+    // by media time has piled up in the buffers on top of the configured caching
+    // Живой поток продвигает время медиа со скоростью реального времени; все, что не покрыто
+    // временем медиа, накопилось в буферах сверх заданного кэширования
+    if (m_hasFrame && m_firstFrameMediaMs >= 0) {
+        const qint64 mediaElapsed = mediaTimeMs() - m_firstFrameMediaMs;
+        const qint64 backlog = qMax<qint64>(0, m_sinceFirstFrame.elapsed() - mediaElapsed);
+        m_metrics.bufferingDelayMs = m_cachingMs + backlog;
+    }
+
+    emit metricsUpdated();
+}
+
+PlaybackMetrics VlcPlayer::metrics() const
+{
+    return m_metrics;
+}
+
+void VlcPlayer::setDecodePolicy(DecodePolicy policy, int maxThreads)
+{
+    // Reapplying the same policy keeps an earlier fallback of this stream
+    // Повторное применение той же политики сохраняет прежний откат этого потока
+    maxThreads = qMax(0, maxThreads);
+    if (policy == m_decodePolicy && maxThreads == m_decodeThreads)
+        return;
+
+    m_decodePolicy = policy;
+    m_decodeThreads = maxThreads;
+    m_hardwareFailed = false;
+    updateDecoderPath();
+}
+
+VlcPlayer::DecodePolicy VlcPlayer::decodePolicy() const
+{
+    return m_decodePolicy;
+}
+
+QString VlcPlayer::decoderPath() const
+{
+    return m_decoderPath;
+}
+
+bool VlcPlayer::usesHardware() const
+{
+    switch (m_decodePolicy) {
+    case DecodeAuto:
+        return !m_hardwareFailed;
+    case DecodeHardware:
+        return true;
+    case DecodeSoftware:
+    case DecodeSoftwareCapped:
+        break;
+    }
+    return false;
+}
+
+QStringList VlcPlayer::decodeOptions() const
+{
+    if (usesHardware())
+        return { QStringLiteral(":avcodec-hw=any") };
+
+    QStringList options = { QStringLiteral(":avcodec-hw=none") };
+    if (m_decodePolicy == DecodeSoftwareCapped && m_decodeThreads > 0) {
+        // A lower thread count already requested by the caller (grid quality levels) is kept
+        // Меньшее число потоков, уже запрошенное вызывающим (уровни качества сетки), сохраняется
+        int threads = m_decodeThreads;
+        static const QString prefix = QStringLiteral(":avcodec-threads=");
+        for (const QString &option : m_options) {
+            if (option.startsWith(prefix)) {
+                const int requested = option.mid(prefix.size()).toInt();
+                if (requested > 0)
+                    threads = qMin(threads, requested);
+            }
+        }
+        options << prefix + QString::number(threads);
+    }
+    return options;
+}
+
+void VlcPlayer::updateDecoderPath()
+{
+    QString path;
+    if (usesHardware())
+        path = QStringLiteral("hardware");
+    else if (m_hardwareFailed)
+        path = QStringLiteral("software (fallback)");
+    else if (m_decodePolicy == DecodeSoftwareCapped && m_decodeThreads > 0)
+        path = QStringLiteral("software (%1 threads)").arg(m_decodeThreads);
+    else
+        path = QStringLiteral("software");
+
+    if (path == m_decoderPath)
+        return;
+    m_decoderPath = path;
+    m_metrics.decoderPath = path;
+    emit decoderPathChanged(m_decoderPath);
+}
+
+void VlcPlayer::setTransport(Transport transport)
+{
+    // Reapplying the same transport keeps an earlier fallback of this stream
+    // Повторное применение того же транспорта сохраняет прежний откат этого потока
+    if (transport == m_transport)
+        return;
+
+    m_transport = transport;
+    m_udpFailed = false;
+    updateTransportPath();
+}
+
+VlcPlayer::Transport VlcPlayer::transport() const
+{
+    return m_transport;
+}
+
+QString VlcPlayer::transportPath() const
+{
+    return m_transportPath;
+}
+
+bool VlcPlayer::usesUdp() const
+{
+    return m_transport != TransportTcp && !m_udpFailed && !m_callbacks.read;
+}
+
+QStringList VlcPlayer::transportOptions() const
+{
+    // The engine defaults to --rtsp-tcp; media options override it per stream
+    // Движок по умолчанию использует --rtsp-tcp; параметры медиа переопределяют его для потока
+    if (m_callbacks.read)
+        return {};
+    if (!usesUdp())
+        return { QStringLiteral(":rtsp-tcp") };
+    if (m_transport == TransportMulticast)
+        return { QStringLiteral(":no-rtsp-tcp"), QStringLiteral(":rtsp-mcast") };
+    return { QStringLiteral(":no-rtsp-tcp") };
+}
+
+void VlcPlayer::updateTransportPath()
+{
+    // Media from application callbacks has no network transport
+    // У медиа из колбэков приложения нет сетевого транспорта
+    QString path;
+    if (m_callbacks.read)
+        path = QString();
+    else if (m_udpFailed && m_transport != TransportTcp)
+        path = QStringLiteral("tcp (fallback)");
+    else if (m_transport == TransportTcp)
+        path = QStringLiteral("tcp");
+    else if (m_transport == TransportMulticast)
+        path = QStringLiteral("multicast");
+    else
+        path = QStringLiteral("udp");
+
+    if (path == m_transportPath)
+        return;
+    m_transportPath = path;
+    m_metrics.transport = path;
+    emit transportPathChanged(m_transportPath);
+}
+
+bool VlcPlayer::fallBackToTcp(const char *reason)
+{
+    if (!usesUdp())
+        return false;
+
+    qWarning() << "VlcPlayer:" << m_url << "falling back to RTSP over TCP:" << reason;
+    m_udpFailed = true;
+    ++m_transportFallbacks;
+    updateTransportPath();
+    return true;
+}
+
+bool VlcPlayer::fallBackToSoftware(const char *reason)
+{
+    if (m_decodePolicy != DecodeAuto || m_hardwareFailed)
+        return false;
+
+    qWarning() << "VlcPlayer:" << m_url << "falling back to software decoding:" << reason;
+    m_hardwareFailed = true;
+    updateDecoderPath();
+    return true;
+}
+
+void VlcPlayer::setVisibility(Visibility visibility)
+{
+    if (visibility == m_visibility)
+        return;
+
+    const bool keyframes = effectiveVisibility() == HiddenKeyframes;
+    m_visibility = visibility;
+    qDebug() << "VlcPlayer:" << m_url << "visibility" << visibilityName(visibility);
+
+    // Frame skipping is a decoder option, so it only changes with a reopen on the same player;
+    // supervision stays armed, as for a reconnect
+    // Пропуск кадров - параметр декодера, поэтому он меняется только переоткрытием на том же плеере;
+    // наблюдение остается включенным, как при переподключении
+    if (keyframes != (effectiveVisibility() == HiddenKeyframes) && m_state != Idle && !m_url.isEmpty() && m_player)
+        start();
+    applyVisibility();
+    emit visibilityChanged(m_visibility);
+}
+
+VlcPlayer::Visibility VlcPlayer::visibility() const
+{
+    return m_visibility;
+}
+
+VlcPlayer::Visibility VlcPlayer::effectiveVisibility() const
+{
+    if (m_visibility == HiddenAudioOnly && !m_streamOutputs.isEmpty())
+        return HiddenNoRender;
+    return m_visibility;
+}
+
+QString VlcPlayer::visibilityName(Visibility visibility)
+{
+    switch (visibility) {
+    case Visible:
+        return QStringLiteral("visible");
+    case HiddenNoRender:
+        return QStringLiteral("hidden (no render)");
+    case HiddenKeyframes:
+        return QStringLiteral("hidden (key frames)");
+    case HiddenAudioOnly:
+        return QStringLiteral("hidden (audio only)");
+    }
+    return QString();
+}
+
+void VlcPlayer::applyVisibility()
+{
+    m_sink->setRendering(m_visibility == Visible);
+    if (!m_player)
+        return;
+
+    // Asking again is harmless: the worker leaves a track it already turned off alone
+    // Повторная просьба безвредна: поток обработки не трогает уже выключенную им дорожку
+    if (effectiveVisibility() == HiddenAudioOnly) {
+        PlayerWorker::shared().setVideoEnabled(m_target, false);
+        m_videoOff = true;
+    } else if (m_videoOff) {
+        PlayerWorker::shared().setVideoEnabled(m_target, true);
+        m_videoOff = false;
+    }
+}
+
+QStringList VlcPlayer::visibilityOptions() const
+{
+    // 3 = skip every non-key frame
+    // 3 = пропускать все неключевые кадры
+    if (effectiveVisibility() == HiddenKeyframes)
+        return { QStringLiteral(":avcodec-skip-frame=3") };
+    return {};
+}
+
+void VlcPlayer::resetShedding()
+{
+    m_hiddenMs = 0;
+    m_rendersSkipped = 0;
+    m_decodesSkipped = 0.0;
+    m_visibleFps = 0.0;
+}
+
+void VlcPlayer::setStreamOutputs(const QStringList &chains)
+{
+    if (chains == m_streamOutputs)
+        return;
+    m_streamOutputs = chains;
+
+    // Outputs need the video track: an audio-only player gets it back before they attach
+    // Выводам нужна видеодорожка: плеер только со звуком получает ее обратно до их подключения
+    applyVisibility();
+    if (m_state == Idle || m_url.isEmpty() || !m_player)
+        return;
+
+    // Setting the new media stops the previous one, closing its outputs before the new ones open
+    // Установка нового медиа останавливает предыдущее, закрывая его выводы до открытия новых
+    qDebug() << "VlcPlayer: restarting" << m_url << "with" << chains.size() << "stream outputs";
+    start();
+}
+
+QStringList VlcPlayer::streamOutputs() const
+{
+    return m_streamOutputs;
+}
+
+void VlcPlayer::setCachingMs(int cachingMs)
+{
+    m_cachingMs = cachingMs;
+}
+
+qint64 VlcPlayer::mediaTimeMs() const
+{
+    if (!m_player)
+        return -1;
+    if (!commandsPending())
+        m_mediaTimeMs = libvlc_media_player_get_time(m_player);
+    return m_mediaTimeMs;
+}
+
+ReconnectSupervisor *VlcPlayer::supervisor() const
+{
+    return m_supervisor;
+}
+
+VideoFrameSink *VlcPlayer::videoSink() const
+{
+    return m_sink;
+}
+
+QString VlcPlayer::url() const
+{
+    return m_url;
+}
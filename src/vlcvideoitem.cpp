@@ -0,0 +1,216 @@
+#include "vlcvideoitem.h"
+#include "vlcplayer.h"
+#include "videoframesink.h"
+#include <QQuickWindow>
+#include <QSGSimpleTextureNode>
+#include <QSGTexture>
+#include <QtMath>
+#include <rhi/qrhi.h>
+
+namespace {
+
+// FrameTexture: One GPU texture per output size whose contents are replaced by every new frame
+// The scene graph calls commitTextureOperations() while preparing the material, which records the
+// upload of the pending frame into its resource batch; the texture itself is only recreated when
+// the frame size changes, so steady playback creates no textures at all
+// FrameTexture: Одна текстура GPU на выходной размер, содержимое которой заменяется каждым новым кадром
+// Граф сцены вызывает commitTextureOperations() при подготовке материала, и тот записывает загрузку
+// ожидающего кадра в свой пакет ресурсов; сама текстура пересоздается только при изменении размера
+// кадра, поэтому при установившемся воспроизведении текстуры не создаются вовсе
+class FrameTexture : public QSGTexture
+{
+public:
+    ~FrameTexture() override
+    {
+        delete m_texture;
+    }
+
+    // Frame to upload on the next commit; keeps its sink slot until then
+    // Кадр для загрузки при следующей фиксации; до тех пор удерживает свой слот приемника
+    void setFrame(const QImage &frame)
+    {
+        m_frame = frame;
+        m_size = frame.size();
+    }
+
+    qint64 comparisonKey() const override
+    {
+        return qint64(quintptr(this));
+    }
+
+    QRhiTexture *rhiTexture() const override
+    {
+        return m_texture;
+    }
+
+    QSize textureSize() const override
+    {
+        return m_size;
+    }
+
+    bool hasAlphaChannel() const override
+    {
+        return false;
+    }
+
+    bool hasMipmaps() const override
+    {
+        return false;
+    }
+
+    void commitTextureOperations(QRhi *rhi, QRhiResourceUpdateBatch *resourceUpdates) override
+    {
+        if (m_frame.isNull())
+            return;
+
+        // RGB32 is BGRA in memory; without BGRA textures (some GLES drivers) the frame is swizzled
+        // RGB32 в памяти - это BGRA; без текстур BGRA (некоторые драйверы GLES) кадр переставляется
+        if (!m_texture || m_texture->pixelSize() != m_size) {
+            delete m_texture;
+            m_bgra = rhi->isTextureFormatSupported(QRhiTexture::BGRA8);
+            m_texture = rhi->newTexture(m_bgra ? QRhiTexture::BGRA8 : QRhiTexture::RGBA8, m_size);
+            if (!m_texture->create()) {
+                delete m_texture;
+                m_texture = nullptr;
+                m_frame = QImage();
+                return;
+            }
+        }
+
+        resourceUpdates->uploadTexture(m_texture, m_bgra ? m_frame : m_frame.convertToFormat(QImage::Format_RGBA8888));
+
+        // The batch holds its own reference until the upload is done
+        // Пакет держит собственную ссылку, пока загрузка не завершится
+        m_frame = QImage();
+    }
+
+private:
+    QRhiTexture *m_texture = nullptr;
+    QImage m_frame;
+    QSize m_size;
+    bool m_bgra = true;
+};
+
+} // namespace
+
+VlcVideoItem::VlcVideoItem(QQuickItem *parent)
+    : QQuickItem(parent)
+{
+    // This item draws its own content through updatePaintNode()
+    // Этот элемент рисует собственное содержимое через updatePaintNode()
+    setFlag(ItemHasContents, true);
+}
+
+VlcPlayer *VlcVideoItem::player() const
+{
+    return m_player;
+}
+
+void VlcVideoItem::setPlayer(VlcPlayer *player)
+{
+    if (m_player == player)
+        return;
+
+    if (m_player) {
+        disconnect(m_player->videoSink(), nullptr, this, nullptr);
+        m_player->videoSink()->setTargetSize(QSize());
+    }
+
+    m_player = player;
+    updateTargetSize();
+
+    // frameReady is emitted on the libvlc video thread; queue it onto the GUI thread
+    // frameReady выпускается в видеопотоке libvlc; поставить его в очередь потока GUI
+    if (m_player) {
+        connect(m_player->videoSink(), &VideoFrameSink::frameReady,
+                this, &VlcVideoItem::onFrameReady, Qt::QueuedConnection);
+    }
+
+    emit playerChanged();
+    update();
+}
+
+QSize VlcVideoItem::videoSize() const
+{
+    return m_videoSize;
+}
+
+void VlcVideoItem::onFrameReady()
+{
+    if (!m_player)
+        return;
+
+    const QSize size = m_player->videoSink()->frameSize();
+    if (size != m_videoSize) {
+        m_videoSize = size;
+        emit videoSizeChanged();
+    }
+    update();
+}
+
+void VlcVideoItem::geometryChange(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChange(newGeometry, oldGeometry);
+    if (newGeometry.size() != oldGeometry.size())
+        updateTargetSize();
+}
+
+void VlcVideoItem::itemChange(ItemChange change, const ItemChangeData &value)
+{
+    QQuickItem::itemChange(change, value);
+    if (change == ItemSceneChange || change == ItemDevicePixelRatioHasChanged)
+        updateTargetSize();
+}
+
+void VlcVideoItem::updateTargetSize()
+{
+    if (!m_player)
+        return;
+
+    // No window yet: keep the decoded size until the item is on screen
+    // Окна еще нет: сохранять размер декодирования, пока элемент не на экране
+    const qreal ratio = window() ? window()->effectiveDevicePixelRatio() : 0.0;
+    const QSize pixels(qCeil(width() * ratio), qCeil(height() * ratio));
+    m_player->videoSink()->setTargetSize(pixels);
+}
+
+QRectF VlcVideoItem::videoRect(const QSize &frameSize) const
+{
+    const QSizeF fitted = QSizeF(frameSize).scaled(size(), Qt::KeepAspectRatio);
+    return QRectF((width() - fitted.width()) / 2.0,
+                  (height() - fitted.height()) / 2.0,
+                  fitted.width(), fitted.height());
+}
+
+QSGNode *VlcVideoItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
+{
+    Q_UNUSED(data)
+    auto *node = static_cast<QSGSimpleTextureNode *>(oldNode);
+
+    if (!m_player) {
+        delete node;
+        return nullptr;
+    }
+
+    // The frame wraps the decoder buffer; the texture upload is the only copy made
+    // Кадр ссылается на буфер декодера; загрузка в текстуру - единственная копия
+    const QImage frame = m_player->videoSink()->takeFrame();
+    if (!frame.isNull()) {
+        if (!node) {
+            node = new QSGSimpleTextureNode();
+            node->setOwnsTexture(true);
+            node->setFiltering(QSGTexture::Linear);
+            node->setTexture(new FrameTexture());
+        }
+        static_cast<FrameTexture *>(node->texture())->setFrame(frame);
+        node->markDirty(QSGNode::DirtyMaterial);
+    }
+
+    // No frame has been decoded yet: leave the area transparent
+    // Еще не декодировано ни одного кадра: оставить область прозрачной
+    if (!node)
+        return nullptr;
+
+    node->setRect(videoRect(node->texture()->textureSize()));
+    return node;
+}